@@ -5,6 +5,7 @@
 #include <functional>
 #include <unordered_map>
 #include <filesystem>
+#include <istream>
 
 namespace MakeAppxCore {
 
@@ -21,9 +22,10 @@ namespace MakeAppxCore {
         No
     };
 
+    // packagePath is the entry name in UTF-8, the encoding it has inside the package.
     struct PackageFile {
-        std::wstring localPath;
-        std::wstring packagePath;
+        std::filesystem::path localPath;
+        std::string packagePath;
         uint64_t size;
         uint32_t attributes;
     };
@@ -38,6 +40,107 @@ namespace MakeAppxCore {
 
     using ProgressCallback = std::function<void(const ProgressInfo&)>;
 
+    class OperationControl;
+
+    // A failure tied to one entry. Unpack records entries it had to skip and carries on.
+    struct OperationError {
+        std::wstring entry;
+        std::wstring message;
+    };
+
+    struct PackOptions {
+        CompressionLevel compression = CompressionLevel::Normal;
+        std::wstring cacheDirectory;
+        std::wstring contentGroupMap;
+        // Writes <package>.journal alongside the package so an interrupted pack continues where it stopped.
+        bool resume = false;
+        // Splits the package into <package>.001, .002, ... of at most this many bytes; 0 writes one file.
+        uint64_t volumeSize = 0;
+    };
+
+    constexpr uint32_t MAX_DEBOUNCE_MILLISECONDS = 60000;
+
+    struct WatchOptions {
+        CompressionLevel compression = CompressionLevel::Normal;
+        std::wstring cacheDirectory;
+        std::wstring contentGroupMap;
+        // A rebuild starts once the tree has been quiet this long, so saving many files costs one rebuild.
+        uint32_t debounceMilliseconds = 300;
+        // Rescans the tree on a timer instead of using change notifications.
+        bool poll = false;
+        uint32_t pollMilliseconds = 1000;
+    };
+
+    struct BundleOptions {
+        CompressionLevel compression = CompressionLevel::Normal;
+        uint64_t volumeSize = 0;
+    };
+
+    struct UnpackOptions {
+        OverwriteMode overwrite = OverwriteMode::Ask;
+        std::vector<std::wstring> includePatterns;
+        std::vector<std::wstring> excludePatterns;
+        std::wstring listFile;
+        bool directIo = false;
+    };
+
+    struct PackageEntryInfo {
+        std::wstring name;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        uint64_t offset = 0;
+        uint32_t crc32 = 0;
+        uint16_t method = 0;
+    };
+
+    struct PackageInfo {
+        uint64_t fileSize = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        bool zip64 = false;
+        bool hasBlockMap = false;
+        bool hasSignature = false;
+        std::vector<PackageEntryInfo> entries;
+        std::string manifest;
+    };
+
+    struct VerifyResult {
+        uint64_t entriesChecked = 0;
+        uint64_t bytesChecked = 0;
+        uint64_t blocksChecked = 0;
+        bool blockMapChecked = false;
+        std::vector<std::wstring> failures;
+    };
+
+    enum class DiffChange {
+        Added,
+        Removed,
+        Modified
+    };
+
+    struct PackageDiffEntry {
+        std::wstring name;
+        DiffChange change = DiffChange::Modified;
+        uint64_t oldSize = 0;
+        uint64_t newSize = 0;
+        uint32_t oldCrc32 = 0;
+        uint32_t newCrc32 = 0;
+        bool blockMapDiffers = false;
+    };
+
+    struct PackageDiff {
+        std::vector<PackageDiffEntry> entries;
+        uint64_t unchanged = 0;
+        bool blockMapsCompared = false;
+    };
+
+    struct DeltaStats {
+        uint64_t copiedBytes = 0;
+        uint64_t literalBytes = 0;
+        uint64_t operations = 0;
+        uint64_t patchSize = 0;
+    };
+
     struct BuildOptions {
         std::wstring layoutFile;
         std::wstring outputPath;
@@ -61,13 +164,34 @@ namespace MakeAppxCore {
         virtual bool Pack(const std::wstring& inputPath, const std::wstring& outputPath,
             CompressionLevel compression = CompressionLevel::Normal,
             ProgressCallback callback = nullptr) = 0;
+        virtual bool Pack(const std::wstring& inputPath, const std::wstring& outputPath,
+            const PackOptions& options, ProgressCallback callback = nullptr) = 0;
         virtual bool Unpack(const std::wstring& inputPath, const std::wstring& outputPath,
             OverwriteMode overwrite = OverwriteMode::Ask,
             ProgressCallback callback = nullptr) = 0;
+        virtual bool Unpack(const std::wstring& inputPath, const std::wstring& outputPath,
+            const UnpackOptions& options, ProgressCallback callback = nullptr) = 0;
+        virtual bool Update(const std::wstring& packagePath, const std::wstring& changesPath,
+            const PackOptions& options, ProgressCallback callback = nullptr) = 0;
+        // Packs the directory, then repacks it whenever its files change until the control is cancelled.
+        // The callback only reports the first build.
+        virtual bool Watch(const std::wstring& inputPath, const std::wstring& outputPath,
+            const WatchOptions& options, ProgressCallback callback = nullptr) = 0;
+        virtual bool Inspect(const std::wstring& packagePath, PackageInfo& info, bool readManifest = false) = 0;
+        virtual bool Verify(const std::wstring& packagePath, VerifyResult& result, ProgressCallback callback = nullptr) = 0;
+        virtual bool Diff(const std::wstring& oldPackage, const std::wstring& newPackage,
+            PackageDiff& diff, bool compareBlockMaps = false) = 0;
+        virtual bool CreateDelta(const std::wstring& oldPackage, const std::wstring& newPackage,
+            const std::wstring& patchPath, DeltaStats& stats, ProgressCallback callback = nullptr) = 0;
+        virtual bool ApplyDelta(const std::wstring& oldPackage, const std::wstring& patchPath,
+            const std::wstring& outputPath, ProgressCallback callback = nullptr) = 0;
         virtual bool Encrypt(const std::wstring& inputPath, const std::wstring& outputPath,
             const std::wstring& keyFile) = 0;
         virtual bool Decrypt(const std::wstring& inputPath, const std::wstring& outputPath,
             const std::wstring& keyFile) = 0;
+        // Pack, Unpack and Update check the control between entries; see AsyncOperation.h.
+        virtual void SetControl(std::shared_ptr<OperationControl> control) = 0;
+        virtual std::vector<OperationError> GetErrors() const = 0;
         virtual std::wstring GetLastError() const = 0;
     };
 
@@ -77,12 +201,51 @@ namespace MakeAppxCore {
         virtual bool Bundle(const std::wstring& inputPath, const std::wstring& outputPath,
             CompressionLevel compression = CompressionLevel::Normal,
             ProgressCallback callback = nullptr) = 0;
+        virtual bool Bundle(const std::wstring& inputPath, const std::wstring& outputPath,
+            const BundleOptions& options, ProgressCallback callback = nullptr) = 0;
         virtual bool Unbundle(const std::wstring& inputPath, const std::wstring& outputPath,
             OverwriteMode overwrite = OverwriteMode::Ask,
             ProgressCallback callback = nullptr) = 0;
+        virtual void SetControl(std::shared_ptr<OperationControl> control) = 0;
+        virtual std::vector<OperationError> GetErrors() const = 0;
+        virtual std::wstring GetLastError() const = 0;
+    };
+
+    // Fills buffer with up to size bytes of entry content and sets produced; producing 0 bytes ends the
+    // entry. Returning false fails the build.
+    using EntryReader = std::function<bool(uint8_t* buffer, size_t size, size_t& produced)>;
+    using PackageSink = std::function<bool(const uint8_t* data, size_t size)>;
+
+    // Builds a package from memory without touching the file system. Entries are written front to back
+    // in the order they were added and followed by a generated AppxBlockMap.xml.
+    class IPackageBuilder {
+    public:
+        virtual ~IPackageBuilder() = default;
+        // The data is borrowed and has to stay valid until Write returns.
+        virtual bool AddEntry(const std::wstring& name, const void* data, size_t size) = 0;
+        virtual bool AddEntry(const std::wstring& name, std::vector<uint8_t> data) = 0;
+        virtual bool AddEntry(const std::wstring& name, uint64_t size, EntryReader reader) = 0;
+        virtual bool Write(std::vector<uint8_t>& output) = 0;
+        virtual bool Write(const PackageSink& sink) = 0;
+        virtual std::wstring GetLastError() const = 0;
+    };
+
+    // Reads a package held in memory. The buffer is borrowed and has to outlive the reader and its streams.
+    class IPackageReader {
+    public:
+        virtual ~IPackageReader() = default;
+        virtual bool Open(const void* data, size_t size) = 0;
+        virtual const PackageInfo& Info() const = 0;
+        // Entry streams decompress on demand and are independent of each other. A stream whose data
+        // is corrupt or fails its CRC check sets badbit.
+        virtual std::unique_ptr<std::istream> OpenEntry(const std::wstring& name) = 0;
+        // Reads a whole entry of up to 256 MB; larger entries have to go through OpenEntry.
+        virtual bool ReadEntry(const std::wstring& name, std::string& data) = 0;
         virtual std::wstring GetLastError() const = 0;
     };
 
     std::unique_ptr<IAppxPackage> CreateAppxPackage();
     std::unique_ptr<IAppxBundle> CreateAppxBundle();
+    std::unique_ptr<IPackageBuilder> CreatePackageBuilder(CompressionLevel compression = CompressionLevel::Normal);
+    std::unique_ptr<IPackageReader> CreatePackageReader();
 }
\ No newline at end of file
@@ -1,19 +1,29 @@
-#define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING
 #include "AppxPackageImpl.h"
+#include "ZipDirectory.h"
+#include "PackageVerifier.h"
+#include "PackageDiff.h"
+#include "DeltaPatch.h"
+#include "ZipStream.h"
+#include "ContentTypes.h"
+#include "Crc32.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <algorithm>
-#include <Windows.h>
-#include <bcrypt.h>
-#include <ntstatus.h>
+#include <iterator>
 #include <random>
-#include <codecvt>
-#include <locale>
+#include <cstring>
 #include <chrono>
-
-#pragma comment(lib, "bcrypt.lib")
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 #ifndef ZIP_CM_DEFAULT
 #define ZIP_CM_DEFAULT -1
@@ -41,74 +51,444 @@ namespace MakeAppxCore {
         return std::make_unique<AppxBuilderImpl>();
     }
 
-    std::string WideToUtf8Safe(const std::wstring& wstr) {
-        if (wstr.empty()) return std::string();
+    std::string NormalizeEntryName(const std::string& name) {
+        std::string normalized = name;
+        std::replace(normalized.begin(), normalized.end(), '\\', '/');
+        std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        });
+        return normalized;
+    }
 
-        int size = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, nullptr, 0, nullptr, nullptr);
-        if (size <= 0) {
-            return std::string(wstr.begin(), wstr.end());
+    namespace {
+        constexpr size_t VOLUME_READ_SIZE = 256 * 1024;
+        constexpr size_t VOLUME_WORKER_MEMORY = FileWriter::BUFFER_SIZE + VOLUME_READ_SIZE + (1 << 15) + 8192;
+        constexpr std::chrono::milliseconds WATCH_WAKE_INTERVAL(250);
+
+        struct TempDirectoryGuard {
+            fs::path path;
+            ~TempDirectoryGuard() {
+                std::error_code ec;
+                if (!path.empty()) fs::remove_all(path, ec);
+            }
+        };
+
+        size_t SelectDuplicateGroups(const std::vector<size_t>& primaryOf, std::vector<bool>& selected) {
+            size_t duplicates = 0;
+            selected.assign(primaryOf.size(), false);
+            for (size_t i = 0; i < primaryOf.size(); ++i) {
+                if (primaryOf[i] != i) {
+                    selected[i] = selected[primaryOf[i]] = true;
+                    ++duplicates;
+                }
+            }
+            return duplicates;
         }
 
-        std::string result(size - 1, 0);
-        WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, &result[0], size, nullptr, nullptr);
-        return result;
-    }
+        // Decompresses one entry into an open writer and checks its size and CRC.
+        bool ExtractEntry(RandomAccessSource& source, const ZipDirectoryEntry& entry, uint64_t dataOffset,
+            const BufferPool::Lease& input, z_stream& stream, FileWriter& writer, std::wstring& error) {
+
+            bool deflated = entry.method == ZIP_METHOD_DEFLATE;
+            if (!deflated && entry.method != ZIP_METHOD_STORE) {
+                error = L"Unsupported compression method " + std::to_wstring(entry.method);
+                return false;
+            }
+            if (deflated) {
+                inflateReset(&stream);
+            }
+
+            uint64_t offset = dataOffset;
+            uint64_t remaining = entry.compressedSize;
+            uint64_t produced = 0;
+            uint32_t crc = 0;
+            int status = Z_OK;
+
+            while (remaining > 0) {
+                size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, input.Size()));
+                if (!source.ReadAt(offset, input.Data(), chunk)) {
+                    error = L"Failed to read entry data";
+                    return false;
+                }
+                offset += chunk;
+                remaining -= chunk;
+
+                if (!deflated) {
+                    crc = Crc32(crc, input.Data(), chunk);
+                    produced += chunk;
+                    if (!writer.Write(input.Data(), chunk)) {
+                        error = writer.GetLastError();
+                        return false;
+                    }
+                    continue;
+                }
 
-    std::wstring Utf8ToWideSafe(const std::string& str) {
-        if (str.empty()) return std::wstring();
+                stream.next_in = input.Data();
+                stream.avail_in = static_cast<uInt>(chunk);
+                do {
+                    size_t available = 0;
+                    uint8_t* buffer = writer.Buffer(available);
+                    if (!buffer) {
+                        error = writer.GetLastError();
+                        return false;
+                    }
+                    stream.next_out = buffer;
+                    stream.avail_out = static_cast<uInt>(available);
+                    status = inflate(&stream, Z_NO_FLUSH);
+                    if (status == Z_BUF_ERROR) break;
+                    if (status != Z_OK && status != Z_STREAM_END) {
+                        error = L"Corrupt compressed data";
+                        return false;
+                    }
+                    size_t inflated = available - stream.avail_out;
+                    crc = Crc32(crc, buffer, inflated);
+                    produced += inflated;
+                    if (!writer.Commit(inflated)) {
+                        error = writer.GetLastError();
+                        return false;
+                    }
+                } while (status != Z_STREAM_END && (stream.avail_in > 0 || stream.avail_out == 0));
+            }
 
-        int size = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, nullptr, 0);
-        if (size <= 0) {
-            return std::wstring(str.begin(), str.end());
+            if ((deflated && status != Z_STREAM_END) || produced != entry.uncompressedSize) {
+                error = L"Entry data is truncated";
+                return false;
+            }
+            if (crc != entry.crc32) {
+                error = L"CRC-32 mismatch";
+                return false;
+            }
+            return true;
         }
 
-        std::wstring result(size - 1, 0);
-        MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &result[0], size);
-        return result;
-    }
+        // libzip reads, compresses and writes the entries in zip_close, so the control is checked there too.
+        void WatchControl(zip_t* zip, OperationControl* control) {
+            if (!control) return;
+            zip_register_cancel_callback_with_state(zip, [](zip_t*, void* state) {
+                return static_cast<OperationControl*>(state)->Checkpoint() ? 0 : 1;
+            }, nullptr, control);
+        }
+
+        // Runs task(i) for every item on the shared scheduler. Tasks never wait on the control: while the
+        // operation is paused, tasks that have not started return at once, and the operation's own thread
+        // waits out the pause before handing the rest over again, so a paused operation holds no shared
+        // worker. A task returns false when it stopped early for the pause, and runs again afterwards.
+        // Returns false once the operation is cancelled.
+        bool RunPausable(TaskGroup& group, size_t count, OperationControl* control,
+            const std::function<uint64_t(size_t)>& weight,
+            const std::function<bool(size_t, const std::atomic<bool>&)>& task,
+            const std::function<void()>& report) {
+
+            std::vector<uint8_t> finished(count, 0);
+            std::atomic<bool> yield{ false };
+            while (true) {
+                yield = false;
+                for (size_t i = 0; i < count; ++i) {
+                    if (finished[i]) continue;
+                    group.Run([&, i]() {
+                        if (yield || (control && control->IsCancelled())) return;
+                        finished[i] = task(i, yield) ? 1 : 0;
+                    }, weight(i));
+                }
 
-    void AppxPackageImpl::SetError(const std::wstring& error) {
-        m_lastError = error;
-    }
+                while (!group.WaitFor(std::chrono::milliseconds(100))) {
+                    if (control && control->IsPaused()) yield = true;
+                    if (report) report();
+                }
 
-    std::wstring AppxPackageImpl::WideToUtf8(const std::wstring& wide) {
-        return Utf8ToWideSafe(WideToUtf8Safe(wide));
-    }
+                if (std::all_of(finished.begin(), finished.end(), [](uint8_t done) { return done != 0; })) return true;
+                if (control && !control->Checkpoint()) return false;
+            }
+        }
 
-    std::wstring AppxPackageImpl::Utf8ToWide(const std::string& utf8) {
-        return Utf8ToWideSafe(utf8);
-    }
+        // One directory of a parallel tree scan. Every subdirectory's listing goes where the subdirectory
+        // itself was listed, which is the order a recursive_directory_iterator walk gives.
+        struct ScannedDirectory {
+            std::vector<PackageFile> files;
+            std::vector<std::pair<size_t, std::unique_ptr<ScannedDirectory>>> children;
+        };
+
+        struct TreeScan {
+            fs::path root;
+            TaskGroup group{ TaskClass::Io };
+            std::mutex mutex;
+            std::string error;
+        };
+
+        // Subdirectories are scanned by tasks of their own, so a deep or wide tree on a slow disk or share
+        // is listed by many threads at once.
+        void ScanDirectory(TreeScan& scan, const fs::path& directory, ScannedDirectory& scanned) {
+            try {
+                for (const auto& entry : fs::directory_iterator(directory)) {
+                    if (entry.is_directory() && !entry.is_symlink()) {
+                        scanned.children.emplace_back(scanned.files.size(), std::make_unique<ScannedDirectory>());
+                        ScannedDirectory& child = *scanned.children.back().second;
+                        scan.group.Run([&scan, path = entry.path(), &child]() { ScanDirectory(scan, path, child); });
+                    }
+                    else if (entry.is_regular_file()) {
+                        PackageFile pf;
+                        pf.localPath = entry.path();
+                        pf.packagePath = PathToUtf8(entry.path().lexically_relative(scan.root));
+                        pf.size = entry.file_size();
+                        pf.attributes = static_cast<uint32_t>(entry.status().permissions());
+                        scanned.files.push_back(std::move(pf));
+                    }
+                }
+            }
+            catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(scan.mutex);
+                if (scan.error.empty()) {
+                    scan.error = e.what();
+                }
+            }
+        }
+
+        void FlattenDirectory(ScannedDirectory& scanned, std::vector<PackageFile>& files) {
+            size_t next = 0;
+            for (auto& child : scanned.children) {
+                std::move(scanned.files.begin() + next, scanned.files.begin() + child.first, std::back_inserter(files));
+                next = child.first;
+                FlattenDirectory(*child.second, files);
+            }
+            std::move(scanned.files.begin() + next, scanned.files.end(), std::back_inserter(files));
+        }
+
+        // What watch mode remembers of a source file to tell on the next scan whether it changed.
+        struct WatchedFile {
+            PackageFile file;
+            fs::file_time_type modified;
+        };
+
+        using WatchedTree = std::map<std::string, WatchedFile>;
+
+        // An entry kept in memory between rebuilds: its compressed data, CRC and block hashes.
+        struct WatchedEntry {
+            uint64_t size = 0;
+            fs::file_time_type modified;
+            CompressedEntry entry;
+            std::vector<uint8_t> data;
+        };
 
-    bool AppxPackageImpl::PromptUserOverwrite(const std::wstring& filePath) {
-        std::wcout << L"File exists: " << filePath << std::endl;
-        std::wcout << L"Overwrite? (y)es, (n)o, (a)ll, (s)kip all: ";
+        // Files that vanish while the tree is listed are left out; the change that removed them
+        // triggers another scan anyway.
+        bool ScanWatchedTree(const fs::path& root, const std::unordered_set<std::string>& ignored,
+            WatchedTree& tree, std::wstring& error) {
 
-        wchar_t response;
-        std::wcin >> response;
-        response = towlower(response);
+            tree.clear();
+            std::error_code ec;
+            fs::recursive_directory_iterator it(root, ec), end;
+            for (; !ec && it != end; it.increment(ec)) {
+                std::error_code statError;
+                if (!it->is_regular_file(statError)) continue;
 
-        switch (response) {
-        case L'y':
+                WatchedFile watched;
+                watched.file.localPath = it->path();
+                watched.file.packagePath = PathToUtf8(it->path().lexically_relative(root));
+                watched.file.size = it->file_size(statError);
+                watched.file.attributes = static_cast<uint32_t>(it->status(statError).permissions());
+                watched.modified = it->last_write_time(statError);
+                if (statError || ignored.count(NormalizeEntryName(watched.file.packagePath))) continue;
+
+                std::string name = watched.file.packagePath;
+                tree.emplace(std::move(name), std::move(watched));
+            }
+            if (ec) {
+                error = L"Error scanning " + FromPath(root) + L": " + Utf8ToWideSafe(ec.message());
+                return false;
+            }
             return true;
-        case L'n':
-            return false;
-        case L'a':
+        }
+
+        bool SameTree(const WatchedTree& a, const WatchedTree& b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+                [](const WatchedTree::value_type& x, const WatchedTree::value_type& y) {
+                    return x.first == y.first && x.second.file.size == y.second.file.size &&
+                        x.second.modified == y.second.modified;
+                });
+        }
+
+        bool CompressWatchedEntry(const PackageFile& file, int level, bool store, CompressedEntryCache* cache,
+            WatchedEntry& watched, std::wstring& error) {
+
+            std::vector<uint8_t>& data = watched.data;
+            data.clear();
+            if (cache) {
+                if (!cache->Lookup(file, level, watched.entry) && !cache->Store(file, level, watched.entry, error)) {
+                    return false;
+                }
+                std::ifstream cached(watched.entry.dataPath, std::ios::binary);
+                cached.seekg(static_cast<std::streamoff>(watched.entry.dataOffset));
+                data.resize(static_cast<size_t>(watched.entry.compressedSize));
+                cached.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+                if (static_cast<uint64_t>(cached.gcount()) != data.size()) {
+                    error = L"Failed to read cached entry";
+                    return false;
+                }
+                return true;
+            }
+
+            std::ifstream input(file.localPath, std::ios::binary);
+            if (!input.is_open()) {
+                error = L"Cannot open file: " + FromPath(file.localPath);
+                return false;
+            }
+            return EncodeEntry(input, level, store, [&data](const uint8_t* chunk, size_t size) {
+                data.insert(data.end(), chunk, chunk + size);
+                return true;
+            }, watched.entry, error);
+        }
+
+        // Compresses on as many threads as the buffer budget allows; the callback runs on the calling thread.
+        bool CompressWatchedEntries(const std::vector<const PackageFile*>& files, const std::vector<WatchedEntry*>& entries,
+            int level, bool store, CompressedEntryCache* cache, OperationControl* control, ProgressCallback callback,
+            std::string& failedEntry, std::wstring& error) {
+
+            ProgressInfo progress = {};
+            progress.totalFiles = files.size();
+            for (const auto* file : files) {
+                progress.totalBytes += file->size;
+            }
+
+            std::atomic<size_t> completedFiles{ 0 };
+            std::atomic<uint64_t> completedBytes{ 0 };
+            std::atomic<bool> failed{ false };
+            std::mutex mutex;
+
+            TaskGroup group(TaskClass::Cpu, BufferPool::Shared().WorkerCount(COMPRESS_WORKER_MEMORY,
+                TaskScheduler::Shared().ThreadCount(TaskClass::Cpu)));
+            bool finished = RunPausable(group, files.size(), control,
+                [&](size_t i) { return files[i]->size; },
+                [&](size_t i, const std::atomic<bool>&) {
+                    if (failed) return true;
+                    std::wstring entryError;
+                    if (CompressWatchedEntry(*files[i], level, store, cache, *entries[i], entryError)) {
+                        completedBytes += files[i]->size;
+                        ++completedFiles;
+                        return true;
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!failed.exchange(true)) {
+                        failedEntry = files[i]->packagePath;
+                        error = entryError;
+                    }
+                    return true;
+                },
+                [&]() {
+                    if (callback) {
+                        progress.processedFiles = std::min<size_t>(completedFiles, files.size() - 1);
+                        progress.processedBytes = completedBytes;
+                        callback(progress);
+                    }
+                });
+
+            if (!finished && !failed) {
+                error = L"Operation cancelled";
+                return false;
+            }
+
+            if (callback && !failed) {
+                progress.processedFiles = files.size();
+                progress.processedBytes = progress.totalBytes;
+                callback(progress);
+            }
+            return !failed;
+        }
+
+        // Writes the package next to its destination and moves it into place, so anything reading the
+        // package sees either the previous build or the new one.
+        bool PublishWatchedPackage(const fs::path& packagePath, const std::vector<PackageFile>& files,
+            const std::unordered_map<std::string, WatchedEntry>& entries, int level, bool store,
+            uint64_t& packageSize, std::wstring& error) {
+
+            fs::path tempPath = packagePath;
+            tempPath += ".watch.tmp";
+            std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+            if (!output.is_open()) {
+                error = L"Failed to create output package: " + FromPath(tempPath);
+                return false;
+            }
+
+            ZipStreamWriter writer(StreamSink([&output](const uint8_t* data, size_t size) {
+                output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+                return output.good();
+            }));
+            uint16_t method = store ? ZIP_METHOD_STORE : ZIP_METHOD_DEFLATE;
+            std::vector<BlockMapEntry> blockMapEntries;
+            bool written = true;
+
+            for (const auto& file : files) {
+                const WatchedEntry& watched = entries.at(file.packagePath);
+                const CompressedEntry& entry = watched.entry;
+                if (!writer.BeginEntry(file.packagePath, method, ToTimeT(watched.modified), entry.uncompressedSize) ||
+                    !writer.Write(watched.data.data(), watched.data.size()) ||
+                    !writer.EndEntry(entry.crc32, entry.uncompressedSize)) {
+                    written = false;
+                    break;
+                }
+
+                BlockMapEntry blockMapEntry;
+                blockMapEntry.name = file.packagePath;
+                blockMapEntry.size = entry.uncompressedSize;
+                blockMapEntry.lfhSize = ZipStreamWriter::LocalHeaderSize(file.packagePath, entry.uncompressedSize);
+                blockMapEntry.blocks = entry.blocks;
+                blockMapEntries.push_back(std::move(blockMapEntry));
+            }
+
+            if (written) {
+                std::istringstream blockMap(GenerateBlockMapXml(blockMapEntries));
+                CompressedEntry blockMapEntry;
+                std::wstring blockMapError;
+                auto sink = [&writer](const uint8_t* data, size_t size) {
+                    return writer.Write(data, size);
+                };
+                written = writer.BeginEntry(BLOCK_MAP_ENTRY_NAME, method, time(nullptr), blockMap.str().size()) &&
+                    EncodeEntry(blockMap, level, store, sink, blockMapEntry, blockMapError) &&
+                    writer.EndEntry(blockMapEntry.crc32, blockMapEntry.uncompressedSize) &&
+                    writer.Finish();
+            }
+
+            output.close();
+            std::error_code ec;
+            if (!written || output.fail()) {
+                error = !writer.GetLastError().empty() ? writer.GetLastError() :
+                    L"Failed to write output package: " + FromPath(tempPath);
+                fs::remove(tempPath, ec);
+                return false;
+            }
+
+            fs::rename(tempPath, packagePath, ec);
+            if (ec) {
+                error = L"Failed to replace " + FromPath(packagePath) + L": " + Utf8ToWideSafe(ec.message());
+                fs::remove(tempPath, ec);
+                return false;
+            }
+            packageSize = writer.Offset();
             return true;
-        case L's':
-            return false;
-        default:
-            std::wcout << L"Invalid response. Skipping file." << std::endl;
-            return false;
         }
     }
 
+    void AppxPackageImpl::SetError(const std::wstring& error) {
+        m_lastError = error;
+    }
+
+    void AppxPackageImpl::AddEntryError(const std::string& entry, const std::wstring& message) {
+        m_errors.push_back({ Utf8ToWideSafe(entry), message });
+    }
+
+    bool AppxPackageImpl::Cancelled() {
+        if (!m_control || m_control->Checkpoint()) return false;
+        SetError(L"Operation cancelled");
+        return true;
+    }
+
     bool AppxPackageImpl::ValidateManifest(const std::wstring& manifestPath) {
-        if (!fs::exists(manifestPath)) {
+        if (!fs::exists(ToPath(manifestPath))) {
             SetError(L"AppxManifest.xml not found");
             return false;
         }
 
-        std::ifstream file(manifestPath);
+        std::ifstream file{ ToPath(manifestPath) };
         if (!file.is_open()) {
             SetError(L"Cannot open AppxManifest.xml");
             return false;
@@ -127,41 +507,119 @@ namespace MakeAppxCore {
 
     bool AppxPackageImpl::ProcessFileTree(const std::wstring& rootPath,
         std::vector<PackageFile>& files) {
-        try {
-            for (const auto& entry : fs::recursive_directory_iterator(rootPath)) {
-                if (entry.is_regular_file()) {
-                    PackageFile pf;
-                    pf.localPath = entry.path().wstring();
-                    pf.packagePath = fs::relative(entry.path(), rootPath).wstring();
-                    pf.size = entry.file_size();
-                    pf.attributes = static_cast<uint32_t>(entry.status().permissions());
-                    files.push_back(pf);
-                }
+        TreeScan scan;
+        scan.root = ToPath(rootPath);
+        ScannedDirectory tree;
+        ScanDirectory(scan, scan.root, tree);
+        scan.group.Wait();
+
+        if (!scan.error.empty()) {
+            SetError(L"Error processing file tree: " + Utf8ToWideSafe(scan.error));
+            return false;
+        }
+        FlattenDirectory(tree, files);
+        return true;
+    }
+
+    bool AppxPackageImpl::CompressEntries(const std::vector<PackageFile>& files, const std::vector<size_t>& primaryOf,
+        CompressedEntryCache& cache, int level, std::vector<CompressedEntry>& entries,
+        ProgressInfo& progress, ProgressCallback callback) {
+
+        entries.assign(files.size(), CompressedEntry());
+
+        std::atomic<size_t> completedFiles{ 0 };
+        std::atomic<uint64_t> completedBytes{ 0 };
+        std::atomic<bool> failed{ false };
+        std::wstring firstError;
+        std::mutex errorMutex;
+
+        // One task per entry; duplicates are counted right away and copied from their primary afterwards.
+        std::vector<size_t> primaries;
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (!primaryOf.empty() && primaryOf[i] != i) {
+                completedBytes += files[i].size;
+                ++completedFiles;
+                continue;
             }
-            return true;
+            primaries.push_back(i);
         }
-        catch (const std::exception& e) {
-            std::wstring error = L"Error processing file tree: ";
-            error += Utf8ToWideSafe(e.what());
-            SetError(error);
+
+        TaskGroup group(TaskClass::Cpu, BufferPool::Shared().WorkerCount(COMPRESS_WORKER_MEMORY,
+            TaskScheduler::Shared().ThreadCount(TaskClass::Cpu)));
+        bool finished = RunPausable(group, primaries.size(), m_control.get(),
+            [&](size_t n) { return files[primaries[n]].size; },
+            [&](size_t n, const std::atomic<bool>&) {
+                size_t i = primaries[n];
+                if (failed) return true;
+
+                std::wstring error;
+                if (!cache.Lookup(files[i], level, entries[i]) &&
+                    !cache.Store(files[i], level, entries[i], error)) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!failed.exchange(true)) {
+                        firstError = error;
+                        AddEntryError(files[i].packagePath, error);
+                    }
+                    return true;
+                }
+                completedBytes += files[i].size;
+                ++completedFiles;
+                return true;
+            },
+            [&]() {
+                if (callback) {
+                    size_t done = completedFiles;
+                    progress.processedFiles = done < files.size() ? done : files.size() - 1;
+                    progress.processedBytes = completedBytes;
+                    progress.currentFile = done < files.size() ? Utf8ToWideSafe(files[done].packagePath) : L"";
+                    callback(progress);
+                }
+            });
+
+        if (failed) {
+            SetError(firstError);
+            return false;
+        }
+        if (!finished) {
+            SetError(L"Operation cancelled");
             return false;
         }
+
+        for (size_t i = 0; i < primaryOf.size(); ++i) {
+            if (primaryOf[i] != i) {
+                entries[i] = entries[primaryOf[i]];
+            }
+        }
+
+        return true;
     }
 
     bool AppxPackageImpl::Pack(const std::wstring& inputPath, const std::wstring& outputPath,
         CompressionLevel compression, ProgressCallback callback) {
 
-        if (!fs::exists(inputPath) || !fs::is_directory(inputPath)) {
+        PackOptions options;
+        options.compression = compression;
+        return Pack(inputPath, outputPath, options, callback);
+    }
+
+    bool AppxPackageImpl::Pack(const std::wstring& inputPath, const std::wstring& outputPath,
+        const PackOptions& options, ProgressCallback callback) {
+
+        m_errors.clear();
+
+        CompressionLevel compression = options.compression;
+
+        if (!fs::exists(ToPath(inputPath)) || !fs::is_directory(ToPath(inputPath))) {
             SetError(L"Input path does not exist or is not a directory");
             return false;
         }
 
-        std::wstring manifestPath = inputPath + L"\\AppxManifest.xml";
+        std::wstring manifestPath = FromPath(ToPath(inputPath) / L"AppxManifest.xml");
         if (!ValidateManifest(manifestPath)) {
             return false;
         }
 
-        fs::path outputDir = fs::path(outputPath).parent_path();
+        fs::path outputDir = ToPath(outputPath).parent_path();
         if (!outputDir.empty() && !fs::exists(outputDir)) {
             try {
                 fs::create_directories(outputDir);
@@ -172,6 +630,16 @@ namespace MakeAppxCore {
             }
         }
 
+        if (options.volumeSize > 0 && (outputPath == L"-" || options.resume)) {
+            SetError(L"Split packages cannot be streamed or resumed");
+            return false;
+        }
+        // The streamed writer lays out every local header itself, so its block map can state their sizes
+        // exactly; cached packs, which always carry a block map, are written by it for that reason.
+        if (outputPath == L"-" || options.resume || options.volumeSize > 0 || !options.cacheDirectory.empty()) {
+            return PackToStream(inputPath, outputPath, options, callback);
+        }
+
         std::vector<PackageFile> files;
         if (!ProcessFileTree(inputPath, files)) {
             return false;
@@ -182,6 +650,22 @@ namespace MakeAppxCore {
             return false;
         }
 
+        std::vector<ContentGroup> contentGroups;
+        if (!options.contentGroupMap.empty()) {
+            std::wstring cgmError;
+            if (!ReadContentGroupMap(options.contentGroupMap, contentGroups, cgmError)) {
+                SetError(cgmError);
+                return false;
+            }
+
+            size_t ungrouped = OrderFilesByContentGroups(files, contentGroups);
+            std::wcout << L"Layout follows " << contentGroups.size() << L" content groups";
+            if (ungrouped > 0) {
+                std::wcout << L" (" << ungrouped << L" files not in any group are placed last)";
+            }
+            std::wcout << std::endl;
+        }
+
         uint64_t totalSize = 0;
         for (const auto& file : files) {
             totalSize += file.size;
@@ -224,57 +708,118 @@ namespace MakeAppxCore {
             break;
         }
 
+        int compressionLevel = ZlibLevelFor(compression);
+
         ProgressInfo progress = {};
         progress.totalFiles = files.size();
         progress.totalBytes = totalSize;
 
+        std::vector<size_t> primaryOf;
+        std::vector<bool> precompressed(files.size());
+        size_t duplicateCount = 0;
+
+        if (compressionMethod == ZIP_CM_DEFLATE) {
+            std::wstring dedupError;
+            if (!FindDuplicateFiles(files, primaryOf, dedupError)) {
+                SetError(dedupError);
+                zip_discard(zip);
+                return false;
+            }
+
+            duplicateCount = SelectDuplicateGroups(primaryOf, precompressed);
+        }
+
+        std::vector<CompressedEntry> compressedEntries(files.size());
+        TempDirectoryGuard dedupCacheGuard;
+
+        if (duplicateCount > 0) {
+            std::vector<PackageFile> groupFiles;
+            std::vector<size_t> groupIndex(files.size());
+            std::vector<size_t> groupPrimaryOf;
+            for (size_t i = 0; i < files.size(); ++i) {
+                if (precompressed[i]) {
+                    groupIndex[i] = groupFiles.size();
+                    groupPrimaryOf.push_back(groupIndex[primaryOf[i]]);
+                    groupFiles.push_back(files[i]);
+                }
+            }
+
+            dedupCacheGuard.path = ToPath(outputPath + L".dedup");
+            CompressedEntryCache cache(dedupCacheGuard.path);
+            std::vector<CompressedEntry> groupEntries;
+            std::wstring cacheError;
+            if (!cache.Open(cacheError) ||
+                !CompressEntries(groupFiles, groupPrimaryOf, cache, compressionLevel, groupEntries, progress, nullptr)) {
+                if (!cacheError.empty()) SetError(cacheError);
+                zip_discard(zip);
+                return false;
+            }
+
+            for (size_t i = 0; i < files.size(); ++i) {
+                if (precompressed[i]) {
+                    compressedEntries[i] = std::move(groupEntries[groupIndex[i]]);
+                }
+            }
+        }
+
+        if (duplicateCount > 0) {
+            std::wcout << L"Deduplicated " << duplicateCount << L" files with identical content" << std::endl;
+        }
+
         uint64_t processedBytes = 0;
         bool success = true;
 
         for (size_t i = 0; i < files.size() && success; ++i) {
             const auto& file = files[i];
 
+            if (Cancelled()) {
+                success = false;
+                break;
+            }
+
             if (callback) {
                 progress.processedFiles = i;
                 progress.processedBytes = processedBytes;
-                progress.currentFile = file.packagePath;
+                progress.currentFile = Utf8ToWideSafe(file.packagePath);
                 callback(progress);
             }
 
-            std::string packagePathUtf8 = WideToUtf8Safe(file.packagePath);
-            std::string localPathUtf8 = WideToUtf8Safe(file.localPath);
-
-            if (packagePathUtf8.empty() || localPathUtf8.empty()) {
-                SetError(L"Failed to convert file paths to UTF-8: " + file.packagePath);
-                success = false;
-                break;
+            zip_source_t* source = nullptr;
+            if (precompressed[i]) {
+                std::error_code ec;
+                time_t modifiedTime = ToTimeT(fs::last_write_time(file.localPath, ec));
+                source = CreateCompressedEntrySource(zip, compressedEntries[i], ec ? time(nullptr) : modifiedTime);
+            }
+            else {
+                source = zip_source_file(zip, PathToUtf8(file.localPath).c_str(), 0, -1);
             }
-
-            zip_source_t* source = zip_source_file(zip, localPathUtf8.c_str(), 0, -1);
             if (!source) {
                 zip_error_t* zip_err = zip_get_error(zip);
-                std::wstring error_msg = L"Failed to create source for file: " + file.packagePath;
+                std::wstring error_msg = L"Failed to create source for file: " + Utf8ToWideSafe(file.packagePath);
                 if (zip_err) {
                     error_msg += L" (ZIP error: " + Utf8ToWideSafe(zip_error_strerror(zip_err)) + L")";
                 }
                 SetError(error_msg);
+                AddEntryError(file.packagePath, error_msg);
                 success = false;
                 break;
             }
 
-            zip_int64_t index = zip_file_add(zip, packagePathUtf8.c_str(), source, ZIP_FL_OVERWRITE);
+            zip_int64_t index = zip_file_add(zip, file.packagePath.c_str(), source, ZIP_FL_OVERWRITE);
             if (index < 0) {
+                zip_source_free(source);
                 zip_error_t* zip_err = zip_get_error(zip);
-                std::wstring error_msg = L"Failed to add file to package: " + file.packagePath;
+                std::wstring error_msg = L"Failed to add file to package: " + Utf8ToWideSafe(file.packagePath);
                 if (zip_err) {
                     error_msg += L" (ZIP error: " + Utf8ToWideSafe(zip_error_strerror(zip_err)) + L")";
                 }
                 SetError(error_msg);
+                AddEntryError(file.packagePath, error_msg);
                 success = false;
                 break;
             }
 
-            if (zip_set_file_compression(zip, index, compressionMethod, 0) != 0) {
+            if (zip_set_file_compression(zip, index, compressionMethod, compressionLevel) != 0) {
             }
 
             processedBytes += file.size;
@@ -305,12 +850,16 @@ namespace MakeAppxCore {
             std::wcout << L"Finalizing package..." << std::endl;
         }
 
+        WatchControl(zip, m_control.get());
         auto start_time = std::chrono::steady_clock::now();
         int close_result = zip_close(zip);
         auto end_time = std::chrono::steady_clock::now();
 
         if (close_result != 0) {
-            SetError(L"Failed to finalize package - ZIP close operation failed");
+            zip_discard(zip);
+            if (!Cancelled()) {
+                SetError(L"Failed to finalize package - ZIP close operation failed");
+            }
             return false;
         }
 
@@ -319,13 +868,13 @@ namespace MakeAppxCore {
             std::wcout << L"Finalization completed in " << duration.count() << L" seconds." << std::endl;
         }
 
-        if (!fs::exists(outputPath)) {
+        if (!fs::exists(ToPath(outputPath))) {
             SetError(L"Output package file was not created");
             return false;
         }
 
         try {
-            auto fileSize = fs::file_size(outputPath);
+            auto fileSize = fs::file_size(ToPath(outputPath));
             if (fileSize == 0) {
                 SetError(L"Output package file is empty");
                 return false;
@@ -334,6 +883,16 @@ namespace MakeAppxCore {
             std::wcout << L"Package created successfully!" << std::endl;
             std::wcout << L"Final size: " << (fileSize / (1024 * 1024)) << L" MB" << std::endl;
 
+            if (!contentGroups.empty()) {
+                std::wstring indexPath = outputPath + L".groups.json";
+                std::wstring indexError;
+                if (!WriteContentGroupIndex(outputPath, indexPath, contentGroups, indexError)) {
+                    SetError(indexError);
+                    return false;
+                }
+                std::wcout << L"Content group index: " << indexPath << std::endl;
+            }
+
         }
         catch (const std::exception& e) {
             SetError(L"Failed to verify output package: " + Utf8ToWideSafe(e.what()));
@@ -343,125 +902,1408 @@ namespace MakeAppxCore {
         return true;
     }
 
-    bool AppxPackageImpl::Unpack(const std::wstring& inputPath, const std::wstring& outputPath,
-        OverwriteMode overwrite, ProgressCallback callback) {
+    // Keeps the entries a previous resumable run finished, as long as their sources are unchanged and the
+    // package still holds them intact, and cuts the package back to the end of the last one kept.
+    bool AppxPackageImpl::RecoverPartialPackage(const fs::path& packagePath, const std::vector<PackageFile>& files,
+        int zlibLevel, PackJournal& journal, std::vector<JournalEntry>& recovered) {
 
-        std::string inputPathUtf8 = WideToUtf8Safe(inputPath);
-        if (inputPathUtf8.empty()) {
-            SetError(L"Failed to convert input path to UTF-8");
+        recovered.clear();
+        std::error_code ec;
+        if (fs::exists(packagePath, ec) && journal.Load(zlibLevel, recovered)) {
+            std::unordered_map<std::string, const PackageFile*> sources;
+            for (const auto& file : files) {
+                sources.emplace(file.packagePath, &file);
+            }
+
+            FileSource source(packagePath);
+            uint64_t expectedOffset = 0;
+            size_t kept = 0;
+            for (; kept < recovered.size(); ++kept) {
+                const JournalEntry& entry = recovered[kept];
+                auto found = sources.find(entry.directory.name);
+                if (found == sources.end() || found->second->size != entry.directory.uncompressedSize ||
+                    entry.directory.localHeaderOffset != expectedOffset) {
+                    break;
+                }
+                time_t modifiedTime = ToTimeT(fs::last_write_time(found->second->localPath, ec));
+                if (ec || modifiedTime != entry.sourceModified || !VerifyStreamedEntry(source, entry.directory, false)) {
+                    break;
+                }
+                expectedOffset = entry.directory.recordEnd;
+            }
+
+            // Only the last entry can have been cut short by the interruption, so its data is checked in full.
+            while (kept > 0 && !VerifyStreamedEntry(source, recovered[kept - 1].directory, true)) {
+                --kept;
+            }
+            recovered.resize(kept);
+        }
+
+        if (!recovered.empty()) {
+            fs::resize_file(packagePath, recovered.back().directory.recordEnd, ec);
+            if (ec) {
+                SetError(L"Cannot truncate partial package: " + Utf8ToWideSafe(ec.message()));
+                return false;
+            }
+        }
+
+        if (!journal.Start(zlibLevel, recovered)) {
+            SetError(L"Cannot write pack journal: " + FromPath(journal.Path()));
             return false;
         }
+        return true;
+    }
 
-        zip_t* zip = zip_open(inputPathUtf8.c_str(), ZIP_RDONLY, nullptr);
-        if (!zip) {
-            SetError(L"Failed to open package file");
+    bool AppxPackageImpl::PackToStream(const std::wstring& inputPath, const std::wstring& outputPath,
+        const PackOptions& options, ProgressCallback callback) {
+
+        bool toFile = outputPath != L"-";
+        std::wostream& log = toFile ? std::wcout : std::wcerr;
+
+        std::vector<PackageFile> files;
+        if (!ProcessFileTree(inputPath, files)) {
             return false;
         }
 
-        struct ZipGuard {
-            zip_t* zip;
-            ZipGuard(zip_t* z) : zip(z) {}
-            ~ZipGuard() {
-                if (zip) zip_close(zip);
+        files.erase(std::remove_if(files.begin(), files.end(), [](const PackageFile& file) {
+            return NormalizeEntryName(file.packagePath) == "appxblockmap.xml";
+        }), files.end());
+
+        if (files.empty()) {
+            SetError(L"No files found to package");
+            return false;
+        }
+
+        std::vector<ContentGroup> contentGroups;
+        if (!options.contentGroupMap.empty()) {
+            std::wstring cgmError;
+            if (!ReadContentGroupMap(options.contentGroupMap, contentGroups, cgmError)) {
+                SetError(cgmError);
+                return false;
             }
-        } zipGuard(zip);
 
-        if (!fs::exists(outputPath)) {
-            try {
-                fs::create_directories(outputPath);
+            size_t ungrouped = OrderFilesByContentGroups(files, contentGroups);
+            log << L"Layout follows " << contentGroups.size() << L" content groups";
+            if (ungrouped > 0) {
+                log << L" (" << ungrouped << L" files not in any group are placed last)";
             }
-            catch (const std::exception& e) {
-                SetError(L"Failed to create output directory: " + Utf8ToWideSafe(e.what()));
-                return false;
+            if (!toFile) {
+                log << L"; no group index is written for streamed packages";
+            }
+            else if (options.volumeSize > 0) {
+                log << L"; no group index is written for split packages";
             }
+            log << std::endl;
         }
 
-        zip_int64_t numEntries = zip_get_num_entries(zip, 0);
-        if (numEntries < 0) {
-            SetError(L"Failed to get package contents");
-            return false;
+        uint64_t totalSize = 0;
+        for (const auto& file : files) {
+            totalSize += file.size;
         }
 
-        ProgressInfo progress = {};
-        progress.totalFiles = static_cast<uint64_t>(numEntries);
-        progress.totalBytes = 0;
-
-        for (zip_int64_t i = 0; i < numEntries; ++i) {
-            const char* name = zip_get_name(zip, i, 0);
-            if (!name) continue;
+        CompressionLevel compression = options.compression;
+        if (totalSize > (10ULL * 1024 * 1024 * 1024) && compression != CompressionLevel::None) {
+            log << L"Warning: Large package detected (" << (totalSize / (1024 * 1024 * 1024))
+                << L" GB). Using no compression to avoid hanging." << std::endl;
+            compression = CompressionLevel::None;
+        }
 
-            std::wstring fileName = Utf8ToWideSafe(name);
-            std::wstring fullPath = outputPath + L"\\" + fileName;
+        bool store = compression == CompressionLevel::None;
+        int compressionLevel = ZlibLevelFor(compression);
+        uint16_t method = store ? ZIP_METHOD_STORE : ZIP_METHOD_DEFLATE;
 
-            if (callback) {
-                progress.processedFiles = static_cast<uint64_t>(i);
-                progress.currentFile = fileName;
-                callback(progress);
+        std::unique_ptr<PackJournal> journal;
+        std::vector<JournalEntry> recovered;
+        if (options.resume) {
+            journal = std::make_unique<PackJournal>(ToPath(outputPath));
+            if (!RecoverPartialPackage(ToPath(outputPath), files, compressionLevel, *journal, recovered)) {
+                return false;
             }
 
-            if (fs::exists(fullPath)) {
-                if (overwrite == OverwriteMode::No) continue;
-                if (overwrite == OverwriteMode::Ask) {
-                    if (!PromptUserOverwrite(fileName)) {
-                        continue;
-                    }
+            if (!recovered.empty()) {
+                std::unordered_set<std::string> written;
+                for (const auto& entry : recovered) {
+                    written.insert(entry.directory.name);
                 }
-            }
+                files.erase(std::remove_if(files.begin(), files.end(), [&written](const PackageFile& file) {
+                    return written.count(file.packagePath) > 0;
+                }), files.end());
 
-            fs::path filePath(fullPath);
-            if (filePath.has_parent_path()) {
-                try {
-                    fs::create_directories(filePath.parent_path());
-                }
-                catch (...) {
-                    continue;
+                totalSize = 0;
+                for (const auto& file : files) {
+                    totalSize += file.size;
                 }
+                log << L"Resuming after " << recovered.size() << L" entries ("
+                    << (recovered.back().directory.recordEnd / (1024 * 1024)) << L" MB) already written" << std::endl;
             }
+        }
 
-            zip_file_t* zipFile = zip_fopen_index(zip, i, 0);
-            if (!zipFile) continue;
-
-            std::ofstream outFile(fullPath, std::ios::binary);
-            if (!outFile.is_open()) {
+        ProgressInfo progress = {};
+        progress.totalFiles = files.size();
+        progress.totalBytes = totalSize;
+
+        bool useCache = !options.cacheDirectory.empty() && !store;
+        std::vector<CompressedEntry> cachedEntries;
+        if (useCache) {
+            CompressedEntryCache cache(ToPath(options.cacheDirectory));
+            std::vector<size_t> primaryOf;
+            std::wstring cacheError;
+            if (!cache.Open(cacheError) || !FindDuplicateFiles(files, primaryOf, cacheError)) {
+                SetError(cacheError);
+                return false;
+            }
+            if (!CompressEntries(files, primaryOf, cache, compressionLevel, cachedEntries, progress, callback)) {
+                return false;
+            }
+
+            log << L"Entry cache: " << cache.GetHits() << L" reused, "
+                << cache.GetMisses() << L" compressed" << std::endl;
+        }
+
+        std::ofstream packageFile;
+        std::unique_ptr<VolumeWriter> volumes;
+        std::unique_ptr<ZipStreamWriter> streamWriter;
+        if (options.volumeSize > 0) {
+            volumes = std::make_unique<VolumeWriter>(ToPath(outputPath), options.volumeSize);
+            streamWriter = std::make_unique<ZipStreamWriter>(StreamSink([&volumes](const uint8_t* data, size_t size) {
+                return volumes->Write(data, size);
+            }));
+        }
+        else if (toFile) {
+            packageFile.open(ToPath(outputPath), std::ios::binary | (recovered.empty() ? std::ios::trunc : std::ios::app));
+            if (!packageFile.is_open()) {
+                SetError(L"Failed to create output package: " + outputPath);
+                return false;
+            }
+            streamWriter = std::make_unique<ZipStreamWriter>(StreamSink([&packageFile](const uint8_t* data, size_t size) {
+                packageFile.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+                return packageFile.good();
+            }));
+        }
+        else {
+            streamWriter = std::make_unique<ZipStreamWriter>(OpenStandardOutput());
+        }
+        ZipStreamWriter& writer = *streamWriter;
+        auto streamError = [&volumes, &writer]() {
+            return volumes && !volumes->GetLastError().empty() ? volumes->GetLastError() : writer.GetLastError();
+        };
+
+        auto sink = [&writer](const uint8_t* data, size_t size) {
+            return writer.Write(data, size);
+        };
+
+        BufferPool::Lease copyBuffer;
+        if (useCache) {
+            copyBuffer = BufferPool::Shared().Acquire(BLOCK_MAP_BLOCK_SIZE);
+        }
+
+        std::vector<BlockMapEntry> blockMapEntries;
+        uint64_t processedBytes = 0;
+
+        if (!recovered.empty()) {
+            std::vector<ZipDirectoryEntry> writtenEntries;
+            for (auto& entry : recovered) {
+                BlockMapEntry blockMapEntry;
+                blockMapEntry.name = entry.directory.name;
+                blockMapEntry.size = entry.directory.uncompressedSize;
+                blockMapEntry.lfhSize = ZipStreamWriter::LocalHeaderSize(entry.directory.name, entry.directory.uncompressedSize);
+                blockMapEntry.blocks = std::move(entry.blocks);
+                blockMapEntries.push_back(std::move(blockMapEntry));
+                writtenEntries.push_back(std::move(entry.directory));
+            }
+            uint64_t resumeOffset = writtenEntries.back().recordEnd;
+            writer.Resume(resumeOffset, std::move(writtenEntries));
+        }
+
+        for (size_t i = 0; i < files.size(); ++i) {
+            const auto& file = files[i];
+
+            if (Cancelled()) {
+                return false;
+            }
+
+            if (callback && !useCache) {
+                progress.processedFiles = i;
+                progress.processedBytes = processedBytes;
+                progress.currentFile = Utf8ToWideSafe(file.packagePath);
+                callback(progress);
+            }
+
+            std::error_code ec;
+            time_t modifiedTime = ToTimeT(fs::last_write_time(file.localPath, ec));
+            if (!writer.BeginEntry(file.packagePath, method, ec ? time(nullptr) : modifiedTime, file.size)) {
+                SetError(streamError());
+                return false;
+            }
+
+            CompressedEntry entry;
+            std::wstring encodeError;
+            if (useCache) {
+                entry = cachedEntries[i];
+                std::ifstream data(entry.dataPath, std::ios::binary);
+                data.seekg(static_cast<std::streamoff>(entry.dataOffset));
+                uint64_t remaining = entry.compressedSize;
+                while (remaining > 0 && data.good()) {
+                    size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, copyBuffer.Size()));
+                    data.read(reinterpret_cast<char*>(copyBuffer.Data()), chunk);
+                    if (static_cast<size_t>(data.gcount()) != chunk || !writer.Write(copyBuffer.Data(), chunk)) break;
+                    remaining -= chunk;
+                }
+                if (remaining > 0) {
+                    encodeError = L"Failed to copy cached entry: " + Utf8ToWideSafe(file.packagePath);
+                }
+            }
+            else {
+                std::ifstream input(file.localPath, std::ios::binary);
+                if (!input.is_open()) {
+                    encodeError = L"Cannot open file: " + FromPath(file.localPath);
+                }
+                else if (!EncodeEntry(input, compressionLevel, store, sink, entry, encodeError)) {
+                    encodeError += L": " + Utf8ToWideSafe(file.packagePath);
+                }
+            }
+
+            if (!encodeError.empty() || !writer.EndEntry(entry.crc32, entry.uncompressedSize)) {
+                SetError(!writer.GetLastError().empty() ? streamError() : encodeError);
+                return false;
+            }
+
+            // The entry is journaled only once its bytes have left this process, so a restart never trusts
+            // data that was still sitting in a buffer.
+            if (journal) {
+                JournalEntry journalEntry;
+                journalEntry.directory = writer.LastEntry();
+                journalEntry.sourceModified = ec ? 0 : modifiedTime;
+                journalEntry.blocks = entry.blocks;
+                if (!packageFile.flush() || !journal->Append(journalEntry)) {
+                    SetError(L"Failed to record progress in " + FromPath(journal->Path()));
+                    return false;
+                }
+            }
+
+            BlockMapEntry blockMapEntry;
+            blockMapEntry.name = file.packagePath;
+            blockMapEntry.size = entry.uncompressedSize;
+            blockMapEntry.lfhSize = ZipStreamWriter::LocalHeaderSize(file.packagePath, file.size);
+            blockMapEntry.blocks = std::move(entry.blocks);
+            blockMapEntries.push_back(std::move(blockMapEntry));
+
+            processedBytes += file.size;
+        }
+
+        std::istringstream blockMap(GenerateBlockMapXml(blockMapEntries));
+        uint64_t blockMapSize = blockMap.str().size();
+        CompressedEntry blockMapEntry;
+        std::wstring blockMapError;
+        if (!writer.BeginEntry(BLOCK_MAP_ENTRY_NAME, method, time(nullptr), blockMapSize) ||
+            !EncodeEntry(blockMap, compressionLevel, store, sink, blockMapEntry, blockMapError) ||
+            !writer.EndEntry(blockMapEntry.crc32, blockMapEntry.uncompressedSize) ||
+            !writer.Finish()) {
+            SetError(!writer.GetLastError().empty() ? streamError() : L"Failed to add AppxBlockMap.xml");
+            return false;
+        }
+
+        if (callback) {
+            progress.processedFiles = files.size();
+            progress.processedBytes = processedBytes;
+            progress.currentFile = L"";
+            callback(progress);
+        }
+
+        if (!toFile) {
+            std::wcerr << L"Streamed " << files.size() + 1 << L" entries, "
+                << (writer.Offset() / (1024 * 1024)) << L" MB written" << std::endl;
+            return true;
+        }
+
+        if (volumes) {
+            if (!volumes->Close()) {
+                SetError(volumes->GetLastError());
+                return false;
+            }
+            std::wcout << L"Package created successfully!" << std::endl;
+            std::wcout << L"Final size: " << (writer.Offset() / (1024 * 1024)) << L" MB in "
+                << volumes->VolumeCount() << L" volumes" << std::endl;
+            return true;
+        }
+
+        packageFile.close();
+        if (packageFile.fail()) {
+            SetError(L"Failed to finalize package: " + outputPath);
+            return false;
+        }
+        if (journal) {
+            journal->Remove();
+        }
+
+        std::wcout << L"Package created successfully!" << std::endl;
+        std::wcout << L"Final size: " << (writer.Offset() / (1024 * 1024)) << L" MB" << std::endl;
+
+        if (!contentGroups.empty()) {
+            std::wstring indexPath = outputPath + L".groups.json";
+            std::wstring indexError;
+            if (!WriteContentGroupIndex(outputPath, indexPath, contentGroups, indexError)) {
+                SetError(indexError);
+                return false;
+            }
+            std::wcout << L"Content group index: " << indexPath << std::endl;
+        }
+        return true;
+    }
+
+    bool AppxPackageImpl::BuildUnpackFilter(const UnpackOptions& options, PathMatcher& include, PathMatcher& exclude) {
+        for (const auto& pattern : options.includePatterns) {
+            include.AddPattern(WideToUtf8Safe(pattern));
+        }
+        for (const auto& pattern : options.excludePatterns) {
+            exclude.AddPattern(WideToUtf8Safe(pattern));
+        }
+
+        if (!options.listFile.empty()) {
+            std::ifstream listFile(ToPath(options.listFile), std::ios::binary);
+            if (!listFile.is_open()) {
+                SetError(L"Cannot open list file: " + options.listFile);
+                return false;
+            }
+
+            std::string line;
+            size_t listed = 0;
+            bool firstLine = true;
+            while (std::getline(listFile, line)) {
+                if (firstLine && line.compare(0, 3, "\xEF\xBB\xBF") == 0) line.erase(0, 3);
+                firstLine = false;
+                while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) line.pop_back();
+                size_t start = line.find_first_not_of(" \t");
+                if (start == std::string::npos || line[start] == '#') continue;
+
+                include.AddPattern(line.substr(start), true);
+                ++listed;
+            }
+
+            if (listed == 0) {
+                SetError(L"List file contains no entries: " + options.listFile);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool AppxPackageImpl::Unpack(const std::wstring& inputPath, const std::wstring& outputPath,
+        OverwriteMode overwrite, ProgressCallback callback) {
+
+        UnpackOptions options;
+        options.overwrite = overwrite;
+        return Unpack(inputPath, outputPath, options, callback);
+    }
+
+    bool AppxPackageImpl::Unpack(const std::wstring& inputPath, const std::wstring& outputPath,
+        const UnpackOptions& options, ProgressCallback callback) {
+
+        m_errors.clear();
+
+        PathMatcher include;
+        PathMatcher exclude;
+        if (!BuildUnpackFilter(options, include, exclude)) {
+            return false;
+        }
+
+        if (inputPath == L"-") {
+            return UnpackFromStream(outputPath, options, include, exclude, callback);
+        }
+
+        std::vector<fs::path> volumes;
+        if (FindVolumes(ToPath(inputPath), volumes)) {
+            return UnpackVolumes(volumes, outputPath, options, include, exclude, callback);
+        }
+
+        std::string inputPathUtf8 = WideToUtf8Safe(inputPath);
+        if (inputPathUtf8.empty()) {
+            SetError(L"Failed to convert input path to UTF-8");
+            return false;
+        }
+
+        zip_t* zip = zip_open(inputPathUtf8.c_str(), ZIP_RDONLY, nullptr);
+        if (!zip) {
+            SetError(L"Failed to open package file");
+            return false;
+        }
+
+        struct ZipGuard {
+            zip_t* zip;
+            ZipGuard(zip_t* z) : zip(z) {}
+            ~ZipGuard() {
+                if (zip) zip_close(zip);
+            }
+        } zipGuard(zip);
+
+        zip_int64_t numEntries = zip_get_num_entries(zip, 0);
+        if (numEntries < 0) {
+            SetError(L"Failed to get package contents");
+            return false;
+        }
+
+        ExtractionPlan plan{ ToPath(outputPath) };
+        for (zip_int64_t i = 0; i < numEntries; ++i) {
+            const char* name = zip_get_name(zip, i, 0);
+            if (!name) continue;
+            if (!include.Empty() && !include.Match(name)) continue;
+            if (exclude.Match(name)) continue;
+
+            zip_stat_t stat;
+            zip_stat_init(&stat);
+            uint64_t size = zip_stat_index(zip, i, 0, &stat) == 0 && (stat.valid & ZIP_STAT_SIZE) ? stat.size : 0;
+            if (!plan.Add(static_cast<size_t>(i), name, size)) {
+                AddEntryError(name, plan.GetLastError());
+            }
+        }
+
+        if (!plan.Prepare(options.overwrite)) {
+            SetError(plan.GetLastError());
+            return false;
+        }
+
+        const std::vector<PlannedFile>& planned = plan.Files();
+        FileWriter writer;
+        ProgressInfo progress = {};
+        progress.totalFiles = static_cast<uint64_t>(planned.size());
+        progress.totalBytes = 0;
+
+        for (size_t fileIndex = 0; fileIndex < planned.size(); ++fileIndex) {
+            const PlannedFile& file = planned[fileIndex];
+
+            if (Cancelled()) {
+                return false;
+            }
+
+            if (callback) {
+                progress.processedFiles = static_cast<uint64_t>(fileIndex);
+                progress.currentFile = Utf8ToWideSafe(file.name);
+                callback(progress);
+            }
+
+            if (!file.write) continue;
+
+            zip_file_t* zipFile = zip_fopen_index(zip, static_cast<zip_int64_t>(file.entry), 0);
+            if (!zipFile) {
+                AddEntryError(file.name, L"Failed to open entry: " + Utf8ToWideSafe(zip_strerror(zip)));
+                continue;
+            }
+
+            bool directIo = options.directIo && file.size >= FileWriter::DIRECT_IO_THRESHOLD;
+            if (!writer.Open(file.path, file.size, directIo)) {
+                AddEntryError(file.name, writer.GetLastError());
                 zip_fclose(zipFile);
                 continue;
             }
 
-            char buffer[BUFFER_SIZE];
-            zip_int64_t bytesRead;
-            while ((bytesRead = zip_fread(zipFile, buffer, BUFFER_SIZE)) > 0) {
-                outFile.write(buffer, bytesRead);
+            size_t available = 0;
+            uint8_t* buffer;
+            zip_int64_t bytesRead = 0;
+            while ((buffer = writer.Buffer(available)) != nullptr &&
+                (bytesRead = zip_fread(zipFile, buffer, available)) > 0) {
+                writer.Commit(static_cast<size_t>(bytesRead));
                 progress.processedBytes += static_cast<uint64_t>(bytesRead);
             }
 
-            outFile.close();
-            zip_fclose(zipFile);
+            if (bytesRead < 0) {
+                AddEntryError(file.name, L"Failed to read entry: " + Utf8ToWideSafe(zip_file_strerror(zipFile)));
+            }
+            if (!writer.Close()) {
+                AddEntryError(file.name, writer.GetLastError());
+            }
+            zip_fclose(zipFile);
+        }
+
+        if (callback) {
+            progress.processedFiles = static_cast<uint64_t>(planned.size());
+            progress.currentFile = L"Complete";
+            callback(progress);
+        }
+
+        return true;
+    }
+
+    bool AppxPackageImpl::UnpackFromStream(const std::wstring& outputPath, const UnpackOptions& options,
+        PathMatcher& include, PathMatcher& exclude, ProgressCallback callback) {
+
+        fs::path root = ToPath(outputPath);
+        std::error_code ec;
+        fs::create_directories(root, ec);
+        if (ec) {
+            SetError(L"Failed to create directory " + outputPath + L": " + Utf8ToWideSafe(ec.message()));
+            return false;
+        }
+
+        ZipStreamReader reader(OpenStandardInput());
+        ZipStreamEntry entry;
+        FileWriter writer;
+        std::unordered_set<std::string> createdDirectories;
+        ProgressInfo progress = {};
+
+        while (reader.NextEntry(entry)) {
+            if (!include.Empty() && !include.Match(entry.name)) continue;
+            if (exclude.Match(entry.name)) continue;
+
+            std::vector<std::string> segments;
+            bool isDirectory = false;
+            if (!SplitEntryPath(entry.name, segments, isDirectory)) {
+                AddEntryError(entry.name, L"Invalid entry path; it would be written outside the output directory");
+                continue;
+            }
+
+            fs::path path = root;
+            std::string relative;
+            size_t directoryCount = isDirectory ? segments.size() : segments.size() - 1;
+            for (size_t i = 0; i < directoryCount; ++i) {
+                path /= PathFromUtf8(segments[i]);
+                if (i > 0) relative += '/';
+                relative += segments[i];
+            }
+            if (directoryCount > 0 && createdDirectories.insert(relative).second) {
+                fs::create_directories(path, ec);
+                if (ec) {
+                    SetError(L"Failed to create directory " + FromPath(path) + L": " + Utf8ToWideSafe(ec.message()));
+                    return false;
+                }
+            }
+            if (isDirectory) continue;
+            path /= PathFromUtf8(segments.back());
+
+            if (Cancelled()) {
+                return false;
+            }
+
+            if (callback) {
+                progress.totalFiles = progress.processedFiles + 1;
+                progress.totalBytes = progress.processedBytes;
+                progress.currentFile = Utf8ToWideSafe(entry.name);
+                callback(progress);
+            }
+
+            if (fs::exists(path, ec)) {
+                if (options.overwrite == OverwriteMode::No) continue;
+                if (options.overwrite == OverwriteMode::Ask) {
+                    SetError(L"File already exists: " + FromPath(path) +
+                        L" (use -o or -s when reading a package from standard input)");
+                    return false;
+                }
+            }
+
+            bool directIo = options.directIo && entry.uncompressedSize >= FileWriter::DIRECT_IO_THRESHOLD;
+            if (!writer.Open(path, entry.uncompressedSize, directIo)) {
+                SetError(writer.GetLastError());
+                return false;
+            }
+
+            size_t available = 0;
+            uint8_t* buffer;
+            size_t bytesRead;
+            while ((buffer = writer.Buffer(available)) != nullptr &&
+                (bytesRead = reader.Read(buffer, available)) > 0) {
+                writer.Commit(bytesRead);
+                progress.processedBytes += bytesRead;
+            }
+
+            if (!writer.Close() || reader.HasError()) {
+                SetError(reader.HasError() ? reader.GetLastError() : writer.GetLastError());
+                AddEntryError(entry.name, m_lastError);
+                return false;
+            }
+            ++progress.processedFiles;
+        }
+
+        if (reader.HasError()) {
+            SetError(reader.GetLastError());
+            return false;
+        }
+
+        if (callback) {
+            progress.totalFiles = progress.processedFiles;
+            progress.totalBytes = progress.processedBytes;
+            progress.currentFile = L"Complete";
+            callback(progress);
+        }
+
+        return true;
+    }
+
+    // Volumes are handed to workers whole, so each worker reads one volume front to back. An entry belongs
+    // to the volume holding its local header and is read across the boundary if it continues past it.
+    bool AppxPackageImpl::UnpackVolumes(const std::vector<fs::path>& volumes, const std::wstring& outputPath,
+        const UnpackOptions& options, PathMatcher& include, PathMatcher& exclude, ProgressCallback callback) {
+
+        VolumeSource source;
+        if (!source.Open(volumes)) {
+            SetError(L"Failed to open package volumes: " + source.GetLastError());
+            return false;
+        }
+
+        ZipDirectory directory;
+        if (!directory.Read(source)) {
+            SetError(L"Failed to read package directory: " + directory.GetLastError());
+            return false;
+        }
+
+        const std::vector<ZipDirectoryEntry>& entries = directory.Entries();
+        ExtractionPlan plan{ ToPath(outputPath) };
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const std::string& name = entries[i].name;
+            if (!include.Empty() && !include.Match(name)) continue;
+            if (exclude.Match(name)) continue;
+            if (!plan.Add(i, name, entries[i].uncompressedSize)) {
+                AddEntryError(name, plan.GetLastError());
+            }
+        }
+
+        if (!plan.Prepare(options.overwrite)) {
+            SetError(plan.GetLastError());
+            return false;
+        }
+
+        const std::vector<PlannedFile>& planned = plan.Files();
+        std::vector<std::vector<size_t>> byVolume(source.VolumeCount());
+        std::vector<uint64_t> dataOffsets(planned.size());
+        ProgressInfo progress = {};
+        for (size_t i = 0; i < planned.size(); ++i) {
+            if (!planned[i].write) continue;
+            const ZipDirectoryEntry& entry = entries[planned[i].entry];
+            if (!directory.ReadDataOffset(source, entry, dataOffsets[i])) {
+                AddEntryError(entry.name, directory.GetLastError());
+                continue;
+            }
+            byVolume[source.VolumeOf(entry.localHeaderOffset)].push_back(i);
+            ++progress.totalFiles;
+            progress.totalBytes += entry.uncompressedSize;
+        }
+
+        std::atomic<uint64_t> completedFiles{ 0 };
+        std::atomic<uint64_t> completedBytes{ 0 };
+        std::mutex errorMutex;
+
+        std::vector<size_t> activeVolumes;
+        std::vector<uint64_t> volumeBytes(byVolume.size());
+        for (size_t volume = 0; volume < byVolume.size(); ++volume) {
+            if (byVolume[volume].empty()) continue;
+            activeVolumes.push_back(volume);
+            for (size_t index : byVolume[volume]) {
+                volumeBytes[volume] += entries[planned[index].entry].uncompressedSize;
+            }
+        }
+
+        // One extract task per volume. Inflating keeps a core busy, so no more run at once than there are cores.
+        // A pause stops a volume between entries; it carries on from the next entry once resumed.
+        std::vector<size_t> nextFile(byVolume.size(), 0);
+        size_t concurrency = TaskScheduler::Shared().ThreadCount(TaskClass::Cpu);
+        TaskGroup group(TaskClass::Io, BufferPool::Shared().WorkerCount(VOLUME_WORKER_MEMORY, concurrency));
+        bool finished = RunPausable(group, activeVolumes.size(), m_control.get(),
+            [&](size_t n) { return volumeBytes[activeVolumes[n]]; },
+            [&](size_t n, const std::atomic<bool>& yield) {
+                const std::vector<size_t>& volumeFiles = byVolume[activeVolumes[n]];
+                size_t& next = nextFile[activeVolumes[n]];
+
+                FileWriter writer;
+                BufferPool::Lease input = BufferPool::Shared().Acquire(VOLUME_READ_SIZE);
+                z_stream stream = {};
+                bool streamReady = inflateInit2(&stream, -MAX_WBITS) == Z_OK;
+
+                for (; next < volumeFiles.size(); ++next) {
+                    if (yield || (m_control && m_control->IsCancelled())) break;
+
+                    size_t index = volumeFiles[next];
+                    const PlannedFile& file = planned[index];
+                    const ZipDirectoryEntry& entry = entries[file.entry];
+                    bool directIo = options.directIo && entry.uncompressedSize >= FileWriter::DIRECT_IO_THRESHOLD;
+                    std::wstring error;
+                    if (!streamReady) {
+                        error = L"Failed to initialize decompressor";
+                    }
+                    else if (!writer.Open(file.path, entry.uncompressedSize, directIo)) {
+                        error = writer.GetLastError();
+                    }
+                    else if (!ExtractEntry(source, entry, dataOffsets[index], input, stream, writer, error)) {
+                        writer.Close();
+                    }
+                    else if (!writer.Close()) {
+                        error = writer.GetLastError();
+                    }
+
+                    if (!error.empty()) {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        AddEntryError(entry.name, error);
+                    }
+                    completedBytes += entry.uncompressedSize;
+                    ++completedFiles;
+                }
+
+                if (streamReady) inflateEnd(&stream);
+                return next == volumeFiles.size();
+            },
+            [&]() {
+                if (callback) {
+                    progress.processedFiles = completedFiles;
+                    progress.processedBytes = completedBytes;
+                    callback(progress);
+                }
+            });
+
+        if (!finished) {
+            SetError(L"Operation cancelled");
+            return false;
+        }
+
+        if (callback) {
+            progress.processedFiles = progress.totalFiles;
+            progress.processedBytes = progress.totalBytes;
+            progress.currentFile = L"Complete";
+            callback(progress);
+        }
+
+        return true;
+    }
+
+    bool AppxPackageImpl::Update(const std::wstring& packagePath, const std::wstring& changesPath,
+        const PackOptions& options, ProgressCallback callback) {
+
+        m_errors.clear();
+
+        if (!fs::exists(ToPath(packagePath))) {
+            SetError(L"Package file does not exist");
+            return false;
+        }
+
+        if (!fs::exists(ToPath(changesPath)) || !fs::is_directory(ToPath(changesPath))) {
+            SetError(L"Changes path does not exist or is not a directory");
+            return false;
+        }
+
+        std::vector<PackageFile> changedFiles;
+        if (!ProcessFileTree(changesPath, changedFiles)) {
+            return false;
+        }
+
+        // The block map and content types are regenerated from the package itself, and a signature cannot
+        // survive the update.
+        changedFiles.erase(std::remove_if(changedFiles.begin(), changedFiles.end(), [](const PackageFile& file) {
+            return IsFootprintFile(NormalizeEntryName(file.packagePath));
+        }), changedFiles.end());
+
+        if (changedFiles.empty()) {
+            SetError(L"No changed files found");
+            return false;
+        }
+
+        std::wstring tempPath = packagePath + L".update.tmp";
+
+        FileSource source(ToPath(packagePath));
+        ZipDirectory directory;
+        if (!source.IsOpen() || !directory.Read(source)) {
+            SetError(L"Failed to open package file");
+            return false;
+        }
+
+        std::map<std::string, BlockMapEntry> oldBlockMap;
+        bool hasBlockMap = false;
+        const ZipDirectoryEntry* oldBlockMapEntry = directory.Find(BLOCK_MAP_ENTRY_NAME);
+        if (oldBlockMapEntry) {
+            std::string xml;
+            std::vector<BlockMapEntry> entries;
+            if (directory.ReadEntryData(source, *oldBlockMapEntry, xml) && ParseBlockMapXml(xml, entries)) {
+                hasBlockMap = true;
+                for (auto& entry : entries) {
+                    oldBlockMap[NormalizeEntryName(entry.name)] = std::move(entry);
+                }
+            }
+            else {
+                std::wcout << L"Warning: existing AppxBlockMap.xml could not be parsed and will be dropped" << std::endl;
+            }
+        }
+
+        // Files with an extension the package has no content type for get a Default, or an Override when
+        // they have no extension at all; otherwise the updated package would not install.
+        ContentTypes contentTypes;
+        bool contentTypesChanged = false;
+        const ZipDirectoryEntry* oldContentTypesEntry = directory.Find(CONTENT_TYPES_ENTRY_NAME);
+        if (oldContentTypesEntry) {
+            std::string xml;
+            if (!directory.ReadEntryData(source, *oldContentTypesEntry, xml) || !contentTypes.Parse(xml)) {
+                SetError(L"Existing [Content_Types].xml could not be parsed");
+                return false;
+            }
+            for (const auto& file : changedFiles) {
+                if (contentTypes.Add(file.packagePath)) {
+                    contentTypesChanged = true;
+                }
+            }
+        }
+
+        bool deflate = options.compression != CompressionLevel::None;
+        int compressionLevel = ZlibLevelFor(options.compression);
+
+        ProgressInfo progress = {};
+        progress.totalFiles = changedFiles.size();
+        for (const auto& file : changedFiles) {
+            progress.totalBytes += file.size;
+        }
+
+        std::vector<CompressedEntry> compressedEntries(changedFiles.size());
+        fs::path cacheRoot = options.cacheDirectory.empty() ?
+            ToPath(packagePath + L".update.cache") : ToPath(options.cacheDirectory);
+
+        TempDirectoryGuard tempCacheGuard{ options.cacheDirectory.empty() && deflate ? cacheRoot : fs::path() };
+
+        if (deflate) {
+            CompressedEntryCache cache(cacheRoot);
+            std::wstring cacheError;
+            if (!cache.Open(cacheError)) {
+                SetError(cacheError);
+                return false;
+            }
+
+            std::vector<size_t> primaryOf;
+            std::wstring dedupError;
+            if (!FindDuplicateFiles(changedFiles, primaryOf, dedupError)) {
+                SetError(dedupError);
+                return false;
+            }
+
+            if (!CompressEntries(changedFiles, primaryOf, cache, compressionLevel, compressedEntries, progress, callback)) {
+                return false;
+            }
+        }
+
+        std::map<std::string, size_t> changedIndex;
+        for (size_t i = 0; i < changedFiles.size(); ++i) {
+            changedIndex[NormalizeEntryName(changedFiles[i].packagePath)] = i;
+        }
+
+        // Written front to back by the streamed writer, which lays out every local header itself, so the
+        // regenerated block map states each LfhSize exactly.
+        std::ofstream output(ToPath(tempPath), std::ios::binary | std::ios::trunc);
+        if (!output.is_open()) {
+            SetError(L"Failed to create updated package: " + tempPath);
+            return false;
+        }
+        ZipStreamWriter writer(StreamSink([&output](const uint8_t* data, size_t size) {
+            output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            return output.good();
+        }));
+        auto sink = [&writer](const uint8_t* data, size_t size) {
+            return writer.Write(data, size);
+        };
+        auto discard = [&]() {
+            output.close();
+            std::error_code ec;
+            fs::remove(ToPath(tempPath), ec);
+            return false;
+        };
+
+        BufferPool::Lease copyBuffer = BufferPool::Shared().Acquire(BLOCK_MAP_BLOCK_SIZE);
+        auto copyRange = [&](RandomAccessSource& from, uint64_t offset, uint64_t size) {
+            while (size > 0) {
+                size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, copyBuffer.Size()));
+                if (!from.ReadAt(offset, copyBuffer.Data(), chunk) || !writer.Write(copyBuffer.Data(), chunk)) {
+                    return false;
+                }
+                offset += chunk;
+                size -= chunk;
+            }
+            return true;
+        };
+
+        uint16_t method = deflate ? ZIP_METHOD_DEFLATE : ZIP_METHOD_STORE;
+        std::vector<bool> changedWritten(changedFiles.size(), false);
+        std::vector<BlockMapEntry> blockMapEntries;
+        size_t copiedEntries = 0;
+
+        auto addChangedFile = [&](size_t i, const std::string& entryName) {
+            const auto& file = changedFiles[i];
+            CompressedEntry& entry = compressedEntries[i];
+
+            std::error_code ec;
+            time_t modifiedTime = ToTimeT(fs::last_write_time(file.localPath, ec));
+            if (!writer.BeginEntry(entryName, method, ec ? time(nullptr) : modifiedTime, file.size)) {
+                SetError(writer.GetLastError());
+                return false;
+            }
+
+            std::wstring encodeError;
+            if (deflate) {
+                FileSource cached(entry.dataPath);
+                if (!cached.IsOpen() || !copyRange(cached, entry.dataOffset, entry.compressedSize)) {
+                    encodeError = L"Failed to copy cached entry: " + Utf8ToWideSafe(file.packagePath);
+                }
+            }
+            else {
+                std::ifstream input(file.localPath, std::ios::binary);
+                if (!input.is_open()) {
+                    encodeError = L"Cannot open file: " + FromPath(file.localPath);
+                }
+                else if (!EncodeEntry(input, compressionLevel, true, sink, entry, encodeError)) {
+                    encodeError += L": " + Utf8ToWideSafe(file.packagePath);
+                }
+            }
+
+            if (!encodeError.empty() || !writer.EndEntry(entry.crc32, entry.uncompressedSize)) {
+                SetError(!writer.GetLastError().empty() ? writer.GetLastError() : encodeError);
+                return false;
+            }
+
+            BlockMapEntry blockMapEntry;
+            blockMapEntry.name = entryName;
+            blockMapEntry.size = entry.uncompressedSize;
+            blockMapEntry.lfhSize = ZipStreamWriter::LocalHeaderSize(entryName, file.size);
+            blockMapEntry.blocks = entry.blocks;
+            blockMapEntries.push_back(std::move(blockMapEntry));
+
+            changedWritten[i] = true;
+            return true;
+        };
+
+        // Unchanged entries are copied compressed, in their original order and with their original timestamp.
+        std::vector<const ZipDirectoryEntry*> entries;
+        for (const auto& entry : directory.Entries()) {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const ZipDirectoryEntry* a, const ZipDirectoryEntry* b) {
+            return a->localHeaderOffset < b->localHeaderOffset;
+        });
+
+        for (const ZipDirectoryEntry* entry : entries) {
+            if (Cancelled()) {
+                return discard();
+            }
+
+            const std::string& entryName = entry->name;
+            std::string normalized = NormalizeEntryName(entryName);
+
+            if (normalized == "appxblockmap.xml") continue;
+            if (normalized == "appxsignature.p7x") {
+                std::wcout << L"Warning: dropping AppxSignature.p7x; the updated package must be re-signed" << std::endl;
+                continue;
+            }
+            if (entry == oldContentTypesEntry && contentTypesChanged) {
+                std::istringstream xml(contentTypes.ToXml());
+                CompressedEntry contentTypesEntry;
+                std::wstring contentTypesError;
+                if (!writer.BeginEntry(entryName, method, time(nullptr), xml.str().size()) ||
+                    !EncodeEntry(xml, compressionLevel, !deflate, sink, contentTypesEntry, contentTypesError) ||
+                    !writer.EndEntry(contentTypesEntry.crc32, contentTypesEntry.uncompressedSize)) {
+                    SetError(!writer.GetLastError().empty() ? writer.GetLastError() : L"Failed to update [Content_Types].xml");
+                    return discard();
+                }
+                continue;
+            }
+
+            auto changed = changedIndex.find(normalized);
+            if (changed != changedIndex.end()) {
+                if (changedWritten[changed->second]) continue;
+                if (!addChangedFile(changed->second, entryName)) {
+                    return discard();
+                }
+                continue;
+            }
+
+            uint64_t dataOffset = 0;
+            if (!directory.ReadDataOffset(source, *entry, dataOffset) ||
+                !writer.BeginEntry(entryName, entry->method, entry->modifiedTime, entry->modifiedDate, entry->uncompressedSize) ||
+                !copyRange(source, dataOffset, entry->compressedSize) ||
+                !writer.EndEntry(entry->crc32, entry->uncompressedSize)) {
+                SetError(L"Failed to copy entry: " + Utf8ToWideSafe(entryName));
+                return discard();
+            }
+            ++copiedEntries;
+
+            auto oldEntry = oldBlockMap.find(normalized);
+            if (oldEntry != oldBlockMap.end()) {
+                BlockMapEntry blockMapEntry = oldEntry->second;
+                blockMapEntry.name = entryName;
+                blockMapEntry.lfhSize = ZipStreamWriter::LocalHeaderSize(entryName, entry->uncompressedSize);
+                blockMapEntries.push_back(std::move(blockMapEntry));
+            }
+            else if (!IsFootprintFile(normalized)) {
+                hasBlockMap = false;
+            }
+        }
+
+        for (size_t i = 0; i < changedFiles.size(); ++i) {
+            if (!changedWritten[i] && !addChangedFile(i, changedFiles[i].packagePath)) {
+                return discard();
+            }
+        }
+
+        if (hasBlockMap) {
+            std::istringstream blockMap(GenerateBlockMapXml(blockMapEntries));
+            CompressedEntry blockMapEntry;
+            std::wstring blockMapError;
+            if (!writer.BeginEntry(BLOCK_MAP_ENTRY_NAME, method, time(nullptr), blockMap.str().size()) ||
+                !EncodeEntry(blockMap, compressionLevel, !deflate, sink, blockMapEntry, blockMapError) ||
+                !writer.EndEntry(blockMapEntry.crc32, blockMapEntry.uncompressedSize)) {
+                SetError(!writer.GetLastError().empty() ? writer.GetLastError() : L"Failed to add AppxBlockMap.xml");
+                return discard();
+            }
+        }
+        else if (oldBlockMapEntry) {
+            std::wcout << L"Warning: block map is incomplete for copied entries; AppxBlockMap.xml was not regenerated" << std::endl;
+        }
+
+        std::wcout << L"Finalizing package..." << std::endl;
+
+        if (!writer.Finish()) {
+            SetError(writer.GetLastError());
+            return discard();
+        }
+        output.close();
+        if (output.fail()) {
+            SetError(L"Failed to finalize package: " + tempPath);
+            return discard();
+        }
+        source.Close();
+
+        std::error_code ec;
+        fs::rename(ToPath(tempPath), ToPath(packagePath), ec);
+        if (ec) {
+            fs::remove(ToPath(tempPath), ec);
+            SetError(L"Failed to replace package file: " + Utf8ToWideSafe(ec.message()));
+            return false;
+        }
+
+        if (callback) {
+            progress.processedFiles = changedFiles.size();
+            progress.processedBytes = progress.totalBytes;
+            progress.currentFile = L"";
+            callback(progress);
+        }
+
+        std::wcout << std::endl << L"Package updated: " << changedFiles.size() << L" files written, "
+            << copiedEntries << L" entries copied" << std::endl;
+
+        return true;
+    }
+
+    // Keeps the scanned tree and every compressed entry in memory, so a rebuild compresses only the files
+    // whose size or modification time changed and then rewrites the package from memory.
+    bool AppxPackageImpl::Watch(const std::wstring& inputPath, const std::wstring& outputPath,
+        const WatchOptions& options, ProgressCallback callback) {
+
+        m_errors.clear();
+
+        fs::path root = ToPath(inputPath);
+        if (!fs::exists(root) || !fs::is_directory(root)) {
+            SetError(L"Input path does not exist or is not a directory");
+            return false;
+        }
+        if (outputPath == L"-") {
+            SetError(L"Watch mode needs a package file, not stdout");
+            return false;
+        }
+
+        fs::path packagePath = ToPath(outputPath);
+        fs::path outputDir = packagePath.parent_path();
+        if (!outputDir.empty() && !fs::exists(outputDir)) {
+            try {
+                fs::create_directories(outputDir);
+            }
+            catch (const std::exception& e) {
+                SetError(L"Failed to create output directory: " + Utf8ToWideSafe(e.what()));
+                return false;
+            }
+        }
+
+        std::vector<ContentGroup> contentGroups;
+        if (!options.contentGroupMap.empty()) {
+            std::wstring cgmError;
+            if (!ReadContentGroupMap(options.contentGroupMap, contentGroups, cgmError)) {
+                SetError(cgmError);
+                return false;
+            }
+        }
+
+        bool store = options.compression == CompressionLevel::None;
+        int level = ZlibLevelFor(options.compression);
+
+        std::unique_ptr<CompressedEntryCache> cache;
+        if (!options.cacheDirectory.empty() && !store) {
+            cache = std::make_unique<CompressedEntryCache>(ToPath(options.cacheDirectory));
+            std::wstring cacheError;
+            if (!cache->Open(cacheError)) {
+                SetError(cacheError);
+                return false;
+            }
+        }
+
+        // A package written inside the watched directory must not be packed into itself.
+        std::unordered_set<std::string> ignored = { "appxblockmap.xml" };
+        std::error_code ec;
+        fs::path absoluteRoot = fs::absolute(root, ec).lexically_normal();
+        for (const char* suffix : { "", ".watch.tmp", ".groups.json" }) {
+            fs::path path = fs::absolute(packagePath, ec).lexically_normal();
+            path += suffix;
+            fs::path relative = path.lexically_relative(absoluteRoot);
+            if (!relative.empty() && *relative.begin() != "..") {
+                ignored.insert(NormalizeEntryName(PathToUtf8(relative)));
+            }
+        }
+
+        DirectoryWatcher watcher;
+        if (!options.poll && !watcher.Open(root)) {
+            std::wcout << L"Change notifications are unavailable; polling instead" << std::endl;
+        }
+        auto debounce = std::chrono::milliseconds(options.debounceMilliseconds);
+        auto pollInterval = std::chrono::milliseconds(std::max<uint32_t>(options.pollMilliseconds, 1));
+
+        // The tree of the last rebuild, successful or not: a tree that failed to build is only tried again
+        // once it changes, unless the failure was writing the package.
+        WatchedTree attempted;
+        std::unordered_map<std::string, WatchedEntry> entries;
+        bool firstBuild = true;
+        bool retry = false;
+
+        while (true) {
+            WatchedTree current;
+            std::wstring error;
+
+            if (firstBuild) {
+                if (!ScanWatchedTree(root, ignored, current, error)) {
+                    SetError(error);
+                    return false;
+                }
+            }
+            else {
+                if (m_control && !m_control->Checkpoint()) {
+                    return true;
+                }
+
+                // Waiting for a quiet period lets a save that touches many files, or writes one large file
+                // in pieces, finish before anything is read.
+                bool native = watcher.IsNative();
+                if (!watcher.Wait(native && !retry ? WATCH_WAKE_INTERVAL : pollInterval) && native && !retry) {
+                    continue;
+                }
+                if (native) {
+                    while (watcher.Wait(debounce)) {
+                    }
+                }
+
+                if (!ScanWatchedTree(root, ignored, current, error)) {
+                    std::wcerr << L"Error: " << error << std::endl;
+                    retry = true;
+                    continue;
+                }
+                if (!retry && SameTree(current, attempted)) {
+                    continue;
+                }
+                if (!native) {
+                    std::this_thread::sleep_for(debounce);
+                    WatchedTree settled;
+                    if (!ScanWatchedTree(root, ignored, settled, error) || !SameTree(settled, current)) {
+                        continue;
+                    }
+                }
+            }
+
+            auto started = std::chrono::steady_clock::now();
+            m_errors.clear();
+            attempted = current;
+            retry = false;
+
+            std::vector<PackageFile> files;
+            files.reserve(current.size());
+            for (const auto& item : current) {
+                files.push_back(item.second.file);
+            }
+            if (!contentGroups.empty()) {
+                OrderFilesByContentGroups(files, contentGroups);
+            }
+
+            for (auto it = entries.begin(); it != entries.end();) {
+                it = current.count(it->first) ? std::next(it) : entries.erase(it);
+            }
+
+            std::vector<const PackageFile*> changedFiles;
+            std::vector<WatchedEntry*> changedEntries;
+            for (const auto& file : files) {
+                const WatchedFile& watched = current.at(file.packagePath);
+                auto found = entries.find(file.packagePath);
+                if (found != entries.end() && found->second.size == file.size &&
+                    found->second.modified == watched.modified) {
+                    continue;
+                }
+                WatchedEntry& entry = entries[file.packagePath];
+                entry.size = file.size;
+                entry.modified = watched.modified;
+                changedFiles.push_back(&file);
+                changedEntries.push_back(&entry);
+            }
+
+            std::string failedEntry;
+            uint64_t packageSize = 0;
+            bool built = ValidateManifest(FromPath(root / L"AppxManifest.xml"));
+            if (built && !CompressWatchedEntries(changedFiles, changedEntries, level, store, cache.get(),
+                    m_control.get(), firstBuild ? callback : nullptr, failedEntry, error)) {
+                if (m_control && m_control->IsCancelled()) {
+                    if (firstBuild) {
+                        SetError(L"Operation cancelled");
+                    }
+                    return !firstBuild;
+                }
+                AddEntryError(failedEntry, error);
+                SetError(error + L": " + Utf8ToWideSafe(failedEntry));
+                built = false;
+            }
+            if (!built) {
+                // Entries that were not compressed must not look current to the next rebuild.
+                for (const auto* file : changedFiles) {
+                    entries.erase(file->packagePath);
+                }
+            }
+            if (built && !PublishWatchedPackage(packagePath, files, entries, level, store, packageSize, error)) {
+                SetError(error);
+                retry = true;
+                built = false;
+            }
+
+            if (!built) {
+                if (firstBuild) {
+                    return false;
+                }
+                std::wcerr << L"Error: " << m_lastError << L"; the previous package is kept" << std::endl;
+                continue;
+            }
+
+            if (!contentGroups.empty()) {
+                std::wstring indexError;
+                if (!WriteContentGroupIndex(outputPath, outputPath + L".groups.json", contentGroups, indexError)) {
+                    std::wcerr << L"Error: " << indexError << std::endl;
+                }
+            }
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+            if (firstBuild) {
+                std::wcout << std::endl << L"Package created in " << elapsed.count() << L" ms, "
+                    << (packageSize / (1024 * 1024)) << L" MB" << std::endl;
+                std::wcout << L"Watching " << inputPath << (watcher.IsNative() ? L"" : L" by polling")
+                    << L" for changes" << std::endl;
+                firstBuild = false;
+            }
+            else {
+                std::wcout << L"Rebuilt in " << elapsed.count() << L" ms: " << changedFiles.size()
+                    << L" entries recompressed, " << files.size() - changedFiles.size() << L" reused, "
+                    << (packageSize / (1024 * 1024)) << L" MB" << std::endl;
+            }
+        }
+    }
+
+    void DescribePackage(const ZipDirectory& directory, uint64_t fileSize, PackageInfo& info) {
+        info.fileSize = fileSize;
+        info.zip64 = directory.IsZip64();
+        info.entries.reserve(directory.Entries().size());
+
+        for (const auto& entry : directory.Entries()) {
+            PackageEntryInfo entryInfo;
+            entryInfo.name = Utf8ToWideSafe(entry.name);
+            entryInfo.compressedSize = entry.compressedSize;
+            entryInfo.uncompressedSize = entry.uncompressedSize;
+            entryInfo.offset = entry.localHeaderOffset;
+            entryInfo.crc32 = entry.crc32;
+            entryInfo.method = entry.method;
+            info.entries.push_back(std::move(entryInfo));
+
+            info.compressedSize += entry.compressedSize;
+            info.uncompressedSize += entry.uncompressedSize;
+
+            std::string name = NormalizeEntryName(entry.name);
+            if (name == NormalizeEntryName(BLOCK_MAP_ENTRY_NAME)) info.hasBlockMap = true;
+            if (name == "appxsignature.p7x") info.hasSignature = true;
+        }
+    }
+
+    bool AppxPackageImpl::Inspect(const std::wstring& packagePath, PackageInfo& info, bool readManifest) {
+        info = PackageInfo();
+
+        FileSource source{ ToPath(packagePath) };
+        if (!source.IsOpen()) {
+            SetError(L"Cannot open package: " + packagePath);
+            return false;
+        }
+
+        ZipDirectory directory;
+        if (!directory.Read(source)) {
+            SetError(L"Failed to read package directory: " + directory.GetLastError());
+            return false;
+        }
+
+        DescribePackage(directory, source.Size(), info);
+
+        if (readManifest) {
+            const ZipDirectoryEntry* manifest = directory.Find("AppxManifest.xml");
+            if (!manifest) {
+                SetError(L"AppxManifest.xml not found in package");
+                return false;
+            }
+            if (!directory.ReadEntryData(source, *manifest, info.manifest)) {
+                SetError(directory.GetLastError());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool AppxPackageImpl::Verify(const std::wstring& packagePath, VerifyResult& result, ProgressCallback callback) {
+        std::wstring error;
+        if (!VerifyPackage(packagePath, result, callback, error)) {
+            SetError(error);
+            return false;
+        }
+        return true;
+    }
+
+    bool AppxPackageImpl::Diff(const std::wstring& oldPackage, const std::wstring& newPackage,
+        PackageDiff& diff, bool compareBlockMaps) {
+        std::wstring error;
+        if (!DiffPackages(oldPackage, newPackage, compareBlockMaps, diff, error)) {
+            SetError(error);
+            return false;
         }
+        return true;
+    }
 
-        if (callback) {
-            progress.processedFiles = static_cast<uint64_t>(numEntries);
-            progress.currentFile = L"Complete";
-            callback(progress);
+    bool AppxPackageImpl::CreateDelta(const std::wstring& oldPackage, const std::wstring& newPackage,
+        const std::wstring& patchPath, DeltaStats& stats, ProgressCallback callback) {
+        std::wstring error;
+        if (!CreateDeltaPatch(oldPackage, newPackage, patchPath, stats, callback, error)) {
+            SetError(error);
+            return false;
         }
+        return true;
+    }
 
+    bool AppxPackageImpl::ApplyDelta(const std::wstring& oldPackage, const std::wstring& patchPath,
+        const std::wstring& outputPath, ProgressCallback callback) {
+        std::wstring error;
+        if (!ApplyDeltaPatch(oldPackage, patchPath, outputPath, callback, error)) {
+            SetError(error);
+            return false;
+        }
         return true;
     }
 
     bool AppxPackageImpl::Encrypt(const std::wstring& inputPath, const std::wstring& outputPath,
         const std::wstring& keyFile) {
 
-        if (!fs::exists(inputPath)) {
+        if (!fs::exists(ToPath(inputPath))) {
             SetError(L"Input package file does not exist");
             return false;
         }
 
-        if (!fs::exists(keyFile)) {
+        if (!fs::exists(ToPath(keyFile))) {
             SetError(L"Key file does not exist");
             return false;
         }
 
         try {
-            std::ifstream keyFileStream(keyFile, std::ios::binary);
+            std::ifstream keyFileStream(ToPath(keyFile), std::ios::binary);
             if (!keyFileStream.is_open()) {
                 SetError(L"Cannot open key file");
                 return false;
@@ -476,30 +2318,9 @@ namespace MakeAppxCore {
                 return false;
             }
 
-            BCRYPT_ALG_HANDLE hAlgorithm = nullptr;
-            BCRYPT_KEY_HANDLE hKey = nullptr;
-            NTSTATUS status;
-
-            status = BCryptOpenAlgorithmProvider(&hAlgorithm, BCRYPT_AES_ALGORITHM, nullptr, 0);
-            if (!BCRYPT_SUCCESS(status)) {
-                SetError(L"Failed to open AES algorithm provider");
-                return false;
-            }
-
-            status = BCryptSetProperty(hAlgorithm, BCRYPT_CHAINING_MODE,
-                (PUCHAR)BCRYPT_CHAIN_MODE_CBC,
-                sizeof(BCRYPT_CHAIN_MODE_CBC), 0);
-            if (!BCRYPT_SUCCESS(status)) {
-                BCryptCloseAlgorithmProvider(hAlgorithm, 0);
-                SetError(L"Failed to set chaining mode");
-                return false;
-            }
-
-            status = BCryptGenerateSymmetricKey(hAlgorithm, &hKey, nullptr, 0,
-                keyData.data(), 32, 0);
-            if (!BCRYPT_SUCCESS(status)) {
-                BCryptCloseAlgorithmProvider(hAlgorithm, 0);
-                SetError(L"Failed to generate symmetric key");
+            AesCbc cipher;
+            if (!cipher.Open(keyData.data(), keyData.size())) {
+                SetError(L"Failed to initialize AES-256 key");
                 return false;
             }
 
@@ -511,12 +2332,10 @@ namespace MakeAppxCore {
                 iv[i] = static_cast<uint8_t>(dis(gen));
             }
 
-            std::ifstream inputFile(inputPath, std::ios::binary);
-            std::ofstream outputFile(outputPath, std::ios::binary);
+            std::ifstream inputFile(ToPath(inputPath), std::ios::binary);
+            std::ofstream outputFile(ToPath(outputPath), std::ios::binary);
 
             if (!inputFile.is_open() || !outputFile.is_open()) {
-                BCryptDestroyKey(hKey);
-                BCryptCloseAlgorithmProvider(hAlgorithm, 0);
                 SetError(L"Failed to open input or output file");
                 return false;
             }
@@ -524,9 +2343,10 @@ namespace MakeAppxCore {
             outputFile.write(reinterpret_cast<char*>(iv), 16);
 
             const size_t CHUNK_SIZE = 8192;
-            uint8_t inputBuffer[CHUNK_SIZE];
-            uint8_t outputBuffer[CHUNK_SIZE + 16];
-            ULONG bytesEncrypted;
+            BufferPool::Lease inputLease = BufferPool::Shared().Acquire(CHUNK_SIZE + 16);
+            BufferPool::Lease outputLease = BufferPool::Shared().Acquire(CHUNK_SIZE + 16);
+            uint8_t* inputBuffer = inputLease.Data();
+            uint8_t* outputBuffer = outputLease.Data();
 
             while (inputFile.read(reinterpret_cast<char*>(inputBuffer), CHUNK_SIZE)) {
                 std::streamsize bytesRead = inputFile.gcount();
@@ -540,25 +2360,16 @@ namespace MakeAppxCore {
                     bytesRead += padSize;
                 }
 
-                status = BCryptEncrypt(hKey, inputBuffer, static_cast<ULONG>(bytesRead),
-                    nullptr, iv, 16, outputBuffer, sizeof(outputBuffer),
-                    &bytesEncrypted, 0);
-
-                if (!BCRYPT_SUCCESS(status)) {
-                    BCryptDestroyKey(hKey);
-                    BCryptCloseAlgorithmProvider(hAlgorithm, 0);
+                if (!cipher.Encrypt(inputBuffer, static_cast<size_t>(bytesRead), iv, outputBuffer)) {
                     SetError(L"Encryption failed");
                     return false;
                 }
 
-                outputFile.write(reinterpret_cast<char*>(outputBuffer), bytesEncrypted);
-                memcpy(iv, outputBuffer + bytesEncrypted - 16, 16);
+                outputFile.write(reinterpret_cast<char*>(outputBuffer), bytesRead);
             }
 
             inputFile.close();
             outputFile.close();
-            BCryptDestroyKey(hKey);
-            BCryptCloseAlgorithmProvider(hAlgorithm, 0);
 
             return true;
         }
@@ -571,18 +2382,18 @@ namespace MakeAppxCore {
     bool AppxPackageImpl::Decrypt(const std::wstring& inputPath, const std::wstring& outputPath,
         const std::wstring& keyFile) {
 
-        if (!fs::exists(inputPath)) {
+        if (!fs::exists(ToPath(inputPath))) {
             SetError(L"Input encrypted file does not exist");
             return false;
         }
 
-        if (!fs::exists(keyFile)) {
+        if (!fs::exists(ToPath(keyFile))) {
             SetError(L"Key file does not exist");
             return false;
         }
 
         try {
-            std::ifstream keyFileStream(keyFile, std::ios::binary);
+            std::ifstream keyFileStream(ToPath(keyFile), std::ios::binary);
             if (!keyFileStream.is_open()) {
                 SetError(L"Cannot open key file");
                 return false;
@@ -597,39 +2408,16 @@ namespace MakeAppxCore {
                 return false;
             }
 
-            BCRYPT_ALG_HANDLE hAlgorithm = nullptr;
-            BCRYPT_KEY_HANDLE hKey = nullptr;
-            NTSTATUS status;
-
-            status = BCryptOpenAlgorithmProvider(&hAlgorithm, BCRYPT_AES_ALGORITHM, nullptr, 0);
-            if (!BCRYPT_SUCCESS(status)) {
-                SetError(L"Failed to open AES algorithm provider");
-                return false;
-            }
-
-            status = BCryptSetProperty(hAlgorithm, BCRYPT_CHAINING_MODE,
-                (PUCHAR)BCRYPT_CHAIN_MODE_CBC,
-                sizeof(BCRYPT_CHAIN_MODE_CBC), 0);
-            if (!BCRYPT_SUCCESS(status)) {
-                BCryptCloseAlgorithmProvider(hAlgorithm, 0);
-                SetError(L"Failed to set chaining mode");
-                return false;
-            }
-
-            status = BCryptGenerateSymmetricKey(hAlgorithm, &hKey, nullptr, 0,
-                keyData.data(), 32, 0);
-            if (!BCRYPT_SUCCESS(status)) {
-                BCryptCloseAlgorithmProvider(hAlgorithm, 0);
-                SetError(L"Failed to generate symmetric key");
+            AesCbc cipher;
+            if (!cipher.Open(keyData.data(), keyData.size())) {
+                SetError(L"Failed to initialize AES-256 key");
                 return false;
             }
 
-            std::ifstream inputFile(inputPath, std::ios::binary);
-            std::ofstream outputFile(outputPath, std::ios::binary);
+            std::ifstream inputFile(ToPath(inputPath), std::ios::binary);
+            std::ofstream outputFile(ToPath(outputPath), std::ios::binary);
 
             if (!inputFile.is_open() || !outputFile.is_open()) {
-                BCryptDestroyKey(hKey);
-                BCryptCloseAlgorithmProvider(hAlgorithm, 0);
                 SetError(L"Failed to open input or output file");
                 return false;
             }
@@ -637,16 +2425,15 @@ namespace MakeAppxCore {
             uint8_t iv[16];
             inputFile.read(reinterpret_cast<char*>(iv), 16);
             if (inputFile.gcount() != 16) {
-                BCryptDestroyKey(hKey);
-                BCryptCloseAlgorithmProvider(hAlgorithm, 0);
                 SetError(L"Invalid encrypted file - missing IV");
                 return false;
             }
 
             const size_t CHUNK_SIZE = 8192;
-            uint8_t inputBuffer[CHUNK_SIZE];
-            uint8_t outputBuffer[CHUNK_SIZE];
-            ULONG bytesDecrypted;
+            BufferPool::Lease inputLease = BufferPool::Shared().Acquire(CHUNK_SIZE);
+            BufferPool::Lease outputLease = BufferPool::Shared().Acquire(CHUNK_SIZE);
+            uint8_t* inputBuffer = inputLease.Data();
+            uint8_t* outputBuffer = outputLease.Data();
             bool isLastChunk = false;
 
             while (inputFile.read(reinterpret_cast<char*>(inputBuffer), CHUNK_SIZE)) {
@@ -656,16 +2443,11 @@ namespace MakeAppxCore {
                     isLastChunk = true;
                 }
 
-                status = BCryptDecrypt(hKey, inputBuffer, static_cast<ULONG>(bytesRead),
-                    nullptr, iv, 16, outputBuffer, sizeof(outputBuffer),
-                    &bytesDecrypted, 0);
-
-                if (!BCRYPT_SUCCESS(status)) {
-                    BCryptDestroyKey(hKey);
-                    BCryptCloseAlgorithmProvider(hAlgorithm, 0);
+                if (!cipher.Decrypt(inputBuffer, static_cast<size_t>(bytesRead), iv, outputBuffer)) {
                     SetError(L"Decryption failed");
                     return false;
                 }
+                size_t bytesDecrypted = static_cast<size_t>(bytesRead);
 
                 if (isLastChunk && bytesDecrypted > 0) {
                     uint8_t padSize = outputBuffer[bytesDecrypted - 1];
@@ -677,14 +2459,10 @@ namespace MakeAppxCore {
                 if (bytesDecrypted > 0) {
                     outputFile.write(reinterpret_cast<char*>(outputBuffer), bytesDecrypted);
                 }
-
-                memcpy(iv, inputBuffer + bytesRead - 16, 16);
             }
 
             inputFile.close();
             outputFile.close();
-            BCryptDestroyKey(hKey);
-            BCryptCloseAlgorithmProvider(hAlgorithm, 0);
 
             return true;
         }
@@ -713,7 +2491,7 @@ namespace MakeAppxCore {
                 manifest << L"      <Resources>\n";
                 manifest << L"        <Resource Language=\"en-US\" />\n";
                 manifest << L"      </Resources>\n";
-                manifest << L"      <File Name=\"" << packageFile.filename().wstring() << L"\" />\n";
+                manifest << L"      <File Name=\"" << FromPath(packageFile.filename()) << L"\" />\n";
                 manifest << L"    </Package>\n";
             }
         }
@@ -725,49 +2503,48 @@ namespace MakeAppxCore {
     }
 
     std::wstring AppxBundleImpl::ExtractPackageIdentity(const fs::path& packagePath) {
-        return L"Package_" + packagePath.stem().wstring();
+        return L"Package_" + FromPath(packagePath.stem());
     }
 
-    bool AppxBundleImpl::PromptUserOverwrite(const std::wstring& filePath) {
-        std::wcout << L"File exists: " << filePath << std::endl;
-        std::wcout << L"Overwrite? (y)es, (n)o, (a)ll, (s)kip all: ";
-
-        wchar_t response;
-        std::wcin >> response;
-        response = towlower(response);
+    void AppxBundleImpl::SetError(const std::wstring& error) {
+        m_lastError = error;
+    }
 
-        switch (response) {
-        case L'y':
-            return true;
-        case L'n':
-            return false;
-        case L'a':
-            return true;
-        case L's':
-            return false;
-        default:
-            std::wcout << L"Invalid response. Skipping file." << std::endl;
-            return false;
-        }
+    void AppxBundleImpl::AddEntryError(const std::string& entry, const std::wstring& message) {
+        m_errors.push_back({ Utf8ToWideSafe(entry), message });
     }
 
-    void AppxBundleImpl::SetError(const std::wstring& error) {
-        m_lastError = error;
+    bool AppxBundleImpl::Cancelled() {
+        if (!m_control || m_control->Checkpoint()) return false;
+        SetError(L"Operation cancelled");
+        return true;
     }
 
     bool AppxBundleImpl::Bundle(const std::wstring& inputPath, const std::wstring& outputPath,
         CompressionLevel compression, ProgressCallback callback) {
 
-        if (!fs::exists(inputPath) || !fs::is_directory(inputPath)) {
+        BundleOptions options;
+        options.compression = compression;
+        return Bundle(inputPath, outputPath, options, callback);
+    }
+
+    bool AppxBundleImpl::Bundle(const std::wstring& inputPath, const std::wstring& outputPath,
+        const BundleOptions& options, ProgressCallback callback) {
+
+        m_errors.clear();
+
+        CompressionLevel compression = options.compression;
+
+        if (!fs::exists(ToPath(inputPath)) || !fs::is_directory(ToPath(inputPath))) {
             SetError(L"Input path does not exist or is not a directory");
             return false;
         }
 
         std::vector<fs::path> packageFiles;
         try {
-            for (const auto& entry : fs::directory_iterator(inputPath)) {
+            for (const auto& entry : fs::directory_iterator(ToPath(inputPath))) {
                 if (entry.is_regular_file()) {
-                    auto ext = entry.path().extension().wstring();
+                    auto ext = FromPath(entry.path().extension());
                     std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
                     if (ext == L".appx" || ext == L".msix") {
                         packageFiles.push_back(entry.path());
@@ -790,7 +2567,7 @@ namespace MakeAppxCore {
             return false;
         }
 
-        fs::path outputDir = fs::path(outputPath).parent_path();
+        fs::path outputDir = ToPath(outputPath).parent_path();
         if (!outputDir.empty() && !fs::exists(outputDir)) {
             try {
                 fs::create_directories(outputDir);
@@ -801,9 +2578,79 @@ namespace MakeAppxCore {
             }
         }
 
+        if (options.volumeSize > 0) {
+            return BundleToVolumes(packageFiles, WideToUtf8Safe(bundleManifest), outputPath, options, callback);
+        }
+
         int compressionMethod = (compression == CompressionLevel::None) ? ZIP_CM_STORE : ZIP_CM_DEFLATE;
         std::string outputPathUtf8 = WideToUtf8Safe(outputPath);
 
+        std::vector<CompressedEntry> compressedEntries(packageFiles.size());
+        std::vector<bool> precompressed(packageFiles.size(), false);
+        TempDirectoryGuard dedupCacheGuard;
+
+        if (compressionMethod == ZIP_CM_DEFLATE && packageFiles.size() > 1) {
+            std::vector<PackageFile> files;
+            for (const auto& packageFile : packageFiles) {
+                PackageFile pf;
+                pf.localPath = packageFile;
+                pf.packagePath = PathToUtf8(packageFile.filename());
+                std::error_code ec;
+                pf.size = fs::file_size(packageFile, ec);
+                files.push_back(pf);
+            }
+
+            std::vector<size_t> primaryOf;
+            std::wstring dedupError;
+            if (!FindDuplicateFiles(files, primaryOf, dedupError)) {
+                SetError(dedupError);
+                return false;
+            }
+
+            size_t duplicateCount = SelectDuplicateGroups(primaryOf, precompressed);
+            if (duplicateCount > 0) {
+                dedupCacheGuard.path = ToPath(outputPath + L".dedup");
+                CompressedEntryCache cache(dedupCacheGuard.path);
+                std::wstring cacheError;
+                if (!cache.Open(cacheError)) {
+                    SetError(cacheError);
+                    return false;
+                }
+
+                std::atomic<bool> failed{ false };
+                std::mutex errorMutex;
+                {
+                    TaskGroup group(TaskClass::Cpu, BufferPool::Shared().WorkerCount(COMPRESS_WORKER_MEMORY,
+                        TaskScheduler::Shared().ThreadCount(TaskClass::Cpu)));
+                    for (size_t i = 0; i < files.size(); ++i) {
+                        if (!precompressed[i] || primaryOf[i] != i) continue;
+                        group.Run([&, i]() {
+                            std::wstring error;
+                            if (failed || cache.Store(files[i], ZlibLevelFor(compression), compressedEntries[i], error)) {
+                                return;
+                            }
+                            std::lock_guard<std::mutex> lock(errorMutex);
+                            if (!failed.exchange(true)) {
+                                cacheError = error;
+                            }
+                        }, files[i].size);
+                    }
+                }
+                if (failed) {
+                    SetError(cacheError);
+                    return false;
+                }
+
+                for (size_t i = 0; i < files.size(); ++i) {
+                    if (precompressed[i] && primaryOf[i] != i) {
+                        compressedEntries[i] = compressedEntries[primaryOf[i]];
+                    }
+                }
+
+                std::wcout << L"Deduplicated " << duplicateCount << L" identical packages" << std::endl;
+            }
+        }
+
         zip_t* zip = zip_open(outputPathUtf8.c_str(), ZIP_CREATE | ZIP_TRUNCATE, nullptr);
         if (!zip) {
             SetError(L"Failed to create bundle file");
@@ -843,26 +2690,40 @@ namespace MakeAppxCore {
         for (size_t i = 0; i < packageFiles.size(); ++i) {
             const auto& packageFile = packageFiles[i];
 
+            if (Cancelled()) {
+                zip_discard(zip);
+                zipGuard.zip = nullptr;
+                return false;
+            }
+
             if (callback) {
                 progress.processedFiles = i + 1;
                 progress.processedBytes = processedBytes;
-                progress.currentFile = packageFile.filename().wstring();
+                progress.currentFile = FromPath(packageFile.filename());
                 callback(progress);
             }
 
-            std::string localPathUtf8 = WideToUtf8Safe(packageFile.wstring());
-            std::string packageName = WideToUtf8Safe(packageFile.filename().wstring());
+            std::string localPathUtf8 = PathToUtf8(packageFile);
+            std::string packageName = PathToUtf8(packageFile.filename());
 
-            zip_source_t* source = zip_source_file(zip, localPathUtf8.c_str(), 0, -1);
+            zip_source_t* source = nullptr;
+            if (precompressed[i]) {
+                std::error_code ec;
+                time_t modifiedTime = ToTimeT(fs::last_write_time(packageFile, ec));
+                source = CreateCompressedEntrySource(zip, compressedEntries[i], ec ? time(nullptr) : modifiedTime);
+            }
+            else {
+                source = zip_source_file(zip, localPathUtf8.c_str(), 0, -1);
+            }
             if (!source) {
-                SetError(L"Failed to create source for: " + packageFile.wstring());
+                SetError(L"Failed to create source for: " + FromPath(packageFile));
                 return false;
             }
 
             zip_int64_t index = zip_file_add(zip, packageName.c_str(), source, ZIP_FL_OVERWRITE);
             if (index < 0) {
                 zip_source_free(source);
-                SetError(L"Failed to add package to bundle: " + packageFile.wstring());
+                SetError(L"Failed to add package to bundle: " + FromPath(packageFile));
                 return false;
             }
 
@@ -882,12 +2743,130 @@ namespace MakeAppxCore {
             callback(progress);
         }
 
+        WatchControl(zip, m_control.get());
+        zipGuard.zip = nullptr;
+        if (zip_close(zip) != 0) {
+            zip_discard(zip);
+            if (!Cancelled()) {
+                SetError(L"Failed to finalize bundle - ZIP close operation failed");
+            }
+            return false;
+        }
+
+        return true;
+    }
+
+    // Split bundles are written front to back through the streaming writer, so no complete copy of the
+    // bundle exists next to its volumes at any point.
+    bool AppxBundleImpl::BundleToVolumes(const std::vector<fs::path>& packageFiles, const std::string& bundleManifest,
+        const std::wstring& outputPath, const BundleOptions& options, ProgressCallback callback) {
+
+        bool store = options.compression == CompressionLevel::None;
+        int compressionLevel = ZlibLevelFor(options.compression);
+        uint16_t method = store ? ZIP_METHOD_STORE : ZIP_METHOD_DEFLATE;
+
+        VolumeWriter volumes(ToPath(outputPath), options.volumeSize);
+        ZipStreamWriter writer(StreamSink([&volumes](const uint8_t* data, size_t size) {
+            return volumes.Write(data, size);
+        }));
+        auto sink = [&writer](const uint8_t* data, size_t size) {
+            return writer.Write(data, size);
+        };
+
+        auto addEntry = [&](const std::string& name, std::istream& input, time_t modified, uint64_t size) {
+            CompressedEntry entry;
+            std::wstring error;
+            if (writer.BeginEntry(name, method, modified, size) &&
+                EncodeEntry(input, compressionLevel, store, sink, entry, error) &&
+                writer.EndEntry(entry.crc32, entry.uncompressedSize)) {
+                return true;
+            }
+            if (!volumes.GetLastError().empty()) {
+                error = volumes.GetLastError();
+            }
+            else if (!writer.GetLastError().empty()) {
+                error = writer.GetLastError();
+            }
+            SetError(error + L": " + Utf8ToWideSafe(name));
+            AddEntryError(name, m_lastError);
+            return false;
+        };
+
+        ProgressInfo progress = {};
+        progress.totalFiles = packageFiles.size() + 1;
+        for (const auto& file : packageFiles) {
+            std::error_code ec;
+            uint64_t size = fs::file_size(file, ec);
+            if (!ec) progress.totalBytes += size;
+        }
+
+        std::istringstream manifest(bundleManifest);
+        if (!addEntry("AppxBundleManifest.xml", manifest, time(nullptr), bundleManifest.size())) {
+            return false;
+        }
+
+        uint64_t processedBytes = 0;
+        for (size_t i = 0; i < packageFiles.size(); ++i) {
+            const auto& packageFile = packageFiles[i];
+
+            if (Cancelled()) {
+                return false;
+            }
+
+            if (callback) {
+                progress.processedFiles = i + 1;
+                progress.processedBytes = processedBytes;
+                progress.currentFile = FromPath(packageFile.filename());
+                callback(progress);
+            }
+
+            std::error_code ec;
+            uint64_t size = fs::file_size(packageFile, ec);
+            std::ifstream input(packageFile, std::ios::binary);
+            if (ec || !input.is_open()) {
+                SetError(L"Failed to create source for: " + FromPath(packageFile));
+                return false;
+            }
+            time_t modifiedTime = ToTimeT(fs::last_write_time(packageFile, ec));
+            if (!addEntry(PathToUtf8(packageFile.filename()), input, ec ? time(nullptr) : modifiedTime, size)) {
+                return false;
+            }
+            processedBytes += size;
+        }
+
+        if (callback) {
+            progress.processedFiles = packageFiles.size() + 1;
+            progress.processedBytes = processedBytes;
+            progress.currentFile = L"Finalizing bundle...";
+            callback(progress);
+        }
+
+        if (!writer.Finish() || !volumes.Close()) {
+            SetError(!volumes.GetLastError().empty() ? volumes.GetLastError() : writer.GetLastError());
+            return false;
+        }
         return true;
     }
 
     bool AppxBundleImpl::Unbundle(const std::wstring& inputPath, const std::wstring& outputPath,
         OverwriteMode overwrite, ProgressCallback callback) {
 
+        m_errors.clear();
+
+        std::vector<fs::path> volumes;
+        if (FindVolumes(ToPath(inputPath), volumes)) {
+            AppxPackageImpl package;
+            package.SetControl(m_control);
+            UnpackOptions options;
+            options.overwrite = overwrite;
+            bool success = package.Unpack(inputPath, outputPath, options, callback);
+            m_errors = package.GetErrors();
+            if (!success) {
+                SetError(package.GetLastError());
+            }
+            return success;
+        }
+
         std::string inputPathUtf8 = WideToUtf8Safe(inputPath);
         zip_t* zip = zip_open(inputPathUtf8.c_str(), ZIP_RDONLY, nullptr);
 
@@ -904,71 +2883,83 @@ namespace MakeAppxCore {
             }
         } zipGuard(zip);
 
-        if (!fs::exists(outputPath)) {
-            try {
-                fs::create_directories(outputPath);
-            }
-            catch (const std::exception& e) {
-                SetError(L"Failed to create output directory: " + Utf8ToWideSafe(e.what()));
-                return false;
-            }
-        }
-
         zip_int64_t numEntries = zip_get_num_entries(zip, 0);
         if (numEntries < 0) {
             SetError(L"Failed to get bundle contents");
             return false;
         }
 
-        ProgressInfo progress = {};
-        progress.totalFiles = static_cast<uint64_t>(numEntries);
-        progress.totalBytes = 0;
-
+        ExtractionPlan plan{ ToPath(outputPath) };
         for (zip_int64_t i = 0; i < numEntries; ++i) {
             const char* name = zip_get_name(zip, i, 0);
             if (!name) continue;
 
-            std::string fileName(name);
-            std::wstring fileNameW = Utf8ToWideSafe(fileName);
-            std::wstring fullPath = outputPath + L"\\" + fileNameW;
+            zip_stat_t stat;
+            zip_stat_init(&stat);
+            uint64_t size = zip_stat_index(zip, i, 0, &stat) == 0 && (stat.valid & ZIP_STAT_SIZE) ? stat.size : 0;
+            if (!plan.Add(static_cast<size_t>(i), name, size)) {
+                AddEntryError(name, plan.GetLastError());
+            }
+        }
+
+        if (!plan.Prepare(overwrite)) {
+            SetError(plan.GetLastError());
+            return false;
+        }
+
+        const std::vector<PlannedFile>& planned = plan.Files();
+        FileWriter writer;
+        ProgressInfo progress = {};
+        progress.totalFiles = static_cast<uint64_t>(planned.size());
+        progress.totalBytes = 0;
+
+        for (size_t fileIndex = 0; fileIndex < planned.size(); ++fileIndex) {
+            const PlannedFile& file = planned[fileIndex];
+
+            if (Cancelled()) {
+                return false;
+            }
 
             if (callback) {
-                progress.processedFiles = static_cast<uint64_t>(i);
-                progress.currentFile = fileNameW;
+                progress.processedFiles = static_cast<uint64_t>(fileIndex);
+                progress.currentFile = Utf8ToWideSafe(file.name);
                 callback(progress);
             }
 
-            if (fs::exists(fullPath)) {
-                if (overwrite == OverwriteMode::No) continue;
-                if (overwrite == OverwriteMode::Ask) {
-                    if (!PromptUserOverwrite(fileNameW)) {
-                        continue;
-                    }
-                }
-            }
+            if (!file.write) continue;
 
-            zip_file_t* zipFile = zip_fopen_index(zip, i, 0);
-            if (!zipFile) continue;
+            zip_file_t* zipFile = zip_fopen_index(zip, static_cast<zip_int64_t>(file.entry), 0);
+            if (!zipFile) {
+                AddEntryError(file.name, L"Failed to open entry: " + Utf8ToWideSafe(zip_strerror(zip)));
+                continue;
+            }
 
-            std::ofstream outFile(fullPath, std::ios::binary);
-            if (!outFile.is_open()) {
+            if (!writer.Open(file.path, file.size)) {
+                AddEntryError(file.name, writer.GetLastError());
                 zip_fclose(zipFile);
                 continue;
             }
 
-            char buffer[8192];
-            zip_int64_t bytesRead;
-            while ((bytesRead = zip_fread(zipFile, buffer, sizeof(buffer))) > 0) {
-                outFile.write(buffer, bytesRead);
+            size_t available = 0;
+            uint8_t* buffer;
+            zip_int64_t bytesRead = 0;
+            while ((buffer = writer.Buffer(available)) != nullptr &&
+                (bytesRead = zip_fread(zipFile, buffer, available)) > 0) {
+                writer.Commit(static_cast<size_t>(bytesRead));
                 progress.processedBytes += static_cast<uint64_t>(bytesRead);
             }
 
-            outFile.close();
+            if (bytesRead < 0) {
+                AddEntryError(file.name, L"Failed to read entry: " + Utf8ToWideSafe(zip_file_strerror(zipFile)));
+            }
+            if (!writer.Close()) {
+                AddEntryError(file.name, writer.GetLastError());
+            }
             zip_fclose(zipFile);
         }
 
         if (callback) {
-            progress.processedFiles = static_cast<uint64_t>(numEntries);
+            progress.processedFiles = static_cast<uint64_t>(planned.size());
             progress.currentFile = L"Complete";
             callback(progress);
         }
@@ -981,7 +2972,7 @@ namespace MakeAppxCore {
     }
 
     bool AppxBuilderImpl::Build(const BuildOptions& options, ProgressCallback callback) {
-        if (!fs::exists(options.layoutFile)) {
+        if (!fs::exists(ToPath(options.layoutFile))) {
             SetError(L"Layout file does not exist: " + options.layoutFile);
             return false;
         }
@@ -993,21 +2984,47 @@ namespace MakeAppxCore {
 
         auto package = CreateAppxPackage();
 
-        std::wstring tempDir = fs::temp_directory_path().wstring() + L"\\MakeAppxBuild_" +
-            std::to_wstring(GetCurrentProcessId());
+        std::wstring tempDir = FromPath(fs::temp_directory_path() / (L"MakeAppxBuild_" +
+            std::to_wstring(CurrentProcessId())));
 
         try {
-            fs::create_directories(tempDir);
+            fs::create_directories(ToPath(tempDir));
 
+            // Directories first, then the copies as I/O tasks.
+            std::vector<fs::path> destPaths;
+            std::set<fs::path> directories;
             for (const auto& file : files) {
-                fs::path destPath = fs::path(tempDir) / file.packagePath;
-                fs::create_directories(destPath.parent_path());
-                fs::copy_file(file.localPath, destPath, fs::copy_options::overwrite_existing);
+                destPaths.push_back(ToPath(tempDir) / PathFromUtf8(file.packagePath));
+                if (directories.insert(destPaths.back().parent_path()).second) {
+                    fs::create_directories(destPaths.back().parent_path());
+                }
+            }
+
+            std::mutex errorMutex;
+            std::string copyError;
+            {
+                TaskGroup group(TaskClass::Io);
+                for (size_t i = 0; i < files.size(); ++i) {
+                    group.Run([&, i]() {
+                        try {
+                            fs::copy_file(files[i].localPath, destPaths[i], fs::copy_options::overwrite_existing);
+                        }
+                        catch (const std::exception& e) {
+                            std::lock_guard<std::mutex> lock(errorMutex);
+                            if (copyError.empty()) {
+                                copyError = e.what();
+                            }
+                        }
+                    }, files[i].size);
+                }
+            }
+            if (!copyError.empty()) {
+                throw std::runtime_error(copyError);
             }
 
             bool result = package->Pack(tempDir, options.outputPath, options.compression, callback);
 
-            fs::remove_all(tempDir);
+            fs::remove_all(ToPath(tempDir));
 
             if (!result) {
                 SetError(package->GetLastError());
@@ -1017,7 +3034,7 @@ namespace MakeAppxCore {
         }
         catch (const std::exception& e) {
             try {
-                fs::remove_all(tempDir);
+                fs::remove_all(ToPath(tempDir));
             }
             catch (...) {
             }
@@ -1028,230 +3045,163 @@ namespace MakeAppxCore {
     }
 
     bool AppxBuilderImpl::ParseLayoutFile(const std::wstring& layoutFile, std::vector<PackageFile>& files) {
-        std::wifstream file(layoutFile);
-        if (!file.is_open()) {
-            SetError(L"Cannot open layout file");
+        std::wstring error;
+        if (!ReadLayoutFile(layoutFile, files, error)) {
+            SetError(error);
             return false;
         }
-
-        std::wstring line;
-        while (std::getline(file, line)) {
-            if (line.empty() || line[0] == L'#') continue;
-
-            size_t firstQuote = line.find(L'"');
-            if (firstQuote == std::wstring::npos) continue;
-
-            size_t secondQuote = line.find(L'"', firstQuote + 1);
-            if (secondQuote == std::wstring::npos) continue;
-
-            size_t thirdQuote = line.find(L'"', secondQuote + 1);
-            if (thirdQuote == std::wstring::npos) continue;
-
-            size_t fourthQuote = line.find(L'"', thirdQuote + 1);
-            if (fourthQuote == std::wstring::npos) continue;
-
-            PackageFile pf;
-            pf.localPath = line.substr(firstQuote + 1, secondQuote - firstQuote - 1);
-            pf.packagePath = line.substr(thirdQuote + 1, fourthQuote - thirdQuote - 1);
-
-            if (fs::exists(pf.localPath)) {
-                try {
-                    pf.size = fs::file_size(pf.localPath);
-                    files.push_back(pf);
-                }
-                catch (...) {
-                    continue;
-                }
-            }
-        }
-
-        return !files.empty();
+        return true;
     }
 
     bool AppxBuilderImpl::ConvertCGM(const std::wstring& sourceCGM, const std::wstring& outputCGM) {
-        if (!fs::exists(sourceCGM)) {
+        if (!fs::exists(ToPath(sourceCGM))) {
             SetError(L"Source CGM file does not exist");
             return false;
         }
 
-        try {
-            std::wifstream sourceFile(sourceCGM);
-            if (!sourceFile.is_open()) {
-                SetError(L"Cannot open source CGM file");
-                return false;
-            }
+        std::ifstream sourceFile(ToPath(sourceCGM), std::ios::binary);
+        if (!sourceFile.is_open()) {
+            SetError(L"Cannot open source CGM file");
+            return false;
+        }
 
-            std::wstring content((std::istreambuf_iterator<wchar_t>(sourceFile)),
-                std::istreambuf_iterator<wchar_t>());
-            sourceFile.close();
+        std::ofstream outputFile(ToPath(outputCGM), std::ios::binary | std::ios::trunc);
+        if (!outputFile.is_open()) {
+            SetError(L"Cannot create output CGM file");
+            return false;
+        }
 
-            if (!ValidateCGMContent(content)) {
-                return false;
-            }
+        fs::path requiredPath = ToPath(outputCGM + L".required.tmp");
+        fs::path optionalPath = ToPath(outputCGM + L".optional.tmp");
 
-            std::wstring convertedContent = TransformCGMContent(content);
-            if (convertedContent.empty()) {
-                SetError(L"CGM transformation failed");
-                return false;
+        struct SpillGuard {
+            fs::path required;
+            fs::path optional;
+            ~SpillGuard() {
+                std::error_code ec;
+                fs::remove(required, ec);
+                fs::remove(optional, ec);
             }
+        } spillGuard{ requiredPath, optionalPath };
 
-            std::wofstream outputFile(outputCGM);
-            if (!outputFile.is_open()) {
-                SetError(L"Cannot create output CGM file");
-                return false;
-            }
+        bool success = false;
+        try {
+            std::fstream requiredGroups(requiredPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+            std::fstream optionalGroups(optionalPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!requiredGroups.is_open() || !optionalGroups.is_open()) {
+                SetError(L"Cannot create temporary files next to output CGM");
+            }
+            else {
+                outputFile << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+                outputFile << "<ContentGroupMap xmlns=\"http://schemas.microsoft.com/appx/2016/contentgroupmap\"\n";
+                outputFile << "                xmlns:s=\"http://schemas.microsoft.com/appx/2016/sourcecgm\">\n";
+
+                XmlReader reader(sourceFile);
+                success = TransformContentGroups(reader, outputFile, requiredGroups, optionalGroups);
+
+                for (std::fstream* spill : { &requiredGroups, &optionalGroups }) {
+                    if (!success) break;
+                    spill->flush();
+                    if (spill->tellp() > 0) {
+                        spill->seekg(0);
+                        outputFile << spill->rdbuf();
+                    }
+                }
 
-            outputFile << convertedContent;
-            outputFile.close();
+                outputFile << "</ContentGroupMap>\n";
+                outputFile.flush();
 
-            return true;
+                if (success && !outputFile.good()) {
+                    SetError(L"Failed to write output CGM file");
+                    success = false;
+                }
+            }
         }
         catch (const std::exception& e) {
             SetError(L"CGM conversion failed: " + Utf8ToWideSafe(e.what()));
-            return false;
-        }
-    }
-
-    bool AppxBuilderImpl::ValidateCGMContent(const std::wstring& content) {
-        if (content.find(L"<ContentGroupMap") == std::wstring::npos) {
-            SetError(L"Invalid source CGM - missing ContentGroupMap element");
-            return false;
+            success = false;
         }
 
-        if (content.find(L"<Automatic") == std::wstring::npos &&
-            content.find(L"<Required") == std::wstring::npos &&
-            content.find(L"<Optional") == std::wstring::npos) {
-            SetError(L"Invalid source CGM - no content groups defined");
-            return false;
+        outputFile.close();
+        if (!success) {
+            std::error_code ec;
+            fs::remove(ToPath(outputCGM), ec);
         }
-
-        return true;
-    }
-
-    std::wstring AppxBuilderImpl::TransformCGMContent(const std::wstring& sourceContent) {
-        std::wstringstream result;
-
-        result << L"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-        result << L"<ContentGroupMap xmlns=\"http://schemas.microsoft.com/appx/2016/contentgroupmap\"\n";
-        result << L"                xmlns:s=\"http://schemas.microsoft.com/appx/2016/sourcecgm\">\n";
-
-        std::wstring transformedGroups = ParseAndTransformContentGroups(sourceContent);
-        result << transformedGroups;
-
-        result << L"</ContentGroupMap>\n";
-
-        return result.str();
+        return success;
     }
 
-    std::wstring AppxBuilderImpl::ParseAndTransformContentGroups(const std::wstring& sourceContent) {
-        std::wstringstream result;
-
-        size_t pos = 0;
-        std::wstring searchStr = L"<Automatic";
-        while ((pos = sourceContent.find(searchStr, pos)) != std::wstring::npos) {
-            size_t endPos = sourceContent.find(L">", pos);
-            if (endPos == std::wstring::npos) break;
+    bool AppxBuilderImpl::TransformContentGroups(XmlReader& reader, std::ostream& automaticGroups,
+        std::ostream& requiredGroups, std::ostream& optionalGroups) {
 
-            std::wstring groupDef = sourceContent.substr(pos, endPos - pos + 1);
-            result << L"  <Automatic>\n";
+        bool sawRoot = false;
+        size_t groupCount = 0;
+        std::ostream* group = nullptr;
+        std::string groupName;
+        size_t groupDepth = 0;
+        size_t filesDepth = 0;
+        bool filesWritten = false;
 
-            size_t filesStart = sourceContent.find(L"<Files", endPos);
-            size_t filesEnd = sourceContent.find(L"</Files>", filesStart);
+        while (reader.Read()) {
+            if (reader.NodeType() == XmlNodeType::StartElement) {
+                std::string name = reader.LocalName();
 
-            if (filesStart != std::wstring::npos && filesEnd != std::wstring::npos) {
-                std::wstring filesSection = sourceContent.substr(filesStart, filesEnd - filesStart + 8);
-                result << L"    " << TransformFilesSection(filesSection) << L"\n";
+                if (name == "ContentGroupMap") {
+                    sawRoot = true;
+                }
+                else if (!group && (name == "Automatic" || name == "Required" || name == "Optional")) {
+                    group = name == "Automatic" ? &automaticGroups :
+                        name == "Required" ? &requiredGroups : &optionalGroups;
+                    groupName = name;
+                    groupDepth = reader.Depth();
+                    filesWritten = false;
+                    ++groupCount;
+
+                    *group << "  <" << name;
+                    std::string optionalName = name == "Optional" ? reader.GetAttribute("Name") : std::string();
+                    if (!optionalName.empty()) {
+                        *group << " Name=\"" << XmlEscape(optionalName) << "\"";
+                    }
+                    *group << ">\n";
+                }
+                else if (group && !filesDepth && !filesWritten && name == "Files") {
+                    *group << "    <Files>\n";
+                    filesDepth = reader.Depth();
+                }
+                else if (filesDepth && name == "File") {
+                    std::string fileName = reader.GetAttribute("Name");
+                    if (!fileName.empty()) {
+                        *group << "      <File Name=\"" << XmlEscape(fileName) << "\" />\n";
+                    }
+                }
             }
-
-            result << L"  </Automatic>\n";
-            pos = endPos + 1;
-        }
-
-        pos = 0;
-        searchStr = L"<Required";
-        while ((pos = sourceContent.find(searchStr, pos)) != std::wstring::npos) {
-            size_t endPos = sourceContent.find(L">", pos);
-            if (endPos == std::wstring::npos) break;
-
-            result << L"  <Required>\n";
-
-            size_t filesStart = sourceContent.find(L"<Files", endPos);
-            size_t filesEnd = sourceContent.find(L"</Files>", filesStart);
-
-            if (filesStart != std::wstring::npos && filesEnd != std::wstring::npos) {
-                std::wstring filesSection = sourceContent.substr(filesStart, filesEnd - filesStart + 8);
-                result << L"    " << TransformFilesSection(filesSection) << L"\n";
+            else if (reader.NodeType() == XmlNodeType::EndElement) {
+                if (filesDepth && reader.Depth() + 1 == filesDepth) {
+                    *group << "    </Files>\n";
+                    filesDepth = 0;
+                    filesWritten = true;
+                }
+                else if (group && reader.Depth() + 1 == groupDepth) {
+                    *group << "  </" << groupName << ">\n";
+                    group = nullptr;
+                }
             }
-
-            result << L"  </Required>\n";
-            pos = endPos + 1;
         }
 
-        pos = 0;
-        searchStr = L"<Optional";
-        while ((pos = sourceContent.find(searchStr, pos)) != std::wstring::npos) {
-            size_t endPos = sourceContent.find(L">", pos);
-            if (endPos == std::wstring::npos) break;
-
-            std::wstring groupName = ExtractAttribute(sourceContent.substr(pos, endPos - pos), L"Name");
-
-            result << L"  <Optional";
-            if (!groupName.empty()) {
-                result << L" Name=\"" << groupName << L"\"";
-            }
-            result << L">\n";
-
-            size_t filesStart = sourceContent.find(L"<Files", endPos);
-            size_t filesEnd = sourceContent.find(L"</Files>", filesStart);
-
-            if (filesStart != std::wstring::npos && filesEnd != std::wstring::npos) {
-                std::wstring filesSection = sourceContent.substr(filesStart, filesEnd - filesStart + 8);
-                result << L"    " << TransformFilesSection(filesSection) << L"\n";
-            }
-
-            result << L"  </Optional>\n";
-            pos = endPos + 1;
+        if (reader.HasError()) {
+            SetError(L"Invalid source CGM - " + reader.GetLastError());
+            return false;
         }
 
-        return result.str();
-    }
-
-    std::wstring AppxBuilderImpl::TransformFilesSection(const std::wstring& filesSection) {
-        std::wstringstream result;
-        result << L"<Files>\n";
-
-        size_t pos = 0;
-        std::wstring searchStr = L"<File";
-        while ((pos = filesSection.find(searchStr, pos)) != std::wstring::npos) {
-            size_t endPos = filesSection.find(L"/>", pos);
-            if (endPos == std::wstring::npos) {
-                endPos = filesSection.find(L">", pos);
-                if (endPos == std::wstring::npos) break;
-            }
-
-            std::wstring fileDef = filesSection.substr(pos, endPos - pos + 2);
-
-            std::wstring fileName = ExtractAttribute(fileDef, L"Name");
-            if (!fileName.empty()) {
-                result << L"      <File Name=\"" << fileName << L"\" />\n";
-            }
-
-            pos = endPos + 2;
+        if (!sawRoot) {
+            SetError(L"Invalid source CGM - missing ContentGroupMap element");
+            return false;
         }
 
-        result << L"    </Files>";
-        return result.str();
-    }
-
-    std::wstring AppxBuilderImpl::ExtractAttribute(const std::wstring& xmlElement, const std::wstring& attributeName) {
-        std::wstring searchStr = attributeName + L"=\"";
-        size_t pos = xmlElement.find(searchStr);
-        if (pos == std::wstring::npos) return L"";
-
-        pos += searchStr.length();
-        size_t endPos = xmlElement.find(L"\"", pos);
-        if (endPos == std::wstring::npos) return L"";
+        if (groupCount == 0) {
+            SetError(L"Invalid source CGM - no content groups defined");
+            return false;
+        }
 
-        return xmlElement.substr(pos, endPos - pos);
+        return true;
     }
-}
\ No newline at end of file
+}
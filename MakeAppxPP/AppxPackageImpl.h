@@ -1,5 +1,19 @@
 #pragma once
 #include "AppxPackage.h"
+#include "Platform.h"
+#include "EntryCache.h"
+#include "XmlReader.h"
+#include "ContentGroupMap.h"
+#include "LayoutFile.h"
+#include "PathMatcher.h"
+#include "ExtractionPlan.h"
+#include "FileWriter.h"
+#include "BufferPool.h"
+#include "AsyncOperation.h"
+#include "PackJournal.h"
+#include "VolumeSet.h"
+#include "DirectoryWatcher.h"
+#include "TaskScheduler.h"
 #include <zip.h>
 #include <memory>
 #include <filesystem>
@@ -9,21 +23,35 @@ namespace MakeAppxCore {
 
     namespace fs = std::filesystem;
 
-    std::string WideToUtf8Safe(const std::wstring& wstr);
-    std::wstring Utf8ToWideSafe(const std::string& str);
+    class ZipDirectory;
+
+    std::string NormalizeEntryName(const std::string& name);
+    void DescribePackage(const ZipDirectory& directory, uint64_t fileSize, PackageInfo& info);
 
     class AppxPackageImpl : public IAppxPackage {
     private:
         std::wstring m_lastError;
-        static constexpr size_t BUFFER_SIZE = 8192;
+        std::vector<OperationError> m_errors;
+        std::shared_ptr<OperationControl> m_control;
 
         bool ValidateManifest(const std::wstring& manifestPath);
         bool ProcessFileTree(const std::wstring& rootPath,
             std::vector<PackageFile>& files);
+        bool BuildUnpackFilter(const UnpackOptions& options, PathMatcher& include, PathMatcher& exclude);
+        bool CompressEntries(const std::vector<PackageFile>& files, const std::vector<size_t>& primaryOf,
+            CompressedEntryCache& cache, int level, std::vector<CompressedEntry>& entries,
+            ProgressInfo& progress, ProgressCallback callback);
+        bool PackToStream(const std::wstring& inputPath, const std::wstring& outputPath,
+            const PackOptions& options, ProgressCallback callback);
+        bool RecoverPartialPackage(const fs::path& packagePath, const std::vector<PackageFile>& files,
+            int zlibLevel, PackJournal& journal, std::vector<JournalEntry>& recovered);
+        bool UnpackFromStream(const std::wstring& outputPath, const UnpackOptions& options,
+            PathMatcher& include, PathMatcher& exclude, ProgressCallback callback);
+        bool UnpackVolumes(const std::vector<fs::path>& volumes, const std::wstring& outputPath,
+            const UnpackOptions& options, PathMatcher& include, PathMatcher& exclude, ProgressCallback callback);
         void SetError(const std::wstring& error);
-        std::wstring WideToUtf8(const std::wstring& wide);
-        std::wstring Utf8ToWide(const std::string& utf8);
-        bool PromptUserOverwrite(const std::wstring& filePath);
+        void AddEntryError(const std::string& entry, const std::wstring& message);
+        bool Cancelled();
 
     public:
         AppxPackageImpl() = default;
@@ -33,26 +61,58 @@ namespace MakeAppxCore {
             CompressionLevel compression = CompressionLevel::Normal,
             ProgressCallback callback = nullptr) override;
 
+        bool Pack(const std::wstring& inputPath, const std::wstring& outputPath,
+            const PackOptions& options, ProgressCallback callback = nullptr) override;
+
         bool Unpack(const std::wstring& inputPath, const std::wstring& outputPath,
             OverwriteMode overwrite = OverwriteMode::Ask,
             ProgressCallback callback = nullptr) override;
 
+        bool Unpack(const std::wstring& inputPath, const std::wstring& outputPath,
+            const UnpackOptions& options, ProgressCallback callback = nullptr) override;
+
+        bool Update(const std::wstring& packagePath, const std::wstring& changesPath,
+            const PackOptions& options, ProgressCallback callback = nullptr) override;
+
+        bool Watch(const std::wstring& inputPath, const std::wstring& outputPath,
+            const WatchOptions& options, ProgressCallback callback = nullptr) override;
+
+        bool Inspect(const std::wstring& packagePath, PackageInfo& info, bool readManifest = false) override;
+
+        bool Verify(const std::wstring& packagePath, VerifyResult& result, ProgressCallback callback = nullptr) override;
+
+        bool Diff(const std::wstring& oldPackage, const std::wstring& newPackage,
+            PackageDiff& diff, bool compareBlockMaps = false) override;
+
+        bool CreateDelta(const std::wstring& oldPackage, const std::wstring& newPackage,
+            const std::wstring& patchPath, DeltaStats& stats, ProgressCallback callback = nullptr) override;
+
+        bool ApplyDelta(const std::wstring& oldPackage, const std::wstring& patchPath,
+            const std::wstring& outputPath, ProgressCallback callback = nullptr) override;
+
         bool Encrypt(const std::wstring& inputPath, const std::wstring& outputPath,
             const std::wstring& keyFile) override;
 
         bool Decrypt(const std::wstring& inputPath, const std::wstring& outputPath,
             const std::wstring& keyFile) override;
 
+        void SetControl(std::shared_ptr<OperationControl> control) override { m_control = std::move(control); }
+        std::vector<OperationError> GetErrors() const override { return m_errors; }
         std::wstring GetLastError() const override { return m_lastError; }
     };
 
     class AppxBundleImpl : public IAppxBundle {
     private:
         std::wstring m_lastError;
+        std::vector<OperationError> m_errors;
+        std::shared_ptr<OperationControl> m_control;
         void SetError(const std::wstring& error);
+        void AddEntryError(const std::string& entry, const std::wstring& message);
+        bool Cancelled();
         std::wstring GenerateBundleManifest(const std::vector<fs::path>& packageFiles);
         std::wstring ExtractPackageIdentity(const fs::path& packagePath);
-        bool PromptUserOverwrite(const std::wstring& filePath);
+        bool BundleToVolumes(const std::vector<fs::path>& packageFiles, const std::string& bundleManifest,
+            const std::wstring& outputPath, const BundleOptions& options, ProgressCallback callback);
 
     public:
         AppxBundleImpl() = default;
@@ -62,10 +122,15 @@ namespace MakeAppxCore {
             CompressionLevel compression = CompressionLevel::Normal,
             ProgressCallback callback = nullptr) override;
 
+        bool Bundle(const std::wstring& inputPath, const std::wstring& outputPath,
+            const BundleOptions& options, ProgressCallback callback = nullptr) override;
+
         bool Unbundle(const std::wstring& inputPath, const std::wstring& outputPath,
             OverwriteMode overwrite = OverwriteMode::Ask,
             ProgressCallback callback = nullptr) override;
 
+        void SetControl(std::shared_ptr<OperationControl> control) override { m_control = std::move(control); }
+        std::vector<OperationError> GetErrors() const override { return m_errors; }
         std::wstring GetLastError() const override { return m_lastError; }
     };
 
@@ -75,11 +140,8 @@ namespace MakeAppxCore {
         void SetError(const std::wstring& error);
         bool ParseLayoutFile(const std::wstring& layoutFile, std::vector<PackageFile>& files);
 
-        bool ValidateCGMContent(const std::wstring& content);
-        std::wstring TransformCGMContent(const std::wstring& sourceContent);
-        std::wstring ParseAndTransformContentGroups(const std::wstring& sourceContent);
-        std::wstring TransformFilesSection(const std::wstring& filesSection);
-        std::wstring ExtractAttribute(const std::wstring& xmlElement, const std::wstring& attributeName);
+        bool TransformContentGroups(XmlReader& reader, std::ostream& automaticGroups,
+            std::ostream& requiredGroups, std::ostream& optionalGroups);
 
     public:
         AppxBuilderImpl() = default;
@@ -0,0 +1,206 @@
+#include "AsyncOperation.h"
+#include "BufferPool.h"
+#include "Platform.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+
+namespace MakeAppxCore {
+
+    void OperationControl::Cancel() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+        m_changed.notify_all();
+    }
+
+    void OperationControl::Pause() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_paused = true;
+    }
+
+    void OperationControl::Resume() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_paused = false;
+        m_changed.notify_all();
+    }
+
+    bool OperationControl::IsPaused() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_paused;
+    }
+
+    bool OperationControl::Checkpoint() {
+        if (m_cancelled) return false;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return !m_paused || m_cancelled; });
+        return !m_cancelled;
+    }
+
+    OperationExecutor::OperationExecutor(size_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max<size_t>(2, std::thread::hardware_concurrency() / 2);
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back(&OperationExecutor::WorkerLoop, this);
+        }
+    }
+
+    // Queued operations still run; cancel them first to shut down quickly.
+    OperationExecutor::~OperationExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_available.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    OperationExecutor& OperationExecutor::Shared() {
+        // Operations running at exit still use the buffer pool and the task scheduler, so both have to be
+        // destroyed after the executor.
+        BufferPool::Shared();
+        TaskScheduler::Shared();
+        static OperationExecutor executor;
+        return executor;
+    }
+
+    void OperationExecutor::Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_available.notify_one();
+    }
+
+    void OperationExecutor::WorkerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_available.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+                if (m_tasks.empty()) return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    OperationStatus OperationHandle::Status() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_status;
+    }
+
+    ProgressInfo OperationHandle::Progress() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_progress;
+    }
+
+    std::wstring OperationHandle::GetLastError() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastError;
+    }
+
+    std::vector<OperationError> OperationHandle::GetErrors() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_errors;
+    }
+
+    bool OperationHandle::Wait() const {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this] { return m_status != OperationStatus::Queued && m_status != OperationStatus::Running; });
+        return m_status == OperationStatus::Succeeded;
+    }
+
+    bool OperationHandle::WaitFor(std::chrono::milliseconds timeout) const {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_finished.wait_for(lock, timeout,
+            [this] { return m_status != OperationStatus::Queued && m_status != OperationStatus::Running; });
+    }
+
+    class AsyncOperationRunner {
+    public:
+        // Runs one engine call on the executor and publishes its progress and outcome on the handle.
+        template <typename Engine, typename Run>
+        static OperationPtr Launch(std::unique_ptr<Engine> engine, ProgressCallback callback,
+            OperationExecutor* executor, Run run) {
+
+            auto handle = std::make_shared<OperationHandle>();
+            std::shared_ptr<Engine> shared(std::move(engine));
+            shared->SetControl(handle->m_control);
+
+            (executor ? *executor : OperationExecutor::Shared()).Submit([handle, shared, callback, run]() {
+                {
+                    std::lock_guard<std::mutex> lock(handle->m_mutex);
+                    if (handle->m_control->IsCancelled()) {
+                        handle->m_status = OperationStatus::Cancelled;
+                        handle->m_lastError = L"Operation cancelled";
+                        handle->m_finished.notify_all();
+                        return;
+                    }
+                    handle->m_status = OperationStatus::Running;
+                }
+
+                ProgressCallback report = [&handle, &callback](const ProgressInfo& progress) {
+                    {
+                        std::lock_guard<std::mutex> lock(handle->m_mutex);
+                        handle->m_progress = progress;
+                    }
+                    if (callback) callback(progress);
+                };
+
+                bool success = false;
+                std::wstring error;
+                try {
+                    success = run(*shared, report);
+                    error = success ? std::wstring() : shared->GetLastError();
+                }
+                catch (const std::exception& e) {
+                    error = L"Unexpected error: " + Utf8ToWideSafe(e.what());
+                }
+
+                std::lock_guard<std::mutex> lock(handle->m_mutex);
+                handle->m_status = success ? OperationStatus::Succeeded :
+                    handle->m_control->IsCancelled() ? OperationStatus::Cancelled : OperationStatus::Failed;
+                handle->m_lastError = std::move(error);
+                handle->m_errors = shared->GetErrors();
+                handle->m_finished.notify_all();
+            });
+
+            return handle;
+        }
+    };
+
+    OperationPtr PackAsync(const std::wstring& inputPath, const std::wstring& outputPath,
+        const PackOptions& options, ProgressCallback callback, OperationExecutor* executor) {
+
+        return AsyncOperationRunner::Launch(CreateAppxPackage(), callback, executor,
+            [inputPath, outputPath, options](IAppxPackage& package, ProgressCallback report) {
+                return package.Pack(inputPath, outputPath, options, report);
+            });
+    }
+
+    OperationPtr UnpackAsync(const std::wstring& inputPath, const std::wstring& outputPath,
+        const UnpackOptions& options, ProgressCallback callback, OperationExecutor* executor) {
+
+        UnpackOptions unpackOptions = options;
+        if (unpackOptions.overwrite == OverwriteMode::Ask) {
+            unpackOptions.overwrite = OverwriteMode::No;
+        }
+        return AsyncOperationRunner::Launch(CreateAppxPackage(), callback, executor,
+            [inputPath, outputPath, unpackOptions](IAppxPackage& package, ProgressCallback report) {
+                return package.Unpack(inputPath, outputPath, unpackOptions, report);
+            });
+    }
+
+    OperationPtr BundleAsync(const std::wstring& inputPath, const std::wstring& outputPath,
+        CompressionLevel compression, ProgressCallback callback, OperationExecutor* executor) {
+
+        return AsyncOperationRunner::Launch(CreateAppxBundle(), callback, executor,
+            [inputPath, outputPath, compression](IAppxBundle& bundle, ProgressCallback report) {
+                return bundle.Bundle(inputPath, outputPath, compression, report);
+            });
+    }
+}
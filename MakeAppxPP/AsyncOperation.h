@@ -0,0 +1,109 @@
+#pragma once
+#include "AppxPackage.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    // Cancels, pauses and resumes a running operation from another thread. Operations check it between
+    // entries, so a pause or cancel takes effect once the entries in flight are finished.
+    class OperationControl {
+    private:
+        mutable std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::atomic<bool> m_cancelled{ false };
+        bool m_paused = false;
+
+    public:
+        void Cancel();
+        void Pause();
+        void Resume();
+        bool IsCancelled() const { return m_cancelled; }
+        bool IsPaused() const;
+
+        // Blocks while the operation is paused. Returns false once it has been cancelled.
+        bool Checkpoint();
+    };
+
+    // A fixed set of threads running whole operations in submission order. The operations parallelize
+    // their own stages, so a few threads are enough to keep several of them going at once.
+    class OperationExecutor {
+    private:
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_available;
+        bool m_stopping = false;
+
+        void WorkerLoop();
+
+    public:
+        explicit OperationExecutor(size_t threadCount = 0);
+        ~OperationExecutor();
+
+        OperationExecutor(const OperationExecutor&) = delete;
+        OperationExecutor& operator=(const OperationExecutor&) = delete;
+
+        static OperationExecutor& Shared();
+
+        size_t ThreadCount() const { return m_threads.size(); }
+        void Submit(std::function<void()> task);
+    };
+
+    enum class OperationStatus {
+        Queued,
+        Running,
+        Succeeded,
+        Failed,
+        Cancelled
+    };
+
+    // The caller's view of an asynchronous operation. Progress and errors can be read at any time;
+    // the progress callback, if any, runs on the executor thread.
+    class OperationHandle {
+    private:
+        friend class AsyncOperationRunner;
+
+        std::shared_ptr<OperationControl> m_control = std::make_shared<OperationControl>();
+        mutable std::mutex m_mutex;
+        mutable std::condition_variable m_finished;
+        OperationStatus m_status = OperationStatus::Queued;
+        ProgressInfo m_progress = {};
+        std::wstring m_lastError;
+        std::vector<OperationError> m_errors;
+
+    public:
+        void Cancel() { m_control->Cancel(); }
+        void Pause() { m_control->Pause(); }
+        void Resume() { m_control->Resume(); }
+        bool IsPaused() const { return m_control->IsPaused(); }
+
+        OperationStatus Status() const;
+        ProgressInfo Progress() const;
+        std::wstring GetLastError() const;
+        std::vector<OperationError> GetErrors() const;
+
+        // Wait returns whether the operation succeeded; WaitFor whether it finished within the timeout.
+        bool Wait() const;
+        bool WaitFor(std::chrono::milliseconds timeout) const;
+    };
+
+    using OperationPtr = std::shared_ptr<OperationHandle>;
+
+    // Each operation gets its own engine, so any number can run concurrently. OverwriteMode::Ask cannot
+    // prompt from an executor thread and is treated as No. A null executor means OperationExecutor::Shared().
+    OperationPtr PackAsync(const std::wstring& inputPath, const std::wstring& outputPath,
+        const PackOptions& options, ProgressCallback callback = nullptr, OperationExecutor* executor = nullptr);
+    OperationPtr UnpackAsync(const std::wstring& inputPath, const std::wstring& outputPath,
+        const UnpackOptions& options, ProgressCallback callback = nullptr, OperationExecutor* executor = nullptr);
+    OperationPtr BundleAsync(const std::wstring& inputPath, const std::wstring& outputPath,
+        CompressionLevel compression = CompressionLevel::Normal, ProgressCallback callback = nullptr,
+        OperationExecutor* executor = nullptr);
+}
@@ -0,0 +1,165 @@
+#include "BlockMap.h"
+#include "XmlReader.h"
+#include <algorithm>
+#include <sstream>
+
+namespace MakeAppxCore {
+
+    namespace {
+        const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        int Base64Value(char c) {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+') return 62;
+            if (c == '/') return 63;
+            return -1;
+        }
+
+        std::string ToBlockMapName(const std::string& entryName) {
+            std::string name = entryName;
+            std::replace(name.begin(), name.end(), '/', '\\');
+            return name;
+        }
+    }
+
+    std::string Base64Encode(const uint8_t* data, size_t size) {
+        std::string result;
+        result.reserve((size + 2) / 3 * 4);
+
+        size_t i = 0;
+        for (; i + 2 < size; i += 3) {
+            uint32_t triple = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+            result += BASE64_ALPHABET[(triple >> 18) & 0x3F];
+            result += BASE64_ALPHABET[(triple >> 12) & 0x3F];
+            result += BASE64_ALPHABET[(triple >> 6) & 0x3F];
+            result += BASE64_ALPHABET[triple & 0x3F];
+        }
+
+        if (i < size) {
+            uint32_t triple = data[i] << 16;
+            if (i + 1 < size) triple |= data[i + 1] << 8;
+            result += BASE64_ALPHABET[(triple >> 18) & 0x3F];
+            result += BASE64_ALPHABET[(triple >> 12) & 0x3F];
+            result += (i + 1 < size) ? BASE64_ALPHABET[(triple >> 6) & 0x3F] : '=';
+            result += '=';
+        }
+
+        return result;
+    }
+
+    bool Base64Decode(const std::string& text, std::vector<uint8_t>& data) {
+        data.clear();
+        uint32_t buffer = 0;
+        int bits = 0;
+
+        for (char c : text) {
+            if (c == '=') break;
+            int value = Base64Value(c);
+            if (value < 0) return false;
+            buffer = (buffer << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                data.push_back(static_cast<uint8_t>((buffer >> bits) & 0xFF));
+            }
+        }
+
+        return true;
+    }
+
+    bool IsFootprintFile(const std::string& normalizedName) {
+        return normalizedName == "appxblockmap.xml" || normalizedName == "appxsignature.p7x" ||
+            normalizedName == "[content_types].xml";
+    }
+
+    std::string GenerateBlockMapXml(const std::vector<BlockMapEntry>& entries) {
+        std::string xml;
+        xml += "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n";
+        xml += "<BlockMap xmlns=\"http://schemas.microsoft.com/appx/2010/blockmap\" ";
+        xml += "HashMethod=\"http://www.w3.org/2001/04/xmlenc#sha256\">\n";
+
+        for (const auto& entry : entries) {
+            xml += "  <File Name=\"" + XmlEscape(ToBlockMapName(entry.name)) + "\" Size=\"" +
+                std::to_string(entry.size) + "\" LfhSize=\"" + std::to_string(entry.lfhSize) + "\"";
+
+            if (entry.blocks.empty()) {
+                xml += " />\n";
+                continue;
+            }
+
+            xml += ">\n";
+            for (const auto& block : entry.blocks) {
+                xml += "    <Block Hash=\"" + Base64Encode(block.hash.data(), block.hash.size()) + "\"";
+                if (block.compressedSize > 0) {
+                    xml += " Size=\"" + std::to_string(block.compressedSize) + "\"";
+                }
+                xml += " />\n";
+            }
+            xml += "  </File>\n";
+        }
+
+        xml += "</BlockMap>\n";
+        return xml;
+    }
+
+    bool ParseBlockMapXml(const std::string& xml, std::vector<BlockMapEntry>& entries) {
+        entries.clear();
+
+        std::istringstream stream(xml);
+        XmlReader reader(stream);
+        bool sawRoot = false;
+        bool inFile = false;
+
+        while (reader.Read()) {
+            if (reader.NodeType() == XmlNodeType::EndElement) {
+                if (reader.LocalName() == "File") inFile = false;
+                continue;
+            }
+            if (reader.NodeType() != XmlNodeType::StartElement) continue;
+
+            std::string name = reader.LocalName();
+            if (name == "BlockMap") {
+                sawRoot = true;
+            }
+            else if (name == "File") {
+                BlockMapEntry entry;
+                entry.name = reader.GetAttribute("Name");
+                std::replace(entry.name.begin(), entry.name.end(), '\\', '/');
+                try {
+                    entry.size = std::stoull(reader.GetAttribute("Size"));
+                    entry.lfhSize = static_cast<uint32_t>(std::stoul(reader.GetAttribute("LfhSize")));
+                }
+                catch (...) {
+                    return false;
+                }
+                entries.push_back(std::move(entry));
+                inFile = true;
+            }
+            else if (name == "Block") {
+                if (!inFile) return false;
+
+                std::vector<uint8_t> hash;
+                if (!Base64Decode(reader.GetAttribute("Hash"), hash) || hash.size() != Sha256::DIGEST_SIZE) {
+                    return false;
+                }
+
+                BlockMapBlock block = {};
+                std::copy(hash.begin(), hash.end(), block.hash.begin());
+                std::string size = reader.GetAttribute("Size");
+                if (!size.empty()) {
+                    try {
+                        block.compressedSize = static_cast<uint32_t>(std::stoul(size));
+                    }
+                    catch (...) {
+                        return false;
+                    }
+                }
+                entries.back().blocks.push_back(block);
+            }
+        }
+
+        return sawRoot && !reader.HasError();
+    }
+}
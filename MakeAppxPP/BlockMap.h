@@ -0,0 +1,32 @@
+#pragma once
+#include "Sha256.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace MakeAppxCore {
+
+    constexpr size_t BLOCK_MAP_BLOCK_SIZE = 65536;
+    constexpr const char* BLOCK_MAP_ENTRY_NAME = "AppxBlockMap.xml";
+
+    struct BlockMapBlock {
+        Sha256::Digest hash;
+        uint32_t compressedSize;
+    };
+
+    struct BlockMapEntry {
+        std::string name;
+        uint64_t size = 0;
+        uint32_t lfhSize = 0;
+        std::vector<BlockMapBlock> blocks;
+    };
+
+    // The package files a block map never lists; takes a name from NormalizeEntryName.
+    bool IsFootprintFile(const std::string& normalizedName);
+
+    std::string GenerateBlockMapXml(const std::vector<BlockMapEntry>& entries);
+    bool ParseBlockMapXml(const std::string& xml, std::vector<BlockMapEntry>& entries);
+
+    std::string Base64Encode(const uint8_t* data, size_t size);
+    bool Base64Decode(const std::string& text, std::vector<uint8_t>& data);
+}
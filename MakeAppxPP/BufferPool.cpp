@@ -0,0 +1,163 @@
+#include "BufferPool.h"
+#include <algorithm>
+
+namespace MakeAppxCore {
+
+    BufferPool& BufferPool::Shared() {
+        static BufferPool pool;
+        return pool;
+    }
+
+    BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other) noexcept {
+        if (this != &other) {
+            Release();
+            m_pool = other.m_pool;
+            m_block = std::move(other.m_block);
+            m_owner = other.m_owner;
+            other.m_pool = nullptr;
+            other.m_block = Block();
+        }
+        return *this;
+    }
+
+    void BufferPool::Lease::Release() {
+        if (!m_pool) return;
+        if (m_block.storage) {
+            m_pool->Return(std::move(m_block), m_owner);
+        }
+        else {
+            m_pool->Credit(m_block.size, m_owner);
+        }
+        m_pool = nullptr;
+        m_block = Block();
+    }
+
+    void BufferPool::SetLimit(uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_limit = bytes;
+        m_released.notify_all();
+    }
+
+    uint64_t BufferPool::Limit() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_limit;
+    }
+
+    uint64_t BufferPool::InUse() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_used;
+    }
+
+    uint64_t BufferPool::Peak() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_peak;
+    }
+
+    // Cached blocks count as used memory, so they are dropped first when a request does not fit.
+    // A thread already holding memory never waits, or two threads each holding their first buffer
+    // could wait for each other forever; so could one thread waiting for itself.
+    void BufferPool::Charge(size_t size, std::unique_lock<std::mutex>& lock) {
+        std::thread::id self = std::this_thread::get_id();
+        while (m_limit != 0 && m_used != 0 && m_used + size > m_limit) {
+            if (!m_cached.empty()) {
+                m_used -= m_cached.back().size;
+                m_cached.pop_back();
+                continue;
+            }
+            if (m_held.count(self)) break;
+            m_released.wait(lock);
+        }
+        m_used += size;
+        m_peak = std::max(m_peak, m_used);
+        Hold(self, size);
+    }
+
+    void BufferPool::Hold(std::thread::id owner, size_t size) {
+        m_held[owner] += size;
+    }
+
+    void BufferPool::Drop(std::thread::id owner, size_t size) {
+        auto held = m_held.find(owner);
+        if (held == m_held.end()) return;
+        held->second -= std::min<uint64_t>(held->second, size);
+        if (held->second == 0) {
+            m_held.erase(held);
+        }
+    }
+
+    void BufferPool::Return(Block&& block, std::thread::id owner) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Drop(owner, block.size);
+        if (m_cached.size() < MAX_CACHED_BLOCKS) {
+            m_cached.push_back(std::move(block));
+        }
+        else {
+            m_used -= block.size;
+        }
+        m_released.notify_all();
+    }
+
+    void BufferPool::Credit(size_t size, std::thread::id owner) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Drop(owner, size);
+        m_used -= size;
+        m_released.notify_all();
+    }
+
+    BufferPool::Lease BufferPool::Acquire(size_t size) {
+        Lease lease;
+        lease.m_pool = this;
+        lease.m_owner = std::this_thread::get_id();
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto cached = std::find_if(m_cached.begin(), m_cached.end(), [size](const Block& block) {
+                return block.size == size;
+            });
+            if (cached != m_cached.end()) {
+                lease.m_block = std::move(*cached);
+                m_cached.erase(cached);
+                Hold(lease.m_owner, size);
+                return lease;
+            }
+            Charge(size, lock);
+        }
+
+        Block& block = lease.m_block;
+        block.storage.reset(new uint8_t[size + ALIGNMENT]);
+        uintptr_t address = reinterpret_cast<uintptr_t>(block.storage.get());
+        block.data = block.storage.get() + (ALIGNMENT - address % ALIGNMENT) % ALIGNMENT;
+        block.size = size;
+        return lease;
+    }
+
+    BufferPool::Lease BufferPool::Reserve(size_t size) {
+        Lease lease;
+        lease.m_pool = this;
+        lease.m_block.size = size;
+        lease.m_owner = std::this_thread::get_id();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        Charge(size, lock);
+        return lease;
+    }
+
+    size_t BufferPool::WorkerCount(size_t bytesPerWorker, size_t maxWorkers) const {
+        maxWorkers = std::max<size_t>(1, maxWorkers);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_limit == 0 || bytesPerWorker == 0) return maxWorkers;
+
+        uint64_t available = m_limit > m_used ? m_limit - m_used : 0;
+        return static_cast<size_t>(std::clamp<uint64_t>(available / bytesPerWorker, 1, maxWorkers));
+    }
+
+    size_t BufferPool::BufferSize(size_t preferred, size_t minimum, size_t shares) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_limit == 0) return preferred;
+
+        uint64_t share = m_limit / std::max<size_t>(1, shares);
+        size_t size = static_cast<size_t>(std::clamp<uint64_t>(share, minimum, preferred));
+        return size >= ALIGNMENT ? size / ALIGNMENT * ALIGNMENT : size;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    // Process-wide budget for the working buffers of streaming operations. With a limit set, requests
+    // wait until they fit; a request larger than the whole budget is granted once nothing else is held.
+    // Only a thread that holds nothing waits: one that asks for its next buffer while holding the first
+    // is granted at once, since waiting could leave every thread waiting on the others. Workers are sized
+    // with WorkerCount so that this never goes far past the limit.
+    class BufferPool {
+    private:
+        struct Block {
+            std::unique_ptr<uint8_t[]> storage;
+            uint8_t* data = nullptr;
+            size_t size = 0;
+        };
+
+        static constexpr size_t MAX_CACHED_BLOCKS = 16;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_released;
+        uint64_t m_limit = 0;
+        uint64_t m_used = 0;
+        uint64_t m_peak = 0;
+        std::vector<Block> m_cached;
+        std::unordered_map<std::thread::id, uint64_t> m_held;
+
+        void Charge(size_t size, std::unique_lock<std::mutex>& lock);
+        void Hold(std::thread::id owner, size_t size);
+        void Drop(std::thread::id owner, size_t size);
+        void Return(Block&& block, std::thread::id owner);
+        void Credit(size_t size, std::thread::id owner);
+
+    public:
+        static constexpr size_t ALIGNMENT = 4096;
+
+        // The smallest limit that fits the largest single worker: a volume writer's file buffer and its input.
+        static constexpr uint64_t MIN_LIMIT = 2 * 1024 * 1024;
+
+        // Owns either a pooled buffer or a plain reservation for memory allocated elsewhere.
+        class Lease {
+        private:
+            friend class BufferPool;
+
+            BufferPool* m_pool = nullptr;
+            Block m_block;
+            std::thread::id m_owner;
+
+        public:
+            Lease() = default;
+            ~Lease() { Release(); }
+
+            Lease(Lease&& other) noexcept { *this = std::move(other); }
+            Lease& operator=(Lease&& other) noexcept;
+
+            uint8_t* Data() const { return m_block.data; }
+            size_t Size() const { return m_block.size; }
+            void Release();
+        };
+
+        static BufferPool& Shared();
+
+        void SetLimit(uint64_t bytes);
+        uint64_t Limit() const;
+        uint64_t InUse() const;
+        uint64_t Peak() const;
+
+        Lease Acquire(size_t size);
+        Lease Reserve(size_t size);
+
+        size_t WorkerCount(size_t bytesPerWorker, size_t maxWorkers) const;
+        size_t BufferSize(size_t preferred, size_t minimum, size_t shares = 1) const;
+    };
+}
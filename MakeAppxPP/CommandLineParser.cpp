@@ -1,15 +1,204 @@
 ﻿#include "CommandLineParser.h"
+#include "PackagingServer.h"
+#include "AppxPackageImpl.h"
+#include "JsonUtil.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
 #include <filesystem>
 #include <chrono>
+#include <cstdio>
 
 namespace fs = std::filesystem;
 
 namespace MakeAppxPP {
 
+    namespace {
+        const wchar_t* MethodName(uint16_t method) {
+            switch (method) {
+            case 0: return L"store";
+            case 8: return L"deflate";
+            default: return L"other";
+            }
+        }
+
+        double CompressionPercent(uint64_t compressed, uint64_t uncompressed) {
+            return uncompressed > 0 ? static_cast<double>(compressed) / uncompressed * 100.0 : 100.0;
+        }
+
+        std::string Crc32Hex(uint32_t crc) {
+            char buffer[9];
+            snprintf(buffer, sizeof(buffer), "%08x", crc);
+            return buffer;
+        }
+
+        void PrintPackageInfo(const std::wstring& packagePath, const MakeAppxCore::PackageInfo& info, bool listEntries) {
+            std::wcout << L"Package:      " << packagePath << std::endl;
+            std::wcout << L"File size:    " << FormatFileSize(info.fileSize) << std::endl;
+            std::wcout << L"Entries:      " << info.entries.size() << std::endl;
+            std::wcout << L"Uncompressed: " << FormatFileSize(info.uncompressedSize) << std::endl;
+            std::wcout << L"Compressed:   " << FormatFileSize(info.compressedSize) << L" ("
+                << std::fixed << std::setprecision(1) << CompressionPercent(info.compressedSize, info.uncompressedSize)
+                << L"%)" << std::endl;
+            std::wcout << L"ZIP64:        " << (info.zip64 ? L"yes" : L"no") << std::endl;
+            std::wcout << L"Block map:    " << (info.hasBlockMap ? L"present" : L"missing") << std::endl;
+            std::wcout << L"Signature:    " << (info.hasSignature ? L"present" : L"missing") << std::endl;
+
+            if (!listEntries) return;
+
+            std::wcout << std::endl;
+            std::wcout << std::setw(14) << L"Size" << std::setw(14) << L"Compressed" << std::setw(8) << L"Ratio"
+                << std::setw(9) << L"Method" << std::setw(10) << L"CRC32" << L"  Name" << std::endl;
+            for (const auto& entry : info.entries) {
+                std::wcout << std::setw(14) << entry.uncompressedSize << std::setw(14) << entry.compressedSize
+                    << std::setw(7) << std::fixed << std::setprecision(1)
+                    << CompressionPercent(entry.compressedSize, entry.uncompressedSize) << L"%"
+                    << std::setw(9) << MethodName(entry.method)
+                    << std::setw(10) << MakeAppxCore::Utf8ToWideSafe(Crc32Hex(entry.crc32))
+                    << L"  " << entry.name << std::endl;
+            }
+        }
+
+        const char* DiffChangeName(MakeAppxCore::DiffChange change) {
+            switch (change) {
+            case MakeAppxCore::DiffChange::Added: return "added";
+            case MakeAppxCore::DiffChange::Removed: return "removed";
+            default: return "modified";
+            }
+        }
+
+        std::string PackageDiffJson(const std::wstring& oldPackage, const std::wstring& newPackage,
+            const MakeAppxCore::PackageDiff& diff) {
+            using MakeAppxCore::WideToUtf8Safe;
+
+            uint64_t counts[3] = {};
+            for (const auto& entry : diff.entries) {
+                ++counts[static_cast<int>(entry.change)];
+            }
+
+            MakeAppxCore::JsonWriter json;
+            json.BeginObject()
+                .Key("old").String(WideToUtf8Safe(oldPackage))
+                .Key("new").String(WideToUtf8Safe(newPackage))
+                .Key("identical").Bool(diff.entries.empty())
+                .Key("blockMapsCompared").Bool(diff.blockMapsCompared)
+                .Key("added").Number(counts[static_cast<int>(MakeAppxCore::DiffChange::Added)])
+                .Key("removed").Number(counts[static_cast<int>(MakeAppxCore::DiffChange::Removed)])
+                .Key("modified").Number(counts[static_cast<int>(MakeAppxCore::DiffChange::Modified)])
+                .Key("unchanged").Number(diff.unchanged)
+                .Key("changes").BeginArray();
+
+            for (const auto& entry : diff.entries) {
+                json.BeginObject()
+                    .Key("name").String(WideToUtf8Safe(entry.name))
+                    .Key("change").String(DiffChangeName(entry.change));
+                if (entry.change != MakeAppxCore::DiffChange::Added) {
+                    json.Key("oldSize").Number(entry.oldSize).Key("oldCrc32").String(Crc32Hex(entry.oldCrc32));
+                }
+                if (entry.change != MakeAppxCore::DiffChange::Removed) {
+                    json.Key("newSize").Number(entry.newSize).Key("newCrc32").String(Crc32Hex(entry.newCrc32));
+                }
+                if (entry.blockMapDiffers) {
+                    json.Key("blockMapDiffers").Bool(true);
+                }
+                json.EndObject();
+            }
+
+            json.EndArray().EndObject();
+            return json.Str();
+        }
+
+        std::string PackageInfoJson(const std::wstring& packagePath, const MakeAppxCore::PackageInfo& info,
+            bool listEntries, bool includeManifest) {
+            using MakeAppxCore::WideToUtf8Safe;
+
+            MakeAppxCore::JsonWriter json;
+            json.BeginObject()
+                .Key("package").String(WideToUtf8Safe(packagePath))
+                .Key("size").Number(info.fileSize)
+                .Key("entryCount").Number(static_cast<uint64_t>(info.entries.size()))
+                .Key("uncompressedSize").Number(info.uncompressedSize)
+                .Key("compressedSize").Number(info.compressedSize)
+                .Key("zip64").Bool(info.zip64)
+                .Key("blockMap").Bool(info.hasBlockMap)
+                .Key("signed").Bool(info.hasSignature);
+
+            if (listEntries) {
+                json.Key("entries").BeginArray();
+                for (const auto& entry : info.entries) {
+                    json.BeginObject()
+                        .Key("name").String(WideToUtf8Safe(entry.name))
+                        .Key("size").Number(entry.uncompressedSize)
+                        .Key("compressedSize").Number(entry.compressedSize)
+                        .Key("method").String(WideToUtf8Safe(MethodName(entry.method)))
+                        .Key("crc32").String(Crc32Hex(entry.crc32))
+                        .Key("offset").Number(entry.offset)
+                        .EndObject();
+                }
+                json.EndArray();
+            }
+
+            if (includeManifest) {
+                json.Key("manifest").String(info.manifest);
+            }
+
+            json.EndObject();
+            return json.Str();
+        }
+
+        bool ParseMemorySize(const std::wstring& text, uint64_t& bytes) {
+            size_t digits = 0;
+            while (digits < text.size() && iswdigit(text[digits])) ++digits;
+            if (digits == 0 || digits > 15) return false;
+
+            std::wstring unit = text.substr(digits);
+            std::transform(unit.begin(), unit.end(), unit.begin(), ::towupper);
+            uint64_t scale = 0;
+            if (unit.empty() || unit == L"B") scale = 1;
+            else if (unit == L"K" || unit == L"KB") scale = 1ull << 10;
+            else if (unit == L"M" || unit == L"MB") scale = 1ull << 20;
+            else if (unit == L"G" || unit == L"GB") scale = 1ull << 30;
+            else return false;
+
+            uint64_t value = std::stoull(text.substr(0, digits));
+            if (value > UINT64_MAX / scale) return false;
+            bytes = value * scale;
+            return bytes > 0;
+        }
+
+        // Digits only: std::stoul would take "-1" and wrap it around to a huge count.
+        bool ParseCount(const std::wstring& text, size_t minimum, size_t maximum, size_t& count) {
+            if (text.empty() || text.size() > 9) return false;
+            if (!std::all_of(text.begin(), text.end(), [](wchar_t c) { return c >= L'0' && c <= L'9'; })) return false;
+
+            count = static_cast<size_t>(std::stoul(text));
+            return count >= minimum && count <= maximum;
+        }
+    }
+
+    bool CommandLineParser::ParseGlobalArgs(CommandLineArgs& args) {
+        for (size_t i = 1; i < m_args.size();) {
+            const std::wstring& arg = m_args[i];
+            if (arg != L"-maxmemory" && arg != L"/maxmemory" && arg != L"--max-memory") {
+                ++i;
+                continue;
+            }
+
+            std::wstring value = i + 1 < m_args.size() ? m_args[i + 1] : L"";
+            if (!ParseMemorySize(value, args.maxMemory)) {
+                SetError(L"Invalid memory size for --max-memory: " + value + L" (use e.g. 512M or 2G)");
+                return false;
+            }
+            if (args.maxMemory < MakeAppxCore::BufferPool::MIN_LIMIT) {
+                SetError(L"--max-memory must be at least " + FormatFileSize(MakeAppxCore::BufferPool::MIN_LIMIT) + L": " + value);
+                return false;
+            }
+            m_args.erase(m_args.begin() + i, m_args.begin() + std::min(i + 2, m_args.size()));
+        }
+        return true;
+    }
+
     bool CommandLineParser::Parse(int argc, wchar_t* argv[], CommandLineArgs& args) {
         m_args.clear();
         m_lastError.clear();
@@ -40,11 +229,26 @@ namespace MakeAppxPP {
             return true;
         }
 
+        if (!ParseGlobalArgs(args)) {
+            return false;
+        }
+
         switch (args.command) {
         case Command::Pack:
             return ParsePackArgs(args, index);
         case Command::Unpack:
             return ParseUnpackArgs(args, index);
+        case Command::Update:
+            return ParseUpdateArgs(args, index);
+        case Command::Info:
+        case Command::List:
+        case Command::Verify:
+            return ParseInfoArgs(args, index);
+        case Command::Diff:
+            return ParseDiffArgs(args, index);
+        case Command::Delta:
+        case Command::Apply:
+            return ParseDeltaArgs(args, index);
         case Command::Bundle:
             return ParseBundleArgs(args, index);
         case Command::Unbundle:
@@ -57,6 +261,8 @@ namespace MakeAppxPP {
             return ParseConvertCGMArgs(args, index);
         case Command::Build:
             return ParseBuildArgs(args, index);
+        case Command::Serve:
+            return ParseServeArgs(args, index);
         default:
             SetError(L"Unknown command");
             return false;
@@ -69,12 +275,20 @@ namespace MakeAppxPP {
 
         if (cmd == L"pack") return Command::Pack;
         if (cmd == L"unpack") return Command::Unpack;
+        if (cmd == L"update") return Command::Update;
+        if (cmd == L"info") return Command::Info;
+        if (cmd == L"list") return Command::List;
+        if (cmd == L"verify") return Command::Verify;
+        if (cmd == L"diff") return Command::Diff;
+        if (cmd == L"delta") return Command::Delta;
+        if (cmd == L"apply") return Command::Apply;
         if (cmd == L"bundle") return Command::Bundle;
         if (cmd == L"unbundle") return Command::Unbundle;
         if (cmd == L"encrypt") return Command::Encrypt;
         if (cmd == L"decrypt") return Command::Decrypt;
         if (cmd == L"convertcgm") return Command::ConvertCGM;
         if (cmd == L"build") return Command::Build;
+        if (cmd == L"serve") return Command::Serve;
         if (cmd == L"help" || cmd == L"/?" || cmd == L"-help" || cmd == L"--help") return Command::Help;
 
         return Command::None;
@@ -122,6 +336,46 @@ namespace MakeAppxPP {
                     return false;
                 }
             }
+            else if (arg == L"-cgm" || arg == L"/cgm") {
+                args.contentGroupMap = GetNextArg(index);
+                if (args.contentGroupMap.empty()) {
+                    SetError(L"Missing content group map path for -cgm option");
+                    return false;
+                }
+            }
+            else if (arg == L"-cache" || arg == L"/cache") {
+                args.cacheDirectory = GetNextArg(index);
+                if (args.cacheDirectory.empty()) {
+                    SetError(L"Missing directory path for -cache option");
+                    return false;
+                }
+            }
+            else if (arg == L"-resume" || arg == L"/resume" || arg == L"--resume") {
+                args.resume = true;
+            }
+            else if (arg == L"-watch" || arg == L"/watch" || arg == L"--watch") {
+                args.watch = true;
+            }
+            else if (arg == L"-poll" || arg == L"/poll" || arg == L"--poll") {
+                args.poll = true;
+            }
+            else if (arg == L"-debounce" || arg == L"/debounce" || arg == L"--debounce") {
+                std::wstring value = GetNextArg(index);
+                size_t milliseconds = 0;
+                if (!ParseCount(value, 0, MakeAppxCore::MAX_DEBOUNCE_MILLISECONDS, milliseconds)) {
+                    SetError(L"Invalid debounce time in milliseconds: " + value + L" (use 0 to " +
+                        std::to_wstring(MakeAppxCore::MAX_DEBOUNCE_MILLISECONDS) + L")");
+                    return false;
+                }
+                args.debounceMilliseconds = static_cast<uint32_t>(milliseconds);
+            }
+            else if (arg == L"-split" || arg == L"/split" || arg == L"--split") {
+                std::wstring value = GetNextArg(index);
+                if (!ParseMemorySize(value, args.volumeSize) || args.volumeSize < 64 * 1024) {
+                    SetError(L"Invalid volume size for -split: " + value + L" (use e.g. 700M or 4095M)");
+                    return false;
+                }
+            }
             else if (arg == L"-v" || arg == L"/v") {
                 args.verbose = true;
             }
@@ -142,6 +396,25 @@ namespace MakeAppxPP {
             SetError(L"Missing required -p (package) option");
             return false;
         }
+        if (args.outputPath == L"-" && (args.resume || args.volumeSize > 0)) {
+            SetError(L"-resume and -split need a package file, not stdout");
+            return false;
+        }
+        if (args.resume && args.volumeSize > 0) {
+            SetError(L"-resume cannot be combined with -split");
+            return false;
+        }
+        if (args.watch && (args.outputPath == L"-" || args.resume || args.volumeSize > 0)) {
+            SetError(L"-watch needs a package file and cannot be combined with -resume or -split");
+            return false;
+        }
+        if ((args.poll || args.debounceMilliseconds != 300) && !args.watch) {
+            SetError(L"-poll and -debounce only apply to -watch");
+            return false;
+        }
+        if (args.outputPath == L"-") {
+            args.quiet = true;
+        }
 
         return true;
     }
@@ -175,6 +448,32 @@ namespace MakeAppxPP {
             else if (arg == L"-s" || arg == L"/s") {
                 args.overwrite = MakeAppxCore::OverwriteMode::No;
             }
+            else if (arg == L"-include" || arg == L"/include" || arg == L"--include") {
+                std::wstring pattern = GetNextArg(index);
+                if (pattern.empty()) {
+                    SetError(L"Missing pattern for -include option");
+                    return false;
+                }
+                args.includePatterns.push_back(pattern);
+            }
+            else if (arg == L"-exclude" || arg == L"/exclude" || arg == L"--exclude") {
+                std::wstring pattern = GetNextArg(index);
+                if (pattern.empty()) {
+                    SetError(L"Missing pattern for -exclude option");
+                    return false;
+                }
+                args.excludePatterns.push_back(pattern);
+            }
+            else if (arg == L"-listfile" || arg == L"/listfile" || arg == L"--list-file") {
+                args.listFile = GetNextArg(index);
+                if (args.listFile.empty()) {
+                    SetError(L"Missing file path for -listfile option");
+                    return false;
+                }
+            }
+            else if (arg == L"-directio" || arg == L"/directio" || arg == L"--direct-io") {
+                args.directIo = true;
+            }
             else if (arg == L"-v" || arg == L"/v") {
                 args.verbose = true;
             }
@@ -199,6 +498,206 @@ namespace MakeAppxPP {
         return true;
     }
 
+    bool CommandLineParser::ParseUpdateArgs(CommandLineArgs& args, size_t& index) {
+        while (index < m_args.size()) {
+            std::wstring arg = GetNextArg(index);
+
+            if (arg == L"/?" || arg == L"-help" || arg == L"--help") {
+                args.showHelp = true;
+                args.specificCommand = L"update";
+                return true;
+            }
+            else if (arg == L"-p" || arg == L"/p") {
+                args.outputPath = GetNextArg(index);
+                if (args.outputPath.empty()) {
+                    SetError(L"Missing package path for -p option");
+                    return false;
+                }
+            }
+            else if (arg == L"-d" || arg == L"/d") {
+                args.inputPath = GetNextArg(index);
+                if (args.inputPath.empty()) {
+                    SetError(L"Missing directory path for -d option");
+                    return false;
+                }
+            }
+            else if (arg == L"-c" || arg == L"/c") {
+                std::wstring compressionStr = GetNextArg(index);
+                if (compressionStr == L"none") {
+                    args.compression = MakeAppxCore::CompressionLevel::None;
+                }
+                else if (compressionStr == L"fast") {
+                    args.compression = MakeAppxCore::CompressionLevel::Fast;
+                }
+                else if (compressionStr == L"normal") {
+                    args.compression = MakeAppxCore::CompressionLevel::Normal;
+                }
+                else if (compressionStr == L"max") {
+                    args.compression = MakeAppxCore::CompressionLevel::Maximum;
+                }
+                else {
+                    SetError(L"Invalid compression level: " + compressionStr);
+                    return false;
+                }
+            }
+            else if (arg == L"-cache" || arg == L"/cache") {
+                args.cacheDirectory = GetNextArg(index);
+                if (args.cacheDirectory.empty()) {
+                    SetError(L"Missing directory path for -cache option");
+                    return false;
+                }
+            }
+            else if (arg == L"-v" || arg == L"/v") {
+                args.verbose = true;
+            }
+            else if (arg == L"-q" || arg == L"/q") {
+                args.quiet = true;
+            }
+            else {
+                SetError(L"Unknown option: " + arg);
+                return false;
+            }
+        }
+
+        if (args.outputPath.empty()) {
+            SetError(L"Missing required -p (package) option");
+            return false;
+        }
+        if (args.inputPath.empty()) {
+            SetError(L"Missing required -d (directory) option");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CommandLineParser::ParseInfoArgs(CommandLineArgs& args, size_t& index) {
+        while (index < m_args.size()) {
+            std::wstring arg = GetNextArg(index);
+
+            if (arg == L"/?" || arg == L"-help" || arg == L"--help") {
+                args.showHelp = true;
+                args.specificCommand = args.command == Command::List ? L"list" :
+                    args.command == Command::Verify ? L"verify" : L"info";
+                return true;
+            }
+            else if (arg == L"-p" || arg == L"/p") {
+                args.inputPath = GetNextArg(index);
+                if (args.inputPath.empty()) {
+                    SetError(L"Missing package path for -p option");
+                    return false;
+                }
+            }
+            else if (args.command != Command::Verify &&
+                (arg == L"-manifest" || arg == L"/manifest" || arg == L"--manifest")) {
+                args.showManifest = true;
+            }
+            else if (arg == L"-json" || arg == L"/json" || arg == L"--json") {
+                args.jsonOutput = true;
+            }
+            else if (arg == L"-v" || arg == L"/v") {
+                args.verbose = true;
+            }
+            else if (arg == L"-q" || arg == L"/q") {
+                args.quiet = true;
+            }
+            else {
+                SetError(L"Unknown option: " + arg);
+                return false;
+            }
+        }
+
+        if (args.inputPath.empty()) {
+            SetError(L"Missing required -p (package) option");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CommandLineParser::ParseDiffArgs(CommandLineArgs& args, size_t& index) {
+        while (index < m_args.size()) {
+            std::wstring arg = GetNextArg(index);
+
+            if (arg == L"/?" || arg == L"-help" || arg == L"--help") {
+                args.showHelp = true;
+                args.specificCommand = L"diff";
+                return true;
+            }
+            else if (arg == L"-strict" || arg == L"/strict" || arg == L"--strict") {
+                args.strictCompare = true;
+            }
+            else if (arg == L"-json" || arg == L"/json" || arg == L"--json") {
+                args.jsonOutput = true;
+            }
+            else if (arg == L"-v" || arg == L"/v") {
+                args.verbose = true;
+            }
+            else if (arg == L"-q" || arg == L"/q") {
+                args.quiet = true;
+            }
+            else if (args.inputPath.empty()) {
+                args.inputPath = arg;
+            }
+            else if (args.comparePath.empty()) {
+                args.comparePath = arg;
+            }
+            else {
+                SetError(L"Unknown option: " + arg);
+                return false;
+            }
+        }
+
+        if (args.inputPath.empty() || args.comparePath.empty()) {
+            SetError(L"diff requires two package paths: <old package> <new package>");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CommandLineParser::ParseDeltaArgs(CommandLineArgs& args, size_t& index) {
+        std::wstring name = args.command == Command::Delta ? L"delta" : L"apply";
+
+        while (index < m_args.size()) {
+            std::wstring arg = GetNextArg(index);
+
+            if (arg == L"/?" || arg == L"-help" || arg == L"--help") {
+                args.showHelp = true;
+                args.specificCommand = name;
+                return true;
+            }
+            else if (arg == L"-o" || arg == L"/o" || arg == L"--output") {
+                args.outputPath = GetNextArg(index);
+            }
+            else if (arg == L"-v" || arg == L"/v") {
+                args.verbose = true;
+            }
+            else if (arg == L"-q" || arg == L"/q") {
+                args.quiet = true;
+            }
+            else if (args.inputPath.empty()) {
+                args.inputPath = arg;
+            }
+            else if (args.comparePath.empty()) {
+                args.comparePath = arg;
+            }
+            else {
+                SetError(L"Unknown option: " + arg);
+                return false;
+            }
+        }
+
+        if (args.inputPath.empty() || args.comparePath.empty() || args.outputPath.empty()) {
+            SetError(args.command == Command::Delta ?
+                L"delta requires <old package> <new package> -o <patch>" :
+                L"apply requires <old package> <patch> -o <output package>");
+            return false;
+        }
+
+        return true;
+    }
+
     bool CommandLineParser::ParseBundleArgs(CommandLineArgs& args, size_t& index) {
         while (index < m_args.size()) {
             std::wstring arg = GetNextArg(index);
@@ -241,6 +740,13 @@ namespace MakeAppxPP {
                     return false;
                 }
             }
+            else if (arg == L"-split" || arg == L"/split" || arg == L"--split") {
+                std::wstring value = GetNextArg(index);
+                if (!ParseMemorySize(value, args.volumeSize) || args.volumeSize < 64 * 1024) {
+                    SetError(L"Invalid volume size for -split: " + value + L" (use e.g. 700M or 4095M)");
+                    return false;
+                }
+            }
             else if (arg == L"-v" || arg == L"/v") {
                 args.verbose = true;
             }
@@ -547,6 +1053,51 @@ namespace MakeAppxPP {
         return true;
     }
 
+    bool CommandLineParser::ParseServeArgs(CommandLineArgs& args, size_t& index) {
+        while (index < m_args.size()) {
+            std::wstring arg = GetNextArg(index);
+
+            if (arg == L"/?" || arg == L"-help" || arg == L"--help") {
+                args.showHelp = true;
+                args.specificCommand = L"serve";
+                return true;
+            }
+            else if (arg == L"-socket" || arg == L"/socket") {
+                args.socketPath = GetNextArg(index);
+                if (args.socketPath.empty()) {
+                    SetError(L"Missing socket path for -socket option");
+                    return false;
+                }
+            }
+            else if (arg == L"-cache" || arg == L"/cache") {
+                args.cacheDirectory = GetNextArg(index);
+                if (args.cacheDirectory.empty()) {
+                    SetError(L"Missing directory path for -cache option");
+                    return false;
+                }
+            }
+            else if (arg == L"-workers" || arg == L"/workers") {
+                std::wstring countStr = GetNextArg(index);
+                if (!ParseCount(countStr, 1, MAX_SERVER_WORKERS, args.workerCount)) {
+                    SetError(L"Invalid worker count: " + countStr + L" (use 1 to " + std::to_wstring(MAX_SERVER_WORKERS) + L")");
+                    return false;
+                }
+            }
+            else if (arg == L"-v" || arg == L"/v") {
+                args.verbose = true;
+            }
+            else if (arg == L"-q" || arg == L"/q") {
+                args.quiet = true;
+            }
+            else {
+                SetError(L"Unknown option: " + arg);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     std::wstring CommandLineParser::GetNextArg(size_t& index) {
         if (index >= m_args.size()) {
             return L"";
@@ -575,12 +1126,24 @@ namespace MakeAppxPP {
         std::wcout << L"---------------" << std::endl;
         std::wcout << L"    pack        --  Create a new app package from files on disk" << std::endl;
         std::wcout << L"    unpack      --  Extract an existing app package to files on disk" << std::endl;
+        std::wcout << L"    update      --  Replace or add files in an existing app package" << std::endl;
+        std::wcout << L"    info        --  Show a summary of a package without extracting it" << std::endl;
+        std::wcout << L"    list        --  List the entries of a package without extracting it" << std::endl;
+        std::wcout << L"    verify      --  Check CRC-32 and block map hashes of every entry in a package" << std::endl;
+        std::wcout << L"    diff        --  Compare the contents of two packages without extracting them" << std::endl;
+        std::wcout << L"    delta       --  Create a patch that turns one package into another" << std::endl;
+        std::wcout << L"    apply       --  Rebuild a package from an older package and a patch" << std::endl;
         std::wcout << L"    bundle      --  Create a new app bundle from files on disk" << std::endl;
         std::wcout << L"    unbundle    --  Extract an existing app bundle to files on disk" << std::endl;
         std::wcout << L"    encrypt     --  Encrypt an existing app package or bundle (AES-256)" << std::endl;
         std::wcout << L"    decrypt     --  Decrypt an existing app package or bundle (AES-256)" << std::endl;
         std::wcout << L"    convertCGM  --  Convert a source content group map (CGM) to the final content group map" << std::endl;
         std::wcout << L"    build       --  Build packages using a packaging layout file" << std::endl;
+        std::wcout << L"    serve       --  Run a resident packaging server on a local socket" << std::endl;
+        std::wcout << std::endl;
+        std::wcout << L"Global options:" << std::endl;
+        std::wcout << L"    --max-memory <size>  Cap working buffers of all commands, e.g. 256M or 2G" << std::endl;
+        std::wcout << L"                         (worker counts and buffer sizes shrink to fit)" << std::endl;
         std::wcout << std::endl;
         std::wcout << L"For help with a specific command, enter \"MakeAppxPro <command> /?\"" << std::endl;
         std::wcout << std::endl;
@@ -598,8 +1161,15 @@ namespace MakeAppxPP {
             std::wcout << L"Usage: MakeAppxPro pack [options]" << std::endl;
             std::wcout << L"Options:" << std::endl;
             std::wcout << L"  -d <directory>    Source directory containing files to package" << std::endl;
-            std::wcout << L"  -p <package>      Output package file (.appx or .msix)" << std::endl;
+            std::wcout << L"  -p <package>      Output package file (.appx or .msix), or - to stream to stdout" << std::endl;
             std::wcout << L"  -c <compression>  Compression level: none, fast, normal, max (default: normal)" << std::endl;
+            std::wcout << L"  -cache <dir>      Reuse compressed entries from a content-hash cache directory" << std::endl;
+            std::wcout << L"  -cgm <final>      Order entries by the groups of a final content group map" << std::endl;
+            std::wcout << L"  -resume           Journal written entries and continue an interrupted pack" << std::endl;
+            std::wcout << L"  -split <size>     Write volumes <package>.001, .002, ... of at most size bytes (e.g. 4095M)" << std::endl;
+            std::wcout << L"  -watch            Keep running and repack whenever files in the directory change" << std::endl;
+            std::wcout << L"  -debounce <ms>    With -watch, wait until files have been quiet this long (0 to 60000, default: 300)" << std::endl;
+            std::wcout << L"  -poll             With -watch, rescan every second instead of using change notifications" << std::endl;
             std::wcout << L"  -v                Verbose output" << std::endl;
             std::wcout << L"  -q                Quiet mode" << std::endl;
         }
@@ -607,10 +1177,77 @@ namespace MakeAppxPP {
             std::wcout << L"Extracts files from a package to a directory." << std::endl;
             std::wcout << L"Usage: MakeAppxPro unpack [options]" << std::endl;
             std::wcout << L"Options:" << std::endl;
-            std::wcout << L"  -p <package>      Source package file (.appx or .msix)" << std::endl;
+            std::wcout << L"  -p <package>      Source package file (.appx or .msix), or - to read from stdin" << std::endl;
+            std::wcout << L"                    Split packages are read from <package>.001, .002, ..." << std::endl;
             std::wcout << L"  -d <directory>    Output directory for extracted files" << std::endl;
             std::wcout << L"  -o                Overwrite existing files without prompting" << std::endl;
             std::wcout << L"  -s                Skip existing files without prompting" << std::endl;
+            std::wcout << L"  -include <glob>   Extract only entries matching the glob (repeatable)" << std::endl;
+            std::wcout << L"  -exclude <glob>   Skip entries matching the glob (repeatable)" << std::endl;
+            std::wcout << L"  -listfile <file>  Extract only the entries listed in the file, one path or glob per line" << std::endl;
+            std::wcout << L"  -directio         Write entries of 64 MB or more without the OS page cache" << std::endl;
+            std::wcout << L"  -v                Verbose output" << std::endl;
+            std::wcout << L"  -q                Quiet mode" << std::endl;
+            std::wcout << std::endl;
+            std::wcout << L"Globs support * and ? within a path segment and ** across segments." << std::endl;
+            std::wcout << L"A glob without '/' matches the entry name at any depth; matching ignores case." << std::endl;
+        }
+        else if (cmd == L"update") {
+            std::wcout << L"Replaces or adds files in an existing package without recompressing unchanged entries." << std::endl;
+            std::wcout << L"Usage: MakeAppxPro update [options]" << std::endl;
+            std::wcout << L"Options:" << std::endl;
+            std::wcout << L"  -p <package>      Package file to update in place (.appx or .msix)" << std::endl;
+            std::wcout << L"  -d <directory>    Directory of new or changed files, laid out as in the package" << std::endl;
+            std::wcout << L"  -c <compression>  Compression level for changed files: none, fast, normal, max (default: normal)" << std::endl;
+            std::wcout << L"  -cache <dir>      Reuse compressed entries from a content-hash cache directory" << std::endl;
+            std::wcout << L"  -v                Verbose output" << std::endl;
+            std::wcout << L"  -q                Quiet mode" << std::endl;
+        }
+        else if (cmd == L"info" || cmd == L"list") {
+            std::wcout << L"Shows package contents by reading only the central directory." << std::endl;
+            std::wcout << L"Usage: MakeAppxPro info|list [options]" << std::endl;
+            std::wcout << L"  info prints a summary, list also prints every entry." << std::endl;
+            std::wcout << L"Options:" << std::endl;
+            std::wcout << L"  -p <package>      Package or bundle file to inspect" << std::endl;
+            std::wcout << L"  -manifest         Print AppxManifest.xml (only that entry is decompressed)" << std::endl;
+            std::wcout << L"  -json             Write the result as a JSON document" << std::endl;
+            std::wcout << L"  -v                Verbose output" << std::endl;
+            std::wcout << L"  -q                Quiet mode" << std::endl;
+        }
+        else if (cmd == L"verify") {
+            std::wcout << L"Decompresses every entry in memory and checks its CRC-32 and AppxBlockMap.xml hashes." << std::endl;
+            std::wcout << L"Usage: MakeAppxPro verify [options]" << std::endl;
+            std::wcout << L"Options:" << std::endl;
+            std::wcout << L"  -p <package>      Package or bundle file to verify" << std::endl;
+            std::wcout << L"  -json             Write the result as a JSON document" << std::endl;
+            std::wcout << L"  -v                Verbose output" << std::endl;
+            std::wcout << L"  -q                Quiet mode" << std::endl;
+            std::wcout << L"Exit code is 0 when the package is intact and 1 otherwise." << std::endl;
+        }
+        else if (cmd == L"diff") {
+            std::wcout << L"Compares two packages by their central directories (names, sizes, CRC-32)." << std::endl;
+            std::wcout << L"Usage: MakeAppxPro diff [options] <old package> <new package>" << std::endl;
+            std::wcout << L"Options:" << std::endl;
+            std::wcout << L"  -strict           Also compare AppxBlockMap.xml block hashes of entries with equal CRCs" << std::endl;
+            std::wcout << L"  -json             Write the result as a JSON document" << std::endl;
+            std::wcout << L"  -q                Print only the summary line" << std::endl;
+            std::wcout << L"Exit code is 0 when the packages match, 1 when they differ and 2 on error." << std::endl;
+        }
+        else if (cmd == L"delta") {
+            std::wcout << L"Creates a patch holding only the data of <new package> that is not found in <old package>." << std::endl;
+            std::wcout << L"Unchanged entries and 64 KB blocks with matching AppxBlockMap.xml hashes are copied from the old package." << std::endl;
+            std::wcout << L"Usage: MakeAppxPro delta [options] <old package> <new package> -o <patch>" << std::endl;
+            std::wcout << L"Options:" << std::endl;
+            std::wcout << L"  -o <patch>        Output patch file" << std::endl;
+            std::wcout << L"  -v                Verbose output" << std::endl;
+            std::wcout << L"  -q                Quiet mode" << std::endl;
+        }
+        else if (cmd == L"apply") {
+            std::wcout << L"Rebuilds a package from an older package and a patch created by delta." << std::endl;
+            std::wcout << L"Every copied and patched range and the final package are checked against SHA-256 hashes in the patch." << std::endl;
+            std::wcout << L"Usage: MakeAppxPro apply [options] <old package> <patch> -o <output package>" << std::endl;
+            std::wcout << L"Options:" << std::endl;
+            std::wcout << L"  -o <package>      Output package file" << std::endl;
             std::wcout << L"  -v                Verbose output" << std::endl;
             std::wcout << L"  -q                Quiet mode" << std::endl;
         }
@@ -621,6 +1258,7 @@ namespace MakeAppxPP {
             std::wcout << L"  -d <directory>    Source directory containing .appx/.msix files" << std::endl;
             std::wcout << L"  -p <bundle>       Output bundle file (.appxbundle or .msixbundle)" << std::endl;
             std::wcout << L"  -c <compression>  Compression level: none, fast, normal, max (default: normal)" << std::endl;
+            std::wcout << L"  -split <size>     Write volumes <bundle>.001, .002, ... of at most size bytes (e.g. 4095M)" << std::endl;
             std::wcout << L"  -v                Verbose output" << std::endl;
             std::wcout << L"  -q                Quiet mode" << std::endl;
         }
@@ -628,7 +1266,7 @@ namespace MakeAppxPP {
             std::wcout << L"Extracts packages from a bundle to a directory." << std::endl;
             std::wcout << L"Usage: MakeAppxPro unbundle [options]" << std::endl;
             std::wcout << L"Options:" << std::endl;
-            std::wcout << L"  -p <bundle>       Source bundle file (.appxbundle or .msixbundle)" << std::endl;
+            std::wcout << L"  -p <bundle>       Source bundle file (.appxbundle or .msixbundle) or its first volume" << std::endl;
             std::wcout << L"  -d <directory>    Output directory for extracted packages" << std::endl;
             std::wcout << L"  -o                Overwrite existing files without prompting" << std::endl;
             std::wcout << L"  -s                Skip existing files without prompting" << std::endl;
@@ -674,6 +1312,22 @@ namespace MakeAppxPP {
             std::wcout << L"  -v                Verbose output" << std::endl;
             std::wcout << L"  -q                Quiet mode" << std::endl;
         }
+        else if (cmd == L"serve") {
+            std::wcout << L"Runs a resident packaging server that accepts JSON requests on a local socket." << std::endl;
+            std::wcout << L"Usage: MakeAppxPro serve [options]" << std::endl;
+            std::wcout << L"Options:" << std::endl;
+            std::wcout << L"  -socket <path>    Local socket path (default: <temp>/makeappxpp.sock)" << std::endl;
+            std::wcout << L"  -workers <n>      Number of resident worker threads, 1 to 256 (default: CPU count)" << std::endl;
+            std::wcout << L"  -cache <dir>      Default entry cache directory for pack requests" << std::endl;
+            std::wcout << L"  -v                Verbose output" << std::endl;
+            std::wcout << L"  -q                Quiet mode" << std::endl;
+            std::wcout << std::endl;
+            std::wcout << L"Requests are one JSON object per line, for example:" << std::endl;
+            std::wcout << L"  {\"id\":\"1\",\"op\":\"pack\",\"input\":\"C:\\\\MyApp\",\"output\":\"MyApp.msix\",\"compression\":\"normal\"}" << std::endl;
+            std::wcout << L"Pack requests may set \"cache\" (overrides -cache) and \"cgm\" (final content group map)." << std::endl;
+            std::wcout << L"Supported ops: pack, unpack, update, bundle, unbundle, ping, shutdown." << std::endl;
+            std::wcout << L"Responses are streamed as \"progress\" events followed by a final \"done\" event." << std::endl;
+        }
         else {
             std::wcout << L"Unknown command: " << command << std::endl;
             ShowGeneralHelp();
@@ -761,7 +1415,7 @@ namespace MakeAppxPP {
         return ss.str();
     }
 
-    int ExecuteCommand(const CommandLineArgs& args) {
+    static int RunCommand(const CommandLineArgs& args) {
         try {
             switch (args.command) {
             case Command::Pack: {
@@ -773,8 +1427,33 @@ namespace MakeAppxPP {
                 auto package = MakeAppxCore::CreateAppxPackage();
                 auto callback = args.quiet ? nullptr : ConsoleProgressCallback;
 
+                MakeAppxCore::PackOptions packOptions;
+                packOptions.compression = args.compression;
+                packOptions.cacheDirectory = args.cacheDirectory;
+                packOptions.contentGroupMap = args.contentGroupMap;
+                packOptions.resume = args.resume;
+                packOptions.volumeSize = args.volumeSize;
+
+                if (args.watch) {
+                    MakeAppxCore::WatchOptions watchOptions;
+                    watchOptions.compression = args.compression;
+                    watchOptions.cacheDirectory = args.cacheDirectory;
+                    watchOptions.contentGroupMap = args.contentGroupMap;
+                    watchOptions.debounceMilliseconds = args.debounceMilliseconds;
+                    watchOptions.poll = args.poll;
+
+                    if (!args.quiet) {
+                        std::wcout << L"Press Ctrl+C to stop watching." << std::endl;
+                    }
+                    if (!package->Watch(args.inputPath, args.outputPath, watchOptions, callback)) {
+                        std::wcerr << L"Error: " << package->GetLastError() << std::endl;
+                        return 1;
+                    }
+                    return 0;
+                }
+
                 bool success = package->Pack(args.inputPath, args.outputPath,
-                    args.compression, callback);
+                    packOptions, callback);
 
                 if (!args.quiet) {
                     std::wcout << std::endl;
@@ -801,23 +1480,276 @@ namespace MakeAppxPP {
                 auto package = MakeAppxCore::CreateAppxPackage();
                 auto callback = args.quiet ? nullptr : ConsoleProgressCallback;
 
+                MakeAppxCore::UnpackOptions unpackOptions;
+                unpackOptions.overwrite = args.overwrite;
+                unpackOptions.includePatterns = args.includePatterns;
+                unpackOptions.excludePatterns = args.excludePatterns;
+                unpackOptions.listFile = args.listFile;
+                unpackOptions.directIo = args.directIo;
+
                 bool success = package->Unpack(args.inputPath, args.outputPath,
-                    args.overwrite, callback);
+                    unpackOptions, callback);
 
                 if (!args.quiet) {
                     std::wcout << std::endl;
                 }
 
-                if (success) {
+                std::vector<MakeAppxCore::OperationError> entryErrors = package->GetErrors();
+                for (const auto& entryError : entryErrors) {
+                    std::wcerr << L"Error: " << entryError.entry << L": " << entryError.message << std::endl;
+                }
+
+                if (success && entryErrors.empty()) {
                     if (!args.quiet) {
                         std::wcout << L"Package extracted successfully." << std::endl;
                     }
                     return 0;
                 }
                 else {
+                    if (!success) {
+                        std::wcerr << L"Error: " << package->GetLastError() << std::endl;
+                    }
+                    return 1;
+                }
+            }
+
+            case Command::Update: {
+                if (!args.quiet) {
+                    std::wcout << L"Updating package: " << args.outputPath << std::endl;
+                    std::wcout << L"Changed files: " << args.inputPath << std::endl;
+                }
+
+                auto package = MakeAppxCore::CreateAppxPackage();
+                auto callback = args.quiet ? nullptr : ConsoleProgressCallback;
+
+                MakeAppxCore::PackOptions packOptions;
+                packOptions.compression = args.compression;
+                packOptions.cacheDirectory = args.cacheDirectory;
+
+                bool success = package->Update(args.outputPath, args.inputPath,
+                    packOptions, callback);
+
+                if (!args.quiet) {
+                    std::wcout << std::endl;
+                }
+
+                if (success) {
+                    if (!args.quiet) {
+                        std::wcout << L"Package updated successfully." << std::endl;
+                    }
+                    return 0;
+                }
+                else {
+                    std::wcerr << L"Error: " << package->GetLastError() << std::endl;
+                    return 1;
+                }
+            }
+
+            case Command::Info:
+            case Command::List: {
+                auto package = MakeAppxCore::CreateAppxPackage();
+                MakeAppxCore::PackageInfo info;
+                bool listEntries = args.command == Command::List;
+
+                if (!package->Inspect(args.inputPath, info, args.showManifest)) {
+                    std::wcerr << L"Error: " << package->GetLastError() << std::endl;
+                    return 1;
+                }
+
+                if (args.jsonOutput) {
+                    std::wcout << MakeAppxCore::Utf8ToWideSafe(
+                        PackageInfoJson(args.inputPath, info, listEntries, args.showManifest)) << std::endl;
+                    return 0;
+                }
+
+                if (!args.quiet) {
+                    PrintPackageInfo(args.inputPath, info, listEntries);
+                }
+                if (args.showManifest) {
+                    if (!args.quiet) {
+                        std::wcout << std::endl;
+                    }
+                    std::wcout << MakeAppxCore::Utf8ToWideSafe(info.manifest) << std::endl;
+                }
+                return 0;
+            }
+
+            case Command::Verify: {
+                auto package = MakeAppxCore::CreateAppxPackage();
+                auto callback = args.quiet || args.jsonOutput ? nullptr : ConsoleProgressCallback;
+                MakeAppxCore::VerifyResult result;
+
+                if (!args.quiet && !args.jsonOutput) {
+                    std::wcout << L"Verifying package: " << args.inputPath << std::endl;
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                bool success = package->Verify(args.inputPath, result, callback);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                if (args.jsonOutput) {
+                    MakeAppxCore::JsonWriter json;
+                    json.BeginObject()
+                        .Key("package").String(MakeAppxCore::WideToUtf8Safe(args.inputPath))
+                        .Key("ok").Bool(success)
+                        .Key("entries").Number(result.entriesChecked)
+                        .Key("bytes").Number(result.bytesChecked)
+                        .Key("blocks").Number(result.blocksChecked)
+                        .Key("blockMap").Bool(result.blockMapChecked)
+                        .Key("seconds").Number(seconds)
+                        .Key("failures").BeginArray();
+                    for (const auto& failure : result.failures) {
+                        json.String(MakeAppxCore::WideToUtf8Safe(failure));
+                    }
+                    json.EndArray();
+                    if (!success && result.failures.empty()) {
+                        json.Key("error").String(MakeAppxCore::WideToUtf8Safe(package->GetLastError()));
+                    }
+                    json.EndObject();
+                    std::wcout << MakeAppxCore::Utf8ToWideSafe(json.Str()) << std::endl;
+                    return success ? 0 : 1;
+                }
+
+                if (callback) {
+                    std::wcout << std::endl;
+                }
+
+                for (const auto& failure : result.failures) {
+                    std::wcerr << L"  " << failure << std::endl;
+                }
+
+                if (success) {
+                    if (!args.quiet) {
+                        std::wcout << L"Verified " << result.entriesChecked << L" entries ("
+                            << FormatFileSize(result.bytesChecked) << L") in " << std::fixed << std::setprecision(2)
+                            << seconds << L"s";
+                        if (result.blockMapChecked) {
+                            std::wcout << L", " << result.blocksChecked << L" block map hashes matched";
+                        }
+                        else {
+                            std::wcout << L", no block map present";
+                        }
+                        std::wcout << L"." << std::endl;
+                    }
+                    return 0;
+                }
+                else {
+                    std::wcerr << L"Error: " << package->GetLastError() << std::endl;
+                    return 1;
+                }
+            }
+
+            case Command::Diff: {
+                auto package = MakeAppxCore::CreateAppxPackage();
+                MakeAppxCore::PackageDiff diff;
+
+                if (!package->Diff(args.inputPath, args.comparePath, diff, args.strictCompare)) {
+                    std::wcerr << L"Error: " << package->GetLastError() << std::endl;
+                    return 2;
+                }
+
+                if (args.jsonOutput) {
+                    std::wcout << MakeAppxCore::Utf8ToWideSafe(PackageDiffJson(args.inputPath, args.comparePath, diff)) << std::endl;
+                    return diff.entries.empty() ? 0 : 1;
+                }
+
+                uint64_t added = 0;
+                uint64_t removed = 0;
+                uint64_t modified = 0;
+                for (const auto& entry : diff.entries) {
+                    switch (entry.change) {
+                    case MakeAppxCore::DiffChange::Added:
+                        ++added;
+                        if (!args.quiet) {
+                            std::wcout << L"  A  " << entry.name << L" (" << FormatFileSize(entry.newSize) << L")" << std::endl;
+                        }
+                        break;
+                    case MakeAppxCore::DiffChange::Removed:
+                        ++removed;
+                        if (!args.quiet) {
+                            std::wcout << L"  D  " << entry.name << L" (" << FormatFileSize(entry.oldSize) << L")" << std::endl;
+                        }
+                        break;
+                    case MakeAppxCore::DiffChange::Modified:
+                        ++modified;
+                        if (!args.quiet) {
+                            std::wcout << L"  M  " << entry.name << L" (" << FormatFileSize(entry.oldSize) << L" -> "
+                                << FormatFileSize(entry.newSize) << L")";
+                            if (entry.blockMapDiffers) {
+                                std::wcout << L" [block map]";
+                            }
+                            std::wcout << std::endl;
+                        }
+                        break;
+                    }
+                }
+
+                std::wcout << added << L" added, " << removed << L" removed, " << modified << L" modified, "
+                    << diff.unchanged << L" unchanged";
+                if (args.strictCompare && !diff.blockMapsCompared) {
+                    std::wcout << L" (block maps not compared: missing in one or both packages)";
+                }
+                std::wcout << std::endl;
+                return diff.entries.empty() ? 0 : 1;
+            }
+
+            case Command::Delta: {
+                auto package = MakeAppxCore::CreateAppxPackage();
+                auto callback = args.quiet ? nullptr : ConsoleProgressCallback;
+                MakeAppxCore::DeltaStats stats;
+
+                if (!args.quiet) {
+                    std::wcout << L"Creating patch: " << args.inputPath << L" -> " << args.comparePath << std::endl;
+                    std::wcout << L"Output: " << args.outputPath << std::endl;
+                }
+
+                bool success = package->CreateDelta(args.inputPath, args.comparePath, args.outputPath, stats, callback);
+
+                if (callback) {
+                    std::wcout << std::endl;
+                }
+
+                if (!success) {
                     std::wcerr << L"Error: " << package->GetLastError() << std::endl;
                     return 1;
                 }
+
+                if (!args.quiet) {
+                    std::wcout << L"Patch created successfully: " << FormatFileSize(stats.patchSize) << L" ("
+                        << FormatFileSize(stats.copiedBytes) << L" reused, " << FormatFileSize(stats.literalBytes)
+                        << L" new";
+                    if (args.verbose) {
+                        std::wcout << L", " << stats.operations << L" operations";
+                    }
+                    std::wcout << L")." << std::endl;
+                }
+                return 0;
+            }
+
+            case Command::Apply: {
+                auto package = MakeAppxCore::CreateAppxPackage();
+                auto callback = args.quiet ? nullptr : ConsoleProgressCallback;
+
+                if (!args.quiet) {
+                    std::wcout << L"Applying patch: " << args.comparePath << L" to " << args.inputPath << std::endl;
+                    std::wcout << L"Output: " << args.outputPath << std::endl;
+                }
+
+                bool success = package->ApplyDelta(args.inputPath, args.comparePath, args.outputPath, callback);
+
+                if (callback) {
+                    std::wcout << std::endl;
+                }
+
+                if (!success) {
+                    std::wcerr << L"Error: " << package->GetLastError() << std::endl;
+                    return 1;
+                }
+
+                if (!args.quiet) {
+                    std::wcout << L"Package rebuilt and verified successfully." << std::endl;
+                }
+                return 0;
             }
 
             case Command::Bundle: {
@@ -829,8 +1761,12 @@ namespace MakeAppxPP {
                 auto bundle = MakeAppxCore::CreateAppxBundle();
                 auto callback = args.quiet ? nullptr : ConsoleProgressCallback;
 
+                MakeAppxCore::BundleOptions bundleOptions;
+                bundleOptions.compression = args.compression;
+                bundleOptions.volumeSize = args.volumeSize;
+
                 bool success = bundle->Bundle(args.inputPath, args.outputPath,
-                    args.compression, callback);
+                    bundleOptions, callback);
 
                 if (!args.quiet) {
                     std::wcout << std::endl;
@@ -864,14 +1800,21 @@ namespace MakeAppxPP {
                     std::wcout << std::endl;
                 }
 
-                if (success) {
+                std::vector<MakeAppxCore::OperationError> entryErrors = bundle->GetErrors();
+                for (const auto& entryError : entryErrors) {
+                    std::wcerr << L"Error: " << entryError.entry << L": " << entryError.message << std::endl;
+                }
+
+                if (success && entryErrors.empty()) {
                     if (!args.quiet) {
                         std::wcout << L"Bundle extracted successfully." << std::endl;
                     }
                     return 0;
                 }
                 else {
-                    std::wcerr << L"Error: " << bundle->GetLastError() << std::endl;
+                    if (!success) {
+                        std::wcerr << L"Error: " << bundle->GetLastError() << std::endl;
+                    }
                     return 1;
                 }
             }
@@ -968,6 +1911,24 @@ namespace MakeAppxPP {
                 }
             }
 
+            case Command::Serve: {
+                ServerOptions serverOpts;
+                serverOpts.socketPath = args.socketPath;
+                serverOpts.workerCount = args.workerCount;
+                serverOpts.cacheDirectory = args.cacheDirectory;
+                serverOpts.verbose = args.verbose;
+                serverOpts.quiet = args.quiet;
+
+                PackagingServer server(serverOpts);
+                if (server.Run()) {
+                    return 0;
+                }
+                else {
+                    std::wcerr << L"Error: " << server.GetLastError() << std::endl;
+                    return 1;
+                }
+            }
+
             default:
                 std::wcerr << L"Error: Unknown command" << std::endl;
                 return 1;
@@ -984,4 +1945,19 @@ namespace MakeAppxPP {
         }
     }
 
-}
\ No newline at end of file
+    int ExecuteCommand(const CommandLineArgs& args) {
+        MakeAppxCore::BufferPool& pool = MakeAppxCore::BufferPool::Shared();
+        pool.SetLimit(args.maxMemory);
+
+        int result = RunCommand(args);
+
+        if ((args.verbose || args.maxMemory != 0) && !args.quiet && !args.jsonOutput) {
+            std::wcout << L"Peak buffer memory: " << FormatFileSize(pool.Peak());
+            if (args.maxMemory != 0) {
+                std::wcout << L" (limit " << FormatFileSize(args.maxMemory) << L")";
+            }
+            std::wcout << std::endl;
+        }
+        return result;
+    }
+}
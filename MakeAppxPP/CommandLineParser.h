@@ -10,12 +10,20 @@ namespace MakeAppxPP {
         None,
         Pack,
         Unpack,
+        Update,
+        Info,
+        List,
+        Verify,
+        Diff,
+        Delta,
+        Apply,
         Bundle,
         Unbundle,
         Encrypt,
         Decrypt,
         ConvertCGM,
         Build,
+        Serve,
         Help
     };
 
@@ -27,10 +35,28 @@ namespace MakeAppxPP {
         std::wstring keyFile;
         std::wstring sourceCGM;
         std::wstring targetCGM;
+        std::wstring socketPath;
+        std::wstring cacheDirectory;
+        std::wstring contentGroupMap;
+        std::wstring listFile;
+        std::wstring comparePath;
+        std::vector<std::wstring> includePatterns;
+        std::vector<std::wstring> excludePatterns;
+        size_t workerCount = 0;
+        uint64_t maxMemory = 0;
+        uint64_t volumeSize = 0;
+        uint32_t debounceMilliseconds = 300;
         MakeAppxCore::CompressionLevel compression = MakeAppxCore::CompressionLevel::Normal;
         MakeAppxCore::OverwriteMode overwrite = MakeAppxCore::OverwriteMode::Ask;
         bool verbose = false;
         bool quiet = false;
+        bool showManifest = false;
+        bool jsonOutput = false;
+        bool strictCompare = false;
+        bool directIo = false;
+        bool resume = false;
+        bool watch = false;
+        bool poll = false;
         bool showHelp = false;
         std::wstring specificCommand;
     };
@@ -41,14 +67,20 @@ namespace MakeAppxPP {
         std::wstring m_lastError;
 
         Command ParseCommand(const std::wstring& cmdStr);
+        bool ParseGlobalArgs(CommandLineArgs& args);
         bool ParsePackArgs(CommandLineArgs& args, size_t& index);
         bool ParseUnpackArgs(CommandLineArgs& args, size_t& index);
+        bool ParseUpdateArgs(CommandLineArgs& args, size_t& index);
+        bool ParseInfoArgs(CommandLineArgs& args, size_t& index);
+        bool ParseDiffArgs(CommandLineArgs& args, size_t& index);
+        bool ParseDeltaArgs(CommandLineArgs& args, size_t& index);
         bool ParseBundleArgs(CommandLineArgs& args, size_t& index);
         bool ParseUnbundleArgs(CommandLineArgs& args, size_t& index);
         bool ParseEncryptArgs(CommandLineArgs& args, size_t& index);
         bool ParseDecryptArgs(CommandLineArgs& args, size_t& index);
         bool ParseConvertCGMArgs(CommandLineArgs& args, size_t& index);
         bool ParseBuildArgs(CommandLineArgs& args, size_t& index);
+        bool ParseServeArgs(CommandLineArgs& args, size_t& index);
 
         std::wstring GetNextArg(size_t& index);
         bool IsFlag(const std::wstring& arg);
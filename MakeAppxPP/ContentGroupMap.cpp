@@ -0,0 +1,182 @@
+#include "ContentGroupMap.h"
+#include "AppxPackageImpl.h"
+#include "XmlReader.h"
+#include "ZipDirectory.h"
+#include "JsonUtil.h"
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+
+namespace MakeAppxCore {
+
+    namespace {
+        struct GroupRange {
+            uint64_t start = UINT64_MAX;
+            uint64_t end = 0;
+            uint64_t bytes = 0;
+            uint64_t files = 0;
+        };
+
+        struct GroupPosition {
+            size_t group;
+            size_t sequence;
+        };
+
+        std::unordered_map<std::string, GroupPosition> MapFilesToGroups(const std::vector<ContentGroup>& groups) {
+            std::unordered_map<std::string, GroupPosition> groupOf;
+            size_t sequence = 0;
+            for (size_t g = 0; g < groups.size(); ++g) {
+                for (const auto& file : groups[g].files) {
+                    groupOf.emplace(NormalizeEntryName(file), GroupPosition{ g, sequence++ });
+                }
+            }
+            return groupOf;
+        }
+
+        void WriteRange(JsonWriter& json, const GroupRange& range) {
+            bool empty = range.files == 0;
+            json.Key("files").Number(range.files)
+                .Key("offset").Number(empty ? uint64_t(0) : range.start)
+                .Key("length").Number(empty ? uint64_t(0) : range.end - range.start)
+                .Key("contiguous").Bool(empty || range.end - range.start == range.bytes);
+        }
+    }
+
+    bool ReadContentGroupMap(const std::wstring& path, std::vector<ContentGroup>& groups, std::wstring& error) {
+        groups.clear();
+
+        std::ifstream stream(ToPath(path), std::ios::binary);
+        if (!stream.is_open()) {
+            error = L"Cannot open content group map: " + path;
+            return false;
+        }
+
+        XmlReader reader(stream);
+        bool sawRoot = false;
+        bool inGroup = false;
+        size_t groupDepth = 0;
+
+        while (reader.Read()) {
+            if (reader.NodeType() == XmlNodeType::EndElement) {
+                if (inGroup && reader.Depth() + 1 == groupDepth) inGroup = false;
+                continue;
+            }
+            if (reader.NodeType() != XmlNodeType::StartElement) continue;
+
+            std::string name = reader.LocalName();
+            if (name == "ContentGroupMap") {
+                sawRoot = true;
+            }
+            else if (!inGroup && (name == "Required" || name == "Automatic" || name == "Optional")) {
+                ContentGroup group;
+                group.type = name;
+                group.name = reader.GetAttribute("Name");
+                groups.push_back(std::move(group));
+                inGroup = true;
+                groupDepth = reader.Depth();
+            }
+            else if (inGroup && name == "File") {
+                std::string fileName = reader.GetAttribute("Name");
+                if (!fileName.empty()) {
+                    groups.back().files.push_back(std::move(fileName));
+                }
+            }
+        }
+
+        if (reader.HasError()) {
+            error = L"Invalid content group map - " + reader.GetLastError();
+            return false;
+        }
+        if (!sawRoot) {
+            error = L"Invalid content group map - missing ContentGroupMap element";
+            return false;
+        }
+
+        std::stable_partition(groups.begin(), groups.end(), [](const ContentGroup& group) {
+            return group.type == "Required";
+        });
+        return true;
+    }
+
+    size_t OrderFilesByContentGroups(std::vector<PackageFile>& files, const std::vector<ContentGroup>& groups) {
+        auto groupOf = MapFilesToGroups(groups);
+
+        std::vector<size_t> rank(files.size());
+        size_t ungrouped = 0;
+        for (size_t i = 0; i < files.size(); ++i) {
+            auto it = groupOf.find(NormalizeEntryName(files[i].packagePath));
+            if (it != groupOf.end()) {
+                rank[i] = it->second.sequence;
+            }
+            else {
+                rank[i] = SIZE_MAX;
+                ++ungrouped;
+            }
+        }
+
+        std::vector<size_t> order(files.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&rank](size_t a, size_t b) {
+            return rank[a] < rank[b];
+        });
+
+        std::vector<PackageFile> ordered;
+        ordered.reserve(files.size());
+        for (size_t i : order) {
+            ordered.push_back(std::move(files[i]));
+        }
+        files = std::move(ordered);
+
+        return ungrouped;
+    }
+
+    bool WriteContentGroupIndex(const std::wstring& packagePath, const std::wstring& indexPath,
+        const std::vector<ContentGroup>& groups, std::wstring& error) {
+
+        FileSource source{ ToPath(packagePath) };
+        ZipDirectory directory;
+        if (!source.IsOpen() || !directory.Read(source)) {
+            error = L"Failed to read package directory: " + directory.GetLastError();
+            return false;
+        }
+
+        auto groupOf = MapFilesToGroups(groups);
+        std::vector<GroupRange> ranges(groups.size() + 1);
+
+        for (const auto& entry : directory.Entries()) {
+            auto it = groupOf.find(NormalizeEntryName(entry.name));
+            GroupRange& range = ranges[it != groupOf.end() ? it->second.group : groups.size()];
+            range.start = std::min(range.start, entry.localHeaderOffset);
+            range.end = std::max(range.end, entry.recordEnd);
+            range.bytes += entry.recordEnd - entry.localHeaderOffset;
+            ++range.files;
+        }
+
+        JsonWriter json;
+        json.BeginObject()
+            .Key("package").String(WideToUtf8Safe(FromPath(ToPath(packagePath).filename())))
+            .Key("size").Number(source.Size())
+            .Key("groups").BeginArray();
+
+        for (size_t g = 0; g < groups.size(); ++g) {
+            json.BeginObject()
+                .Key("type").String(groups[g].type)
+                .Key("name").String(groups[g].name);
+            WriteRange(json, ranges[g]);
+            json.EndObject();
+        }
+
+        json.EndArray().Key("ungrouped").BeginObject();
+        WriteRange(json, ranges[groups.size()]);
+        json.EndObject().EndObject();
+
+        std::ofstream output(ToPath(indexPath), std::ios::binary | std::ios::trunc);
+        output << json.Str() << "\n";
+        if (!output.good()) {
+            error = L"Failed to write content group index: " + indexPath;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "AppxPackage.h"
+#include <string>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    struct ContentGroup {
+        std::string type;
+        std::string name;
+        std::vector<std::string> files;
+    };
+
+    bool ReadContentGroupMap(const std::wstring& path, std::vector<ContentGroup>& groups, std::wstring& error);
+    size_t OrderFilesByContentGroups(std::vector<PackageFile>& files, const std::vector<ContentGroup>& groups);
+    bool WriteContentGroupIndex(const std::wstring& packagePath, const std::wstring& indexPath,
+        const std::vector<ContentGroup>& groups, std::wstring& error);
+}
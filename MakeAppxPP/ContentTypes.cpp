@@ -0,0 +1,158 @@
+#include "ContentTypes.h"
+#include "XmlReader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+namespace MakeAppxCore {
+
+    namespace {
+        std::string Lower(std::string text) {
+            std::transform(text.begin(), text.end(), text.begin(), [](char c) {
+                return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            });
+            return text;
+        }
+
+        // The extension OPC matches a Default against: whatever follows the last dot of the file name.
+        std::string ExtensionOf(const std::string& entryName) {
+            size_t slash = entryName.find_last_of("/\\");
+            size_t nameStart = slash == std::string::npos ? 0 : slash + 1;
+            size_t dot = entryName.rfind('.');
+            if (dot == std::string::npos || dot < nameStart || dot + 1 == entryName.size()) return std::string();
+            return entryName.substr(dot + 1);
+        }
+
+        // Part names are absolute, use forward slashes and percent-encode anything outside the URI
+        // characters OPC allows unescaped.
+        std::string PartName(const std::string& entryName) {
+            static const char* allowed = "-._~!$&'()*+,;=:@/";
+            std::string part = "/";
+            for (char c : entryName) {
+                unsigned char byte = static_cast<unsigned char>(c);
+                if (c == '\\') {
+                    part += '/';
+                }
+                else if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                    (byte < 0x80 && c != '\0' && strchr(allowed, c))) {
+                    part += c;
+                }
+                else {
+                    char escaped[4];
+                    snprintf(escaped, sizeof(escaped), "%%%02X", byte);
+                    part += escaped;
+                }
+            }
+            return part;
+        }
+
+        struct ExtensionType {
+            const char* extension;
+            const char* contentType;
+        };
+
+        const ExtensionType KNOWN_TYPES[] = {
+            { "appx", "application/vnd.ms-appx" },
+            { "bmp", "image/bmp" },
+            { "css", "text/css" },
+            { "dll", "application/x-msdownload" },
+            { "exe", "application/x-msdownload" },
+            { "gif", "image/gif" },
+            { "htm", "text/html" },
+            { "html", "text/html" },
+            { "ico", "image/vnd.microsoft.icon" },
+            { "jpeg", "image/jpeg" },
+            { "jpg", "image/jpeg" },
+            { "js", "application/javascript" },
+            { "json", "application/json" },
+            { "mp3", "audio/mpeg" },
+            { "mp4", "video/mp4" },
+            { "msix", "application/vnd.ms-appx" },
+            { "png", "image/png" },
+            { "svg", "image/svg+xml" },
+            { "tif", "image/tiff" },
+            { "tiff", "image/tiff" },
+            { "ttf", "application/x-font-ttf" },
+            { "txt", "text/plain" },
+            { "wav", "audio/wav" },
+            { "woff", "application/font-woff" },
+            { "xml", "application/xml" },
+        };
+    }
+
+    std::string ContentTypeForExtension(const std::string& extension) {
+        std::string key = Lower(extension);
+        for (const auto& known : KNOWN_TYPES) {
+            if (key == known.extension) return known.contentType;
+        }
+        return "application/octet-stream";
+    }
+
+    bool ContentTypes::Parse(const std::string& xml) {
+        m_defaults.clear();
+        m_overrides.clear();
+
+        std::istringstream stream(xml);
+        XmlReader reader(stream);
+        bool sawRoot = false;
+
+        while (reader.Read()) {
+            if (reader.NodeType() != XmlNodeType::StartElement) continue;
+
+            std::string name = reader.LocalName();
+            if (reader.Depth() == 1) {
+                if (name != "Types") return false;
+                sawRoot = true;
+            }
+            else if (name == "Default") {
+                m_defaults.emplace_back(reader.GetAttribute("Extension"), reader.GetAttribute("ContentType"));
+            }
+            else if (name == "Override") {
+                m_overrides.emplace_back(reader.GetAttribute("PartName"), reader.GetAttribute("ContentType"));
+            }
+        }
+
+        return sawRoot && !reader.HasError();
+    }
+
+    bool ContentTypes::Covers(const std::string& entryName) const {
+        std::string part = Lower(PartName(entryName));
+        for (const auto& entry : m_overrides) {
+            if (Lower(entry.first) == part) return true;
+        }
+
+        std::string extension = Lower(ExtensionOf(entryName));
+        if (extension.empty()) return false;
+        for (const auto& entry : m_defaults) {
+            if (Lower(entry.first) == extension) return true;
+        }
+        return false;
+    }
+
+    bool ContentTypes::Add(const std::string& entryName) {
+        if (Covers(entryName)) return false;
+
+        std::string extension = ExtensionOf(entryName);
+        if (extension.empty()) {
+            m_overrides.emplace_back(PartName(entryName), "application/octet-stream");
+        }
+        else {
+            m_defaults.emplace_back(Lower(extension), ContentTypeForExtension(extension));
+        }
+        return true;
+    }
+
+    std::string ContentTypes::ToXml() const {
+        std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        xml += "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">";
+        for (const auto& entry : m_defaults) {
+            xml += "<Default Extension=\"" + XmlEscape(entry.first) + "\" ContentType=\"" + XmlEscape(entry.second) + "\"/>";
+        }
+        for (const auto& entry : m_overrides) {
+            xml += "<Override PartName=\"" + XmlEscape(entry.first) + "\" ContentType=\"" + XmlEscape(entry.second) + "\"/>";
+        }
+        xml += "</Types>";
+        return xml;
+    }
+}
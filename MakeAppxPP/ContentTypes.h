@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    constexpr const char* CONTENT_TYPES_ENTRY_NAME = "[Content_Types].xml";
+
+    // The OPC [Content_Types].xml of a package: a content type for each file extension, and overrides
+    // for single parts. Every entry other than the footprint files needs one or the other.
+    class ContentTypes {
+    private:
+        std::vector<std::pair<std::string, std::string>> m_defaults;
+        std::vector<std::pair<std::string, std::string>> m_overrides;
+
+    public:
+        bool Parse(const std::string& xml);
+        bool Covers(const std::string& entryName) const;
+        // Adds a Default for the entry's extension, or an Override for an entry without one, unless the
+        // entry is already covered. Returns whether anything was added.
+        bool Add(const std::string& entryName);
+        std::string ToXml() const;
+    };
+
+    std::string ContentTypeForExtension(const std::string& extension);
+}
@@ -0,0 +1,221 @@
+#include "Crc32.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CRC32_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(_M_ARM64) || defined(__ARM_FEATURE_CRC32)
+#define CRC32_ARM 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <arm_acle.h>
+#endif
+#endif
+
+#if defined(CRC32_X86) && defined(__GNUC__)
+#define CRC32_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#define CRC32_TARGET_PCLMUL
+#endif
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr uint32_t POLYNOMIAL = 0xEDB88320;
+
+        struct SliceTables {
+            uint32_t table[8][256];
+
+            SliceTables() {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t crc = i;
+                    for (int bit = 0; bit < 8; ++bit) {
+                        crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+                    }
+                    table[0][i] = crc;
+                }
+                for (uint32_t i = 0; i < 256; ++i) {
+                    for (int slice = 1; slice < 8; ++slice) {
+                        table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+                    }
+                }
+            }
+        };
+
+        const SliceTables& Tables() {
+            static const SliceTables tables;
+            return tables;
+        }
+
+        // Operates on the inverted register value.
+        uint32_t Crc32SliceBy8(uint32_t crc, const uint8_t* data, size_t size) {
+            const auto& t = Tables().table;
+
+            while (size >= 8) {
+                uint32_t low;
+                uint32_t high;
+                memcpy(&low, data, 4);
+                memcpy(&high, data + 4, 4);
+                low ^= crc;
+                crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+                    t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+                data += 8;
+                size -= 8;
+            }
+
+            while (size--) {
+                crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+            }
+            return crc;
+        }
+
+#ifdef CRC32_X86
+        constexpr size_t PCLMUL_MINIMUM_SIZE = 64;
+
+        bool HasPclmul() {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            unsigned int ecx = static_cast<unsigned int>(info[2]);
+#else
+            unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+            if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+#endif
+            return (ecx & (1u << 1)) != 0 && (ecx & (1u << 19)) != 0;
+        }
+
+        // Carry-less multiplication folding ("Fast CRC Computation Using PCLMULQDQ", Intel 2009).
+        // Processes a multiple of 16 bytes, at least 64, on the inverted register value.
+        CRC32_TARGET_PCLMUL
+        uint32_t Crc32Pclmul(uint32_t crc, const uint8_t* data, size_t size) {
+            alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+            alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+            alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+            alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+            __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+            x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+            x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+            x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+            x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+            x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+            x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+            data += 64;
+            size -= 64;
+
+            while (size >= 64) {
+                x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+                x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+                x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+                x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+                x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+                x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+                x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+                x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+                x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00)));
+                x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10)));
+                x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20)));
+                x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30)));
+                data += 64;
+                size -= 64;
+            }
+
+            x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+            while (size >= 16) {
+                x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+                x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+                x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+                data += 16;
+                size -= 16;
+            }
+
+            x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+            x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+            x1 = _mm_srli_si128(x1, 8);
+            x1 = _mm_xor_si128(x1, x2);
+
+            x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+            x2 = _mm_srli_si128(x1, 4);
+            x1 = _mm_and_si128(x1, x3);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_xor_si128(x1, x2);
+
+            x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+            x2 = _mm_and_si128(x1, x3);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+            x2 = _mm_and_si128(x2, x3);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+            x1 = _mm_xor_si128(x1, x2);
+
+            return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+        }
+
+        const bool s_usePclmul = HasPclmul();
+#endif
+
+#ifdef CRC32_ARM
+        uint32_t Crc32Arm(uint32_t crc, const uint8_t* data, size_t size) {
+            while (size >= 8) {
+                uint64_t value;
+                memcpy(&value, data, 8);
+                crc = __crc32d(crc, value);
+                data += 8;
+                size -= 8;
+            }
+            while (size--) {
+                crc = __crc32b(crc, *data++);
+            }
+            return crc;
+        }
+#endif
+    }
+
+    uint32_t Crc32(uint32_t crc, const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        crc = ~crc;
+
+#if defined(CRC32_X86)
+        if (s_usePclmul && size >= PCLMUL_MINIMUM_SIZE) {
+            size_t folded = size & ~static_cast<size_t>(15);
+            crc = Crc32Pclmul(crc, bytes, folded);
+            bytes += folded;
+            size -= folded;
+        }
+        crc = Crc32SliceBy8(crc, bytes, size);
+#elif defined(CRC32_ARM)
+        crc = Crc32Arm(crc, bytes, size);
+#else
+        crc = Crc32SliceBy8(crc, bytes, size);
+#endif
+
+        return ~crc;
+    }
+
+    const char* Crc32Implementation() {
+#if defined(CRC32_X86)
+        return s_usePclmul ? "pclmul" : "slice-by-8";
+#elif defined(CRC32_ARM)
+        return "armv8-crc32";
+#else
+        return "slice-by-8";
+#endif
+    }
+}
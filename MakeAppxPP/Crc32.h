@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace MakeAppxCore {
+
+    // Same polynomial and conventions as zlib's crc32(): start from 0, chain by passing the previous result.
+    uint32_t Crc32(uint32_t crc, const void* data, size_t size);
+    const char* Crc32Implementation();
+}
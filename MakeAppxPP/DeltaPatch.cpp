@@ -0,0 +1,545 @@
+#include "DeltaPatch.h"
+#include "AppxPackageImpl.h"
+#include "BlockMap.h"
+#include "ZipDirectory.h"
+#include "BufferPool.h"
+#include "FileWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr char PATCH_MAGIC[8] = { 'M', 'X', 'D', 'E', 'L', 'T', 'A', '1' };
+        constexpr uint32_t PATCH_VERSION = 1;
+        constexpr size_t CHUNK_SIZE = BLOCK_MAP_BLOCK_SIZE;
+        constexpr uint16_t METHOD_STORE = 0;
+        // Type, length, old offset and hash, as WriteOp lays them out.
+        constexpr uint64_t SERIALIZED_OP_SIZE = 1 + 8 + 8 + sizeof(Sha256::Digest);
+
+        enum class OpType : uint8_t {
+            Copy = 0,
+            Literal = 1
+        };
+
+        // A patch is: header, literal bytes in output order, the op list, and a trailer pointing at the op list.
+        struct PatchHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t reserved;
+            uint64_t oldSize;
+            uint64_t newSize;
+            Sha256::Digest newHash;
+        };
+
+        struct PatchTrailer {
+            uint64_t opListOffset;
+            uint64_t opCount;
+            char magic[8];
+        };
+
+        struct PatchOp {
+            OpType type = OpType::Literal;
+            uint64_t length = 0;
+            uint64_t oldOffset = 0;
+            Sha256::Digest hash = {};
+        };
+
+        template <typename T>
+        void WriteValue(std::ofstream& out, const T& value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        template <typename T>
+        bool ReadValue(std::ifstream& in, T& value) {
+            in.read(reinterpret_cast<char*>(&value), sizeof(value));
+            return in.gcount() == sizeof(value);
+        }
+
+        void WriteOp(std::ofstream& out, const PatchOp& op) {
+            WriteValue(out, static_cast<uint8_t>(op.type));
+            WriteValue(out, op.length);
+            WriteValue(out, op.oldOffset);
+            out.write(reinterpret_cast<const char*>(op.hash.data()), op.hash.size());
+        }
+
+        bool ReadOp(std::ifstream& in, PatchOp& op) {
+            uint8_t type = 0;
+            if (!ReadValue(in, type) || !ReadValue(in, op.length) || !ReadValue(in, op.oldOffset)) return false;
+            in.read(reinterpret_cast<char*>(op.hash.data()), op.hash.size());
+            if (in.gcount() != static_cast<std::streamsize>(op.hash.size())) return false;
+            if (type > static_cast<uint8_t>(OpType::Literal)) return false;
+            op.type = static_cast<OpType>(type);
+            return true;
+        }
+
+        struct PackageIndex {
+            FileSource source;
+            ZipDirectory directory;
+            std::vector<BlockMapEntry> blockMap;
+            std::unordered_map<std::string, const BlockMapEntry*> blockMapByName;
+
+            explicit PackageIndex(const std::wstring& path) : source(ToPath(path)) {}
+        };
+
+        bool OpenPackage(const std::wstring& path, PackageIndex& index, std::wstring& error) {
+            if (!index.source.IsOpen() || !index.directory.Read(index.source)) {
+                error = L"Failed to read package directory of " + path + L": " + index.directory.GetLastError();
+                return false;
+            }
+
+            const ZipDirectoryEntry* blockMapEntry = index.directory.Find(BLOCK_MAP_ENTRY_NAME);
+            std::string xml;
+            if (blockMapEntry && index.directory.ReadEntryData(index.source, *blockMapEntry, xml) &&
+                ParseBlockMapXml(xml, index.blockMap)) {
+                for (const auto& entry : index.blockMap) {
+                    index.blockMapByName.emplace(NormalizeEntryName(entry.name), &entry);
+                }
+            }
+            return true;
+        }
+
+        // Compressed size of each 64 KB block, when the block map describes the entry's compressed layout.
+        bool CompressedBlockSizes(const PackageIndex& index, const ZipDirectoryEntry& entry,
+            std::vector<uint64_t>& sizes, const BlockMapEntry*& blocks) {
+
+            sizes.clear();
+            auto it = index.blockMapByName.find(NormalizeEntryName(entry.name));
+            if (it == index.blockMapByName.end()) return false;
+            blocks = it->second;
+
+            uint64_t total = 0;
+            uint64_t remaining = entry.uncompressedSize;
+            for (const auto& block : blocks->blocks) {
+                uint64_t size = entry.method == METHOD_STORE ?
+                    std::min<uint64_t>(remaining, BLOCK_MAP_BLOCK_SIZE) : block.compressedSize;
+                remaining -= std::min<uint64_t>(remaining, BLOCK_MAP_BLOCK_SIZE);
+                sizes.push_back(size);
+                total += size;
+            }
+            return total == entry.compressedSize && !sizes.empty();
+        }
+
+        std::string BlockKey(const Sha256::Digest& hash, uint64_t compressedSize) {
+            std::string key(reinterpret_cast<const char*>(hash.data()), hash.size());
+            key.append(reinterpret_cast<const char*>(&compressedSize), sizeof(compressedSize));
+            return key;
+        }
+
+        class PatchWriter {
+        private:
+            std::ofstream& m_out;
+            std::vector<PatchOp> m_ops;
+            Sha256 m_opHash;
+            Sha256 m_fileHash;
+            bool m_open = false;
+            DeltaStats& m_stats;
+
+            void CloseOp() {
+                if (!m_open) return;
+                m_ops.back().hash = m_opHash.Finish();
+                m_open = false;
+            }
+
+        public:
+            PatchWriter(std::ofstream& out, DeltaStats& stats) : m_out(out), m_stats(stats) {}
+
+            void Copy(uint64_t oldOffset, const uint8_t* data, size_t size) {
+                if (!m_open || m_ops.back().type != OpType::Copy ||
+                    m_ops.back().oldOffset + m_ops.back().length != oldOffset) {
+                    CloseOp();
+                    PatchOp op;
+                    op.type = OpType::Copy;
+                    op.oldOffset = oldOffset;
+                    m_ops.push_back(op);
+                    m_open = true;
+                }
+                m_ops.back().length += size;
+                m_opHash.Update(data, size);
+                m_fileHash.Update(data, size);
+                m_stats.copiedBytes += size;
+            }
+
+            void Literal(const uint8_t* data, size_t size) {
+                if (!m_open || m_ops.back().type != OpType::Literal) {
+                    CloseOp();
+                    m_ops.push_back(PatchOp());
+                    m_open = true;
+                }
+                m_ops.back().length += size;
+                m_opHash.Update(data, size);
+                m_fileHash.Update(data, size);
+                m_out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+                m_stats.literalBytes += size;
+            }
+
+            const std::vector<PatchOp>& Finish(Sha256::Digest& fileHash) {
+                CloseOp();
+                fileHash = m_fileHash.Finish();
+                m_stats.operations = m_ops.size();
+                return m_ops;
+            }
+        };
+
+        class DeltaBuilder {
+        private:
+            PackageIndex& m_old;
+            PackageIndex& m_new;
+            PatchWriter& m_writer;
+            BufferPool::Lease m_newBuffer;
+            BufferPool::Lease m_oldBuffer;
+
+        public:
+            std::wstring error;
+
+            DeltaBuilder(PackageIndex& oldIndex, PackageIndex& newIndex, PatchWriter& writer)
+                : m_old(oldIndex), m_new(newIndex), m_writer(writer),
+                  m_newBuffer(BufferPool::Shared().Acquire(CHUNK_SIZE)), m_oldBuffer(BufferPool::Shared().Acquire(CHUNK_SIZE)) {}
+
+            // Emits [offset, offset + length) of the new package, copying chunks that match the old range.
+            bool Emit(uint64_t offset, uint64_t length, bool hasCandidate, uint64_t oldOffset) {
+                while (length > 0) {
+                    size_t chunk = static_cast<size_t>(std::min<uint64_t>(length, CHUNK_SIZE));
+                    if (!m_new.source.ReadAt(offset, m_newBuffer.Data(), chunk)) {
+                        error = L"Failed to read new package";
+                        return false;
+                    }
+
+                    if (hasCandidate && m_old.source.ReadAt(oldOffset, m_oldBuffer.Data(), chunk) &&
+                        memcmp(m_newBuffer.Data(), m_oldBuffer.Data(), chunk) == 0) {
+                        m_writer.Copy(oldOffset, m_newBuffer.Data(), chunk);
+                    }
+                    else {
+                        m_writer.Literal(m_newBuffer.Data(), chunk);
+                    }
+
+                    offset += chunk;
+                    oldOffset += chunk;
+                    length -= chunk;
+                }
+                return true;
+            }
+        };
+    }
+
+    bool CreateDeltaPatch(const std::wstring& oldPackage, const std::wstring& newPackage,
+        const std::wstring& patchPath, DeltaStats& stats, ProgressCallback callback, std::wstring& error) {
+
+        stats = DeltaStats();
+
+        PackageIndex oldIndex(oldPackage);
+        PackageIndex newIndex(newPackage);
+        if (!OpenPackage(oldPackage, oldIndex, error) || !OpenPackage(newPackage, newIndex, error)) {
+            return false;
+        }
+
+        std::unordered_map<std::string, const ZipDirectoryEntry*> oldByName;
+        std::unordered_map<std::string, uint64_t> oldBlocks;
+        std::vector<uint64_t> sizes;
+        for (const auto& entry : oldIndex.directory.Entries()) {
+            oldByName.emplace(NormalizeEntryName(entry.name), &entry);
+
+            const BlockMapEntry* blocks = nullptr;
+            uint64_t dataOffset = 0;
+            if (!CompressedBlockSizes(oldIndex, entry, sizes, blocks) ||
+                !oldIndex.directory.ReadDataOffset(oldIndex.source, entry, dataOffset)) {
+                continue;
+            }
+            for (size_t i = 0; i < sizes.size(); ++i) {
+                oldBlocks.emplace(BlockKey(blocks->blocks[i].hash, sizes[i]), dataOffset);
+                dataOffset += sizes[i];
+            }
+        }
+
+        // Written beside the target and renamed into place, so a failed run never leaves half a patch.
+        fs::path tempPath = ToPath(patchPath + L".tmp");
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            error = L"Cannot create patch file: " + patchPath;
+            return false;
+        }
+
+        auto fail = [&](const std::wstring& message) {
+            out.close();
+            std::error_code ec;
+            fs::remove(tempPath, ec);
+            error = message;
+            return false;
+        };
+
+        PatchHeader header = {};
+        memcpy(header.magic, PATCH_MAGIC, sizeof(PATCH_MAGIC));
+        header.version = PATCH_VERSION;
+        header.oldSize = oldIndex.source.Size();
+        header.newSize = newIndex.source.Size();
+        WriteValue(out, header);
+
+        PatchWriter writer(out, stats);
+        DeltaBuilder builder(oldIndex, newIndex, writer);
+
+        std::vector<const ZipDirectoryEntry*> entries;
+        for (const auto& entry : newIndex.directory.Entries()) {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const ZipDirectoryEntry* a, const ZipDirectoryEntry* b) {
+            return a->localHeaderOffset < b->localHeaderOffset;
+        });
+
+        ProgressInfo progress = {};
+        progress.totalFiles = entries.size();
+        progress.totalBytes = newIndex.source.Size();
+
+        uint64_t position = 0;
+        for (const ZipDirectoryEntry* entry : entries) {
+            if (entry->localHeaderOffset > position &&
+                !builder.Emit(position, entry->localHeaderOffset - position, false, 0)) {
+                return fail(builder.error);
+            }
+
+            uint64_t recordStart = entry->localHeaderOffset;
+            uint64_t recordLength = entry->recordEnd - recordStart;
+            auto old = oldByName.find(NormalizeEntryName(entry->name));
+            bool sameRecord = old != oldByName.end() &&
+                old->second->crc32 == entry->crc32 && old->second->method == entry->method &&
+                old->second->compressedSize == entry->compressedSize &&
+                old->second->uncompressedSize == entry->uncompressedSize &&
+                old->second->recordEnd - old->second->localHeaderOffset == recordLength;
+
+            uint64_t dataOffset = 0;
+            const BlockMapEntry* blocks = nullptr;
+
+            if (sameRecord) {
+                if (!builder.Emit(recordStart, recordLength, true, old->second->localHeaderOffset)) {
+                    return fail(builder.error);
+                }
+            }
+            else if (newIndex.directory.ReadDataOffset(newIndex.source, *entry, dataOffset) &&
+                CompressedBlockSizes(newIndex, *entry, sizes, blocks)) {
+
+                bool ok = builder.Emit(recordStart, dataOffset - recordStart, false, 0);
+                uint64_t blockOffset = dataOffset;
+                for (size_t i = 0; ok && i < sizes.size(); ++i) {
+                    auto match = oldBlocks.find(BlockKey(blocks->blocks[i].hash, sizes[i]));
+                    ok = builder.Emit(blockOffset, sizes[i], match != oldBlocks.end(),
+                        match != oldBlocks.end() ? match->second : 0);
+                    blockOffset += sizes[i];
+                }
+                ok = ok && builder.Emit(blockOffset, entry->recordEnd - blockOffset, false, 0);
+                if (!ok) {
+                    return fail(builder.error);
+                }
+            }
+            else if (!builder.Emit(recordStart, recordLength, false, 0)) {
+                return fail(builder.error);
+            }
+
+            position = entry->recordEnd;
+
+            if (callback) {
+                ++progress.processedFiles;
+                progress.processedBytes = position;
+                progress.currentFile = Utf8ToWideSafe(entry->name);
+                callback(progress);
+            }
+        }
+
+        if (!builder.Emit(position, newIndex.source.Size() - position, false, 0)) {
+            return fail(builder.error);
+        }
+
+        const std::vector<PatchOp>& ops = writer.Finish(header.newHash);
+
+        PatchTrailer trailer = {};
+        trailer.opListOffset = static_cast<uint64_t>(out.tellp());
+        trailer.opCount = ops.size();
+        memcpy(trailer.magic, PATCH_MAGIC, sizeof(PATCH_MAGIC));
+
+        for (const auto& op : ops) {
+            WriteOp(out, op);
+        }
+        WriteValue(out, trailer);
+
+        out.seekp(0);
+        WriteValue(out, header);
+        out.close();
+
+        if (!out.good()) {
+            return fail(L"Failed to write patch file: " + patchPath);
+        }
+
+        std::error_code ec;
+        stats.patchSize = fs::file_size(tempPath, ec);
+        fs::rename(tempPath, ToPath(patchPath), ec);
+        if (ec) {
+            return fail(L"Failed to write patch file: " + Utf8ToWideSafe(ec.message()));
+        }
+        return true;
+    }
+
+    bool ApplyDeltaPatch(const std::wstring& oldPackage, const std::wstring& patchPath,
+        const std::wstring& outputPath, ProgressCallback callback, std::wstring& error) {
+
+        std::ifstream patch(ToPath(patchPath), std::ios::binary);
+        if (!patch.is_open()) {
+            error = L"Cannot open patch file: " + patchPath;
+            return false;
+        }
+
+        std::error_code sizeError;
+        uint64_t patchSize = fs::file_size(ToPath(patchPath), sizeError);
+        if (sizeError || patchSize < sizeof(PatchHeader) + sizeof(PatchTrailer)) {
+            error = L"Not a valid delta patch: " + patchPath;
+            return false;
+        }
+
+        PatchHeader header = {};
+        PatchTrailer trailer = {};
+        patch.seekg(-static_cast<std::streamoff>(sizeof(trailer)), std::ios::end);
+        bool valid = ReadValue(patch, trailer) && memcmp(trailer.magic, PATCH_MAGIC, sizeof(PATCH_MAGIC)) == 0;
+        patch.seekg(0);
+        valid = valid && ReadValue(patch, header) && memcmp(header.magic, PATCH_MAGIC, sizeof(PATCH_MAGIC)) == 0;
+        if (!valid || header.version != PATCH_VERSION) {
+            error = L"Not a valid delta patch: " + patchPath;
+            return false;
+        }
+
+        // The op list fills the space between the literals and the trailer exactly; anything else is a
+        // corrupt or hostile count, checked before it sizes an allocation.
+        uint64_t opListEnd = patchSize - sizeof(PatchTrailer);
+        if (trailer.opListOffset < sizeof(PatchHeader) || trailer.opListOffset > opListEnd ||
+            trailer.opCount > (opListEnd - trailer.opListOffset) / SERIALIZED_OP_SIZE ||
+            trailer.opCount * SERIALIZED_OP_SIZE != opListEnd - trailer.opListOffset) {
+            error = L"Patch operation list is corrupt: " + patchPath;
+            return false;
+        }
+
+        std::vector<PatchOp> ops(static_cast<size_t>(trailer.opCount));
+        patch.seekg(static_cast<std::streamoff>(trailer.opListOffset));
+        for (auto& op : ops) {
+            if (!ReadOp(patch, op)) {
+                error = L"Patch operation list is truncated: " + patchPath;
+                return false;
+            }
+        }
+        patch.clear();
+        patch.seekg(sizeof(PatchHeader));
+
+        // Copies stay inside the old package, literals inside the literal region, and together the ops
+        // produce exactly newSize bytes, so newSize is bounded by real data before it is preallocated.
+        uint64_t literalBytes = 0;
+        uint64_t outputBytes = 0;
+        uint64_t literalRegion = trailer.opListOffset - sizeof(PatchHeader);
+        for (const auto& op : ops) {
+            bool inRange = op.type == OpType::Copy ?
+                op.oldOffset <= header.oldSize && op.length <= header.oldSize - op.oldOffset :
+                op.length <= literalRegion - literalBytes;
+            if (!inRange || op.length > header.newSize - outputBytes) {
+                error = L"Patch operation list is corrupt: " + patchPath;
+                return false;
+            }
+            if (op.type == OpType::Literal) {
+                literalBytes += op.length;
+            }
+            outputBytes += op.length;
+        }
+        if (outputBytes != header.newSize || literalBytes != literalRegion) {
+            error = L"Patch operation list is corrupt: " + patchPath;
+            return false;
+        }
+
+        FileSource old{ ToPath(oldPackage) };
+        if (!old.IsOpen() || old.Size() != header.oldSize) {
+            error = L"Old package does not match the patch (expected " + std::to_wstring(header.oldSize) + L" bytes)";
+            return false;
+        }
+
+        fs::path tempPath = ToPath(outputPath + L".apply.tmp");
+        FileWriter out;
+        if (!out.Open(tempPath, header.newSize)) {
+            error = out.GetLastError();
+            return false;
+        }
+
+        auto fail = [&](const std::wstring& message) {
+            out.Close();
+            std::error_code ec;
+            fs::remove(tempPath, ec);
+            error = message;
+            return false;
+        };
+
+        ProgressInfo progress = {};
+        progress.totalFiles = ops.size();
+        progress.totalBytes = header.newSize;
+
+        Sha256 fileHash;
+        Sha256 opHash;
+        uint64_t written = 0;
+
+        for (size_t i = 0; i < ops.size(); ++i) {
+            const PatchOp& op = ops[i];
+            uint64_t remaining = op.length;
+            uint64_t oldOffset = op.oldOffset;
+
+            while (remaining > 0) {
+                size_t available = 0;
+                uint8_t* buffer = out.Buffer(available);
+                if (!buffer) {
+                    return fail(out.GetLastError());
+                }
+
+                size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, available));
+                if (op.type == OpType::Copy) {
+                    if (!old.ReadAt(oldOffset, buffer, chunk)) {
+                        return fail(L"Copy operation reads past the end of the old package");
+                    }
+                    oldOffset += chunk;
+                }
+                else {
+                    patch.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(chunk));
+                    if (patch.gcount() != static_cast<std::streamsize>(chunk)) {
+                        return fail(L"Patch data is truncated");
+                    }
+                }
+
+                opHash.Update(buffer, chunk);
+                fileHash.Update(buffer, chunk);
+                if (!out.Commit(chunk)) {
+                    return fail(out.GetLastError());
+                }
+                remaining -= chunk;
+                written += chunk;
+            }
+
+            if (opHash.Finish() != op.hash) {
+                return fail(op.type == OpType::Copy ?
+                    L"Old package content does not match the patch (operation " + std::to_wstring(i) + L")" :
+                    L"Patch data is corrupt (operation " + std::to_wstring(i) + L")");
+            }
+
+            if (callback) {
+                progress.processedFiles = i + 1;
+                progress.processedBytes = written;
+                callback(progress);
+            }
+        }
+
+        if (!out.Close()) {
+            return fail(out.GetLastError());
+        }
+        if (written != header.newSize || fileHash.Finish() != header.newHash) {
+            return fail(L"Reconstructed package hash does not match the patch");
+        }
+
+        std::error_code ec;
+        fs::rename(tempPath, ToPath(outputPath), ec);
+        if (ec) {
+            fs::remove(tempPath, ec);
+            error = L"Failed to write output file: " + Utf8ToWideSafe(ec.message());
+            return false;
+        }
+        return true;
+    }
+}
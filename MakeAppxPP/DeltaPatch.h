@@ -0,0 +1,11 @@
+#pragma once
+#include "AppxPackage.h"
+#include <string>
+
+namespace MakeAppxCore {
+
+    bool CreateDeltaPatch(const std::wstring& oldPackage, const std::wstring& newPackage,
+        const std::wstring& patchPath, DeltaStats& stats, ProgressCallback callback, std::wstring& error);
+    bool ApplyDeltaPatch(const std::wstring& oldPackage, const std::wstring& patchPath,
+        const std::wstring& outputPath, ProgressCallback callback, std::wstring& error);
+}
@@ -0,0 +1,153 @@
+#include "DirectoryWatcher.h"
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace MakeAppxCore {
+
+    namespace fs = std::filesystem;
+
+    DirectoryWatcher::~DirectoryWatcher() {
+        Close();
+    }
+
+#ifdef _WIN32
+    bool DirectoryWatcher::Open(const fs::path& root) {
+        Close();
+        HANDLE handle = FindFirstChangeNotificationW(root.c_str(), TRUE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+            FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+        if (handle == INVALID_HANDLE_VALUE) return false;
+        m_handle = handle;
+        return true;
+    }
+
+    void DirectoryWatcher::Close() {
+        if (m_handle) FindCloseChangeNotification(m_handle);
+        m_handle = nullptr;
+    }
+
+    bool DirectoryWatcher::IsNative() const {
+        return m_handle != nullptr;
+    }
+
+    bool DirectoryWatcher::Wait(std::chrono::milliseconds timeout) {
+        if (!m_handle) {
+            std::this_thread::sleep_for(timeout);
+            return false;
+        }
+        if (WaitForSingleObject(m_handle, static_cast<DWORD>(timeout.count())) != WAIT_OBJECT_0) {
+            return false;
+        }
+        if (!FindNextChangeNotification(m_handle)) {
+            Close();
+        }
+        return true;
+    }
+#elif defined(__linux__)
+    namespace {
+        constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+            IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+    }
+
+    bool DirectoryWatcher::Open(const fs::path& root) {
+        Close();
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd < 0) return false;
+        if (!AddTree(root)) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void DirectoryWatcher::Close() {
+        if (m_fd >= 0) close(m_fd);
+        m_fd = -1;
+        m_directories.clear();
+    }
+
+    bool DirectoryWatcher::IsNative() const {
+        return m_fd >= 0;
+    }
+
+    // inotify watches one directory at a time, so every directory of the tree needs its own watch.
+    bool DirectoryWatcher::AddTree(const fs::path& directory) {
+        int wd = inotify_add_watch(m_fd, directory.c_str(), WATCH_MASK);
+        if (wd < 0) {
+            // The directory may already be gone again; only running out of watches is fatal.
+            return errno != ENOSPC && errno != ENOMEM;
+        }
+        m_directories[wd] = directory;
+
+        std::error_code ec;
+        for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_directory(ec) && !it->is_symlink(ec) && !AddTree(it->path())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool DirectoryWatcher::Wait(std::chrono::milliseconds timeout) {
+        if (m_fd < 0) {
+            std::this_thread::sleep_for(timeout);
+            return false;
+        }
+
+        pollfd descriptor = { m_fd, POLLIN, 0 };
+        if (poll(&descriptor, 1, static_cast<int>(timeout.count())) <= 0) {
+            return false;
+        }
+
+        alignas(inotify_event) char buffer[64 * 1024];
+        bool treeComplete = true;
+        ssize_t length;
+        while ((length = read(m_fd, buffer, sizeof(buffer))) > 0) {
+            for (char* position = buffer; position < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+                position += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_IGNORED) {
+                    m_directories.erase(event->wd);
+                }
+                else if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)) && event->len > 0) {
+                    auto parent = m_directories.find(event->wd);
+                    if (parent != m_directories.end() && !AddTree(parent->second / event->name)) {
+                        treeComplete = false;
+                    }
+                }
+            }
+        }
+
+        if (!treeComplete) {
+            Close();
+        }
+        return true;
+    }
+#else
+    bool DirectoryWatcher::Open(const fs::path&) {
+        return false;
+    }
+
+    void DirectoryWatcher::Close() {
+        m_fd = -1;
+    }
+
+    bool DirectoryWatcher::IsNative() const {
+        return false;
+    }
+
+    bool DirectoryWatcher::Wait(std::chrono::milliseconds timeout) {
+        std::this_thread::sleep_for(timeout);
+        return false;
+    }
+#endif
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+
+namespace MakeAppxCore {
+
+    // Tells when something below a directory may have changed, without saying what: callers rescan.
+    // inotify on Linux and change notifications on Windows. Where neither is available, or Linux runs
+    // out of inotify watches, the watcher stops being native and callers fall back to polling.
+    class DirectoryWatcher {
+    private:
+#ifdef _WIN32
+        void* m_handle = nullptr;
+#else
+        int m_fd = -1;
+        std::unordered_map<int, std::filesystem::path> m_directories;
+
+        bool AddTree(const std::filesystem::path& directory);
+#endif
+
+    public:
+        DirectoryWatcher() = default;
+        ~DirectoryWatcher();
+
+        DirectoryWatcher(const DirectoryWatcher&) = delete;
+        DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+        bool Open(const std::filesystem::path& root);
+        void Close();
+        bool IsNative() const;
+
+        // Returns true as soon as a change is seen and false once the timeout passes without one.
+        bool Wait(std::chrono::milliseconds timeout);
+    };
+}
@@ -0,0 +1,574 @@
+#include "EntryCache.h"
+#include "AppxPackageImpl.h"
+#include "Crc32.h"
+#include "BufferPool.h"
+#include "TaskScheduler.h"
+#include <zlib.h>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr uint32_t METADATA_MAGIC = 0x4543584D;
+        constexpr uint32_t METADATA_VERSION = 1;
+
+        struct CompressedSourceState {
+            CompressedEntry entry;
+            time_t modifiedTime;
+            std::ifstream stream;
+            uint64_t remaining = 0;
+            zip_error_t error;
+        };
+
+        zip_int64_t CompressedSourceCallback(void* userdata, void* data, zip_uint64_t len, zip_source_cmd_t cmd) {
+            auto* state = static_cast<CompressedSourceState*>(userdata);
+
+            switch (cmd) {
+            case ZIP_SOURCE_OPEN:
+                state->stream.open(state->entry.dataPath, std::ios::binary);
+                if (!state->stream.is_open()) {
+                    zip_error_set(&state->error, ZIP_ER_OPEN, errno);
+                    return -1;
+                }
+                state->stream.seekg(static_cast<std::streamoff>(state->entry.dataOffset));
+                state->remaining = state->entry.compressedSize;
+                return 0;
+
+            case ZIP_SOURCE_READ: {
+                uint64_t toRead = len < state->remaining ? len : state->remaining;
+                if (toRead == 0) return 0;
+                state->stream.read(static_cast<char*>(data), static_cast<std::streamsize>(toRead));
+                uint64_t bytesRead = static_cast<uint64_t>(state->stream.gcount());
+                if (bytesRead != toRead) {
+                    zip_error_set(&state->error, ZIP_ER_READ, errno);
+                    return -1;
+                }
+                state->remaining -= bytesRead;
+                return static_cast<zip_int64_t>(bytesRead);
+            }
+
+            case ZIP_SOURCE_CLOSE:
+                state->stream.close();
+                return 0;
+
+            case ZIP_SOURCE_STAT: {
+                if (len < sizeof(zip_stat_t)) {
+                    zip_error_set(&state->error, ZIP_ER_INVAL, 0);
+                    return -1;
+                }
+                zip_stat_t* st = static_cast<zip_stat_t*>(data);
+                zip_stat_init(st);
+                st->valid = ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_COMP_METHOD |
+                    ZIP_STAT_CRC | ZIP_STAT_MTIME | ZIP_STAT_ENCRYPTION_METHOD;
+                st->size = state->entry.uncompressedSize;
+                st->comp_size = state->entry.compressedSize;
+                st->comp_method = ZIP_CM_DEFLATE;
+                st->encryption_method = ZIP_EM_NONE;
+                st->crc = state->entry.crc32;
+                st->mtime = state->modifiedTime;
+                return sizeof(zip_stat_t);
+            }
+
+            case ZIP_SOURCE_ERROR:
+                return zip_error_to_data(&state->error, data, len);
+
+            case ZIP_SOURCE_FREE:
+                zip_error_fini(&state->error);
+                delete state;
+                return 0;
+
+            case ZIP_SOURCE_SUPPORTS:
+                return zip_source_make_command_bitmap(ZIP_SOURCE_OPEN, ZIP_SOURCE_READ, ZIP_SOURCE_CLOSE,
+                    ZIP_SOURCE_STAT, ZIP_SOURCE_ERROR, ZIP_SOURCE_FREE, ZIP_SOURCE_SUPPORTS, -1);
+
+            default:
+                zip_error_set(&state->error, ZIP_ER_OPNOTSUPP, 0);
+                return -1;
+            }
+        }
+
+        template <typename T>
+        void WriteValue(std::ofstream& out, T value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        template <typename T>
+        bool ReadValue(std::ifstream& in, T& value) {
+            in.read(reinterpret_cast<char*>(&value), sizeof(value));
+            return in.gcount() == sizeof(value);
+        }
+    }
+
+    int ZlibLevelFor(CompressionLevel compression) {
+        switch (compression) {
+        case CompressionLevel::Fast:
+            return 1;
+        case CompressionLevel::Maximum:
+            return 9;
+        case CompressionLevel::None:
+            return 0;
+        case CompressionLevel::Normal:
+        default:
+            return 6;
+        }
+    }
+
+    time_t ToTimeT(fs::file_time_type fileTime) {
+        auto systemTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            fileTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+        return std::chrono::system_clock::to_time_t(systemTime);
+    }
+
+    bool EncodeEntry(std::istream& input, int zlibLevel, bool store, const EntrySink& sink,
+        CompressedEntry& entry, std::wstring& error) {
+
+        BufferPool::Lease deflateState;
+        z_stream stream = {};
+        if (!store) {
+            deflateState = BufferPool::Shared().Reserve(DEFLATE_STATE_MEMORY);
+            if (deflateInit2(&stream, zlibLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                error = L"Failed to initialize deflate";
+                return false;
+            }
+        }
+
+        BufferPool::Lease inBuffer = BufferPool::Shared().Acquire(BLOCK_MAP_BLOCK_SIZE);
+        BufferPool::Lease outBuffer;
+        if (!store) {
+            outBuffer = BufferPool::Shared().Acquire(deflateBound(&stream, BLOCK_MAP_BLOCK_SIZE) + 64);
+        }
+        Sha256 blockHasher;
+        uint32_t crc = 0;
+
+        entry = CompressedEntry();
+        bool success = true;
+
+        while (success) {
+            input.read(reinterpret_cast<char*>(inBuffer.Data()), BLOCK_MAP_BLOCK_SIZE);
+            size_t bytesRead = static_cast<size_t>(input.gcount());
+            int flush = bytesRead < BLOCK_MAP_BLOCK_SIZE ? Z_FINISH : Z_FULL_FLUSH;
+
+            BlockMapBlock block = {};
+            if (bytesRead > 0) {
+                crc = Crc32(crc, inBuffer.Data(), bytesRead);
+                blockHasher.Update(inBuffer.Data(), bytesRead);
+                block.hash = blockHasher.Finish();
+            }
+
+            uint64_t produced = 0;
+            if (store) {
+                if (bytesRead > 0 && !sink(inBuffer.Data(), bytesRead)) {
+                    error = L"Failed to write entry data";
+                    success = false;
+                    break;
+                }
+                produced = bytesRead;
+            }
+            else {
+                stream.next_in = inBuffer.Data();
+                stream.avail_in = static_cast<uInt>(bytesRead);
+
+                do {
+                    stream.next_out = outBuffer.Data();
+                    stream.avail_out = static_cast<uInt>(outBuffer.Size());
+                    if (deflate(&stream, flush) == Z_STREAM_ERROR) {
+                        error = L"Deflate failed";
+                        success = false;
+                        break;
+                    }
+                    size_t have = outBuffer.Size() - stream.avail_out;
+                    if (have > 0 && !sink(outBuffer.Data(), have)) {
+                        error = L"Failed to write entry data";
+                        success = false;
+                        break;
+                    }
+                    produced += have;
+                } while (stream.avail_out == 0);
+            }
+
+            // Block maps omit Size for stored files, so stored blocks keep a compressed size of zero.
+            if (bytesRead > 0) {
+                block.compressedSize = store ? 0 : static_cast<uint32_t>(produced);
+                entry.blocks.push_back(block);
+            }
+            else if (!entry.blocks.empty()) {
+                entry.blocks.back().compressedSize += static_cast<uint32_t>(produced);
+            }
+
+            entry.uncompressedSize += bytesRead;
+            entry.compressedSize += produced;
+
+            if (flush == Z_FINISH) break;
+        }
+
+        if (!store) {
+            deflateEnd(&stream);
+        }
+
+        if (success && input.bad()) {
+            error = L"Failed to read entry data";
+            success = false;
+        }
+
+        if (success) {
+            entry.crc32 = static_cast<uint32_t>(crc);
+            entry.contentHash = ContentHashFromBlocks(entry.blocks, entry.uncompressedSize);
+        }
+
+        return success;
+    }
+
+    bool CompressFileEntry(const fs::path& sourcePath, const fs::path& outputPath, int zlibLevel,
+        CompressedEntry& entry, std::wstring& error) {
+
+        std::ifstream input(sourcePath, std::ios::binary);
+        if (!input.is_open()) {
+            error = L"Cannot open file: " + FromPath(sourcePath);
+            return false;
+        }
+
+        std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+        if (!output.is_open()) {
+            error = L"Cannot create cache file: " + FromPath(outputPath);
+            return false;
+        }
+
+        auto sink = [&output](const uint8_t* data, size_t size) {
+            output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            return output.good();
+        };
+
+        if (!EncodeEntry(input, zlibLevel, false, sink, entry, error)) {
+            error += L": " + FromPath(sourcePath);
+            return false;
+        }
+
+        output.close();
+        if (!output.good()) {
+            error = L"Failed to write cache file: " + FromPath(outputPath);
+            return false;
+        }
+
+        entry.dataPath = outputPath;
+        entry.dataOffset = 0;
+        return true;
+    }
+
+    bool HashFileBlocks(const fs::path& sourcePath, std::vector<BlockMapBlock>& blocks, std::wstring& error) {
+        std::ifstream input(sourcePath, std::ios::binary);
+        if (!input.is_open()) {
+            error = L"Cannot open file: " + FromPath(sourcePath);
+            return false;
+        }
+
+        BufferPool::Lease buffer = BufferPool::Shared().Acquire(BLOCK_MAP_BLOCK_SIZE);
+        Sha256 hasher;
+        blocks.clear();
+
+        while (input) {
+            input.read(reinterpret_cast<char*>(buffer.Data()), BLOCK_MAP_BLOCK_SIZE);
+            size_t bytesRead = static_cast<size_t>(input.gcount());
+            if (bytesRead == 0) break;
+
+            BlockMapBlock block = {};
+            hasher.Update(buffer.Data(), bytesRead);
+            block.hash = hasher.Finish();
+            blocks.push_back(block);
+        }
+
+        if (input.bad()) {
+            error = L"Failed to read file: " + FromPath(sourcePath);
+            return false;
+        }
+        return true;
+    }
+
+    Sha256::Digest ContentHashFromBlocks(const std::vector<BlockMapBlock>& blocks, uint64_t size) {
+        Sha256 hasher;
+        for (const auto& block : blocks) {
+            hasher.Update(block.hash.data(), block.hash.size());
+        }
+        hasher.Update(&size, sizeof(size));
+        return hasher.Finish();
+    }
+
+    bool FindDuplicateFiles(const std::vector<PackageFile>& files, std::vector<size_t>& primaryOf,
+        std::wstring& error) {
+
+        primaryOf.resize(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            primaryOf[i] = i;
+        }
+
+        std::unordered_map<uint64_t, std::vector<size_t>> sizeBuckets;
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (files[i].size > 0) {
+                sizeBuckets[files[i].size].push_back(i);
+            }
+        }
+
+        std::vector<size_t> candidates;
+        for (const auto& bucket : sizeBuckets) {
+            if (bucket.second.size() > 1) {
+                candidates.insert(candidates.end(), bucket.second.begin(), bucket.second.end());
+            }
+        }
+
+        if (candidates.empty()) return true;
+
+        std::vector<Sha256::Digest> hashes(files.size());
+        std::atomic<bool> failed{ false };
+        std::mutex errorMutex;
+
+        {
+            TaskGroup group(TaskClass::Cpu, BufferPool::Shared().WorkerCount(BLOCK_MAP_BLOCK_SIZE,
+                TaskScheduler::Shared().ThreadCount(TaskClass::Cpu)));
+            for (size_t fileIndex : candidates) {
+                group.Run([&, fileIndex]() {
+                    if (failed) return;
+                    std::vector<BlockMapBlock> blocks;
+                    std::wstring hashError;
+                    if (!HashFileBlocks(files[fileIndex].localPath, blocks, hashError)) {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!failed.exchange(true)) {
+                            error = hashError;
+                        }
+                        return;
+                    }
+                    hashes[fileIndex] = ContentHashFromBlocks(blocks, files[fileIndex].size);
+                }, files[fileIndex].size);
+            }
+        }
+
+        if (failed) return false;
+
+        for (const auto& bucket : sizeBuckets) {
+            if (bucket.second.size() < 2) continue;
+
+            std::map<Sha256::Digest, size_t> firstByHash;
+            for (size_t fileIndex : bucket.second) {
+                primaryOf[fileIndex] = firstByHash.emplace(hashes[fileIndex], fileIndex).first->second;
+            }
+        }
+
+        return true;
+    }
+
+    zip_source_t* CreateCompressedEntrySource(zip_t* zip, const CompressedEntry& entry, time_t modifiedTime) {
+        auto* state = new CompressedSourceState();
+        state->entry = entry;
+        state->modifiedTime = modifiedTime;
+        zip_error_init(&state->error);
+
+        zip_source_t* source = zip_source_function(zip, CompressedSourceCallback, state);
+        if (!source) {
+            zip_error_fini(&state->error);
+            delete state;
+        }
+        return source;
+    }
+
+    CompressedEntryCache::CompressedEntryCache(const fs::path& root) : m_root(root) {
+    }
+
+    bool CompressedEntryCache::Open(std::wstring& error) {
+        try {
+            fs::create_directories(m_root / L"keys");
+            fs::create_directories(m_root / L"blobs");
+            fs::create_directories(m_root / L"tmp");
+            return true;
+        }
+        catch (const std::exception& e) {
+            error = L"Failed to initialize cache directory: " + Utf8ToWideSafe(e.what());
+            return false;
+        }
+    }
+
+    bool CompressedEntryCache::MakeKey(const PackageFile& file, int level, std::string& keyHex) {
+        std::error_code ec;
+        auto modified = fs::last_write_time(file.localPath, ec);
+        if (ec) return false;
+
+        std::string key = PathToUtf8(file.localPath);
+        key += '|';
+        key += std::to_string(file.size);
+        key += '|';
+        key += std::to_string(static_cast<long long>(modified.time_since_epoch().count()));
+        key += '|';
+        key += std::to_string(level);
+
+        keyHex = Sha256::ToHex(Sha256::Hash(key.data(), key.size()));
+        return true;
+    }
+
+    fs::path CompressedEntryCache::KeyPath(const std::string& keyHex) const {
+        return m_root / L"keys" / keyHex.substr(0, 2) / keyHex;
+    }
+
+    fs::path CompressedEntryCache::BlobPath(const std::string& contentHex, int level, const char* extension) const {
+        return m_root / L"blobs" / contentHex.substr(0, 2) /
+            (contentHex + "-" + std::to_string(level) + extension);
+    }
+
+    fs::path CompressedEntryCache::NewTempPath() {
+        return m_root / L"tmp" / (std::to_string(CurrentProcessId()) + "-" +
+            std::to_string(m_tempCounter.fetch_add(1)) + ".tmp");
+    }
+
+    bool CompressedEntryCache::ReadMetadata(const fs::path& metaPath, CompressedEntry& entry) const {
+        std::ifstream in(metaPath, std::ios::binary);
+        if (!in.is_open()) return false;
+
+        uint32_t magic = 0, version = 0, blockCount = 0;
+        if (!ReadValue(in, magic) || magic != METADATA_MAGIC) return false;
+        if (!ReadValue(in, version) || version != METADATA_VERSION) return false;
+        if (!ReadValue(in, entry.uncompressedSize) || !ReadValue(in, entry.compressedSize) ||
+            !ReadValue(in, entry.crc32) || !ReadValue(in, blockCount)) {
+            return false;
+        }
+
+        if (blockCount != (entry.uncompressedSize + BLOCK_MAP_BLOCK_SIZE - 1) / BLOCK_MAP_BLOCK_SIZE) {
+            return false;
+        }
+
+        entry.blocks.resize(blockCount);
+        for (auto& block : entry.blocks) {
+            in.read(reinterpret_cast<char*>(block.hash.data()), block.hash.size());
+            if (in.gcount() != static_cast<std::streamsize>(block.hash.size())) return false;
+            if (!ReadValue(in, block.compressedSize)) return false;
+        }
+
+        return true;
+    }
+
+    bool CompressedEntryCache::WriteMetadata(const fs::path& metaPath, const CompressedEntry& entry) {
+        fs::path tempPath = NewTempPath();
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return false;
+
+            WriteValue(out, METADATA_MAGIC);
+            WriteValue(out, METADATA_VERSION);
+            WriteValue(out, entry.uncompressedSize);
+            WriteValue(out, entry.compressedSize);
+            WriteValue(out, entry.crc32);
+            WriteValue(out, static_cast<uint32_t>(entry.blocks.size()));
+            for (const auto& block : entry.blocks) {
+                out.write(reinterpret_cast<const char*>(block.hash.data()), block.hash.size());
+                WriteValue(out, block.compressedSize);
+            }
+
+            if (!out.good()) return false;
+        }
+
+        std::error_code ec;
+        fs::rename(tempPath, metaPath, ec);
+        if (ec) {
+            fs::remove(tempPath, ec);
+            return false;
+        }
+        return true;
+    }
+
+    bool CompressedEntryCache::WriteKey(const fs::path& keyPath, const std::string& contentHex) {
+        std::error_code ec;
+        fs::create_directories(keyPath.parent_path(), ec);
+
+        fs::path tempPath = NewTempPath();
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return false;
+            out << contentHex;
+            if (!out.good()) return false;
+        }
+
+        fs::rename(tempPath, keyPath, ec);
+        if (ec) {
+            fs::remove(tempPath, ec);
+            return false;
+        }
+        return true;
+    }
+
+    bool CompressedEntryCache::Lookup(const PackageFile& file, int level, CompressedEntry& entry) {
+        std::string keyHex;
+        if (!MakeKey(file, level, keyHex)) return false;
+
+        std::string contentHex;
+        {
+            std::ifstream keyFile(KeyPath(keyHex), std::ios::binary);
+            if (!keyFile.is_open()) return false;
+            keyFile >> contentHex;
+        }
+
+        CompressedEntry cached;
+        if (!Sha256::FromHex(contentHex, cached.contentHash)) return false;
+
+        fs::path blobPath = BlobPath(contentHex, level, ".deflate");
+        if (!ReadMetadata(BlobPath(contentHex, level, ".meta"), cached)) return false;
+        if (cached.uncompressedSize != file.size) return false;
+
+        std::error_code ec;
+        if (fs::file_size(blobPath, ec) != cached.compressedSize || ec) return false;
+
+        cached.dataPath = blobPath;
+        cached.dataOffset = 0;
+        entry = std::move(cached);
+        ++m_hits;
+        return true;
+    }
+
+    bool CompressedEntryCache::Store(const PackageFile& file, int level, CompressedEntry& entry,
+        std::wstring& error) {
+
+        ++m_misses;
+
+        fs::path tempPath = NewTempPath();
+        if (!CompressFileEntry(file.localPath, tempPath, level, entry, error)) {
+            std::error_code ec;
+            fs::remove(tempPath, ec);
+            return false;
+        }
+
+        std::string contentHex = Sha256::ToHex(entry.contentHash);
+        fs::path blobPath = BlobPath(contentHex, level, ".deflate");
+        fs::path metaPath = BlobPath(contentHex, level, ".meta");
+
+        std::error_code ec;
+        fs::create_directories(blobPath.parent_path(), ec);
+
+        CompressedEntry existing;
+        if (ReadMetadata(metaPath, existing) && fs::file_size(blobPath, ec) == entry.compressedSize && !ec) {
+            fs::remove(tempPath, ec);
+        }
+        else {
+            fs::rename(tempPath, blobPath, ec);
+            if (ec) {
+                fs::remove(tempPath, ec);
+                error = L"Failed to store cache blob: " + FromPath(blobPath);
+                return false;
+            }
+            if (!WriteMetadata(metaPath, entry)) {
+                error = L"Failed to store cache metadata: " + FromPath(metaPath);
+                return false;
+            }
+        }
+
+        entry.dataPath = blobPath;
+        entry.dataOffset = 0;
+
+        std::string keyHex;
+        if (MakeKey(file, level, keyHex)) {
+            WriteKey(KeyPath(keyHex), contentHex);
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "AppxPackage.h"
+#include "BlockMap.h"
+#include <zip.h>
+#include <filesystem>
+#include <atomic>
+#include <functional>
+#include <istream>
+#include <ctime>
+
+namespace MakeAppxCore {
+
+    namespace fs = std::filesystem;
+
+    struct CompressedEntry {
+        Sha256::Digest contentHash = {};
+        uint64_t uncompressedSize = 0;
+        uint64_t compressedSize = 0;
+        uint32_t crc32 = 0;
+        std::vector<BlockMapBlock> blocks;
+        fs::path dataPath;
+        uint64_t dataOffset = 0;
+    };
+
+    // Deflate window and hash tables at the default memLevel, plus the 64 KB input and output buffers.
+    constexpr size_t DEFLATE_STATE_MEMORY = (1 << 17) + (1 << 17) + 8192;
+    constexpr size_t COMPRESS_WORKER_MEMORY = DEFLATE_STATE_MEMORY + 2 * BLOCK_MAP_BLOCK_SIZE + 4096;
+
+    int ZlibLevelFor(CompressionLevel compression);
+    time_t ToTimeT(fs::file_time_type fileTime);
+
+    using EntrySink = std::function<bool(const uint8_t* data, size_t size)>;
+
+    bool EncodeEntry(std::istream& input, int zlibLevel, bool store, const EntrySink& sink,
+        CompressedEntry& entry, std::wstring& error);
+    bool CompressFileEntry(const fs::path& sourcePath, const fs::path& outputPath, int zlibLevel,
+        CompressedEntry& entry, std::wstring& error);
+
+    bool HashFileBlocks(const fs::path& sourcePath, std::vector<BlockMapBlock>& blocks, std::wstring& error);
+    Sha256::Digest ContentHashFromBlocks(const std::vector<BlockMapBlock>& blocks, uint64_t size);
+    bool FindDuplicateFiles(const std::vector<PackageFile>& files, std::vector<size_t>& primaryOf,
+        std::wstring& error);
+
+    zip_source_t* CreateCompressedEntrySource(zip_t* zip, const CompressedEntry& entry, time_t modifiedTime);
+
+    class CompressedEntryCache {
+    private:
+        fs::path m_root;
+        std::atomic<uint64_t> m_hits{ 0 };
+        std::atomic<uint64_t> m_misses{ 0 };
+        std::atomic<uint64_t> m_tempCounter{ 0 };
+
+        fs::path KeyPath(const std::string& keyHex) const;
+        fs::path BlobPath(const std::string& contentHex, int level, const char* extension) const;
+        fs::path NewTempPath();
+        bool ReadMetadata(const fs::path& metaPath, CompressedEntry& entry) const;
+        bool WriteMetadata(const fs::path& metaPath, const CompressedEntry& entry);
+        bool WriteKey(const fs::path& keyPath, const std::string& contentHex);
+        static bool MakeKey(const PackageFile& file, int level, std::string& keyHex);
+
+    public:
+        explicit CompressedEntryCache(const fs::path& root);
+
+        bool Open(std::wstring& error);
+        bool Lookup(const PackageFile& file, int level, CompressedEntry& entry);
+        bool Store(const PackageFile& file, int level, CompressedEntry& entry, std::wstring& error);
+
+        uint64_t GetHits() const { return m_hits; }
+        uint64_t GetMisses() const { return m_misses; }
+    };
+}
@@ -0,0 +1,195 @@
+#include "ExtractionPlan.h"
+#include "AppxPackageImpl.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+#include <cwctype>
+
+namespace MakeAppxCore {
+
+    namespace {
+        // Names compare case-insensitively on Windows; only names outside ASCII need the round trip through UTF-16.
+        std::string PathKey(const std::string& name) {
+#ifdef _WIN32
+            bool ascii = std::all_of(name.begin(), name.end(), [](char c) { return (c & 0x80) == 0; });
+            if (!ascii) {
+                std::wstring key = Utf8ToWideSafe(name);
+                std::transform(key.begin(), key.end(), key.begin(), ::towlower);
+                return WideToUtf8Safe(key);
+            }
+            std::string key = name;
+            std::transform(key.begin(), key.end(), key.begin(), [](char c) {
+                return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            });
+            return key;
+#else
+            return name;
+#endif
+        }
+    }
+
+    OverwriteAnswer PromptOverwrite(const std::wstring& filePath) {
+        std::wcout << L"File exists: " << filePath << std::endl;
+        std::wcout << L"Overwrite? (y)es, (n)o, (a)ll, (s)kip all: ";
+
+        wchar_t response;
+        std::wcin >> response;
+        response = towlower(response);
+
+        switch (response) {
+        case L'y':
+            return OverwriteAnswer::Yes;
+        case L'n':
+            return OverwriteAnswer::No;
+        case L'a':
+            return OverwriteAnswer::All;
+        case L's':
+            return OverwriteAnswer::None;
+        default:
+            std::wcout << L"Invalid response. Skipping file." << std::endl;
+            return OverwriteAnswer::No;
+        }
+    }
+
+    size_t ExtractionPlan::AddDirectory(const std::string& relativePath, const std::string& name, size_t parent) {
+        auto inserted = m_directoryIndex.emplace(PathKey(relativePath), m_directories.size());
+        if (inserted.second) {
+            PlannedDirectory directory;
+            directory.path = (parent == ROOT ? m_root : m_directories[parent].path) / PathFromUtf8(name);
+            directory.parent = parent;
+            m_directories.push_back(std::move(directory));
+        }
+        return inserted.first->second;
+    }
+
+    bool SplitEntryPath(const std::string& entryName, std::vector<std::string>& segments, bool& isDirectory) {
+        segments.clear();
+        size_t start = 0;
+        while (start <= entryName.size()) {
+            size_t end = entryName.find_first_of("/\\", start);
+            if (end == std::string::npos) end = entryName.size();
+            if (end - start == 2 && entryName.compare(start, 2, "..") == 0) return false;
+            if (end > start && !(end - start == 1 && entryName[start] == '.')) {
+                segments.emplace_back(entryName, start, end - start);
+                // A drive letter such as "C:" would take the joined path off the output root on Windows.
+                if (PathFromUtf8(segments.back()).has_root_name()) return false;
+            }
+            start = end + 1;
+        }
+        if (segments.empty()) return false;
+
+        isDirectory = entryName.back() == '/' || entryName.back() == '\\';
+        return true;
+    }
+
+    bool ExtractionPlan::Add(size_t entry, const std::string& entryName, uint64_t size) {
+        std::vector<std::string> segments;
+        bool isDirectory = false;
+        if (!SplitEntryPath(entryName, segments, isDirectory)) {
+            m_lastError = L"Invalid entry path; it would be written outside the output directory";
+            return false;
+        }
+
+        size_t directoryCount = isDirectory ? segments.size() : segments.size() - 1;
+
+        std::string relative;
+        size_t parent = ROOT;
+        for (size_t i = 0; i < directoryCount; ++i) {
+            if (!relative.empty()) relative += '/';
+            relative += segments[i];
+            parent = AddDirectory(relative, segments[i], parent);
+        }
+        if (isDirectory) return true;
+
+        PlannedFile file;
+        file.entry = entry;
+        file.size = size;
+        file.name = entryName;
+        file.path = parent == ROOT ? m_root : m_directories[parent].path;
+        file.path /= PathFromUtf8(segments.back());
+        m_files.push_back(std::move(file));
+        m_directoryOf.push_back(parent);
+        return true;
+    }
+
+    bool ExtractionPlan::CreateDirectories() {
+        std::error_code ec;
+        for (auto& directory : m_directories) {
+            directory.created = fs::create_directory(directory.path, ec);
+            if (ec) {
+                m_lastError = L"Failed to create directory " + FromPath(directory.path) + L": " + Utf8ToWideSafe(ec.message());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // One listing per pre-existing directory replaces an exists() call per entry; fresh directories are empty.
+    void ExtractionPlan::FindExistingFiles() {
+        std::vector<std::vector<size_t>> filesIn(m_directories.size() + 1);
+        for (size_t i = 0; i < m_files.size(); ++i) {
+            filesIn[m_directoryOf[i] == ROOT ? m_directories.size() : m_directoryOf[i]].push_back(i);
+        }
+
+        std::unordered_set<std::string> present;
+        for (size_t d = 0; d < filesIn.size(); ++d) {
+            if (filesIn[d].empty()) continue;
+
+            bool isRoot = d == m_directories.size();
+            if (isRoot ? m_rootCreated : m_directories[d].created) continue;
+
+            present.clear();
+            std::error_code ec;
+            for (fs::directory_iterator it(isRoot ? m_root : m_directories[d].path, ec), end; !ec && it != end; it.increment(ec)) {
+                present.insert(PathKey(PathToUtf8(it->path().filename())));
+            }
+
+            for (size_t i : filesIn[d]) {
+                m_files[i].exists = present.count(PathKey(PathToUtf8(m_files[i].path.filename()))) != 0;
+            }
+        }
+    }
+
+    void ExtractionPlan::ResolveOverwrites(OverwriteMode overwrite, const OverwritePrompt& prompt) {
+        for (auto& file : m_files) {
+            if (!file.exists) continue;
+
+            if (overwrite == OverwriteMode::Ask) {
+                switch (prompt(Utf8ToWideSafe(file.name))) {
+                case OverwriteAnswer::Yes:
+                    break;
+                case OverwriteAnswer::No:
+                    file.write = false;
+                    break;
+                case OverwriteAnswer::All:
+                    overwrite = OverwriteMode::Yes;
+                    break;
+                case OverwriteAnswer::None:
+                    overwrite = OverwriteMode::No;
+                    file.write = false;
+                    break;
+                }
+            }
+            else {
+                file.write = overwrite == OverwriteMode::Yes;
+            }
+        }
+    }
+
+    bool ExtractionPlan::Prepare(OverwriteMode overwrite, const OverwritePrompt& prompt) {
+        std::error_code ec;
+        m_rootCreated = fs::create_directories(m_root, ec);
+        if (ec) {
+            m_lastError = L"Failed to create output directory: " + Utf8ToWideSafe(ec.message());
+            return false;
+        }
+
+        if (!CreateDirectories()) {
+            return false;
+        }
+
+        FindExistingFiles();
+        ResolveOverwrites(overwrite, prompt);
+        return true;
+    }
+}
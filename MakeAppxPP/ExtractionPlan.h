@@ -0,0 +1,70 @@
+#pragma once
+#include "AppxPackage.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <functional>
+
+namespace MakeAppxCore {
+
+    enum class OverwriteAnswer {
+        Yes,
+        No,
+        All,
+        None
+    };
+
+    using OverwritePrompt = std::function<OverwriteAnswer(const std::wstring&)>;
+
+    OverwriteAnswer PromptOverwrite(const std::wstring& filePath);
+
+    // Splits a UTF-8 entry name into path segments, dropping "." and empty segments; rejects names containing ".."
+    // or a root name such as a drive letter.
+    bool SplitEntryPath(const std::string& entryName, std::vector<std::string>& segments, bool& isDirectory);
+
+    struct PlannedFile {
+        size_t entry = 0;
+        std::string name;
+        std::filesystem::path path;
+        uint64_t size = 0;
+        bool exists = false;
+        bool write = true;
+    };
+
+    // Resolves every output path, directory and overwrite decision of an extraction before any data is written.
+    class ExtractionPlan {
+    private:
+        static constexpr size_t ROOT = SIZE_MAX;
+
+        // Directories are recorded parents-first, so index order is also creation order.
+        struct PlannedDirectory {
+            std::filesystem::path path;
+            size_t parent = ROOT;
+            bool created = false;
+        };
+
+        std::filesystem::path m_root;
+        bool m_rootCreated = false;
+        std::vector<PlannedFile> m_files;
+        std::vector<size_t> m_directoryOf;
+        std::vector<PlannedDirectory> m_directories;
+        std::unordered_map<std::string, size_t> m_directoryIndex;
+        std::wstring m_lastError;
+
+        size_t AddDirectory(const std::string& relativePath, const std::string& name, size_t parent);
+        bool CreateDirectories();
+        void FindExistingFiles();
+        void ResolveOverwrites(OverwriteMode overwrite, const OverwritePrompt& prompt);
+
+    public:
+        explicit ExtractionPlan(const std::filesystem::path& root) : m_root(root) {}
+
+        // Fails for names that would resolve outside the root; the caller reports those as entry errors.
+        bool Add(size_t entry, const std::string& entryName, uint64_t size = 0);
+        bool Prepare(OverwriteMode overwrite, const OverwritePrompt& prompt = PromptOverwrite);
+
+        const std::vector<PlannedFile>& Files() const { return m_files; }
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+}
@@ -0,0 +1,191 @@
+#include "FileWriter.h"
+#include "Platform.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MakeAppxCore {
+
+    FileWriter::~FileWriter() {
+        CloseFile();
+    }
+
+    bool FileWriter::SetError(const std::wstring& error) {
+        m_lastError = error + L": " + m_path;
+        return false;
+    }
+
+#ifdef _WIN32
+    bool FileWriter::OpenFile(const std::filesystem::path& path, bool direct) {
+        DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN | (direct ? FILE_FLAG_NO_BUFFERING : 0);
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, flags, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        m_file = file;
+        return true;
+    }
+
+    void FileWriter::Preallocate(uint64_t size) {
+        FILE_ALLOCATION_INFO info = {};
+        info.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+        if (SetFileInformationByHandle(m_file, FileAllocationInfo, &info, sizeof(info))) {
+            m_reserved = size;
+        }
+    }
+
+    bool FileWriter::WriteRaw(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 0x40000000));
+            DWORD written = 0;
+            if (!::WriteFile(m_file, data, chunk, &written, nullptr) || written == 0) return false;
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    bool FileWriter::SetFileSize(uint64_t size) {
+        FILE_END_OF_FILE_INFO info = {};
+        info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        return SetFileInformationByHandle(m_file, FileEndOfFileInfo, &info, sizeof(info)) != 0;
+    }
+
+    void FileWriter::CloseFile() {
+        if (m_file) CloseHandle(m_file);
+        m_file = nullptr;
+    }
+#else
+    bool FileWriter::OpenFile(const std::filesystem::path& path, bool direct) {
+        int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+        if (direct) flags |= O_DIRECT;
+#else
+        if (direct) return false;
+#endif
+        m_file = open(path.c_str(), flags, 0644);
+        return m_file >= 0;
+    }
+
+    void FileWriter::Preallocate(uint64_t size) {
+#ifdef __linux__
+        if (fallocate(m_file, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size)) == 0) {
+            m_reserved = size;
+        }
+#else
+        (void)size;
+#endif
+    }
+
+    bool FileWriter::WriteRaw(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = write(m_file, data, size);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool FileWriter::SetFileSize(uint64_t size) {
+        return ftruncate(m_file, static_cast<off_t>(size)) == 0;
+    }
+
+    void FileWriter::CloseFile() {
+        if (m_file >= 0) close(m_file);
+        m_file = -1;
+    }
+#endif
+
+    bool FileWriter::Open(const std::filesystem::path& path, uint64_t expectedSize, bool directIo) {
+        CloseFile();
+        m_path = FromPath(path);
+        m_used = 0;
+        m_flushed = 0;
+        m_reserved = 0;
+
+        // Direct I/O needs sector-aligned buffers and lengths; fall back to buffered I/O where it is refused.
+        m_direct = directIo && OpenFile(path, true);
+        if (!m_direct && !OpenFile(path, false)) {
+            return SetError(L"Cannot create file");
+        }
+
+        if (!m_buffer.Data()) {
+            BufferPool& pool = BufferPool::Shared();
+            m_buffer = pool.Acquire(pool.BufferSize(BUFFER_SIZE, MIN_BUFFER_SIZE, 4));
+        }
+
+        if (expectedSize > 0) {
+            Preallocate(expectedSize);
+        }
+        return true;
+    }
+
+    bool FileWriter::Flush() {
+        if (m_used == 0) return true;
+        if (!WriteRaw(m_buffer.Data(), m_used)) {
+            return SetError(L"Failed to write file");
+        }
+        m_flushed += m_used;
+        m_used = 0;
+        return true;
+    }
+
+    uint8_t* FileWriter::Buffer(size_t& available) {
+        if (m_used == m_buffer.Size() && !Flush()) {
+            available = 0;
+            return nullptr;
+        }
+        available = m_buffer.Size() - m_used;
+        return m_buffer.Data() + m_used;
+    }
+
+    bool FileWriter::Commit(size_t size) {
+        m_used += size;
+        return m_used < m_buffer.Size() || Flush();
+    }
+
+    bool FileWriter::Write(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            size_t available = 0;
+            uint8_t* buffer = Buffer(available);
+            if (!buffer) return false;
+
+            size_t chunk = std::min(size, available);
+            memcpy(buffer, bytes, chunk);
+            if (!Commit(chunk)) return false;
+            bytes += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+
+    bool FileWriter::Close() {
+        uint64_t size = Size();
+        bool ok = true;
+
+        if (m_direct && m_used % ALIGNMENT != 0) {
+            size_t padded = (m_used + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+            memset(m_buffer.Data() + m_used, 0, padded - m_used);
+            m_used = padded;
+        }
+        ok = Flush();
+
+        // Trim the zero padding of the last direct write and any reservation beyond the final size.
+        if (ok && (m_flushed != size || m_reserved > size) && !SetFileSize(size)) {
+            ok = SetError(L"Failed to set file size");
+        }
+
+        CloseFile();
+        m_used = 0;
+        return ok;
+    }
+}
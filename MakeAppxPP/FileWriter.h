@@ -0,0 +1,55 @@
+#pragma once
+#include "BufferPool.h"
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+
+namespace MakeAppxCore {
+
+    // Buffered output file that reserves its expected size up front and writes in large aligned pieces.
+    class FileWriter {
+    private:
+#ifdef _WIN32
+        void* m_file = nullptr;
+#else
+        int m_file = -1;
+#endif
+        BufferPool::Lease m_buffer;
+        size_t m_used = 0;
+        uint64_t m_flushed = 0;
+        uint64_t m_reserved = 0;
+        bool m_direct = false;
+        std::wstring m_path;
+        std::wstring m_lastError;
+
+        bool SetError(const std::wstring& error);
+        bool OpenFile(const std::filesystem::path& path, bool direct);
+        void Preallocate(uint64_t size);
+        bool WriteRaw(const uint8_t* data, size_t size);
+        bool SetFileSize(uint64_t size);
+        bool Flush();
+        void CloseFile();
+
+    public:
+        static constexpr size_t BUFFER_SIZE = 1 << 20;
+        static constexpr size_t MIN_BUFFER_SIZE = 64 * 1024;
+        static constexpr size_t ALIGNMENT = 4096;
+        static constexpr uint64_t DIRECT_IO_THRESHOLD = 64ull << 20;
+
+        FileWriter() = default;
+        ~FileWriter();
+
+        FileWriter(const FileWriter&) = delete;
+        FileWriter& operator=(const FileWriter&) = delete;
+
+        bool Open(const std::filesystem::path& path, uint64_t expectedSize = 0, bool directIo = false);
+        bool Write(const void* data, size_t size);
+        uint8_t* Buffer(size_t& available);
+        bool Commit(size_t size);
+        bool Close();
+
+        uint64_t Size() const { return m_flushed + m_used; }
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+}
@@ -0,0 +1,294 @@
+#include "JsonUtil.h"
+#include <cstdio>
+#include <cctype>
+
+namespace MakeAppxCore {
+
+    std::string JsonEscape(const std::string& value) {
+        std::string result;
+        result.reserve(value.size() + 2);
+
+        for (unsigned char c : value) {
+            switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\b': result += "\\b"; break;
+            case '\f': result += "\\f"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    result += buffer;
+                }
+                else {
+                    result += static_cast<char>(c);
+                }
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    namespace {
+
+        void AppendUtf8(std::string& out, uint32_t codePoint) {
+            if (codePoint < 0x80) {
+                out += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800) {
+                out += static_cast<char>(0xC0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000) {
+                out += static_cast<char>(0xE0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else {
+                out += static_cast<char>(0xF0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        class JsonParser {
+        private:
+            const std::string& m_text;
+            size_t m_pos = 0;
+
+        public:
+            explicit JsonParser(const std::string& text) : m_text(text) {}
+
+            void SkipWhitespace() {
+                while (m_pos < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+                    ++m_pos;
+                }
+            }
+
+            bool Consume(char c) {
+                SkipWhitespace();
+                if (m_pos < m_text.size() && m_text[m_pos] == c) {
+                    ++m_pos;
+                    return true;
+                }
+                return false;
+            }
+
+            bool Peek(char c) {
+                SkipWhitespace();
+                return m_pos < m_text.size() && m_text[m_pos] == c;
+            }
+
+            bool AtEnd() {
+                SkipWhitespace();
+                return m_pos >= m_text.size();
+            }
+
+            bool ParseHex4(uint32_t& value) {
+                if (m_pos + 4 > m_text.size()) return false;
+                value = 0;
+                for (int i = 0; i < 4; ++i) {
+                    char c = m_text[m_pos++];
+                    value <<= 4;
+                    if (c >= '0' && c <= '9') value |= c - '0';
+                    else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+                    else return false;
+                }
+                return true;
+            }
+
+            bool ParseString(std::string& out) {
+                if (!Consume('"')) return false;
+
+                while (m_pos < m_text.size()) {
+                    char c = m_text[m_pos++];
+                    if (c == '"') return true;
+                    if (c != '\\') {
+                        out += c;
+                        continue;
+                    }
+
+                    if (m_pos >= m_text.size()) return false;
+                    char escaped = m_text[m_pos++];
+                    switch (escaped) {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        uint32_t codePoint = 0;
+                        if (!ParseHex4(codePoint)) return false;
+                        // Surrogates only come as a high and low pair; anything else would put invalid
+                        // UTF-8 into a path.
+                        if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) return false;
+                        if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                            if (m_pos + 1 >= m_text.size() || m_text[m_pos] != '\\' || m_text[m_pos + 1] != 'u') {
+                                return false;
+                            }
+                            m_pos += 2;
+                            uint32_t low = 0;
+                            if (!ParseHex4(low) || low < 0xDC00 || low > 0xDFFF) return false;
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        AppendUtf8(out, codePoint);
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+                }
+
+                return false;
+            }
+
+            bool ParseScalar(std::string& out) {
+                SkipWhitespace();
+                size_t start = m_pos;
+                while (m_pos < m_text.size()) {
+                    char c = m_text[m_pos];
+                    if (c == ',' || c == '}' || isspace(static_cast<unsigned char>(c))) break;
+                    ++m_pos;
+                }
+                out = m_text.substr(start, m_pos - start);
+                if (out == "null") out.clear();
+                return m_pos > start;
+            }
+        };
+    }
+
+    bool ParseJsonObject(const std::string& text, JsonObject& object, std::string& error) {
+        JsonParser parser(text);
+
+        if (!parser.Consume('{')) {
+            error = "expected '{'";
+            return false;
+        }
+
+        if (!parser.Consume('}')) {
+            do {
+                std::string key;
+                if (!parser.ParseString(key)) {
+                    error = "expected string key";
+                    return false;
+                }
+                if (!parser.Consume(':')) {
+                    error = "expected ':' after key " + key;
+                    return false;
+                }
+
+                std::string value;
+                bool parsed = parser.Peek('"') ? parser.ParseString(value) : parser.ParseScalar(value);
+                if (!parsed) {
+                    error = "invalid value for key " + key;
+                    return false;
+                }
+
+                object[key] = value;
+            } while (parser.Consume(','));
+
+            if (!parser.Consume('}')) {
+                error = "expected '}'";
+                return false;
+            }
+        }
+
+        if (!parser.AtEnd()) {
+            error = "trailing characters after object";
+            return false;
+        }
+
+        return true;
+    }
+
+    void JsonWriter::BeforeValue() {
+        if (m_afterKey) {
+            m_afterKey = false;
+            return;
+        }
+        if (!m_first.empty()) {
+            if (!m_first.back()) {
+                m_out += ',';
+            }
+            m_first.back() = false;
+        }
+    }
+
+    JsonWriter& JsonWriter::BeginObject() {
+        BeforeValue();
+        m_out += '{';
+        m_first.push_back(true);
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::EndObject() {
+        m_out += '}';
+        m_first.pop_back();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::BeginArray() {
+        BeforeValue();
+        m_out += '[';
+        m_first.push_back(true);
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::EndArray() {
+        m_out += ']';
+        m_first.pop_back();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::Key(const std::string& key) {
+        BeforeValue();
+        m_out += '"';
+        m_out += JsonEscape(key);
+        m_out += "\":";
+        m_afterKey = true;
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::String(const std::string& value) {
+        BeforeValue();
+        m_out += '"';
+        m_out += JsonEscape(value);
+        m_out += '"';
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::Number(uint64_t value) {
+        BeforeValue();
+        m_out += std::to_string(value);
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::Number(double value) {
+        BeforeValue();
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.4f", value);
+        m_out += buffer;
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::Bool(bool value) {
+        BeforeValue();
+        m_out += value ? "true" : "false";
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::Null() {
+        BeforeValue();
+        m_out += "null";
+        return *this;
+    }
+}
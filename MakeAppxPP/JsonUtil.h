@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace MakeAppxCore {
+
+    using JsonObject = std::map<std::string, std::string>;
+
+    std::string JsonEscape(const std::string& value);
+    bool ParseJsonObject(const std::string& text, JsonObject& object, std::string& error);
+
+    class JsonWriter {
+    private:
+        std::string m_out;
+        std::vector<bool> m_first;
+        bool m_afterKey = false;
+
+        void BeforeValue();
+
+    public:
+        JsonWriter& BeginObject();
+        JsonWriter& EndObject();
+        JsonWriter& BeginArray();
+        JsonWriter& EndArray();
+        JsonWriter& Key(const std::string& key);
+        JsonWriter& String(const std::string& value);
+        JsonWriter& Number(uint64_t value);
+        JsonWriter& Number(double value);
+        JsonWriter& Bool(bool value);
+        JsonWriter& Null();
+
+        const std::string& Str() const { return m_out; }
+    };
+}
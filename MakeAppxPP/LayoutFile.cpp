@@ -0,0 +1,136 @@
+#include "LayoutFile.h"
+#include "AppxPackageImpl.h"
+#include "MappedFile.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr size_t STAT_BATCH = 64;
+
+        struct LayoutEntry {
+            std::string localPath;
+            std::string packagePath;
+            size_t line = 0;
+        };
+
+        enum class SourceStatus : uint8_t {
+            Ok,
+            Missing,
+            NotAFile,
+            Unreadable
+        };
+
+        const char* FindQuote(const char* begin, const char* end) {
+            return static_cast<const char*>(memchr(begin, '"', static_cast<size_t>(end - begin)));
+        }
+
+        SourceStatus StatSource(PackageFile& file) {
+            std::error_code ec;
+            fs::file_status status = fs::status(file.localPath, ec);
+            if (ec || !fs::exists(status)) return SourceStatus::Missing;
+            if (!fs::is_regular_file(status)) return SourceStatus::NotAFile;
+
+            file.size = fs::file_size(file.localPath, ec);
+            return ec ? SourceStatus::Unreadable : SourceStatus::Ok;
+        }
+
+        // Stat calls are latency bound on network shares, so they run as I/O tasks, a batch of files each.
+        void StatSources(std::vector<PackageFile>& files, std::vector<SourceStatus>& statuses) {
+            statuses.assign(files.size(), SourceStatus::Ok);
+
+            TaskGroup group(TaskClass::Io);
+            for (size_t first = 0; first < files.size(); first += STAT_BATCH) {
+                group.Run([&files, &statuses, first]() {
+                    size_t last = std::min(first + STAT_BATCH, files.size());
+                    for (size_t index = first; index < last; ++index) {
+                        statuses[index] = StatSource(files[index]);
+                    }
+                });
+            }
+            group.Wait();
+        }
+
+        bool ParseLayout(const char* data, size_t size, std::vector<LayoutEntry>& entries) {
+            const char* pos = data;
+            const char* end = data + size;
+            if (size >= 3 && memcmp(pos, "\xEF\xBB\xBF", 3) == 0) pos += 3;
+
+            size_t lineNumber = 0;
+            while (pos < end) {
+                const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(end - pos)));
+                if (!lineEnd) lineEnd = end;
+                const char* line = pos;
+                pos = lineEnd < end ? lineEnd + 1 : end;
+                ++lineNumber;
+
+                while (line < lineEnd && (*line == ' ' || *line == '\t')) ++line;
+                if (line == lineEnd || *line == '#') continue;
+
+                const char* q1 = FindQuote(line, lineEnd);
+                const char* q2 = q1 ? FindQuote(q1 + 1, lineEnd) : nullptr;
+                const char* q3 = q2 ? FindQuote(q2 + 1, lineEnd) : nullptr;
+                const char* q4 = q3 ? FindQuote(q3 + 1, lineEnd) : nullptr;
+                if (!q4) continue;
+
+                LayoutEntry entry;
+                entry.localPath.assign(q1 + 1, q2);
+                entry.packagePath.assign(q3 + 1, q4);
+                entry.line = lineNumber;
+                entries.push_back(std::move(entry));
+            }
+
+            return !entries.empty();
+        }
+    }
+
+    bool ReadLayoutFile(const std::wstring& path, std::vector<PackageFile>& files, std::wstring& error) {
+        files.clear();
+
+        std::vector<LayoutEntry> entries;
+        {
+            MappedFile layout;
+            if (!layout.Open(ToPath(path))) {
+                error = L"Cannot open layout file - " + layout.GetLastError();
+                return false;
+            }
+            if (!ParseLayout(reinterpret_cast<const char*>(layout.Data()), layout.Size(), entries)) {
+                error = L"Layout file contains no file mappings: " + path;
+                return false;
+            }
+        }
+
+        files.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            files[i].localPath = PathFromUtf8(entries[i].localPath);
+            files[i].packagePath = std::move(entries[i].packagePath);
+            files[i].size = 0;
+            files[i].attributes = 0;
+        }
+
+        std::vector<SourceStatus> statuses;
+        StatSources(files, statuses);
+
+        size_t failures = 0;
+        std::wstring details;
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (statuses[i] == SourceStatus::Ok) continue;
+            ++failures;
+
+            const wchar_t* reason = statuses[i] == SourceStatus::Missing ? L"not found" :
+                statuses[i] == SourceStatus::NotAFile ? L"not a regular file" : L"cannot be read";
+            details += L"\n  line " + std::to_wstring(entries[i].line) + L": " + FromPath(files[i].localPath) + L" (" + reason + L")";
+        }
+
+        if (failures > 0) {
+            error = std::to_wstring(failures) + L" of " + std::to_wstring(files.size()) +
+                L" layout sources are not usable:" + details;
+            files.clear();
+            return false;
+        }
+
+        return true;
+    }
+}
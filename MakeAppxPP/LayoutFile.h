@@ -0,0 +1,9 @@
+#pragma once
+#include "AppxPackage.h"
+#include <string>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    bool ReadLayoutFile(const std::wstring& path, std::vector<PackageFile>& files, std::wstring& error);
+}
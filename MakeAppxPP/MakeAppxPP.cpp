@@ -1,7 +1,8 @@
 #include "CommandLineParser.h"
+#include "Platform.h"
 #include <iostream>
 #include <locale>
-#include <cstring>
+#include <vector>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -92,9 +93,10 @@ int main(int argc, char* argv[]) {
     std::vector<wchar_t*> wideArgPtrs;
 
     for (int i = 0; i < argc; ++i) {
-        std::wstring wideArg(argv[i], argv[i] + strlen(argv[i]));
-        wideArgs.push_back(wideArg);
-        wideArgPtrs.push_back(&wideArgs.back()[0]);
+        wideArgs.push_back(MakeAppxCore::Utf8ToWideSafe(argv[i]));
+    }
+    for (auto& wideArg : wideArgs) {
+        wideArgPtrs.push_back(&wideArg[0]);
     }
 
     return wmain(argc, wideArgPtrs.data());
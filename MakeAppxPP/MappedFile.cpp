@@ -0,0 +1,109 @@
+#include "MappedFile.h"
+#include "Platform.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MakeAppxCore {
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::filesystem::path& path) {
+        Close();
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            m_lastError = L"Cannot open file: " + path.wstring();
+            return false;
+        }
+        m_file = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            m_lastError = L"Cannot determine size of file: " + path.wstring();
+            Close();
+            return false;
+        }
+        if (size.QuadPart == 0) {
+            return true;
+        }
+
+        m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) {
+            m_lastError = L"Cannot map file: " + path.wstring();
+            Close();
+            return false;
+        }
+
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data) {
+            m_lastError = L"Cannot map view of file: " + path.wstring();
+            Close();
+            return false;
+        }
+
+        m_size = static_cast<size_t>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file) CloseHandle(m_file);
+        m_data = nullptr;
+        m_mapping = nullptr;
+        m_file = nullptr;
+        m_size = 0;
+    }
+#else
+    bool MappedFile::Open(const std::filesystem::path& path) {
+        Close();
+
+        m_file = open(path.c_str(), O_RDONLY);
+        if (m_file < 0) {
+            m_lastError = L"Cannot open file: " + FromPath(path);
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(m_file, &info) != 0) {
+            m_lastError = L"Cannot determine size of file: " + FromPath(path);
+            Close();
+            return false;
+        }
+        if (info.st_size == 0) {
+            return true;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+        if (data == MAP_FAILED) {
+            m_lastError = L"Cannot map file: " + FromPath(path);
+            Close();
+            return false;
+        }
+        madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+        m_data = static_cast<const uint8_t*>(data);
+        m_size = static_cast<size_t>(info.st_size);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+        if (m_file >= 0) close(m_file);
+        m_data = nullptr;
+        m_file = -1;
+        m_size = 0;
+    }
+#endif
+}
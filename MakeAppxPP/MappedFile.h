@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <filesystem>
+#include <cstdint>
+
+namespace MakeAppxCore {
+
+    class MappedFile {
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+#ifdef _WIN32
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+        std::wstring m_lastError;
+
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::filesystem::path& path);
+        void Close();
+
+        const uint8_t* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+}
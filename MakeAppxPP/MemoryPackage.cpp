@@ -0,0 +1,370 @@
+#include "MemoryPackage.h"
+#include "AppxPackageImpl.h"
+#include "ZipStream.h"
+#include "Crc32.h"
+#include <zlib.h>
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <ios>
+#include <sstream>
+
+namespace MakeAppxCore {
+
+    std::unique_ptr<IPackageBuilder> CreatePackageBuilder(CompressionLevel compression) {
+        return std::make_unique<PackageBuilderImpl>(compression);
+    }
+
+    std::unique_ptr<IPackageReader> CreatePackageReader() {
+        return std::make_unique<PackageReaderImpl>();
+    }
+
+    namespace {
+        // Presents a borrowed buffer as a read-only stream without copying it.
+        class MemoryStreamBuf : public std::streambuf {
+        public:
+            MemoryStreamBuf(const uint8_t* data, size_t size) {
+                char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+                setg(begin, begin, begin + size);
+            }
+        };
+
+        // Pulls entry content from an EntryReader one block at a time.
+        class ReaderStreamBuf : public std::streambuf {
+        private:
+            const EntryReader& m_reader;
+            std::vector<char> m_buffer;
+            bool m_failed = false;
+
+        protected:
+            int_type underflow() override {
+                size_t produced = 0;
+                if (m_failed || !m_reader(reinterpret_cast<uint8_t*>(m_buffer.data()), m_buffer.size(), produced) ||
+                    produced > m_buffer.size()) {
+                    m_failed = true;
+                    return traits_type::eof();
+                }
+                if (produced == 0) return traits_type::eof();
+                setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + produced);
+                return traits_type::to_int_type(*gptr());
+            }
+
+        public:
+            explicit ReaderStreamBuf(const EntryReader& reader) : m_reader(reader), m_buffer(BLOCK_MAP_BLOCK_SIZE) {}
+
+            bool Failed() const { return m_failed; }
+        };
+
+        // Serves one entry of an in-memory package. Stored data is handed out in place and deflated data
+        // is inflated a window at a time. The CRC is checked at the end; a mismatch throws, which the
+        // owning istream turns into badbit.
+        class EntryStreamBuf : public std::streambuf {
+        private:
+            static constexpr size_t WINDOW_SIZE = 64 * 1024;
+
+            const uint8_t* m_next;
+            uint64_t m_remaining;
+            ZipDirectoryEntry m_entry;
+            z_stream m_inflate = {};
+            bool m_inflateReady = false;
+            bool m_streamEnded = false;
+            bool m_finished = false;
+            std::vector<char> m_buffer;
+            uint32_t m_crc = 0;
+            uint64_t m_produced = 0;
+
+            [[noreturn]] void Fail(const char* reason) {
+                throw std::ios_base::failure(std::string(reason) + ": " + m_entry.name);
+            }
+
+            int_type Finish() {
+                m_finished = true;
+                if (m_produced != m_entry.uncompressedSize || m_crc != m_entry.crc32) {
+                    Fail("CRC mismatch");
+                }
+                return traits_type::eof();
+            }
+
+        protected:
+            int_type underflow() override {
+                if (m_finished) return traits_type::eof();
+
+                size_t produced = 0;
+                if (m_entry.method == ZIP_METHOD_STORE) {
+                    produced = static_cast<size_t>(std::min<uint64_t>(m_remaining, WINDOW_SIZE));
+                    if (produced == 0) return Finish();
+                    char* begin = const_cast<char*>(reinterpret_cast<const char*>(m_next));
+                    setg(begin, begin, begin + produced);
+                    m_next += produced;
+                    m_remaining -= produced;
+                }
+                else {
+                    if (m_streamEnded) return Finish();
+                    if (m_inflate.avail_in == 0 && m_remaining > 0) {
+                        uInt chunk = static_cast<uInt>(std::min<uint64_t>(m_remaining, UINT_MAX));
+                        m_inflate.next_in = const_cast<Bytef*>(m_next);
+                        m_inflate.avail_in = chunk;
+                        m_next += chunk;
+                        m_remaining -= chunk;
+                    }
+                    m_inflate.next_out = reinterpret_cast<Bytef*>(m_buffer.data());
+                    m_inflate.avail_out = static_cast<uInt>(m_buffer.size());
+                    int result = inflate(&m_inflate, Z_NO_FLUSH);
+                    produced = m_buffer.size() - m_inflate.avail_out;
+                    if (result == Z_STREAM_END) {
+                        m_streamEnded = true;
+                        if (produced == 0) return Finish();
+                    }
+                    else if (result != Z_OK || produced == 0) {
+                        Fail("Corrupt compressed data");
+                    }
+                    setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + produced);
+                }
+
+                m_crc = Crc32(m_crc, gptr(), produced);
+                m_produced += produced;
+                return traits_type::to_int_type(*gptr());
+            }
+
+        public:
+            EntryStreamBuf(const uint8_t* data, const ZipDirectoryEntry& entry)
+                : m_next(data), m_remaining(entry.compressedSize), m_entry(entry) {
+                if (entry.method == ZIP_METHOD_DEFLATE) {
+                    m_buffer.resize(WINDOW_SIZE);
+                    m_inflateReady = inflateInit2(&m_inflate, -MAX_WBITS) == Z_OK;
+                }
+            }
+
+            ~EntryStreamBuf() override {
+                if (m_inflateReady) inflateEnd(&m_inflate);
+            }
+
+            bool IsReady() const { return m_entry.method == ZIP_METHOD_STORE || m_inflateReady; }
+        };
+
+        class EntryStream : public std::istream {
+        private:
+            EntryStreamBuf m_buffer;
+
+        public:
+            EntryStream(const uint8_t* data, const ZipDirectoryEntry& entry) : std::istream(nullptr), m_buffer(data, entry) {
+                rdbuf(&m_buffer);
+            }
+
+            bool IsReady() const { return m_buffer.IsReady(); }
+        };
+
+        std::string EntryNameFromWide(const std::wstring& name) {
+            std::string utf8 = WideToUtf8Safe(name);
+            std::replace(utf8.begin(), utf8.end(), '\\', '/');
+            return utf8;
+        }
+    }
+
+    bool PackageBuilderImpl::SetError(const std::wstring& error) {
+        m_lastError = error;
+        return false;
+    }
+
+    bool PackageBuilderImpl::AddEntry(const std::wstring& name, Entry&& entry) {
+        entry.name = EntryNameFromWide(name);
+        std::vector<std::string> segments;
+        bool isDirectory = false;
+        if (!SplitEntryPath(entry.name, segments, isDirectory) || isDirectory) {
+            return SetError(L"Invalid entry name: " + name);
+        }
+        entry.name = segments[0];
+        for (size_t i = 1; i < segments.size(); ++i) {
+            entry.name += '/';
+            entry.name += segments[i];
+        }
+
+        std::string normalized = NormalizeEntryName(entry.name);
+        if (normalized == NormalizeEntryName(BLOCK_MAP_ENTRY_NAME)) {
+            return SetError(L"AppxBlockMap.xml is generated and cannot be added");
+        }
+        if (!m_names.insert(normalized).second) {
+            return SetError(L"Duplicate entry: " + name);
+        }
+
+        m_entries.push_back(std::move(entry));
+        return true;
+    }
+
+    bool PackageBuilderImpl::AddEntry(const std::wstring& name, const void* data, size_t size) {
+        Entry entry;
+        entry.data = static_cast<const uint8_t*>(data);
+        entry.size = size;
+        return AddEntry(name, std::move(entry));
+    }
+
+    bool PackageBuilderImpl::AddEntry(const std::wstring& name, std::vector<uint8_t> data) {
+        Entry entry;
+        entry.owned = std::move(data);
+        entry.data = entry.owned.data();
+        entry.size = entry.owned.size();
+        return AddEntry(name, std::move(entry));
+    }
+
+    bool PackageBuilderImpl::AddEntry(const std::wstring& name, uint64_t size, EntryReader reader) {
+        if (!reader) {
+            return SetError(L"No reader given for entry: " + name);
+        }
+        Entry entry;
+        entry.size = size;
+        entry.reader = std::move(reader);
+        return AddEntry(name, std::move(entry));
+    }
+
+    bool PackageBuilderImpl::Write(std::vector<uint8_t>& output) {
+        output.clear();
+        return Write([&output](const uint8_t* data, size_t size) {
+            output.insert(output.end(), data, data + size);
+            return true;
+        });
+    }
+
+    bool PackageBuilderImpl::Write(const PackageSink& sink) {
+        if (m_names.count("appxmanifest.xml") == 0) {
+            return SetError(L"AppxManifest.xml not found");
+        }
+
+        bool store = m_compression == CompressionLevel::None;
+        int compressionLevel = ZlibLevelFor(m_compression);
+        uint16_t method = store ? ZIP_METHOD_STORE : ZIP_METHOD_DEFLATE;
+        time_t modifiedTime = time(nullptr);
+
+        ZipStreamWriter writer(sink);
+        auto entrySink = [&writer](const uint8_t* data, size_t size) {
+            return writer.Write(data, size);
+        };
+
+        std::vector<BlockMapEntry> blockMapEntries;
+        blockMapEntries.reserve(m_entries.size());
+
+        for (const auto& entry : m_entries) {
+            std::wstring name = Utf8ToWideSafe(entry.name);
+            if (!writer.BeginEntry(entry.name, method, modifiedTime, entry.size)) {
+                return SetError(writer.GetLastError());
+            }
+
+            CompressedEntry encoded;
+            std::wstring encodeError;
+            bool encodedAll;
+            if (entry.reader) {
+                ReaderStreamBuf buffer(entry.reader);
+                std::istream input(&buffer);
+                encodedAll = EncodeEntry(input, compressionLevel, store, entrySink, encoded, encodeError);
+                if (encodedAll && buffer.Failed()) {
+                    encodeError = L"Failed to read entry data";
+                    encodedAll = false;
+                }
+            }
+            else {
+                MemoryStreamBuf buffer(entry.data, static_cast<size_t>(entry.size));
+                std::istream input(&buffer);
+                encodedAll = EncodeEntry(input, compressionLevel, store, entrySink, encoded, encodeError);
+            }
+
+            if (!encodedAll) {
+                return SetError(!writer.GetLastError().empty() ? writer.GetLastError() : encodeError + L": " + name);
+            }
+            if (encoded.uncompressedSize != entry.size) {
+                return SetError(L"Entry produced " + std::to_wstring(encoded.uncompressedSize) +
+                    L" bytes instead of " + std::to_wstring(entry.size) + L": " + name);
+            }
+            if (!writer.EndEntry(encoded.crc32, encoded.uncompressedSize)) {
+                return SetError(writer.GetLastError());
+            }
+            if (IsFootprintFile(NormalizeEntryName(entry.name))) continue;
+
+            BlockMapEntry blockMapEntry;
+            blockMapEntry.name = entry.name;
+            blockMapEntry.size = encoded.uncompressedSize;
+            blockMapEntry.lfhSize = ZipStreamWriter::LocalHeaderSize(entry.name, entry.size);
+            blockMapEntry.blocks = std::move(encoded.blocks);
+            blockMapEntries.push_back(std::move(blockMapEntry));
+        }
+
+        std::istringstream blockMap(GenerateBlockMapXml(blockMapEntries));
+        uint64_t blockMapSize = blockMap.str().size();
+        CompressedEntry blockMapEntry;
+        std::wstring blockMapError;
+        if (!writer.BeginEntry(BLOCK_MAP_ENTRY_NAME, method, modifiedTime, blockMapSize) ||
+            !EncodeEntry(blockMap, compressionLevel, store, entrySink, blockMapEntry, blockMapError) ||
+            !writer.EndEntry(blockMapEntry.crc32, blockMapEntry.uncompressedSize) ||
+            !writer.Finish()) {
+            return SetError(!writer.GetLastError().empty() ? writer.GetLastError() : L"Failed to add AppxBlockMap.xml");
+        }
+
+        return true;
+    }
+
+    bool PackageReaderImpl::SetError(const std::wstring& error) {
+        m_lastError = error;
+        return false;
+    }
+
+    bool PackageReaderImpl::Open(const void* data, size_t size) {
+        m_source = std::make_unique<MemorySource>(static_cast<const uint8_t*>(data), size);
+        m_directory = ZipDirectory();
+        m_info = PackageInfo();
+
+        if (!m_directory.Read(*m_source)) {
+            m_source.reset();
+            return SetError(L"Failed to read package directory: " + m_directory.GetLastError());
+        }
+
+        DescribePackage(m_directory, size, m_info);
+        return true;
+    }
+
+    const ZipDirectoryEntry* PackageReaderImpl::FindEntry(const std::wstring& name) {
+        if (!m_source) {
+            SetError(L"No package is open");
+            return nullptr;
+        }
+        const ZipDirectoryEntry* entry = m_directory.Find(EntryNameFromWide(name));
+        if (!entry) {
+            SetError(L"Entry not found: " + name);
+        }
+        return entry;
+    }
+
+    std::unique_ptr<std::istream> PackageReaderImpl::OpenEntry(const std::wstring& name) {
+        const ZipDirectoryEntry* entry = FindEntry(name);
+        if (!entry) return nullptr;
+
+        if (entry->method != ZIP_METHOD_STORE && entry->method != ZIP_METHOD_DEFLATE) {
+            SetError(L"Unsupported compression method " + std::to_wstring(entry->method) + L" for: " + name);
+            return nullptr;
+        }
+
+        uint64_t dataOffset = 0;
+        if (!m_directory.ReadDataOffset(*m_source, *entry, dataOffset)) {
+            SetError(m_directory.GetLastError());
+            return nullptr;
+        }
+        if (dataOffset > m_source->Size() || entry->compressedSize > m_source->Size() - dataOffset) {
+            SetError(L"Entry data extends past the end of the package: " + name);
+            return nullptr;
+        }
+
+        auto stream = std::make_unique<EntryStream>(m_source->Data() + dataOffset, *entry);
+        if (!stream->IsReady()) {
+            SetError(L"Failed to initialize decompressor");
+            return nullptr;
+        }
+        return stream;
+    }
+
+    bool PackageReaderImpl::ReadEntry(const std::wstring& name, std::string& data) {
+        const ZipDirectoryEntry* entry = FindEntry(name);
+        if (!entry) return false;
+
+        if (!m_directory.ReadEntryData(*m_source, *entry, data)) {
+            return SetError(m_directory.GetLastError());
+        }
+        return true;
+    }
+}
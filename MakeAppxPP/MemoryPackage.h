@@ -0,0 +1,56 @@
+#pragma once
+#include "AppxPackage.h"
+#include "ZipDirectory.h"
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    class PackageBuilderImpl : public IPackageBuilder {
+    private:
+        struct Entry {
+            std::string name;
+            const uint8_t* data = nullptr;
+            uint64_t size = 0;
+            std::vector<uint8_t> owned;
+            EntryReader reader;
+        };
+
+        CompressionLevel m_compression;
+        std::vector<Entry> m_entries;
+        std::unordered_set<std::string> m_names;
+        std::wstring m_lastError;
+
+        bool SetError(const std::wstring& error);
+        bool AddEntry(const std::wstring& name, Entry&& entry);
+
+    public:
+        explicit PackageBuilderImpl(CompressionLevel compression) : m_compression(compression) {}
+
+        bool AddEntry(const std::wstring& name, const void* data, size_t size) override;
+        bool AddEntry(const std::wstring& name, std::vector<uint8_t> data) override;
+        bool AddEntry(const std::wstring& name, uint64_t size, EntryReader reader) override;
+        bool Write(std::vector<uint8_t>& output) override;
+        bool Write(const PackageSink& sink) override;
+        std::wstring GetLastError() const override { return m_lastError; }
+    };
+
+    class PackageReaderImpl : public IPackageReader {
+    private:
+        std::unique_ptr<MemorySource> m_source;
+        ZipDirectory m_directory;
+        PackageInfo m_info;
+        std::wstring m_lastError;
+
+        bool SetError(const std::wstring& error);
+        const ZipDirectoryEntry* FindEntry(const std::wstring& name);
+
+    public:
+        bool Open(const void* data, size_t size) override;
+        const PackageInfo& Info() const override { return m_info; }
+        std::unique_ptr<std::istream> OpenEntry(const std::wstring& name) override;
+        bool ReadEntry(const std::wstring& name, std::string& data) override;
+        std::wstring GetLastError() const override { return m_lastError; }
+    };
+}
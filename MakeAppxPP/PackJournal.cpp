@@ -0,0 +1,176 @@
+#include "PackJournal.h"
+#include "Crc32.h"
+#include <cstring>
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr uint32_t JOURNAL_MAGIC = 0x4A50584D;
+        constexpr uint32_t JOURNAL_VERSION = 1;
+        constexpr uint32_t MAX_RECORD_SIZE = 64 * 1024 * 1024;
+
+        template <typename T>
+        void PutValue(std::string& out, T value) {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        template <typename T>
+        bool TakeValue(const std::string& in, size_t& position, T& value) {
+            if (in.size() - position < sizeof(value)) return false;
+            memcpy(&value, in.data() + position, sizeof(value));
+            position += sizeof(value);
+            return true;
+        }
+
+        std::string EncodeRecord(const JournalEntry& entry) {
+            const ZipDirectoryEntry& directory = entry.directory;
+            std::string payload;
+            PutValue(payload, static_cast<uint16_t>(directory.name.size()));
+            payload += directory.name;
+            PutValue(payload, directory.versionNeeded);
+            PutValue(payload, directory.flags);
+            PutValue(payload, directory.method);
+            PutValue(payload, directory.modifiedTime);
+            PutValue(payload, directory.modifiedDate);
+            PutValue(payload, directory.crc32);
+            PutValue(payload, directory.compressedSize);
+            PutValue(payload, directory.uncompressedSize);
+            PutValue(payload, directory.localHeaderOffset);
+            PutValue(payload, directory.recordEnd);
+            PutValue(payload, static_cast<int64_t>(entry.sourceModified));
+            PutValue(payload, static_cast<uint32_t>(entry.blocks.size()));
+            for (const auto& block : entry.blocks) {
+                payload.append(reinterpret_cast<const char*>(block.hash.data()), block.hash.size());
+                PutValue(payload, block.compressedSize);
+            }
+
+            std::string record;
+            PutValue(record, static_cast<uint32_t>(payload.size()));
+            record += payload;
+            PutValue(record, Crc32(0, payload.data(), payload.size()));
+            return record;
+        }
+
+        bool DecodeRecord(const std::string& payload, JournalEntry& entry) {
+            ZipDirectoryEntry& directory = entry.directory;
+            size_t position = 0;
+            uint16_t nameSize = 0;
+            if (!TakeValue(payload, position, nameSize) || payload.size() - position < nameSize) return false;
+            directory.name.assign(payload, position, nameSize);
+            position += nameSize;
+
+            int64_t sourceModified = 0;
+            uint32_t blockCount = 0;
+            if (!TakeValue(payload, position, directory.versionNeeded) ||
+                !TakeValue(payload, position, directory.flags) ||
+                !TakeValue(payload, position, directory.method) ||
+                !TakeValue(payload, position, directory.modifiedTime) ||
+                !TakeValue(payload, position, directory.modifiedDate) ||
+                !TakeValue(payload, position, directory.crc32) ||
+                !TakeValue(payload, position, directory.compressedSize) ||
+                !TakeValue(payload, position, directory.uncompressedSize) ||
+                !TakeValue(payload, position, directory.localHeaderOffset) ||
+                !TakeValue(payload, position, directory.recordEnd) ||
+                !TakeValue(payload, position, sourceModified) ||
+                !TakeValue(payload, position, blockCount)) {
+                return false;
+            }
+            entry.sourceModified = static_cast<time_t>(sourceModified);
+
+            if (blockCount != (directory.uncompressedSize + BLOCK_MAP_BLOCK_SIZE - 1) / BLOCK_MAP_BLOCK_SIZE) {
+                return false;
+            }
+            entry.blocks.resize(blockCount);
+            for (auto& block : entry.blocks) {
+                if (payload.size() - position < block.hash.size()) return false;
+                memcpy(block.hash.data(), payload.data() + position, block.hash.size());
+                position += block.hash.size();
+                if (!TakeValue(payload, position, block.compressedSize)) return false;
+            }
+            return position == payload.size();
+        }
+
+        template <typename T>
+        bool ReadValue(std::ifstream& in, T& value) {
+            in.read(reinterpret_cast<char*>(&value), sizeof(value));
+            return in.gcount() == sizeof(value);
+        }
+    }
+
+    PackJournal::PackJournal(const fs::path& packagePath) : m_path(packagePath) {
+        m_path += ".journal";
+    }
+
+    bool PackJournal::Load(int zlibLevel, std::vector<JournalEntry>& entries) {
+        entries.clear();
+        std::ifstream in(m_path, std::ios::binary);
+        if (!in.is_open()) return false;
+
+        uint32_t magic = 0, version = 0;
+        int32_t level = 0;
+        if (!ReadValue(in, magic) || magic != JOURNAL_MAGIC) return false;
+        if (!ReadValue(in, version) || version != JOURNAL_VERSION) return false;
+        if (!ReadValue(in, level) || level != zlibLevel) return false;
+
+        uint32_t size = 0;
+        std::string payload;
+        while (ReadValue(in, size) && size <= MAX_RECORD_SIZE) {
+            payload.resize(size);
+            in.read(&payload[0], size);
+            uint32_t crc = 0;
+            if (static_cast<uint32_t>(in.gcount()) != size || !ReadValue(in, crc) ||
+                crc != Crc32(0, payload.data(), payload.size())) {
+                break;
+            }
+
+            JournalEntry entry;
+            if (!DecodeRecord(payload, entry)) break;
+            entries.push_back(std::move(entry));
+        }
+        return true;
+    }
+
+    bool PackJournal::Start(int zlibLevel, const std::vector<JournalEntry>& entries) {
+        m_out.close();
+
+        fs::path tempPath = m_path;
+        tempPath += ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return false;
+
+            out.write(reinterpret_cast<const char*>(&JOURNAL_MAGIC), sizeof(JOURNAL_MAGIC));
+            out.write(reinterpret_cast<const char*>(&JOURNAL_VERSION), sizeof(JOURNAL_VERSION));
+            int32_t level = zlibLevel;
+            out.write(reinterpret_cast<const char*>(&level), sizeof(level));
+            for (const auto& entry : entries) {
+                std::string record = EncodeRecord(entry);
+                out.write(record.data(), static_cast<std::streamsize>(record.size()));
+            }
+            if (!out.good()) return false;
+        }
+
+        std::error_code ec;
+        fs::rename(tempPath, m_path, ec);
+        if (ec) {
+            fs::remove(tempPath, ec);
+            return false;
+        }
+
+        m_out.open(m_path, std::ios::binary | std::ios::app);
+        return m_out.is_open();
+    }
+
+    bool PackJournal::Append(const JournalEntry& entry) {
+        std::string record = EncodeRecord(entry);
+        m_out.write(record.data(), static_cast<std::streamsize>(record.size()));
+        m_out.flush();
+        return m_out.good();
+    }
+
+    void PackJournal::Remove() {
+        m_out.close();
+        std::error_code ec;
+        fs::remove(m_path, ec);
+    }
+}
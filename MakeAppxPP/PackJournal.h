@@ -0,0 +1,40 @@
+#pragma once
+#include "BlockMap.h"
+#include "ZipDirectory.h"
+#include <filesystem>
+#include <fstream>
+#include <ctime>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    namespace fs = std::filesystem;
+
+    // An entry that a resumable pack has completely written, with what it takes to rebuild its central
+    // directory record and block map and to tell whether the source file has changed since.
+    struct JournalEntry {
+        ZipDirectoryEntry directory;
+        time_t sourceModified = 0;
+        std::vector<BlockMapBlock> blocks;
+    };
+
+    // Append-only log kept next to a package while it is being written. Each record carries its own CRC,
+    // so a record torn by a crash ends the log instead of corrupting it.
+    class PackJournal {
+    private:
+        fs::path m_path;
+        std::ofstream m_out;
+
+    public:
+        explicit PackJournal(const fs::path& packagePath);
+
+        const fs::path& Path() const { return m_path; }
+
+        // Reads the records of a previous run that used the same compression level.
+        bool Load(int zlibLevel, std::vector<JournalEntry>& entries);
+        // Replaces the journal with the given entries and keeps it open for Append.
+        bool Start(int zlibLevel, const std::vector<JournalEntry>& entries);
+        bool Append(const JournalEntry& entry);
+        void Remove();
+    };
+}
@@ -0,0 +1,146 @@
+#include "PackageDiff.h"
+#include "AppxPackageImpl.h"
+#include "BlockMap.h"
+#include "ZipDirectory.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace MakeAppxCore {
+
+    namespace {
+        struct PackageIndex {
+            FileSource source;
+            ZipDirectory directory;
+            std::unordered_map<std::string, const ZipDirectoryEntry*> byName;
+            std::vector<BlockMapEntry> blockMap;
+            std::unordered_map<std::string, const BlockMapEntry*> blockMapByName;
+
+            explicit PackageIndex(const std::wstring& path) : source(ToPath(path)) {}
+        };
+
+        bool OpenPackage(const std::wstring& path, PackageIndex& index, std::wstring& error) {
+            if (!index.source.IsOpen()) {
+                error = L"Cannot open package: " + path;
+                return false;
+            }
+            if (!index.directory.Read(index.source)) {
+                error = L"Failed to read package directory of " + path + L": " + index.directory.GetLastError();
+                return false;
+            }
+
+            index.byName.reserve(index.directory.Entries().size());
+            for (const auto& entry : index.directory.Entries()) {
+                index.byName.emplace(NormalizeEntryName(entry.name), &entry);
+            }
+            return true;
+        }
+
+        bool LoadBlockMap(const std::wstring& path, PackageIndex& index, std::wstring& error) {
+            const ZipDirectoryEntry* entry = index.directory.Find(BLOCK_MAP_ENTRY_NAME);
+            if (!entry) return false;
+
+            std::string xml;
+            if (!index.directory.ReadEntryData(index.source, *entry, xml) || !ParseBlockMapXml(xml, index.blockMap)) {
+                error = L"Invalid block map in " + path;
+                return false;
+            }
+
+            for (const auto& blockMapEntry : index.blockMap) {
+                index.blockMapByName.emplace(NormalizeEntryName(blockMapEntry.name), &blockMapEntry);
+            }
+            return true;
+        }
+
+        bool SameBlocks(const BlockMapEntry& a, const BlockMapEntry& b) {
+            if (a.size != b.size || a.blocks.size() != b.blocks.size()) return false;
+            for (size_t i = 0; i < a.blocks.size(); ++i) {
+                if (a.blocks[i].hash != b.blocks[i].hash) return false;
+            }
+            return true;
+        }
+    }
+
+    bool DiffPackages(const std::wstring& oldPackage, const std::wstring& newPackage,
+        bool compareBlockMaps, PackageDiff& diff, std::wstring& error) {
+
+        diff = PackageDiff();
+
+        PackageIndex oldIndex(oldPackage);
+        PackageIndex newIndex(newPackage);
+        if (!OpenPackage(oldPackage, oldIndex, error) || !OpenPackage(newPackage, newIndex, error)) {
+            return false;
+        }
+
+        if (compareBlockMaps) {
+            error.clear();
+            bool oldHasBlockMap = LoadBlockMap(oldPackage, oldIndex, error);
+            if (!error.empty()) return false;
+            bool newHasBlockMap = LoadBlockMap(newPackage, newIndex, error);
+            if (!error.empty()) return false;
+            diff.blockMapsCompared = oldHasBlockMap && newHasBlockMap;
+        }
+
+        std::string blockMapName = NormalizeEntryName(BLOCK_MAP_ENTRY_NAME);
+
+        for (const auto& oldEntry : oldIndex.directory.Entries()) {
+            std::string name = NormalizeEntryName(oldEntry.name);
+            auto it = newIndex.byName.find(name);
+
+            if (it == newIndex.byName.end()) {
+                PackageDiffEntry change;
+                change.name = Utf8ToWideSafe(oldEntry.name);
+                change.change = DiffChange::Removed;
+                change.oldSize = oldEntry.uncompressedSize;
+                change.oldCrc32 = oldEntry.crc32;
+                diff.entries.push_back(std::move(change));
+                continue;
+            }
+
+            const ZipDirectoryEntry& newEntry = *it->second;
+            bool modified = oldEntry.uncompressedSize != newEntry.uncompressedSize || oldEntry.crc32 != newEntry.crc32;
+            bool blockMapDiffers = false;
+
+            if (!modified && diff.blockMapsCompared && name != blockMapName) {
+                auto oldBlocks = oldIndex.blockMapByName.find(name);
+                auto newBlocks = newIndex.blockMapByName.find(name);
+                bool oldListed = oldBlocks != oldIndex.blockMapByName.end();
+                bool newListed = newBlocks != newIndex.blockMapByName.end();
+                if (oldListed != newListed || (oldListed && !SameBlocks(*oldBlocks->second, *newBlocks->second))) {
+                    modified = true;
+                    blockMapDiffers = true;
+                }
+            }
+
+            if (!modified) {
+                ++diff.unchanged;
+                continue;
+            }
+
+            PackageDiffEntry change;
+            change.name = Utf8ToWideSafe(newEntry.name);
+            change.change = DiffChange::Modified;
+            change.oldSize = oldEntry.uncompressedSize;
+            change.newSize = newEntry.uncompressedSize;
+            change.oldCrc32 = oldEntry.crc32;
+            change.newCrc32 = newEntry.crc32;
+            change.blockMapDiffers = blockMapDiffers;
+            diff.entries.push_back(std::move(change));
+        }
+
+        for (const auto& newEntry : newIndex.directory.Entries()) {
+            if (oldIndex.byName.count(NormalizeEntryName(newEntry.name))) continue;
+
+            PackageDiffEntry change;
+            change.name = Utf8ToWideSafe(newEntry.name);
+            change.change = DiffChange::Added;
+            change.newSize = newEntry.uncompressedSize;
+            change.newCrc32 = newEntry.crc32;
+            diff.entries.push_back(std::move(change));
+        }
+
+        std::sort(diff.entries.begin(), diff.entries.end(), [](const PackageDiffEntry& a, const PackageDiffEntry& b) {
+            return a.name < b.name;
+        });
+        return true;
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "AppxPackage.h"
+#include <string>
+
+namespace MakeAppxCore {
+
+    bool DiffPackages(const std::wstring& oldPackage, const std::wstring& newPackage,
+        bool compareBlockMaps, PackageDiff& diff, std::wstring& error);
+}
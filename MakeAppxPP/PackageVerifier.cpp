@@ -0,0 +1,309 @@
+#include "PackageVerifier.h"
+#include "AppxPackageImpl.h"
+#include "BlockMap.h"
+#include "Crc32.h"
+#include "BufferPool.h"
+#include "MappedFile.h"
+#include "TaskScheduler.h"
+#include "ZipDirectory.h"
+#include <zlib.h>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr uint16_t METHOD_STORE = 0;
+        constexpr uint16_t METHOD_DEFLATE = 8;
+        constexpr size_t MAX_INFLATE_INPUT = 1u << 30;
+        constexpr size_t INFLATE_STATE_MEMORY = (1 << 15) + 8192;
+        constexpr size_t VERIFY_WORKER_MEMORY = INFLATE_STATE_MEMORY + BLOCK_MAP_BLOCK_SIZE;
+        constexpr size_t VERIFY_BATCH = 64;
+
+        struct EntryCheck {
+            const ZipDirectoryEntry* entry = nullptr;
+            const BlockMapEntry* blockMap = nullptr;
+            uint64_t dataOffset = 0;
+        };
+
+        class EntryVerifier {
+        private:
+            z_stream m_stream = {};
+            bool m_streamReady = false;
+            Sha256 m_hash;
+            BufferPool::Lease m_inflateState;
+            BufferPool::Lease m_block;
+
+            const BlockMapEntry* m_blockMap = nullptr;
+            size_t m_blockIndex = 0;
+            uint32_t m_crc = 0;
+            uint64_t m_size = 0;
+            std::string m_failure;
+
+            bool Fail(const std::string& failure) {
+                m_failure = failure;
+                return false;
+            }
+
+            bool ConsumeBlock(const uint8_t* data, size_t size) {
+                m_crc = Crc32(m_crc, data, size);
+                m_size += size;
+
+                if (m_blockMap) {
+                    if (m_blockIndex >= m_blockMap->blocks.size()) {
+                        return Fail("more data than the block map describes");
+                    }
+                    m_hash.Update(data, size);
+                    if (m_hash.Finish() != m_blockMap->blocks[m_blockIndex].hash) {
+                        return Fail("block " + std::to_string(m_blockIndex) + " hash mismatch");
+                    }
+                    ++m_blockIndex;
+                }
+                return true;
+            }
+
+            bool VerifyStored(const uint8_t* data, uint64_t size) {
+                while (size > 0) {
+                    size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, BLOCK_MAP_BLOCK_SIZE));
+                    if (!ConsumeBlock(data, chunk)) return false;
+                    data += chunk;
+                    size -= chunk;
+                }
+                return true;
+            }
+
+            bool VerifyDeflated(const uint8_t* data, uint64_t size) {
+                if (!m_streamReady) {
+                    if (inflateInit2(&m_stream, -MAX_WBITS) != Z_OK) {
+                        return Fail("failed to initialize decompressor");
+                    }
+                    m_streamReady = true;
+                }
+                else {
+                    inflateReset(&m_stream);
+                }
+                m_stream.avail_in = 0;
+
+                // The sink is exactly one block map block, so each time it fills we check one block.
+                size_t filled = 0;
+                for (;;) {
+                    if (m_stream.avail_in == 0 && size > 0) {
+                        size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, MAX_INFLATE_INPUT));
+                        m_stream.next_in = const_cast<Bytef*>(data);
+                        m_stream.avail_in = static_cast<uInt>(chunk);
+                        data += chunk;
+                        size -= chunk;
+                    }
+
+                    m_stream.next_out = m_block.Data() + filled;
+                    m_stream.avail_out = static_cast<uInt>(m_block.Size() - filled);
+                    int result = inflate(&m_stream, Z_NO_FLUSH);
+
+                    if (result == Z_BUF_ERROR && m_stream.avail_in == 0 && size == 0) {
+                        return Fail("compressed data is truncated");
+                    }
+                    if (result != Z_OK && result != Z_STREAM_END) {
+                        return Fail("corrupt compressed data");
+                    }
+
+                    filled = m_block.Size() - m_stream.avail_out;
+                    if (filled == m_block.Size() || (result == Z_STREAM_END && filled > 0)) {
+                        if (!ConsumeBlock(m_block.Data(), filled)) return false;
+                        filled = 0;
+                    }
+                    if (result == Z_STREAM_END) break;
+                }
+
+                if (m_stream.avail_in != 0 || size != 0) {
+                    return Fail("trailing data after compressed stream");
+                }
+                return true;
+            }
+
+        public:
+            EntryVerifier()
+                : m_inflateState(BufferPool::Shared().Reserve(INFLATE_STATE_MEMORY)),
+                  m_block(BufferPool::Shared().Acquire(BLOCK_MAP_BLOCK_SIZE)) {}
+
+            ~EntryVerifier() {
+                if (m_streamReady) inflateEnd(&m_stream);
+            }
+
+            bool Verify(const uint8_t* package, const EntryCheck& check) {
+                const ZipDirectoryEntry& entry = *check.entry;
+                m_blockMap = check.blockMap;
+                m_blockIndex = 0;
+                m_crc = 0;
+                m_size = 0;
+                m_failure.clear();
+
+                const uint8_t* data = package + check.dataOffset;
+                if (entry.method == METHOD_STORE) {
+                    if (entry.compressedSize != entry.uncompressedSize) {
+                        return Fail("stored entry has different compressed and uncompressed sizes");
+                    }
+                    if (!VerifyStored(data, entry.compressedSize)) return false;
+                }
+                else if (entry.method == METHOD_DEFLATE) {
+                    if (!VerifyDeflated(data, entry.compressedSize)) return false;
+                }
+                else {
+                    return Fail("unsupported compression method " + std::to_string(entry.method));
+                }
+
+                if (m_size != entry.uncompressedSize) {
+                    return Fail("size mismatch (" + std::to_string(m_size) + " bytes, expected " +
+                        std::to_string(entry.uncompressedSize) + ")");
+                }
+                if (m_crc != entry.crc32) {
+                    return Fail("CRC-32 mismatch");
+                }
+                if (m_blockMap) {
+                    if (m_blockMap->size != m_size) {
+                        return Fail("size differs from block map");
+                    }
+                    if (m_blockIndex != m_blockMap->blocks.size()) {
+                        return Fail("fewer blocks than the block map describes");
+                    }
+                }
+                return true;
+            }
+
+            uint64_t VerifiedSize() const { return m_size; }
+            size_t VerifiedBlocks() const { return m_blockIndex; }
+            const std::string& Failure() const { return m_failure; }
+        };
+    }
+
+    bool VerifyPackage(const std::wstring& packagePath, VerifyResult& result,
+        ProgressCallback callback, std::wstring& error) {
+
+        result = VerifyResult();
+
+        MappedFile package;
+        if (!package.Open(ToPath(packagePath))) {
+            error = package.GetLastError();
+            return false;
+        }
+
+        MemorySource source(package.Data(), package.Size());
+        ZipDirectory directory;
+        if (!directory.Read(source)) {
+            error = L"Failed to read package directory: " + directory.GetLastError();
+            return false;
+        }
+
+        std::vector<BlockMapEntry> blockMap;
+        std::unordered_map<std::string, const BlockMapEntry*> blockMapByName;
+        const ZipDirectoryEntry* blockMapEntry = directory.Find(BLOCK_MAP_ENTRY_NAME);
+        if (blockMapEntry) {
+            std::string xml;
+            if (!directory.ReadEntryData(source, *blockMapEntry, xml)) {
+                result.failures.push_back(L"AppxBlockMap.xml: " + directory.GetLastError());
+            }
+            else if (!ParseBlockMapXml(xml, blockMap)) {
+                result.failures.push_back(L"AppxBlockMap.xml: invalid block map");
+            }
+            else {
+                result.blockMapChecked = true;
+                for (const auto& entry : blockMap) {
+                    blockMapByName.emplace(NormalizeEntryName(entry.name), &entry);
+                }
+            }
+        }
+
+        std::vector<EntryCheck> checks;
+        checks.reserve(directory.Entries().size());
+        std::unordered_set<std::string> covered;
+
+        for (const auto& entry : directory.Entries()) {
+            EntryCheck check;
+            check.entry = &entry;
+
+            if (!directory.ReadDataOffset(source, entry, check.dataOffset) ||
+                check.dataOffset > package.Size() || entry.compressedSize > package.Size() - check.dataOffset) {
+                result.failures.push_back(Utf8ToWideSafe(entry.name) + L": entry data lies outside the package");
+                continue;
+            }
+
+            if (result.blockMapChecked) {
+                std::string normalized = NormalizeEntryName(entry.name);
+                auto it = blockMapByName.find(normalized);
+                if (it != blockMapByName.end()) {
+                    check.blockMap = it->second;
+                    covered.insert(normalized);
+                }
+                else if (!IsFootprintFile(normalized)) {
+                    result.failures.push_back(Utf8ToWideSafe(entry.name) + L": not listed in the block map");
+                }
+            }
+
+            checks.push_back(check);
+        }
+
+        for (const auto& entry : blockMapByName) {
+            if (covered.find(entry.first) == covered.end()) {
+                result.failures.push_back(Utf8ToWideSafe(entry.second->name) +
+                    L": listed in the block map but missing from the package");
+            }
+        }
+
+        std::sort(checks.begin(), checks.end(), [](const EntryCheck& a, const EntryCheck& b) {
+            return a.entry->compressedSize > b.entry->compressedSize;
+        });
+
+        ProgressInfo progress = {};
+        progress.totalFiles = checks.size();
+        for (const auto& check : checks) {
+            progress.totalBytes += check.entry->uncompressedSize;
+        }
+
+        std::mutex resultMutex;
+
+        // Entries up to a block in size share a task, and the verifier with it, with up to VERIFY_BATCH others.
+        TaskGroup group(TaskClass::Cpu, BufferPool::Shared().WorkerCount(VERIFY_WORKER_MEMORY,
+            TaskScheduler::Shared().ThreadCount(TaskClass::Cpu)));
+        for (size_t first = 0; first < checks.size();) {
+            size_t last = first;
+            uint64_t taskBytes = 0;
+            do {
+                taskBytes += checks[last++].entry->compressedSize;
+            } while (last < checks.size() && last - first < VERIFY_BATCH && taskBytes < BLOCK_MAP_BLOCK_SIZE);
+
+            group.Run([&, first, last]() {
+                EntryVerifier verifier;
+                for (size_t index = first; index < last; ++index) {
+                    const EntryCheck& check = checks[index];
+                    bool ok = verifier.Verify(package.Data(), check);
+
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (!ok) {
+                        result.failures.push_back(Utf8ToWideSafe(check.entry->name) + L": " +
+                            Utf8ToWideSafe(verifier.Failure()));
+                    }
+                    ++result.entriesChecked;
+                    result.bytesChecked += verifier.VerifiedSize();
+                    result.blocksChecked += verifier.VerifiedBlocks();
+
+                    if (callback) {
+                        progress.processedFiles = result.entriesChecked;
+                        progress.processedBytes = result.bytesChecked;
+                        progress.currentFile = Utf8ToWideSafe(check.entry->name);
+                        callback(progress);
+                    }
+                }
+            }, taskBytes);
+            first = last;
+        }
+        group.Wait();
+
+        std::sort(result.failures.begin(), result.failures.end());
+        if (!result.failures.empty()) {
+            error = std::to_wstring(result.failures.size()) + L" integrity problem(s) found in " + packagePath;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "AppxPackage.h"
+#include <string>
+
+namespace MakeAppxCore {
+
+    bool VerifyPackage(const std::wstring& packagePath, VerifyResult& result,
+        ProgressCallback callback, std::wstring& error);
+}
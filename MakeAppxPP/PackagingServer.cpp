@@ -0,0 +1,526 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cerrno>
+#endif
+
+#include "PackagingServer.h"
+#include "AppxPackageImpl.h"
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace MakeAppxPP {
+
+    using MakeAppxCore::JsonObject;
+    using MakeAppxCore::JsonWriter;
+    using MakeAppxCore::WideToUtf8Safe;
+    using MakeAppxCore::Utf8ToWideSafe;
+    using MakeAppxCore::ToPath;
+    using MakeAppxCore::FromPath;
+
+    namespace {
+
+#ifdef _WIN32
+        const SocketHandle INVALID_SOCKET_HANDLE = static_cast<SocketHandle>(INVALID_SOCKET);
+
+        void CloseSocket(SocketHandle socketHandle) {
+            closesocket(static_cast<SOCKET>(socketHandle));
+        }
+
+        void InterruptListener(SocketHandle socketHandle) {
+            closesocket(static_cast<SOCKET>(socketHandle));
+        }
+
+        void InterruptConnection(SocketHandle socketHandle) {
+            shutdown(static_cast<SOCKET>(socketHandle), SD_BOTH);
+        }
+
+        // The default socket lives in the per-user temp directory, whose ACL already keeps other users out.
+        bool IsSameUser(SocketHandle) {
+            return true;
+        }
+#else
+        const SocketHandle INVALID_SOCKET_HANDLE = -1;
+
+        void CloseSocket(SocketHandle socketHandle) {
+            close(socketHandle);
+        }
+
+        void InterruptListener(SocketHandle socketHandle) {
+            shutdown(socketHandle, SHUT_RDWR);
+        }
+
+        void InterruptConnection(SocketHandle socketHandle) {
+            shutdown(socketHandle, SHUT_RDWR);
+        }
+
+        // Requests run with the server's rights, so only its own user may send them.
+        bool IsSameUser(SocketHandle socketHandle) {
+#ifdef SO_PEERCRED
+            ucred credentials = {};
+            socklen_t size = sizeof(credentials);
+            if (getsockopt(socketHandle, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0) return false;
+            return credentials.uid == geteuid();
+#else
+            uid_t uid = 0;
+            gid_t gid = 0;
+            if (getpeereid(socketHandle, &uid, &gid) != 0) return false;
+            return uid == geteuid();
+#endif
+        }
+#endif
+
+        // A stale socket left by a server that died is replaced; a live server or anything that is not a
+        // socket is left alone.
+        bool ClearSocketPath(const sockaddr_un& address, const std::wstring& socketPath, std::wstring& error) {
+#ifndef _WIN32
+            struct stat status = {};
+            if (lstat(address.sun_path, &status) != 0) {
+                return true;
+            }
+            if (!S_ISSOCK(status.st_mode)) {
+                error = L"Not a socket, refusing to replace: " + socketPath;
+                return false;
+            }
+#else
+            std::error_code ec;
+            if (!fs::exists(ToPath(socketPath), ec)) {
+                return true;
+            }
+            if (fs::is_directory(ToPath(socketPath), ec)) {
+                error = L"Not a socket, refusing to replace: " + socketPath;
+                return false;
+            }
+#endif
+
+            SocketHandle probe = static_cast<SocketHandle>(socket(AF_UNIX, SOCK_STREAM, 0));
+            if (probe != INVALID_SOCKET_HANDLE) {
+                bool live = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+                CloseSocket(probe);
+                if (live) {
+                    error = L"Another server is already listening on: " + socketPath;
+                    return false;
+                }
+            }
+
+            std::error_code removeError;
+            fs::remove(ToPath(socketPath), removeError);
+            return true;
+        }
+
+        constexpr size_t MAX_REQUEST_SIZE = 1024 * 1024;
+        constexpr size_t RECEIVE_BUFFER_SIZE = 8192;
+
+        bool ParseCompression(const std::string& value, MakeAppxCore::CompressionLevel& level) {
+            if (value.empty() || value == "normal") level = MakeAppxCore::CompressionLevel::Normal;
+            else if (value == "none") level = MakeAppxCore::CompressionLevel::None;
+            else if (value == "fast") level = MakeAppxCore::CompressionLevel::Fast;
+            else if (value == "max") level = MakeAppxCore::CompressionLevel::Maximum;
+            else return false;
+            return true;
+        }
+
+        bool ParseOverwrite(const std::string& value, MakeAppxCore::OverwriteMode& mode) {
+            if (value.empty() || value == "no") mode = MakeAppxCore::OverwriteMode::No;
+            else if (value == "yes") mode = MakeAppxCore::OverwriteMode::Yes;
+            else return false;
+            return true;
+        }
+
+        std::string ValueOf(const JsonObject& object, const std::string& key) {
+            auto it = object.find(key);
+            return it != object.end() ? it->second : std::string();
+        }
+    }
+
+    PackagingServer::PackagingServer(const ServerOptions& options)
+        : m_options(options), m_listenSocket(INVALID_SOCKET_HANDLE) {
+        if (m_options.socketPath.empty()) {
+            m_options.socketPath = DefaultSocketPath();
+        }
+    }
+
+    PackagingServer::~PackagingServer() {
+        Stop();
+        for (auto& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    std::wstring PackagingServer::DefaultSocketPath() {
+        return FromPath(fs::temp_directory_path() / L"makeappxpp.sock");
+    }
+
+    void PackagingServer::SetError(const std::wstring& error) {
+        m_lastError = error;
+    }
+
+    void PackagingServer::Log(const std::wstring& message) {
+        if (!m_options.quiet) {
+            std::wcout << L"[serve] " << message << std::endl;
+        }
+    }
+
+    bool PackagingServer::Run() {
+#ifdef _WIN32
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+            SetError(L"Failed to initialize Winsock");
+            return false;
+        }
+#else
+        signal(SIGPIPE, SIG_IGN);
+#endif
+
+        std::string socketPathUtf8 = WideToUtf8Safe(m_options.socketPath);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (socketPathUtf8.empty() || socketPathUtf8.size() >= sizeof(address.sun_path)) {
+            SetError(L"Socket path is empty or too long: " + m_options.socketPath);
+            return false;
+        }
+        memcpy(address.sun_path, socketPathUtf8.c_str(), socketPathUtf8.size() + 1);
+
+        std::wstring pathError;
+        if (!ClearSocketPath(address, m_options.socketPath, pathError)) {
+            SetError(pathError);
+            return false;
+        }
+
+        m_listenSocket = static_cast<SocketHandle>(socket(AF_UNIX, SOCK_STREAM, 0));
+        if (m_listenSocket == INVALID_SOCKET_HANDLE) {
+            SetError(L"Failed to create local socket");
+            return false;
+        }
+
+#ifndef _WIN32
+        // Created owner-only from the start; no worker thread runs yet to see the narrowed umask.
+        mode_t previousMask = umask(0077);
+        bool bound = bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        umask(previousMask);
+#else
+        bool bound = bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+#endif
+        if (!bound || listen(m_listenSocket, SOMAXCONN) != 0) {
+            CloseSocket(m_listenSocket);
+            m_listenSocket = INVALID_SOCKET_HANDLE;
+            SetError(L"Failed to listen on socket: " + m_options.socketPath);
+            return false;
+        }
+
+        size_t workerCount = m_options.workerCount;
+        if (workerCount == 0) {
+            workerCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        m_running = true;
+        for (size_t i = 0; i < workerCount; ++i) {
+            m_workers.emplace_back(&PackagingServer::WorkerLoop, this);
+        }
+
+        Log(L"Listening on " + m_options.socketPath + L" with " +
+            std::to_wstring(workerCount) + L" workers");
+
+        while (m_running) {
+            SocketHandle client = static_cast<SocketHandle>(accept(m_listenSocket, nullptr, nullptr));
+            if (client == INVALID_SOCKET_HANDLE) {
+                if (!m_running) break;
+#ifndef _WIN32
+                if (errno != EINTR && errno != ECONNABORTED) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+#endif
+                continue;
+            }
+
+            if (!IsSameUser(client)) {
+                CloseSocket(client);
+                Log(L"Rejected a connection from another user");
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                m_pendingClients.push_back(client);
+            }
+            m_queueCondition.notify_one();
+        }
+
+        Stop();
+        for (auto& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+        m_workers.clear();
+
+#ifndef _WIN32
+        CloseSocket(m_listenSocket);
+#endif
+        m_listenSocket = INVALID_SOCKET_HANDLE;
+        std::error_code ec;
+        fs::remove(ToPath(m_options.socketPath), ec);
+
+#ifdef _WIN32
+        WSACleanup();
+#endif
+
+        Log(L"Server stopped");
+        return true;
+    }
+
+    void PackagingServer::Stop() {
+        if (m_running.exchange(false)) {
+            InterruptListener(m_listenSocket);
+
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            for (SocketHandle client : m_activeClients) {
+                InterruptConnection(client);
+            }
+        }
+        m_queueCondition.notify_all();
+    }
+
+    void PackagingServer::WorkerLoop() {
+        WorkerContext context;
+        context.package = MakeAppxCore::CreateAppxPackage();
+        context.bundle = MakeAppxCore::CreateAppxBundle();
+
+        while (true) {
+            SocketHandle client;
+            {
+                std::unique_lock<std::mutex> lock(m_queueMutex);
+                m_queueCondition.wait(lock, [this] { return !m_running || !m_pendingClients.empty(); });
+                if (!m_running) {
+                    for (SocketHandle pending : m_pendingClients) {
+                        CloseSocket(pending);
+                    }
+                    m_pendingClients.clear();
+                    return;
+                }
+                client = m_pendingClients.front();
+                m_pendingClients.pop_front();
+                m_activeClients.insert(client);
+            }
+
+            HandleClient(client, context);
+
+            {
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                m_activeClients.erase(client);
+            }
+            CloseSocket(client);
+        }
+    }
+
+    bool PackagingServer::SendLine(SocketHandle client, const std::string& line) {
+        std::string payload = line + "\n";
+        size_t sent = 0;
+        while (sent < payload.size()) {
+#ifdef _WIN32
+            int result = send(static_cast<SOCKET>(client), payload.data() + sent,
+                static_cast<int>(payload.size() - sent), 0);
+#elif defined(MSG_NOSIGNAL)
+            ssize_t result = send(client, payload.data() + sent, payload.size() - sent, MSG_NOSIGNAL);
+#else
+            ssize_t result = send(client, payload.data() + sent, payload.size() - sent, 0);
+#endif
+            if (result <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(result);
+        }
+        return true;
+    }
+
+    void PackagingServer::HandleClient(SocketHandle client, WorkerContext& context) {
+        std::string pending;
+        char buffer[RECEIVE_BUFFER_SIZE];
+
+        while (true) {
+#ifdef _WIN32
+            int received = recv(static_cast<SOCKET>(client), buffer, sizeof(buffer), 0);
+#else
+            ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+#endif
+            if (received <= 0) {
+                return;
+            }
+
+            pending.append(buffer, static_cast<size_t>(received));
+
+            size_t lineEnd;
+            while ((lineEnd = pending.find('\n')) != std::string::npos) {
+                std::string line = pending.substr(0, lineEnd);
+                pending.erase(0, lineEnd + 1);
+
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty()) continue;
+
+                JsonObject request;
+                std::string parseError;
+                if (!MakeAppxCore::ParseJsonObject(line, request, parseError)) {
+                    JsonWriter response;
+                    response.BeginObject()
+                        .Key("event").String("done")
+                        .Key("success").Bool(false)
+                        .Key("error").String("Malformed request: " + parseError)
+                        .EndObject();
+                    if (!SendLine(client, response.Str())) return;
+                    continue;
+                }
+
+                if (!HandleRequest(client, request, context)) {
+                    return;
+                }
+            }
+
+            if (pending.size() > MAX_REQUEST_SIZE) {
+                JsonWriter response;
+                response.BeginObject()
+                    .Key("event").String("done")
+                    .Key("success").Bool(false)
+                    .Key("error").String("Request too large")
+                    .EndObject();
+                SendLine(client, response.Str());
+                return;
+            }
+        }
+    }
+
+    bool PackagingServer::HandleRequest(SocketHandle client, const JsonObject& request,
+        WorkerContext& context) {
+
+        std::string id = ValueOf(request, "id");
+        std::string op = ValueOf(request, "op");
+
+        auto sendResult = [&](bool success, const std::string& error) {
+            JsonWriter response;
+            response.BeginObject()
+                .Key("id").String(id)
+                .Key("event").String("done")
+                .Key("success").Bool(success);
+            if (!error.empty()) {
+                response.Key("error").String(error);
+            }
+            response.EndObject();
+            return SendLine(client, response.Str());
+        };
+
+        if (op == "ping") {
+            return sendResult(true, "");
+        }
+
+        if (op == "shutdown") {
+            sendResult(true, "");
+            Log(L"Shutdown requested");
+            Stop();
+            return false;
+        }
+
+        std::wstring input = Utf8ToWideSafe(ValueOf(request, "input"));
+        std::wstring output = Utf8ToWideSafe(ValueOf(request, "output"));
+        if (input.empty() || output.empty()) {
+            return sendResult(false, "Request requires 'input' and 'output'");
+        }
+
+        bool clientConnected = true;
+        auto lastUpdate = std::chrono::steady_clock::time_point();
+        MakeAppxCore::ProgressCallback callback = [&](const MakeAppxCore::ProgressInfo& progress) {
+            if (!clientConnected) return;
+
+            auto now = std::chrono::steady_clock::now();
+            bool complete = progress.processedFiles >= progress.totalFiles;
+            if (!complete && now - lastUpdate < std::chrono::milliseconds(100)) {
+                return;
+            }
+            lastUpdate = now;
+
+            JsonWriter event;
+            event.BeginObject()
+                .Key("id").String(id)
+                .Key("event").String("progress")
+                .Key("processedFiles").Number(progress.processedFiles)
+                .Key("totalFiles").Number(progress.totalFiles)
+                .Key("processedBytes").Number(progress.processedBytes)
+                .Key("totalBytes").Number(progress.totalBytes)
+                .Key("currentFile").String(WideToUtf8Safe(progress.currentFile))
+                .EndObject();
+            clientConnected = SendLine(client, event.Str());
+        };
+
+        if (m_options.verbose) {
+            Log(Utf8ToWideSafe(op) + L": " + input + L" -> " + output);
+        }
+
+        bool success = false;
+        std::wstring error;
+
+        if (op == "pack" || op == "bundle") {
+            MakeAppxCore::CompressionLevel compression;
+            if (!ParseCompression(ValueOf(request, "compression"), compression)) {
+                return sendResult(false, "Invalid compression level");
+            }
+
+            if (op == "pack") {
+                MakeAppxCore::PackOptions packOptions;
+                packOptions.compression = compression;
+                packOptions.cacheDirectory = request.count("cache") ?
+                    Utf8ToWideSafe(ValueOf(request, "cache")) : m_options.cacheDirectory;
+                packOptions.contentGroupMap = Utf8ToWideSafe(ValueOf(request, "cgm"));
+
+                success = context.package->Pack(input, output, packOptions, callback);
+                if (!success) error = context.package->GetLastError();
+            }
+            else {
+                success = context.bundle->Bundle(input, output, compression, callback);
+                if (!success) error = context.bundle->GetLastError();
+            }
+        }
+        else if (op == "update") {
+            MakeAppxCore::PackOptions packOptions;
+            if (!ParseCompression(ValueOf(request, "compression"), packOptions.compression)) {
+                return sendResult(false, "Invalid compression level");
+            }
+            packOptions.cacheDirectory = request.count("cache") ?
+                Utf8ToWideSafe(ValueOf(request, "cache")) : m_options.cacheDirectory;
+
+            success = context.package->Update(output, input, packOptions, callback);
+            if (!success) error = context.package->GetLastError();
+        }
+        else if (op == "unpack" || op == "unbundle") {
+            MakeAppxCore::OverwriteMode overwrite;
+            if (!ParseOverwrite(ValueOf(request, "overwrite"), overwrite)) {
+                return sendResult(false, "Invalid overwrite mode (expected 'yes' or 'no')");
+            }
+
+            if (op == "unpack") {
+                success = context.package->Unpack(input, output, overwrite, callback);
+                if (!success) error = context.package->GetLastError();
+            }
+            else {
+                success = context.bundle->Unbundle(input, output, overwrite, callback);
+                if (!success) error = context.bundle->GetLastError();
+            }
+        }
+        else {
+            return sendResult(false, "Unknown op: " + op);
+        }
+
+        if (!clientConnected) {
+            return false;
+        }
+
+        return sendResult(success, WideToUtf8Safe(error));
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "AppxPackage.h"
+#include "JsonUtil.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace MakeAppxPP {
+
+#ifdef _WIN32
+    using SocketHandle = uintptr_t;
+#else
+    using SocketHandle = int;
+#endif
+
+    constexpr size_t MAX_SERVER_WORKERS = 256;
+
+    struct ServerOptions {
+        std::wstring socketPath;
+        std::wstring cacheDirectory;
+        size_t workerCount = 0;
+        bool verbose = false;
+        bool quiet = false;
+    };
+
+    class PackagingServer {
+    private:
+        struct WorkerContext {
+            std::unique_ptr<MakeAppxCore::IAppxPackage> package;
+            std::unique_ptr<MakeAppxCore::IAppxBundle> bundle;
+        };
+
+        ServerOptions m_options;
+        std::wstring m_lastError;
+        SocketHandle m_listenSocket;
+        std::atomic<bool> m_running{ false };
+
+        std::vector<std::thread> m_workers;
+        std::deque<SocketHandle> m_pendingClients;
+        std::set<SocketHandle> m_activeClients;
+        std::mutex m_queueMutex;
+        std::condition_variable m_queueCondition;
+
+        void SetError(const std::wstring& error);
+        void WorkerLoop();
+        void HandleClient(SocketHandle client, WorkerContext& context);
+        bool HandleRequest(SocketHandle client, const MakeAppxCore::JsonObject& request,
+            WorkerContext& context);
+        bool SendLine(SocketHandle client, const std::string& line);
+        void Log(const std::wstring& message);
+
+    public:
+        explicit PackagingServer(const ServerOptions& options);
+        ~PackagingServer();
+
+        bool Run();
+        void Stop();
+        std::wstring GetLastError() const { return m_lastError; }
+
+        static std::wstring DefaultSocketPath();
+    };
+}
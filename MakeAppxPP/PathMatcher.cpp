@@ -0,0 +1,186 @@
+#include "PathMatcher.h"
+#include "AppxPackageImpl.h"
+#include <algorithm>
+
+namespace MakeAppxCore {
+
+    namespace {
+        bool HasWildcard(const std::string& segment) {
+            return segment.find_first_of("*?") != std::string::npos;
+        }
+
+        void SplitSegments(const std::string& path, std::vector<std::string>& segments) {
+            segments.clear();
+            size_t start = 0;
+            while (start <= path.size()) {
+                size_t end = path.find('/', start);
+                if (end == std::string::npos) end = path.size();
+                if (end > start) segments.push_back(path.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+    }
+
+    bool MatchSegmentGlob(const char* pattern, const char* text) {
+        const char* starPattern = nullptr;
+        const char* starText = nullptr;
+
+        while (*text) {
+            if (*pattern == '*') {
+                starPattern = ++pattern;
+                starText = text;
+            }
+            else if (*pattern == '?' || *pattern == *text) {
+                ++pattern;
+                ++text;
+            }
+            else if (starPattern) {
+                pattern = starPattern;
+                text = ++starText;
+            }
+            else {
+                return false;
+            }
+        }
+
+        while (*pattern == '*') ++pattern;
+        return *pattern == '\0';
+    }
+
+    PathMatcher::PathMatcher() {
+        AddNode();
+    }
+
+    uint32_t PathMatcher::AddNode() {
+        m_nodes.emplace_back();
+        m_levels.clear();
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+    }
+
+    void PathMatcher::AddPattern(const std::string& pattern, bool anchored) {
+        std::string normalized = NormalizeEntryName(pattern);
+        if (!normalized.empty() && normalized[0] == '/') {
+            anchored = true;
+        }
+
+        std::vector<std::string> segments;
+        SplitSegments(normalized, segments);
+        if (segments.empty()) return;
+
+        size_t slash = normalized.find('/');
+        if (!anchored && (slash == std::string::npos || slash == normalized.size() - 1)) {
+            segments.insert(segments.begin(), "**");
+        }
+
+        uint32_t node = 0;
+        for (const auto& segment : segments) {
+            uint32_t next = NO_NODE;
+
+            if (segment == "**") {
+                next = m_nodes[node].anySegments;
+                if (next == NO_NODE) {
+                    next = AddNode();
+                    m_nodes[next].isAnySegments = true;
+                    m_nodes[node].anySegments = next;
+                }
+            }
+            else if (HasWildcard(segment)) {
+                auto& wildcards = m_nodes[node].wildcards;
+                auto it = std::find_if(wildcards.begin(), wildcards.end(),
+                    [&segment](const std::pair<std::string, uint32_t>& w) { return w.first == segment; });
+                if (it != wildcards.end()) {
+                    next = it->second;
+                }
+                else {
+                    next = AddNode();
+                    m_nodes[node].wildcards.emplace_back(segment, next);
+                }
+            }
+            else {
+                auto it = m_nodes[node].literals.find(segment);
+                if (it != m_nodes[node].literals.end()) {
+                    next = it->second;
+                }
+                else {
+                    next = AddNode();
+                    m_nodes[node].literals.emplace(segment, next);
+                }
+            }
+
+            node = next;
+        }
+
+        m_nodes[node].terminal = true;
+        ++m_patternCount;
+    }
+
+    void PathMatcher::AddClosure(std::vector<uint32_t>& states, uint32_t node) const {
+        if (std::find(states.begin(), states.end(), node) != states.end()) return;
+        states.push_back(node);
+        if (m_nodes[node].anySegments != NO_NODE) {
+            AddClosure(states, m_nodes[node].anySegments);
+        }
+    }
+
+    void PathMatcher::Advance(const Level& current, const std::string& segment, Level& next) const {
+        next.segment = segment;
+        next.states.clear();
+        next.matched = current.matched;
+        if (next.matched) return;
+
+        for (uint32_t state : current.states) {
+            const Node& node = m_nodes[state];
+
+            if (node.isAnySegments) {
+                AddClosure(next.states, state);
+            }
+
+            auto it = node.literals.find(segment);
+            if (it != node.literals.end()) {
+                AddClosure(next.states, it->second);
+            }
+
+            for (const auto& wildcard : node.wildcards) {
+                if (MatchSegmentGlob(wildcard.first.c_str(), segment.c_str())) {
+                    AddClosure(next.states, wildcard.second);
+                }
+            }
+        }
+
+        for (uint32_t state : next.states) {
+            if (m_nodes[state].terminal) {
+                next.matched = true;
+                break;
+            }
+        }
+    }
+
+    bool PathMatcher::Match(const std::string& path) {
+        if (m_patternCount == 0) return false;
+
+        if (m_levels.empty()) {
+            Level root;
+            AddClosure(root.states, 0);
+            m_levels.push_back(std::move(root));
+        }
+
+        std::vector<std::string> segments;
+        SplitSegments(NormalizeEntryName(path), segments);
+
+        // Entries are usually grouped by directory, so keep the states of the shared prefix.
+        size_t common = 0;
+        while (common < segments.size() && common + 1 < m_levels.size() &&
+            m_levels[common + 1].segment == segments[common]) {
+            ++common;
+        }
+        m_levels.resize(common + 1);
+
+        for (size_t i = common; i < segments.size(); ++i) {
+            Level next;
+            Advance(m_levels.back(), segments[i], next);
+            m_levels.push_back(std::move(next));
+        }
+
+        return m_levels.back().matched;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace MakeAppxCore {
+
+    class PathMatcher {
+    private:
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+        struct Node {
+            std::unordered_map<std::string, uint32_t> literals;
+            std::vector<std::pair<std::string, uint32_t>> wildcards;
+            uint32_t anySegments = NO_NODE;
+            bool isAnySegments = false;
+            bool terminal = false;
+        };
+
+        struct Level {
+            std::string segment;
+            std::vector<uint32_t> states;
+            bool matched = false;
+        };
+
+        std::vector<Node> m_nodes;
+        std::vector<Level> m_levels;
+        size_t m_patternCount = 0;
+
+        uint32_t AddNode();
+        void AddClosure(std::vector<uint32_t>& states, uint32_t node) const;
+        void Advance(const Level& current, const std::string& segment, Level& next) const;
+
+    public:
+        PathMatcher();
+
+        void AddPattern(const std::string& pattern, bool anchored = false);
+        bool Match(const std::string& path);
+
+        bool Empty() const { return m_patternCount == 0; }
+        size_t PatternCount() const { return m_patternCount; }
+    };
+
+    bool MatchSegmentGlob(const char* pattern, const char* text);
+}
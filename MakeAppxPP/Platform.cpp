@@ -0,0 +1,164 @@
+#include "Platform.h"
+#include "Utf8.h"
+#include <cstring>
+#ifdef _WIN32
+#include <Windows.h>
+#include <bcrypt.h>
+#pragma comment(lib, "bcrypt.lib")
+#else
+#include <unistd.h>
+#include <openssl/evp.h>
+#endif
+
+namespace MakeAppxCore {
+
+    std::string WideToUtf8Safe(const std::wstring& wstr) {
+        std::string result;
+        TranscodeWideToUtf8(wstr.data(), wstr.size(), result);
+        return result;
+    }
+
+    std::wstring Utf8ToWideSafe(const std::string& str) {
+        std::wstring result;
+        TranscodeUtf8ToWide(str.data(), str.size(), result);
+        return result;
+    }
+
+#ifdef _WIN32
+    uint32_t CurrentProcessId() {
+        return static_cast<uint32_t>(GetCurrentProcessId());
+    }
+
+    std::filesystem::path ToPath(const std::wstring& path) {
+        return std::filesystem::path(path);
+    }
+
+    std::wstring FromPath(const std::filesystem::path& path) {
+        return path.wstring();
+    }
+
+    std::filesystem::path PathFromUtf8(const std::string& path) {
+        return std::filesystem::path(Utf8ToWideSafe(path));
+    }
+
+    std::string PathToUtf8(const std::filesystem::path& path) {
+        const std::wstring& native = path.native();
+        std::string result;
+        TranscodeWideToUtf8(native.data(), native.size(), result);
+        return result;
+    }
+
+    AesCbc::~AesCbc() {
+        if (m_key) BCryptDestroyKey(static_cast<BCRYPT_KEY_HANDLE>(m_key));
+        if (m_algorithm) BCryptCloseAlgorithmProvider(static_cast<BCRYPT_ALG_HANDLE>(m_algorithm), 0);
+    }
+
+    bool AesCbc::Open(const uint8_t* key, size_t size) {
+        if (size != KEY_SIZE) return false;
+
+        BCRYPT_ALG_HANDLE algorithm = nullptr;
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&algorithm, BCRYPT_AES_ALGORITHM, nullptr, 0))) {
+            return false;
+        }
+        m_algorithm = algorithm;
+
+        if (!BCRYPT_SUCCESS(BCryptSetProperty(algorithm, BCRYPT_CHAINING_MODE,
+            (PUCHAR)BCRYPT_CHAIN_MODE_CBC, sizeof(BCRYPT_CHAIN_MODE_CBC), 0))) {
+            return false;
+        }
+
+        BCRYPT_KEY_HANDLE handle = nullptr;
+        if (!BCRYPT_SUCCESS(BCryptGenerateSymmetricKey(algorithm, &handle, nullptr, 0,
+            const_cast<PUCHAR>(key), static_cast<ULONG>(size), 0))) {
+            return false;
+        }
+        m_key = handle;
+        return true;
+    }
+
+    bool AesCbc::Encrypt(const uint8_t* input, size_t size, uint8_t* iv, uint8_t* output) {
+        ULONG written = 0;
+        return BCRYPT_SUCCESS(BCryptEncrypt(static_cast<BCRYPT_KEY_HANDLE>(m_key), const_cast<PUCHAR>(input),
+            static_cast<ULONG>(size), nullptr, iv, BLOCK_SIZE, output, static_cast<ULONG>(size), &written, 0));
+    }
+
+    bool AesCbc::Decrypt(const uint8_t* input, size_t size, uint8_t* iv, uint8_t* output) {
+        ULONG written = 0;
+        return BCRYPT_SUCCESS(BCryptDecrypt(static_cast<BCRYPT_KEY_HANDLE>(m_key), const_cast<PUCHAR>(input),
+            static_cast<ULONG>(size), nullptr, iv, BLOCK_SIZE, output, static_cast<ULONG>(size), &written, 0));
+    }
+#else
+    namespace {
+        bool RunCipher(EVP_CIPHER_CTX* context, bool encrypt, const uint8_t* key,
+            const uint8_t* input, size_t size, uint8_t* iv, uint8_t* output) {
+            if (size % AesCbc::BLOCK_SIZE != 0) return false;
+            if (size == 0) return true;
+
+            uint8_t nextIv[AesCbc::BLOCK_SIZE];
+            if (!encrypt) std::memcpy(nextIv, input + size - AesCbc::BLOCK_SIZE, AesCbc::BLOCK_SIZE);
+
+            int written = 0;
+            int finalWritten = 0;
+            bool success = context &&
+                EVP_CipherInit_ex(context, EVP_aes_256_cbc(), nullptr, key, iv, encrypt ? 1 : 0) == 1 &&
+                EVP_CIPHER_CTX_set_padding(context, 0) == 1 &&
+                EVP_CipherUpdate(context, output, &written, input, static_cast<int>(size)) == 1 &&
+                EVP_CipherFinal_ex(context, output + written, &finalWritten) == 1;
+            if (!success) return false;
+
+            std::memcpy(iv, encrypt ? output + size - AesCbc::BLOCK_SIZE : nextIv, AesCbc::BLOCK_SIZE);
+            return true;
+        }
+    }
+
+    uint32_t CurrentProcessId() {
+        return static_cast<uint32_t>(getpid());
+    }
+
+    std::filesystem::path ToPath(const std::wstring& path) {
+        return std::filesystem::path(WideToUtf8Safe(path));
+    }
+
+    std::wstring FromPath(const std::filesystem::path& path) {
+        return Utf8ToWideSafe(path.native());
+    }
+
+    std::filesystem::path PathFromUtf8(const std::string& path) {
+        return std::filesystem::path(path);
+    }
+
+    std::string PathToUtf8(const std::filesystem::path& path) {
+        return path.native();
+    }
+
+    AesCbc::~AesCbc() {
+        if (m_algorithm) EVP_CIPHER_CTX_free(static_cast<EVP_CIPHER_CTX*>(m_algorithm));
+        if (m_key) {
+            std::memset(m_key, 0, KEY_SIZE);
+            delete[] static_cast<uint8_t*>(m_key);
+        }
+    }
+
+    bool AesCbc::Open(const uint8_t* key, size_t size) {
+        if (size != KEY_SIZE) return false;
+
+        m_algorithm = EVP_CIPHER_CTX_new();
+        if (!m_algorithm) return false;
+
+        uint8_t* copy = new uint8_t[KEY_SIZE];
+        std::memcpy(copy, key, KEY_SIZE);
+        m_key = copy;
+        return true;
+    }
+
+    bool AesCbc::Encrypt(const uint8_t* input, size_t size, uint8_t* iv, uint8_t* output) {
+        return m_key && RunCipher(static_cast<EVP_CIPHER_CTX*>(m_algorithm), true,
+            static_cast<const uint8_t*>(m_key), input, size, iv, output);
+    }
+
+    bool AesCbc::Decrypt(const uint8_t* input, size_t size, uint8_t* iv, uint8_t* output) {
+        return m_key && RunCipher(static_cast<EVP_CIPHER_CTX*>(m_algorithm), false,
+            static_cast<const uint8_t*>(m_key), input, size, iv, output);
+    }
+#endif
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <filesystem>
+#include <cstdint>
+#include <cstddef>
+
+namespace MakeAppxCore {
+
+    // The few operating system services the core needs. Win32 (and BCrypt) on Windows,
+    // POSIX and OpenSSL elsewhere. Modules with their own Win32 code paths (MappedFile, FileWriter,
+    // DirectoryWatcher, Sha256 and the console entry point) include Windows.h behind _WIN32 themselves.
+    std::string WideToUtf8Safe(const std::wstring& wstr);
+    std::wstring Utf8ToWideSafe(const std::string& str);
+    uint32_t CurrentProcessId();
+
+    // Paths cross the API as wide strings. std::filesystem converts those through the "C" locale on
+    // POSIX, which rejects anything outside ASCII, so conversions go through UTF-8 explicitly there.
+    std::filesystem::path ToPath(const std::wstring& path);
+    std::wstring FromPath(const std::filesystem::path& path);
+
+    // Internally paths and entry names are UTF-8. On POSIX that is the native encoding and these
+    // convert nothing; on Windows they transcode at the point where a path meets the file system.
+    std::filesystem::path PathFromUtf8(const std::string& path);
+    std::string PathToUtf8(const std::filesystem::path& path);
+
+    // AES-256 in CBC mode without padding. Like BCryptEncrypt, each call advances the IV in place,
+    // so a stream can be processed in consecutive chunks of whole blocks.
+    class AesCbc {
+    private:
+        void* m_algorithm = nullptr;
+        void* m_key = nullptr;
+
+    public:
+        static constexpr size_t KEY_SIZE = 32;
+        static constexpr size_t BLOCK_SIZE = 16;
+
+        AesCbc() = default;
+        ~AesCbc();
+
+        AesCbc(const AesCbc&) = delete;
+        AesCbc& operator=(const AesCbc&) = delete;
+
+        bool Open(const uint8_t* key, size_t size);
+        bool Encrypt(const uint8_t* input, size_t size, uint8_t* iv, uint8_t* output);
+        bool Decrypt(const uint8_t* input, size_t size, uint8_t* iv, uint8_t* output);
+    };
+}
@@ -0,0 +1,120 @@
+// Scheduling overhead of the task scheduler on a tiny-file workload: every task checksums a few hundred
+// bytes, the way a package of a million small files gives each stage a million small jobs. The inline
+// loop is the cost of the work alone; on a single core, the difference to it is the cost per task.
+//
+// Usage: SchedulerBenchmark [tasks] [bytes per task]
+
+#include "Crc32.h"
+#include "TaskScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MakeAppxCore;
+
+namespace {
+    size_t g_tasks = 1000000;
+    size_t g_payload = 256;
+    std::vector<uint8_t> g_data;
+    std::vector<uint32_t> g_results;
+    double g_inlineNs = 0;
+
+    void Work(size_t index) {
+        size_t offset = (index * 64) % (g_data.size() - g_payload);
+        g_results[index] = Crc32(0, g_data.data() + offset, g_payload);
+    }
+
+    void Report(const char* name, const std::function<void()>& run) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        double perTask = ns / static_cast<double>(g_tasks);
+        if (g_inlineNs == 0) g_inlineNs = perTask;
+        printf("  %-34s %9.1f ms %9.1f ns/task %+9.1f ns\n", name, ns / 1e6, perTask, perTask - g_inlineNs);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) g_tasks = std::strtoull(argv[1], nullptr, 10);
+    if (argc > 2) g_payload = std::strtoull(argv[2], nullptr, 10);
+    if (g_tasks == 0) g_tasks = 1;
+
+    g_data.resize(64 * 1024 + g_payload + 1);
+    for (size_t i = 0; i < g_data.size(); ++i) {
+        g_data[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    g_results.resize(g_tasks);
+
+    TaskScheduler& scheduler = TaskScheduler::Shared();
+    size_t cpuThreads = scheduler.ThreadCount(TaskClass::Cpu);
+    printf("%zu tasks of %zu bytes, %zu CPU and %zu I/O workers\n", g_tasks, g_payload,
+        cpuThreads, scheduler.ThreadCount(TaskClass::Io));
+    printf("  %-34s %12s %17s %12s\n", "", "total", "per task", "vs inline");
+
+    // Starts the worker threads, so no run pays for creating them.
+    {
+        TaskGroup cpu(TaskClass::Cpu), io(TaskClass::Io);
+        cpu.Run([]() {});
+        io.Run([]() {});
+    }
+
+    Report("inline", []() {
+        for (size_t i = 0; i < g_tasks; ++i) Work(i);
+    });
+
+    Report("ad-hoc threads, shared index", [cpuThreads]() {
+        std::atomic<size_t> next{ 0 };
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < cpuThreads; ++t) {
+            threads.emplace_back([&next]() {
+                size_t i;
+                while ((i = next.fetch_add(1)) < g_tasks) Work(i);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    });
+
+    Report("CPU tasks", []() {
+        TaskGroup group(TaskClass::Cpu);
+        for (size_t i = 0; i < g_tasks; ++i) {
+            group.Run([i]() { Work(i); }, g_payload);
+        }
+        group.Wait();
+    });
+
+    Report("CPU tasks, submitted by a worker", []() {
+        TaskGroup group(TaskClass::Cpu);
+        group.Run([&group]() {
+            for (size_t i = 0; i < g_tasks; ++i) {
+                group.Run([i]() { Work(i); }, g_payload);
+            }
+        });
+        group.Wait();
+    });
+
+    Report("CPU tasks, at most 2 at once", []() {
+        TaskGroup group(TaskClass::Cpu, 2);
+        for (size_t i = 0; i < g_tasks; ++i) {
+            group.Run([i]() { Work(i); }, g_payload);
+        }
+        group.Wait();
+    });
+
+    Report("I/O tasks", []() {
+        TaskGroup group(TaskClass::Io);
+        for (size_t i = 0; i < g_tasks; ++i) {
+            group.Run([i]() { Work(i); }, g_payload);
+        }
+        group.Wait();
+    });
+
+    uint64_t check = 0;
+    for (uint32_t result : g_results) check += result;
+    printf("checksum %016llx\n", static_cast<unsigned long long>(check));
+    return 0;
+}
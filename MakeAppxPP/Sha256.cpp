@@ -0,0 +1,124 @@
+#include "Sha256.h"
+#include <stdexcept>
+#ifdef _WIN32
+#include <Windows.h>
+#include <bcrypt.h>
+#pragma comment(lib, "bcrypt.lib")
+#else
+#include <openssl/evp.h>
+#endif
+
+namespace MakeAppxCore {
+
+#ifdef _WIN32
+    namespace {
+
+        BCRYPT_ALG_HANDLE GetSha256Provider() {
+            static BCRYPT_ALG_HANDLE provider = [] {
+                BCRYPT_ALG_HANDLE handle = nullptr;
+                if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&handle, BCRYPT_SHA256_ALGORITHM,
+                    nullptr, BCRYPT_HASH_REUSABLE_FLAG))) {
+                    handle = nullptr;
+                }
+                return handle;
+            }();
+            return provider;
+        }
+    }
+
+    Sha256::Sha256() {
+        BCRYPT_ALG_HANDLE provider = GetSha256Provider();
+        BCRYPT_HASH_HANDLE hash = nullptr;
+        if (!provider || !BCRYPT_SUCCESS(BCryptCreateHash(provider, &hash, nullptr, 0,
+            nullptr, 0, BCRYPT_HASH_REUSABLE_FLAG))) {
+            throw std::runtime_error("Failed to create SHA-256 hash object");
+        }
+        m_hash = hash;
+    }
+
+    Sha256::~Sha256() {
+        if (m_hash) {
+            BCryptDestroyHash(static_cast<BCRYPT_HASH_HANDLE>(m_hash));
+        }
+    }
+
+    void Sha256::Update(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            ULONG chunk = static_cast<ULONG>(size > 0x40000000 ? 0x40000000 : size);
+            BCryptHashData(static_cast<BCRYPT_HASH_HANDLE>(m_hash), const_cast<PUCHAR>(bytes), chunk, 0);
+            bytes += chunk;
+            size -= chunk;
+        }
+    }
+
+    Sha256::Digest Sha256::Finish() {
+        Digest digest = {};
+        BCryptFinishHash(static_cast<BCRYPT_HASH_HANDLE>(m_hash), digest.data(),
+            static_cast<ULONG>(digest.size()), 0);
+        return digest;
+    }
+
+#else
+    Sha256::Sha256() {
+        EVP_MD_CTX* context = EVP_MD_CTX_new();
+        if (!context || EVP_DigestInit_ex(context, EVP_sha256(), nullptr) != 1) {
+            EVP_MD_CTX_free(context);
+            throw std::runtime_error("Failed to create SHA-256 hash object");
+        }
+        m_hash = context;
+    }
+
+    Sha256::~Sha256() {
+        EVP_MD_CTX_free(static_cast<EVP_MD_CTX*>(m_hash));
+    }
+
+    void Sha256::Update(const void* data, size_t size) {
+        EVP_DigestUpdate(static_cast<EVP_MD_CTX*>(m_hash), data, size);
+    }
+
+    Sha256::Digest Sha256::Finish() {
+        Digest digest = {};
+        EVP_MD_CTX* context = static_cast<EVP_MD_CTX*>(m_hash);
+        EVP_DigestFinal_ex(context, digest.data(), nullptr);
+        EVP_DigestInit_ex(context, EVP_sha256(), nullptr);
+        return digest;
+    }
+#endif
+
+    Sha256::Digest Sha256::Hash(const void* data, size_t size) {
+        Sha256 hasher;
+        hasher.Update(data, size);
+        return hasher.Finish();
+    }
+
+    std::string Sha256::ToHex(const Digest& digest) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(digest.size() * 2);
+        for (uint8_t byte : digest) {
+            hex += digits[byte >> 4];
+            hex += digits[byte & 0x0F];
+        }
+        return hex;
+    }
+
+    bool Sha256::FromHex(const std::string& hex, Digest& digest) {
+        if (hex.size() != DIGEST_SIZE * 2) return false;
+
+        auto nibble = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        };
+
+        for (size_t i = 0; i < DIGEST_SIZE; ++i) {
+            int high = nibble(hex[i * 2]);
+            int low = nibble(hex[i * 2 + 1]);
+            if (high < 0 || low < 0) return false;
+            digest[i] = static_cast<uint8_t>((high << 4) | low);
+        }
+        return true;
+    }
+}
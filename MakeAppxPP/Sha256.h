@@ -0,0 +1,29 @@
+#pragma once
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace MakeAppxCore {
+
+    class Sha256 {
+    public:
+        static constexpr size_t DIGEST_SIZE = 32;
+        using Digest = std::array<uint8_t, DIGEST_SIZE>;
+
+        Sha256();
+        ~Sha256();
+        Sha256(const Sha256&) = delete;
+        Sha256& operator=(const Sha256&) = delete;
+
+        void Update(const void* data, size_t size);
+        Digest Finish();
+
+        static Digest Hash(const void* data, size_t size);
+        static std::string ToHex(const Digest& digest);
+        static bool FromHex(const std::string& hex, Digest& digest);
+
+    private:
+        void* m_hash = nullptr;
+    };
+}
@@ -0,0 +1,253 @@
+#include "TaskScheduler.h"
+#include "BufferPool.h"
+#include <algorithm>
+
+namespace MakeAppxCore {
+
+    namespace {
+        // The worker the current thread is, if any. Submissions from a worker go to its own deque.
+        thread_local const TaskScheduler* t_scheduler = nullptr;
+        thread_local size_t t_pool = 0;
+        thread_local size_t t_worker = 0;
+
+        // How long a helping worker sleeps when there is nothing to run while its tasks finish elsewhere.
+        constexpr std::chrono::milliseconds HELP_WAIT(1);
+    }
+
+    TaskScheduler::TaskScheduler(size_t cpuThreads, size_t ioThreads) {
+        size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+        m_pools[0].threadCount = cpuThreads ? cpuThreads : cores;
+        m_pools[1].threadCount = ioThreads ? ioThreads : std::clamp<size_t>(cores * 4, 8, 64);
+
+        for (auto& pool : m_pools) {
+            for (size_t i = 0; i < pool.threadCount; ++i) {
+                pool.workers.push_back(std::make_unique<Worker>());
+            }
+        }
+    }
+
+    // Queued tasks still run before the threads exit.
+    TaskScheduler::~TaskScheduler() {
+        m_stopping = true;
+        for (auto& pool : m_pools) {
+            {
+                std::lock_guard<std::mutex> lock(pool.mutex);
+            }
+            pool.available.notify_all();
+            for (auto& thread : pool.threads) {
+                thread.join();
+            }
+        }
+    }
+
+    TaskScheduler& TaskScheduler::Shared() {
+        // Tasks running at exit still use the buffer pool, so it has to be destroyed after the scheduler.
+        BufferPool::Shared();
+        static TaskScheduler scheduler;
+        return scheduler;
+    }
+
+    // Threads start on first use, so a process that never compresses never has compression threads.
+    void TaskScheduler::Start(Pool& pool) {
+        std::call_once(pool.started, [this, &pool] {
+            for (size_t i = 0; i < pool.threadCount; ++i) {
+                pool.threads.emplace_back(&TaskScheduler::WorkerLoop, this, std::ref(pool), i);
+            }
+        });
+    }
+
+    size_t TaskScheduler::CurrentWorker(TaskClass taskClass) const {
+        size_t index = taskClass == TaskClass::Io ? 1 : 0;
+        if (t_scheduler != this || t_pool != index) return m_pools[index].threadCount;
+        return t_worker;
+    }
+
+    void TaskScheduler::Submit(TaskClass taskClass, uint64_t weight, std::function<void()> task, TaskGroup* group) {
+        Pool& pool = PoolOf(taskClass);
+        Start(pool);
+
+        size_t index = CurrentWorker(taskClass);
+        if (index >= pool.threadCount) {
+            index = pool.next.fetch_add(1, std::memory_order_relaxed) % pool.threadCount;
+        }
+
+        pool.queued.fetch_add(1);
+        {
+            Worker& worker = *pool.workers[index];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (weight >= LARGE_TASK) {
+                worker.tasks.push_front({ std::move(task), group });
+            }
+            else {
+                worker.tasks.push_back({ std::move(task), group });
+            }
+        }
+
+        // A worker that is awake and looking for work takes this task or wakes the next worker itself.
+        // Workers count themselves as sleeping before they look at the queue, so one of the two sees the other.
+        if (pool.searching == 0 && pool.sleeping > 0) {
+            Wake(pool);
+        }
+    }
+
+    void TaskScheduler::Wake(Pool& pool) {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.sleeping > pool.wakeups) {
+            ++pool.wakeups;
+            ++pool.searching;
+            pool.available.notify_one();
+        }
+    }
+
+    // Own deque first, then the others in turn. The front of every deque holds the most urgent task,
+    // so thieves take from the front as well.
+    bool TaskScheduler::Take(Pool& pool, size_t first, Task& task) {
+        size_t count = pool.workers.size();
+        for (size_t i = 0; i < count; ++i) {
+            Worker& worker = *pool.workers[(first + i) % count];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.tasks.empty()) continue;
+
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            pool.queued.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    void TaskScheduler::Execute(Task& task) {
+        TaskGroup* group = task.group;
+        {
+            // Whatever the task captured goes before the group hears it has finished.
+            std::function<void()> run = std::move(task.run);
+            run();
+        }
+        if (group) {
+            group->Finished();
+        }
+    }
+
+    bool TaskScheduler::RunPending() {
+        if (t_scheduler != this) return false;
+
+        Task task;
+        if (!Take(m_pools[t_pool], t_worker, task)) return false;
+        Execute(task);
+        return true;
+    }
+
+    void TaskScheduler::WorkerLoop(Pool& pool, size_t index) {
+        t_scheduler = this;
+        t_pool = static_cast<size_t>(&pool - m_pools);
+        t_worker = index;
+
+        Task task;
+        bool searching = false;
+        while (true) {
+            if (Take(pool, index, task)) {
+                // Only the last searcher to find work wakes another, so a burst of submissions brings the
+                // workers up one after the other instead of waking one per task.
+                if (searching) {
+                    searching = false;
+                    if (pool.searching.fetch_sub(1) == 1 && pool.queued > 0) {
+                        Wake(pool);
+                    }
+                }
+                Execute(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(pool.mutex);
+            if (searching) {
+                searching = false;
+                pool.searching.fetch_sub(1);
+            }
+            pool.sleeping.fetch_add(1);
+            pool.available.wait(lock, [this, &pool] { return m_stopping || pool.wakeups > 0 || pool.queued > 0; });
+            pool.sleeping.fetch_sub(1);
+            if (m_stopping && pool.queued == 0) return;
+
+            if (pool.wakeups > 0) {
+                --pool.wakeups;
+            }
+            else {
+                pool.searching.fetch_add(1);
+            }
+            searching = true;
+        }
+    }
+
+    TaskGroup::TaskGroup(TaskClass taskClass, size_t concurrency, TaskScheduler& scheduler)
+        : m_scheduler(scheduler), m_class(taskClass),
+        m_limit(concurrency < scheduler.ThreadCount(taskClass) ? concurrency : 0) {
+    }
+
+    TaskGroup::~TaskGroup() {
+        Wait();
+    }
+
+    void TaskGroup::Run(std::function<void()> task, uint64_t weight) {
+        m_pending.fetch_add(1);
+        if (m_limit) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_running >= m_limit) {
+                m_held.push({ weight, m_sequence++, std::move(task) });
+                return;
+            }
+            ++m_running;
+        }
+        m_scheduler.Submit(m_class, weight, std::move(task), this);
+    }
+
+    void TaskGroup::Finished() {
+        if (m_limit) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_held.empty()) {
+                HeldTask next = std::move(const_cast<HeldTask&>(m_held.top()));
+                m_held.pop();
+                lock.unlock();
+                m_scheduler.Submit(m_class, next.weight, std::move(next.run), this);
+            }
+            else {
+                --m_running;
+            }
+        }
+
+        // The last task finishes under the lock: a waiter that sees nothing pending may destroy the group
+        // as soon as it gets the lock.
+        size_t pending = m_pending;
+        while (pending > 1) {
+            if (m_pending.compare_exchange_weak(pending, pending - 1)) return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.fetch_sub(1) == 1) {
+            m_done.notify_all();
+        }
+    }
+
+    void TaskGroup::Wait() {
+        while (!WaitFor(std::chrono::hours(1))) {
+        }
+    }
+
+    bool TaskGroup::WaitFor(std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // A worker waiting on tasks of its own class runs them itself; blocking could leave no worker
+        // free to run them.
+        if (m_scheduler.CurrentWorker(m_class) < m_scheduler.ThreadCount(m_class)) {
+            while (m_pending > 0 && std::chrono::steady_clock::now() < deadline) {
+                lock.unlock();
+                bool ran = m_scheduler.RunPending();
+                lock.lock();
+                if (!ran) {
+                    m_done.wait_for(lock, HELP_WAIT, [this] { return m_pending == 0; });
+                }
+            }
+            return m_pending == 0;
+        }
+        return m_done.wait_until(lock, deadline, [this] { return m_pending == 0; });
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    class TaskGroup;
+
+    // CPU tasks get one thread per core. I/O tasks mostly wait on the disk, so they have a larger set of
+    // threads of their own and never keep compression from running.
+    enum class TaskClass {
+        Cpu,
+        Io
+    };
+
+    // The worker threads behind every parallel stage of the engines. Each worker owns a deque: it runs its
+    // own tasks first and steals from the other workers of its class once it runs dry. Tasks weighing at
+    // least LARGE_TASK bytes go to the front, so big files start first instead of finishing last.
+    class TaskScheduler {
+    private:
+        struct Task {
+            std::function<void()> run;
+            TaskGroup* group = nullptr;
+        };
+
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        struct Pool {
+            size_t threadCount = 0;
+            std::vector<std::unique_ptr<Worker>> workers;
+            std::vector<std::thread> threads;
+            std::once_flag started;
+            std::mutex mutex;
+            std::condition_variable available;
+            std::atomic<size_t> queued{ 0 };
+            std::atomic<size_t> sleeping{ 0 };
+            std::atomic<size_t> searching{ 0 };
+            std::atomic<size_t> next{ 0 };
+            size_t wakeups = 0;
+        };
+
+        Pool m_pools[2];
+        std::atomic<bool> m_stopping{ false };
+
+        Pool& PoolOf(TaskClass taskClass) { return m_pools[taskClass == TaskClass::Io ? 1 : 0]; }
+        void Start(Pool& pool);
+        void Wake(Pool& pool);
+        bool Take(Pool& pool, size_t first, Task& task);
+        void Execute(Task& task);
+        void WorkerLoop(Pool& pool, size_t index);
+
+    public:
+        static constexpr uint64_t LARGE_TASK = 1 << 20;
+
+        explicit TaskScheduler(size_t cpuThreads = 0, size_t ioThreads = 0);
+        ~TaskScheduler();
+
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+        static TaskScheduler& Shared();
+
+        size_t ThreadCount(TaskClass taskClass) const { return m_pools[taskClass == TaskClass::Io ? 1 : 0].threadCount; }
+
+        // Index of the calling thread among the workers of its class, for per-worker state; ThreadCount when
+        // the caller is not a worker of this scheduler. Tasks only ever run on workers of their own class.
+        size_t CurrentWorker(TaskClass taskClass) const;
+
+        void Submit(TaskClass taskClass, uint64_t weight, std::function<void()> task, TaskGroup* group = nullptr);
+
+        // Runs one queued task on the calling worker thread, if there is one. Lets a task wait for others
+        // without holding up the worker it runs on.
+        bool RunPending();
+    };
+
+    // Tasks of one stage, waited for together. A concurrency limit keeps the stage within its buffer
+    // budget: the group then holds tasks back, heaviest first, until one of its running tasks finishes.
+    // Tasks must not throw. The destructor waits for the tasks still running.
+    class TaskGroup {
+    private:
+        friend class TaskScheduler;
+
+        struct HeldTask {
+            uint64_t weight;
+            uint64_t sequence;
+            std::function<void()> run;
+        };
+
+        struct Lighter {
+            bool operator()(const HeldTask& a, const HeldTask& b) const {
+                return a.weight != b.weight ? a.weight < b.weight : a.sequence > b.sequence;
+            }
+        };
+
+        TaskScheduler& m_scheduler;
+        TaskClass m_class;
+        size_t m_limit;
+        std::atomic<size_t> m_pending{ 0 };
+        std::mutex m_mutex;
+        std::condition_variable m_done;
+        size_t m_running = 0;
+        uint64_t m_sequence = 0;
+        std::priority_queue<HeldTask, std::vector<HeldTask>, Lighter> m_held;
+
+        void Finished();
+
+    public:
+        explicit TaskGroup(TaskClass taskClass = TaskClass::Cpu, size_t concurrency = 0,
+            TaskScheduler& scheduler = TaskScheduler::Shared());
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        TaskScheduler& Scheduler() const { return m_scheduler; }
+        size_t Concurrency() const { return m_limit ? m_limit : m_scheduler.ThreadCount(m_class); }
+
+        void Run(std::function<void()> task, uint64_t weight = 0);
+        void Wait();
+
+        // Returns true once every task has finished, false when the timeout passes first.
+        bool WaitFor(std::chrono::milliseconds timeout);
+    };
+}
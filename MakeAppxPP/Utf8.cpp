@@ -0,0 +1,229 @@
+#include "Utf8.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define UTF8_SSE2 1
+#include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define UTF8_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr bool WIDE_IS_UTF16 = sizeof(wchar_t) == 2;
+        constexpr uint32_t REPLACEMENT = 0xFFFD;
+
+        // Widens 16 ASCII bytes, returning false (and writing nothing) if any byte is not ASCII.
+        inline bool WidenAscii16(const char* input, wchar_t* output) {
+#if defined(UTF8_SSE2)
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+            if (_mm_movemask_epi8(bytes) != 0) return false;
+
+            const __m128i zero = _mm_setzero_si128();
+            __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            if constexpr (WIDE_IS_UTF16) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output), low);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 8), high);
+            }
+            else {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(low, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi16(low, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 8), _mm_unpacklo_epi16(high, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 12), _mm_unpackhi_epi16(high, zero));
+            }
+            return true;
+#elif defined(UTF8_NEON)
+            uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(input));
+            if (vmaxvq_u8(bytes) >= 0x80) return false;
+
+            uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+            uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+            if constexpr (WIDE_IS_UTF16) {
+                vst1q_u16(reinterpret_cast<uint16_t*>(output), low);
+                vst1q_u16(reinterpret_cast<uint16_t*>(output + 8), high);
+            }
+            else {
+                uint32_t* out = reinterpret_cast<uint32_t*>(output);
+                vst1q_u32(out, vmovl_u16(vget_low_u16(low)));
+                vst1q_u32(out + 4, vmovl_u16(vget_high_u16(low)));
+                vst1q_u32(out + 8, vmovl_u16(vget_low_u16(high)));
+                vst1q_u32(out + 12, vmovl_u16(vget_high_u16(high)));
+            }
+            return true;
+#else
+            uint64_t words[2];
+            std::memcpy(words, input, sizeof(words));
+            if (((words[0] | words[1]) & 0x8080808080808080ull) != 0) return false;
+            for (size_t i = 0; i < 16; ++i) {
+                output[i] = static_cast<wchar_t>(input[i]);
+            }
+            return true;
+#endif
+        }
+
+        // Narrows 8 ASCII wide characters, returning false (and writing nothing) if any is not ASCII.
+        inline bool NarrowAscii8(const wchar_t* input, char* output) {
+#if defined(UTF8_SSE2)
+            __m128i packed;
+            if constexpr (WIDE_IS_UTF16) {
+                packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(packed, _mm_set1_epi16(static_cast<short>(0xFF80))),
+                    _mm_setzero_si128())) != 0xFFFF) return false;
+            }
+            else {
+                __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+                __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 4));
+                __m128i mask = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+                __m128i outside = _mm_or_si128(_mm_and_si128(low, mask), _mm_and_si128(high, mask));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(outside, _mm_setzero_si128())) != 0xFFFF) return false;
+                packed = _mm_packs_epi32(low, high);
+            }
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(packed, packed));
+            return true;
+#elif defined(UTF8_NEON)
+            uint16x8_t packed;
+            if constexpr (WIDE_IS_UTF16) {
+                packed = vld1q_u16(reinterpret_cast<const uint16_t*>(input));
+            }
+            else {
+                const uint32_t* in = reinterpret_cast<const uint32_t*>(input);
+                uint32x4_t low = vld1q_u32(in);
+                uint32x4_t high = vld1q_u32(in + 4);
+                if (vmaxvq_u32(vorrq_u32(low, high)) >= 0x80) return false;
+                packed = vcombine_u16(vmovn_u32(low), vmovn_u32(high));
+            }
+            if (vmaxvq_u16(packed) >= 0x80) return false;
+            vst1_u8(reinterpret_cast<uint8_t*>(output), vmovn_u16(packed));
+            return true;
+#else
+            for (size_t i = 0; i < 8; ++i) {
+                if (static_cast<uint32_t>(input[i]) >= 0x80) return false;
+            }
+            for (size_t i = 0; i < 8; ++i) {
+                output[i] = static_cast<char>(input[i]);
+            }
+            return true;
+#endif
+        }
+
+        inline char* AppendUtf8(char* out, uint32_t code) {
+            if (code < 0x80) {
+                *out++ = static_cast<char>(code);
+            }
+            else if (code < 0x800) {
+                *out++ = static_cast<char>(0xC0 | (code >> 6));
+                *out++ = static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000) {
+                *out++ = static_cast<char>(0xE0 | (code >> 12));
+                *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else {
+                *out++ = static_cast<char>(0xF0 | (code >> 18));
+                *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (code & 0x3F));
+            }
+            return out;
+        }
+
+        inline wchar_t* AppendWide(wchar_t* out, uint32_t code) {
+            if (WIDE_IS_UTF16 && code >= 0x10000) {
+                code -= 0x10000;
+                *out++ = static_cast<wchar_t>(0xD800 | (code >> 10));
+                *out++ = static_cast<wchar_t>(0xDC00 | (code & 0x3FF));
+            }
+            else {
+                *out++ = static_cast<wchar_t>(code);
+            }
+            return out;
+        }
+    }
+
+    bool TranscodeUtf8ToWide(const char* data, size_t size, std::wstring& output) {
+        // Every code unit of the result consumes at least one input byte.
+        output.resize(size);
+        wchar_t* out = &output[0];
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* end = p + size;
+        bool valid = true;
+
+        while (p < end) {
+            while (end - p >= 16 && WidenAscii16(reinterpret_cast<const char*>(p), out)) {
+                p += 16;
+                out += 16;
+            }
+            if (p == end) break;
+
+            uint32_t code = *p;
+            if (code < 0x80) {
+                *out++ = static_cast<wchar_t>(code);
+                ++p;
+                continue;
+            }
+
+            size_t length = (code >> 5) == 0x6 ? 2 : (code >> 4) == 0xE ? 3 : (code >> 3) == 0x1E ? 4 : 0;
+            if (length == 0 || static_cast<size_t>(end - p) < length) {
+                *out++ = static_cast<wchar_t>(REPLACEMENT);
+                valid = false;
+                ++p;
+                continue;
+            }
+
+            code &= 0x7F >> length;
+            size_t i = 1;
+            for (; i < length && (p[i] & 0xC0) == 0x80; ++i) {
+                code = (code << 6) | (p[i] & 0x3F);
+            }
+            static const uint32_t minimum[] = { 0, 0, 0x80, 0x800, 0x10000 };
+            if (i < length || code < minimum[length] || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+                *out++ = static_cast<wchar_t>(REPLACEMENT);
+                valid = false;
+                p += i;
+                continue;
+            }
+
+            out = AppendWide(out, code);
+            p += length;
+        }
+
+        output.resize(static_cast<size_t>(out - output.data()));
+        return valid;
+    }
+
+    bool TranscodeWideToUtf8(const wchar_t* data, size_t size, std::string& output) {
+        // A UTF-16 unit needs at most 3 bytes (a surrogate pair 4 for 2 units); a UTF-32 unit at most 4.
+        output.resize(size * (WIDE_IS_UTF16 ? 3 : 4));
+        char* out = &output[0];
+        const wchar_t* p = data;
+        const wchar_t* end = data + size;
+        bool valid = true;
+
+        while (p < end) {
+            while (end - p >= 8 && NarrowAscii8(p, out)) {
+                p += 8;
+                out += 8;
+            }
+            if (p == end) break;
+
+            uint32_t code = static_cast<uint32_t>(*p++);
+            if (WIDE_IS_UTF16 && code >= 0xD800 && code <= 0xDBFF && p < end &&
+                static_cast<uint32_t>(*p) >= 0xDC00 && static_cast<uint32_t>(*p) <= 0xDFFF) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (static_cast<uint32_t>(*p++) - 0xDC00);
+            }
+            else if (code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+                code = REPLACEMENT;
+                valid = false;
+            }
+            out = AppendUtf8(out, code);
+        }
+
+        output.resize(static_cast<size_t>(out - output.data()));
+        return valid;
+    }
+}
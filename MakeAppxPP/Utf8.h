@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace MakeAppxCore {
+
+    // Transcodes between UTF-8 and wchar_t strings (UTF-16 on Windows, UTF-32 elsewhere).
+    // Runs of ASCII are validated and widened or narrowed 16 characters at a time.
+    // Malformed input is replaced with U+FFFD; the result reports whether any was found.
+    bool TranscodeUtf8ToWide(const char* data, size_t size, std::wstring& output);
+    bool TranscodeWideToUtf8(const wchar_t* data, size_t size, std::string& output);
+}
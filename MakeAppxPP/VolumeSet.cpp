@@ -0,0 +1,227 @@
+#include "VolumeSet.h"
+#include "Platform.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace MakeAppxCore {
+
+    fs::path VolumePath(const fs::path& packagePath, size_t number) {
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%03zu", number);
+        fs::path path = packagePath;
+        path += suffix;
+        return path;
+    }
+
+    bool FindVolumes(const fs::path& path, std::vector<fs::path>& volumes) {
+        volumes.clear();
+        std::error_code ec;
+        fs::path packagePath;
+        if (path.extension() == ".001" && fs::is_regular_file(path, ec)) {
+            packagePath = path;
+            packagePath.replace_extension();
+        }
+        else if (!fs::exists(path, ec) && fs::is_regular_file(VolumePath(path, 1), ec)) {
+            packagePath = path;
+        }
+        else {
+            return false;
+        }
+
+        for (size_t number = 1; fs::is_regular_file(VolumePath(packagePath, number), ec); ++number) {
+            volumes.push_back(VolumePath(packagePath, number));
+        }
+        return true;
+    }
+
+    VolumeWriter::VolumeWriter(const fs::path& packagePath, uint64_t volumeSize)
+        : m_packagePath(packagePath), m_volumeSize(volumeSize) {
+        m_buffer.reserve(BUFFER_SIZE);
+    }
+
+    VolumeWriter::~VolumeWriter() {
+        Stop();
+        if (m_closed) return;
+
+        m_volume.close();
+        std::error_code ec;
+        for (size_t number = 1; number <= m_volumeCount; ++number) {
+            fs::remove(VolumePath(m_packagePath, number), ec);
+        }
+    }
+
+    void VolumeWriter::Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_closed) {
+                m_failed = true;
+            }
+        }
+        m_changed.notify_all();
+        m_drain.Wait();
+    }
+
+    // Runs until the queue is empty; Submit starts a new drain for the next buffer.
+    void VolumeWriter::Drain() {
+        while (true) {
+            std::vector<uint8_t> buffer;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_failed || m_queue.empty()) {
+                    m_draining = false;
+                    m_changed.notify_all();
+                    return;
+                }
+                buffer = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            bool written = WriteVolumes(buffer.data(), buffer.size());
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                buffer.clear();
+                m_spare.push_back(std::move(buffer));
+                if (!written) {
+                    m_failed = true;
+                }
+            }
+            m_changed.notify_all();
+        }
+    }
+
+    bool VolumeWriter::WriteVolumes(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            if (!m_volume.is_open()) {
+                fs::path path = VolumePath(m_packagePath, m_volumeCount + 1);
+                m_volume.open(path, std::ios::binary | std::ios::trunc);
+                if (!m_volume.is_open()) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_lastError = L"Cannot create volume: " + FromPath(path);
+                    return false;
+                }
+                ++m_volumeCount;
+                m_volumeUsed = 0;
+            }
+
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, m_volumeSize - m_volumeUsed));
+            m_volume.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(chunk));
+            m_volumeUsed += chunk;
+            if (m_volumeUsed == m_volumeSize) {
+                m_volume.close();
+            }
+            if (m_volume.fail()) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_lastError = L"Failed to write volume: " + FromPath(VolumePath(m_packagePath, m_volumeCount));
+                return false;
+            }
+            data += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+
+    bool VolumeWriter::Submit() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return m_failed || m_queue.size() < MAX_QUEUED; });
+        if (m_failed) return false;
+
+        m_queue.push_back(std::move(m_buffer));
+        if (!m_spare.empty()) {
+            m_buffer = std::move(m_spare.back());
+            m_spare.pop_back();
+        }
+        else {
+            m_buffer = std::vector<uint8_t>();
+            m_buffer.reserve(BUFFER_SIZE);
+        }
+
+        if (!m_draining) {
+            m_draining = true;
+            lock.unlock();
+            m_drain.Run([this]() { Drain(); });
+        }
+        return true;
+    }
+
+    bool VolumeWriter::Write(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            size_t chunk = std::min(size, BUFFER_SIZE - m_buffer.size());
+            m_buffer.insert(m_buffer.end(), data, data + chunk);
+            data += chunk;
+            size -= chunk;
+            if (m_buffer.size() == BUFFER_SIZE && !Submit()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool VolumeWriter::Close() {
+        if (m_closed) return true;
+        if (!m_buffer.empty() && !Submit()) {
+            Stop();
+            return false;
+        }
+
+        m_drain.Wait();
+        if (m_failed) return false;
+
+        if (m_volume.is_open()) {
+            m_volume.close();
+            if (m_volume.fail()) {
+                m_lastError = L"Failed to write volume: " + FromPath(VolumePath(m_packagePath, m_volumeCount));
+                return false;
+            }
+        }
+
+        // A previous, longer split of the same package would otherwise leave volumes that no longer belong.
+        std::error_code ec;
+        size_t stale = m_volumeCount + 1;
+        while (fs::remove(VolumePath(m_packagePath, stale), ec)) {
+            ++stale;
+        }
+        m_closed = true;
+        return true;
+    }
+
+    bool VolumeSource::Open(const std::vector<fs::path>& volumes) {
+        m_volumes.clear();
+        m_starts.clear();
+        m_size = 0;
+
+        for (const auto& path : volumes) {
+            auto volume = std::make_unique<MappedFile>();
+            if (!volume->Open(path)) {
+                m_lastError = volume->GetLastError();
+                return false;
+            }
+            m_starts.push_back(m_size);
+            m_size += volume->Size();
+            m_volumes.push_back(std::move(volume));
+        }
+        return !m_volumes.empty();
+    }
+
+    size_t VolumeSource::VolumeOf(uint64_t offset) const {
+        auto next = std::upper_bound(m_starts.begin(), m_starts.end(), offset);
+        return static_cast<size_t>(next - m_starts.begin()) - 1;
+    }
+
+    bool VolumeSource::ReadAt(uint64_t offset, void* buffer, size_t size) {
+        if (offset > m_size || size > m_size - offset) return false;
+
+        uint8_t* out = static_cast<uint8_t*>(buffer);
+        size_t volume = size > 0 ? VolumeOf(offset) : 0;
+        while (size > 0) {
+            uint64_t inVolume = offset - m_starts[volume];
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, m_volumes[volume]->Size() - inVolume));
+            memcpy(out, m_volumes[volume]->Data() + inVolume, chunk);
+            out += chunk;
+            offset += chunk;
+            size -= chunk;
+            ++volume;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "MappedFile.h"
+#include "TaskScheduler.h"
+#include "ZipDirectory.h"
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MakeAppxCore {
+
+    namespace fs = std::filesystem;
+
+    // A split package is stored as <package>.001, <package>.002 and so on; concatenated in order, the
+    // volumes are the package, so any of them can be joined with cat or copy /b.
+    fs::path VolumePath(const fs::path& packagePath, size_t number);
+
+    // Accepts either the package path or the path of its first volume and lists the volumes in order.
+    bool FindVolumes(const fs::path& path, std::vector<fs::path>& volumes);
+
+    // Cuts a byte stream into volumes of at most volumeSize bytes. Full buffers are written by an I/O task,
+    // one at a time and in order, so the producer keeps compressing while data goes to disk.
+    // Unless Close succeeds, the volumes written so far are removed again.
+    class VolumeWriter {
+    private:
+        static constexpr size_t BUFFER_SIZE = 1 << 20;
+        static constexpr size_t MAX_QUEUED = 8;
+
+        fs::path m_packagePath;
+        uint64_t m_volumeSize;
+        std::vector<uint8_t> m_buffer;
+        std::deque<std::vector<uint8_t>> m_queue;
+        std::vector<std::vector<uint8_t>> m_spare;
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        bool m_draining = false;
+        bool m_failed = false;
+        bool m_closed = false;
+        std::wstring m_lastError;
+
+        // Owned by the drain task while one is running.
+        std::ofstream m_volume;
+        size_t m_volumeCount = 0;
+        uint64_t m_volumeUsed = 0;
+
+        TaskGroup m_drain{ TaskClass::Io };
+
+        void Drain();
+        bool WriteVolumes(const uint8_t* data, size_t size);
+        bool Submit();
+        void Stop();
+
+    public:
+        VolumeWriter(const fs::path& packagePath, uint64_t volumeSize);
+        ~VolumeWriter();
+
+        VolumeWriter(const VolumeWriter&) = delete;
+        VolumeWriter& operator=(const VolumeWriter&) = delete;
+
+        bool Write(const uint8_t* data, size_t size);
+        bool Close();
+
+        size_t VolumeCount() const { return m_volumeCount; }
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+
+    // Reads a split package as one archive. Every volume is mapped, so reads are safe from any number of threads.
+    class VolumeSource : public RandomAccessSource {
+    private:
+        std::vector<std::unique_ptr<MappedFile>> m_volumes;
+        std::vector<uint64_t> m_starts;
+        uint64_t m_size = 0;
+        std::wstring m_lastError;
+
+    public:
+        bool Open(const std::vector<fs::path>& volumes);
+
+        uint64_t Size() const override { return m_size; }
+        bool ReadAt(uint64_t offset, void* buffer, size_t size) override;
+
+        size_t VolumeCount() const { return m_volumes.size(); }
+        size_t VolumeOf(uint64_t offset) const;
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+}
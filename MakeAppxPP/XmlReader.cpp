@@ -0,0 +1,334 @@
+#include "XmlReader.h"
+#include <cstring>
+
+namespace MakeAppxCore {
+
+    namespace {
+        bool IsXmlWhitespace(int c) {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        bool IsNameChar(int c) {
+            return c >= 0 && !IsXmlWhitespace(c) && c != '=' && c != '>' && c != '/' &&
+                c != '<' && c != '"' && c != '\'';
+        }
+
+        void AppendUtf8(std::string& target, uint32_t codePoint) {
+            if (codePoint < 0x80) {
+                target += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800) {
+                target += static_cast<char>(0xC0 | (codePoint >> 6));
+                target += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000) {
+                target += static_cast<char>(0xE0 | (codePoint >> 12));
+                target += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                target += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else {
+                target += static_cast<char>(0xF0 | (codePoint >> 18));
+                target += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                target += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                target += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+    }
+
+    XmlReader::XmlReader(std::istream& stream) : m_stream(stream), m_buffer(BUFFER_SIZE) {
+        if (Peek() == 0xEF) {
+            const char bom[] = "\xEF\xBB\xBF";
+            size_t matched = 0;
+            while (matched < 3 && Peek() == static_cast<unsigned char>(bom[matched])) {
+                Get();
+                ++matched;
+            }
+        }
+    }
+
+    bool XmlReader::Fill() {
+        if (!m_stream) return false;
+        m_stream.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_length = static_cast<size_t>(m_stream.gcount());
+        m_position = 0;
+        return m_length > 0;
+    }
+
+    int XmlReader::Peek() {
+        if (m_position >= m_length && !Fill()) return -1;
+        return static_cast<unsigned char>(m_buffer[m_position]);
+    }
+
+    int XmlReader::Get() {
+        int c = Peek();
+        if (c >= 0) {
+            ++m_position;
+            if (c == '\n') ++m_line;
+        }
+        return c;
+    }
+
+    bool XmlReader::Fail(const std::wstring& error) {
+        m_lastError = error + L" (line " + std::to_wstring(m_line) + L")";
+        m_nodeType = XmlNodeType::None;
+        return false;
+    }
+
+    void XmlReader::SkipWhitespace() {
+        while (IsXmlWhitespace(Peek())) Get();
+    }
+
+    bool XmlReader::ReadName(std::string& name) {
+        name.clear();
+        while (IsNameChar(Peek())) {
+            name += static_cast<char>(Get());
+        }
+        return !name.empty();
+    }
+
+    bool XmlReader::ReadUntil(const char* terminator, std::string* target) {
+        size_t length = strlen(terminator);
+        std::string tail;
+
+        for (;;) {
+            int c = Get();
+            if (c < 0) return Fail(L"Unterminated markup, expected '" +
+                std::wstring(terminator, terminator + length) + L"'");
+
+            tail += static_cast<char>(c);
+            if (tail.size() > length) {
+                if (target) *target += tail[0];
+                tail.erase(0, 1);
+            }
+            if (tail == terminator) return true;
+        }
+    }
+
+    bool XmlReader::ReadReference(std::string& target) {
+        std::string entity;
+        for (;;) {
+            int c = Get();
+            if (c < 0) return Fail(L"Unterminated entity reference");
+            if (c == ';') break;
+            entity += static_cast<char>(c);
+            if (entity.size() > 10) return Fail(L"Invalid entity reference");
+        }
+
+        if (entity == "amp") target += '&';
+        else if (entity == "lt") target += '<';
+        else if (entity == "gt") target += '>';
+        else if (entity == "quot") target += '"';
+        else if (entity == "apos") target += '\'';
+        else if (entity.size() > 1 && entity[0] == '#') {
+            bool hex = entity[1] == 'x' || entity[1] == 'X';
+            uint32_t codePoint = 0;
+            try {
+                codePoint = static_cast<uint32_t>(std::stoul(entity.substr(hex ? 2 : 1), nullptr, hex ? 16 : 10));
+            }
+            catch (...) {
+                return Fail(L"Invalid character reference");
+            }
+            if (codePoint > 0x10FFFF) return Fail(L"Invalid character reference");
+            AppendUtf8(target, codePoint);
+        }
+        else {
+            target += '&' + entity + ';';
+        }
+        return true;
+    }
+
+    bool XmlReader::ReadDeclaration() {
+        if (Peek() == '-') {
+            Get();
+            if (Get() != '-') return Fail(L"Malformed comment");
+            return ReadUntil("-->", nullptr);
+        }
+
+        if (Peek() == '[') {
+            std::string marker;
+            while (marker.size() < 7 && Peek() >= 0) marker += static_cast<char>(Get());
+            if (marker != "[CDATA[") return Fail(L"Malformed CDATA section");
+            m_text.clear();
+            if (!ReadUntil("]]>", &m_text)) return false;
+            m_nodeType = XmlNodeType::Text;
+            return true;
+        }
+
+        int nesting = 0;
+        for (;;) {
+            int c = Get();
+            if (c < 0) return Fail(L"Unterminated declaration");
+            if (c == '[') ++nesting;
+            else if (c == ']') --nesting;
+            else if (c == '>' && nesting <= 0) return true;
+        }
+    }
+
+    bool XmlReader::ReadStartElement() {
+        if (!ReadName(m_name)) return Fail(L"Invalid element name");
+
+        m_attributes.clear();
+        m_isEmptyElement = false;
+
+        for (;;) {
+            SkipWhitespace();
+            int c = Peek();
+            if (c < 0) return Fail(L"Unterminated start tag <" + std::wstring(m_name.begin(), m_name.end()) + L">");
+
+            if (c == '>') {
+                Get();
+                break;
+            }
+            if (c == '/') {
+                Get();
+                if (Get() != '>') return Fail(L"Expected '>' after '/'");
+                m_isEmptyElement = true;
+                break;
+            }
+
+            std::string attributeName;
+            if (!ReadName(attributeName)) return Fail(L"Invalid attribute name");
+            SkipWhitespace();
+            if (Get() != '=') return Fail(L"Expected '=' after attribute name");
+            SkipWhitespace();
+
+            int quote = Get();
+            if (quote != '"' && quote != '\'') return Fail(L"Expected quoted attribute value");
+
+            std::string value;
+            for (;;) {
+                int v = Get();
+                if (v < 0) return Fail(L"Unterminated attribute value");
+                if (v == quote) break;
+                if (v == '&') {
+                    if (!ReadReference(value)) return false;
+                }
+                else {
+                    value += static_cast<char>(v);
+                }
+            }
+            m_attributes.emplace_back(std::move(attributeName), std::move(value));
+        }
+
+        m_elementStack.push_back(m_name);
+        m_pendingEnd = m_isEmptyElement;
+        m_nodeType = XmlNodeType::StartElement;
+        return true;
+    }
+
+    bool XmlReader::ReadEndElement() {
+        if (!ReadName(m_name)) return Fail(L"Invalid end tag");
+        SkipWhitespace();
+        if (Get() != '>') return Fail(L"Expected '>' in end tag");
+
+        if (m_elementStack.empty() || m_elementStack.back() != m_name) {
+            return Fail(L"Mismatched end tag </" + std::wstring(m_name.begin(), m_name.end()) + L">");
+        }
+
+        m_elementStack.pop_back();
+        m_attributes.clear();
+        m_isEmptyElement = false;
+        m_nodeType = XmlNodeType::EndElement;
+        return true;
+    }
+
+    bool XmlReader::ReadText() {
+        m_text.clear();
+        bool whitespaceOnly = true;
+
+        for (;;) {
+            int c = Peek();
+            if (c < 0 || c == '<') break;
+            Get();
+            if (c == '&') {
+                if (!ReadReference(m_text)) return false;
+                whitespaceOnly = false;
+            }
+            else {
+                if (!IsXmlWhitespace(c)) whitespaceOnly = false;
+                m_text += static_cast<char>(c);
+            }
+        }
+
+        m_nodeType = whitespaceOnly ? XmlNodeType::None : XmlNodeType::Text;
+        return true;
+    }
+
+    bool XmlReader::Read() {
+        if (HasError()) return false;
+
+        if (m_pendingEnd) {
+            m_pendingEnd = false;
+            m_elementStack.pop_back();
+            m_attributes.clear();
+            m_isEmptyElement = false;
+            m_nodeType = XmlNodeType::EndElement;
+            return true;
+        }
+
+        for (;;) {
+            int c = Peek();
+            if (c < 0) {
+                if (!m_elementStack.empty()) {
+                    return Fail(L"Unexpected end of document inside <" +
+                        std::wstring(m_elementStack.back().begin(), m_elementStack.back().end()) + L">");
+                }
+                m_nodeType = XmlNodeType::EndOfDocument;
+                return false;
+            }
+
+            if (c != '<') {
+                if (!ReadText()) return false;
+                if (m_nodeType == XmlNodeType::Text) return true;
+                continue;
+            }
+
+            Get();
+            c = Peek();
+            if (c == '?') {
+                if (!ReadUntil("?>", nullptr)) return false;
+            }
+            else if (c == '!') {
+                Get();
+                m_nodeType = XmlNodeType::None;
+                if (!ReadDeclaration()) return false;
+                if (m_nodeType == XmlNodeType::Text) return true;
+            }
+            else if (c == '/') {
+                Get();
+                return ReadEndElement();
+            }
+            else {
+                return ReadStartElement();
+            }
+        }
+    }
+
+    std::string XmlReader::LocalName() const {
+        size_t colon = m_name.find(':');
+        return colon == std::string::npos ? m_name : m_name.substr(colon + 1);
+    }
+
+    std::string XmlReader::GetAttribute(const std::string& name) const {
+        for (const auto& attribute : m_attributes) {
+            if (attribute.first == name) return attribute.second;
+        }
+        return std::string();
+    }
+
+    std::string XmlEscape(const std::string& value) {
+        std::string result;
+        result.reserve(value.size());
+        for (char c : value) {
+            switch (c) {
+            case '&': result += "&amp;"; break;
+            case '<': result += "&lt;"; break;
+            case '>': result += "&gt;"; break;
+            case '"': result += "&quot;"; break;
+            case '\'': result += "&apos;"; break;
+            default: result += c; break;
+            }
+        }
+        return result;
+    }
+}
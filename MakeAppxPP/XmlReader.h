@@ -0,0 +1,68 @@
+#pragma once
+#include <istream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+namespace MakeAppxCore {
+
+    enum class XmlNodeType {
+        None,
+        StartElement,
+        EndElement,
+        Text,
+        EndOfDocument
+    };
+
+    class XmlReader {
+    private:
+        static constexpr size_t BUFFER_SIZE = 65536;
+
+        std::istream& m_stream;
+        std::vector<char> m_buffer;
+        size_t m_position = 0;
+        size_t m_length = 0;
+        uint64_t m_line = 1;
+
+        XmlNodeType m_nodeType = XmlNodeType::None;
+        std::string m_name;
+        std::string m_text;
+        std::vector<std::pair<std::string, std::string>> m_attributes;
+        std::vector<std::string> m_elementStack;
+        bool m_isEmptyElement = false;
+        bool m_pendingEnd = false;
+        std::wstring m_lastError;
+
+        bool Fill();
+        int Peek();
+        int Get();
+        void SkipWhitespace();
+        bool ReadName(std::string& name);
+        bool ReadUntil(const char* terminator, std::string* target);
+        bool ReadReference(std::string& target);
+        bool ReadDeclaration();
+        bool ReadStartElement();
+        bool ReadEndElement();
+        bool ReadText();
+        bool Fail(const std::wstring& error);
+
+    public:
+        explicit XmlReader(std::istream& stream);
+
+        bool Read();
+
+        XmlNodeType NodeType() const { return m_nodeType; }
+        const std::string& Name() const { return m_name; }
+        std::string LocalName() const;
+        const std::string& Text() const { return m_text; }
+        bool IsEmptyElement() const { return m_isEmptyElement; }
+        size_t Depth() const { return m_elementStack.size(); }
+        std::string GetAttribute(const std::string& name) const;
+
+        bool HasError() const { return !m_lastError.empty(); }
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+
+    std::string XmlEscape(const std::string& value);
+}
@@ -0,0 +1,320 @@
+#include "ZipDirectory.h"
+#include "AppxPackageImpl.h"
+#include "Crc32.h"
+#include <zlib.h>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <cstring>
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+        constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+        constexpr uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+        constexpr uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+        constexpr uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+        constexpr uint16_t ZIP64_EXTRA_FIELD = 0x0001;
+
+        constexpr size_t LOCAL_HEADER_SIZE = 30;
+        constexpr size_t CENTRAL_HEADER_SIZE = 46;
+        constexpr size_t END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+        constexpr size_t ZIP64_LOCATOR_SIZE = 20;
+        constexpr size_t ZIP64_END_SIZE = 56;
+        constexpr size_t MAX_COMMENT_SIZE = 0xFFFF;
+        constexpr uint16_t METHOD_STORE = 0;
+        constexpr uint16_t METHOD_DEFLATE = 8;
+        // Deflate cannot expand data by more than this, so a larger claimed size is corrupt.
+        constexpr uint64_t MAX_DEFLATE_RATIO = 1032;
+
+        uint16_t ReadU16(const uint8_t* p) {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        uint32_t ReadU32(const uint8_t* p) {
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        uint64_t ReadU64(const uint8_t* p) {
+            return static_cast<uint64_t>(ReadU32(p)) | (static_cast<uint64_t>(ReadU32(p + 4)) << 32);
+        }
+    }
+
+    FileSource::FileSource(const std::filesystem::path& path)
+        : m_stream(path, std::ios::binary) {
+        std::error_code ec;
+        m_size = std::filesystem::file_size(path, ec);
+        if (ec) m_size = 0;
+    }
+
+    bool FileSource::ReadAt(uint64_t offset, void* buffer, size_t size) {
+        if (offset + size > m_size) return false;
+        m_stream.clear();
+        m_stream.seekg(static_cast<std::streamoff>(offset));
+        m_stream.read(static_cast<char*>(buffer), static_cast<std::streamsize>(size));
+        return static_cast<size_t>(m_stream.gcount()) == size;
+    }
+
+    bool MemorySource::ReadAt(uint64_t offset, void* buffer, size_t size) {
+        if (offset > m_size || size > m_size - offset) return false;
+        memcpy(buffer, m_data + offset, size);
+        return true;
+    }
+
+    bool ZipDirectory::SetError(const std::wstring& error) {
+        m_lastError = error;
+        return false;
+    }
+
+    bool ZipDirectory::ReadEndOfCentralDirectory(RandomAccessSource& source, uint64_t& entryCount) {
+        uint64_t fileSize = source.Size();
+        if (fileSize < END_OF_CENTRAL_DIRECTORY_SIZE) {
+            return SetError(L"File is too small to be a ZIP archive");
+        }
+
+        size_t tailSize = static_cast<size_t>(std::min<uint64_t>(fileSize, END_OF_CENTRAL_DIRECTORY_SIZE + MAX_COMMENT_SIZE));
+        uint64_t tailOffset = fileSize - tailSize;
+        std::vector<uint8_t> tail(tailSize);
+        if (!source.ReadAt(tailOffset, tail.data(), tail.size())) {
+            return SetError(L"Failed to read end of archive");
+        }
+
+        size_t eocd = std::string::npos;
+        for (size_t i = tailSize - END_OF_CENTRAL_DIRECTORY_SIZE + 1; i-- > 0;) {
+            if (ReadU32(&tail[i]) == END_OF_CENTRAL_DIRECTORY_SIGNATURE &&
+                i + END_OF_CENTRAL_DIRECTORY_SIZE + ReadU16(&tail[i + 20]) <= tailSize) {
+                eocd = i;
+                break;
+            }
+        }
+
+        if (eocd == std::string::npos) {
+            return SetError(L"End of central directory record not found");
+        }
+
+        const uint8_t* record = &tail[eocd];
+        entryCount = ReadU16(record + 10);
+        m_centralDirectorySize = ReadU32(record + 12);
+        m_centralDirectoryOffset = ReadU32(record + 16);
+
+        uint64_t eocdOffset = tailOffset + eocd;
+        if (eocdOffset >= ZIP64_LOCATOR_SIZE) {
+            uint8_t locator[ZIP64_LOCATOR_SIZE];
+            if (source.ReadAt(eocdOffset - ZIP64_LOCATOR_SIZE, locator, sizeof(locator)) &&
+                ReadU32(locator) == ZIP64_LOCATOR_SIGNATURE) {
+
+                uint8_t zip64End[ZIP64_END_SIZE];
+                if (!source.ReadAt(ReadU64(locator + 8), zip64End, sizeof(zip64End)) ||
+                    ReadU32(zip64End) != ZIP64_END_SIGNATURE) {
+                    return SetError(L"Invalid ZIP64 end of central directory record");
+                }
+
+                entryCount = ReadU64(zip64End + 32);
+                m_centralDirectorySize = ReadU64(zip64End + 40);
+                m_centralDirectoryOffset = ReadU64(zip64End + 48);
+                m_zip64 = true;
+            }
+        }
+
+        if (m_centralDirectoryOffset > fileSize || m_centralDirectorySize > fileSize - m_centralDirectoryOffset) {
+            return SetError(L"Central directory extends past end of file");
+        }
+
+        return true;
+    }
+
+    bool ZipDirectory::ParseCentralDirectory(const std::vector<uint8_t>& data, uint64_t entryCount) {
+        m_entries.clear();
+        m_entries.reserve(static_cast<size_t>(std::min<uint64_t>(entryCount, data.size() / CENTRAL_HEADER_SIZE)));
+
+        size_t pos = 0;
+        while (pos + CENTRAL_HEADER_SIZE <= data.size() && ReadU32(&data[pos]) == CENTRAL_HEADER_SIGNATURE) {
+            const uint8_t* header = &data[pos];
+            uint16_t nameLength = ReadU16(header + 28);
+            uint16_t extraLength = ReadU16(header + 30);
+            uint16_t commentLength = ReadU16(header + 32);
+
+            if (pos + CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength > data.size()) {
+                return SetError(L"Truncated central directory entry");
+            }
+
+            ZipDirectoryEntry entry;
+            entry.versionMadeBy = ReadU16(header + 4);
+            entry.versionNeeded = ReadU16(header + 6);
+            entry.flags = ReadU16(header + 8);
+            entry.method = ReadU16(header + 10);
+            entry.modifiedTime = ReadU16(header + 12);
+            entry.modifiedDate = ReadU16(header + 14);
+            entry.crc32 = ReadU32(header + 16);
+            entry.compressedSize = ReadU32(header + 20);
+            entry.uncompressedSize = ReadU32(header + 24);
+            entry.externalAttributes = ReadU32(header + 38);
+            entry.localHeaderOffset = ReadU32(header + 42);
+            entry.name.assign(reinterpret_cast<const char*>(header + CENTRAL_HEADER_SIZE), nameLength);
+
+            const uint8_t* extra = header + CENTRAL_HEADER_SIZE + nameLength;
+            const uint8_t* extraEnd = extra + extraLength;
+            while (extra + 4 <= extraEnd) {
+                uint16_t id = ReadU16(extra);
+                uint16_t size = ReadU16(extra + 2);
+                const uint8_t* field = extra + 4;
+                if (field + size > extraEnd) break;
+
+                if (id == ZIP64_EXTRA_FIELD) {
+                    const uint8_t* value = field;
+                    const uint8_t* valueEnd = field + size;
+                    if (entry.uncompressedSize == 0xFFFFFFFF && value + 8 <= valueEnd) {
+                        entry.uncompressedSize = ReadU64(value);
+                        value += 8;
+                    }
+                    if (entry.compressedSize == 0xFFFFFFFF && value + 8 <= valueEnd) {
+                        entry.compressedSize = ReadU64(value);
+                        value += 8;
+                    }
+                    if (entry.localHeaderOffset == 0xFFFFFFFF && value + 8 <= valueEnd) {
+                        entry.localHeaderOffset = ReadU64(value);
+                    }
+                }
+                extra = field + size;
+            }
+
+            m_entries.push_back(std::move(entry));
+            pos += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        }
+
+        if (m_entries.size() != entryCount) {
+            return SetError(L"Central directory entry count mismatch");
+        }
+
+        return true;
+    }
+
+    void ZipDirectory::ComputeRecordExtents() {
+        std::vector<size_t> order(m_entries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return m_entries[a].localHeaderOffset < m_entries[b].localHeaderOffset;
+        });
+
+        for (size_t i = 0; i < order.size(); ++i) {
+            m_entries[order[i]].recordEnd = i + 1 < order.size() ?
+                m_entries[order[i + 1]].localHeaderOffset : m_centralDirectoryOffset;
+        }
+    }
+
+    bool ZipDirectory::Read(RandomAccessSource& source) {
+        m_entries.clear();
+        m_zip64 = false;
+        m_lastError.clear();
+
+        uint64_t entryCount = 0;
+        if (!ReadEndOfCentralDirectory(source, entryCount)) {
+            return false;
+        }
+
+        std::vector<uint8_t> data(static_cast<size_t>(m_centralDirectorySize));
+        if (!data.empty() && !source.ReadAt(m_centralDirectoryOffset, data.data(), data.size())) {
+            return SetError(L"Failed to read central directory");
+        }
+
+        if (!ParseCentralDirectory(data, entryCount)) {
+            return false;
+        }
+
+        ComputeRecordExtents();
+        return true;
+    }
+
+    bool ZipDirectory::ReadDataOffset(RandomAccessSource& source, const ZipDirectoryEntry& entry, uint64_t& dataOffset) {
+        uint8_t header[LOCAL_HEADER_SIZE];
+        if (!source.ReadAt(entry.localHeaderOffset, header, sizeof(header)) ||
+            ReadU32(header) != LOCAL_HEADER_SIGNATURE) {
+            return SetError(L"Invalid local file header for: " + Utf8ToWideSafe(entry.name));
+        }
+
+        dataOffset = entry.localHeaderOffset + LOCAL_HEADER_SIZE + ReadU16(header + 26) + ReadU16(header + 28);
+        return true;
+    }
+
+    bool ZipDirectory::ReadEntryData(RandomAccessSource& source, const ZipDirectoryEntry& entry, std::string& data,
+        uint64_t maxSize) {
+
+        std::wstring name = Utf8ToWideSafe(entry.name);
+        if (entry.method != METHOD_STORE && entry.method != METHOD_DEFLATE) {
+            return SetError(L"Unsupported compression method " + std::to_wstring(entry.method) + L" for: " + name);
+        }
+        if (entry.uncompressedSize > maxSize) {
+            return SetError(L"Entry is too large to read into memory: " + name);
+        }
+        if (entry.method == METHOD_STORE ? entry.compressedSize != entry.uncompressedSize :
+            entry.uncompressedSize > entry.compressedSize * MAX_DEFLATE_RATIO + 64) {
+            return SetError(L"Invalid entry sizes for: " + name);
+        }
+
+        uint64_t dataOffset = 0;
+        if (!ReadDataOffset(source, entry, dataOffset)) {
+            return false;
+        }
+        if (dataOffset > source.Size() || entry.compressedSize > source.Size() - dataOffset) {
+            return SetError(L"Entry data extends past the end of the package: " + name);
+        }
+
+        std::vector<uint8_t> compressed(static_cast<size_t>(entry.compressedSize));
+        if (!compressed.empty() && !source.ReadAt(dataOffset, compressed.data(), compressed.size())) {
+            return SetError(L"Failed to read entry data for: " + name);
+        }
+
+        if (entry.method == METHOD_STORE) {
+            data.assign(compressed.begin(), compressed.end());
+        }
+        else {
+            data.resize(static_cast<size_t>(entry.uncompressedSize));
+
+            z_stream stream = {};
+            if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+                return SetError(L"Failed to initialize decompressor");
+            }
+            // avail_in and avail_out are 32-bit, so entries past 4 GB are fed through in slices.
+            const size_t slice = std::numeric_limits<uInt>::max();
+            size_t consumed = 0;
+            size_t produced = 0;
+            int result = data.empty() ? Z_STREAM_END : Z_OK;
+            while (result == Z_OK) {
+                stream.next_in = compressed.data() + consumed;
+                stream.avail_in = static_cast<uInt>(std::min(compressed.size() - consumed, slice));
+                stream.next_out = reinterpret_cast<Bytef*>(&data[0]) + produced;
+                stream.avail_out = static_cast<uInt>(std::min(data.size() - produced, slice));
+                uInt availIn = stream.avail_in;
+                uInt availOut = stream.avail_out;
+
+                result = inflate(&stream, Z_NO_FLUSH);
+                consumed += availIn - stream.avail_in;
+                produced += availOut - stream.avail_out;
+                if (result == Z_OK && availIn == stream.avail_in && availOut == stream.avail_out) {
+                    result = Z_BUF_ERROR;
+                }
+            }
+            inflateEnd(&stream);
+
+            if (result != Z_STREAM_END || produced != entry.uncompressedSize) {
+                return SetError(L"Corrupt compressed data for: " + name);
+            }
+        }
+
+        if (Crc32(0, data.data(), data.size()) != entry.crc32) {
+            return SetError(L"CRC mismatch for: " + name);
+        }
+
+        return true;
+    }
+
+    const ZipDirectoryEntry* ZipDirectory::Find(const std::string& name) const {
+        std::string normalized = NormalizeEntryName(name);
+        for (const auto& entry : m_entries) {
+            if (NormalizeEntryName(entry.name) == normalized) return &entry;
+        }
+        return nullptr;
+    }
+}
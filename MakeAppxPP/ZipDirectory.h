@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+
+namespace MakeAppxCore {
+
+    class RandomAccessSource {
+    public:
+        virtual ~RandomAccessSource() = default;
+        virtual uint64_t Size() const = 0;
+        virtual bool ReadAt(uint64_t offset, void* buffer, size_t size) = 0;
+    };
+
+    class FileSource : public RandomAccessSource {
+    private:
+        std::ifstream m_stream;
+        uint64_t m_size = 0;
+
+    public:
+        explicit FileSource(const std::filesystem::path& path);
+
+        bool IsOpen() const { return m_stream.is_open(); }
+        void Close() { m_stream.close(); }
+        uint64_t Size() const override { return m_size; }
+        bool ReadAt(uint64_t offset, void* buffer, size_t size) override;
+    };
+
+    class MemorySource : public RandomAccessSource {
+    private:
+        const uint8_t* m_data;
+        uint64_t m_size;
+
+    public:
+        MemorySource(const uint8_t* data, uint64_t size) : m_data(data), m_size(size) {}
+
+        const uint8_t* Data() const { return m_data; }
+
+        uint64_t Size() const override { return m_size; }
+        bool ReadAt(uint64_t offset, void* buffer, size_t size) override;
+    };
+
+    struct ZipDirectoryEntry {
+        std::string name;
+        uint16_t versionMadeBy = 0;
+        uint16_t versionNeeded = 0;
+        uint16_t flags = 0;
+        uint16_t method = 0;
+        uint16_t modifiedTime = 0;
+        uint16_t modifiedDate = 0;
+        uint32_t crc32 = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        uint64_t localHeaderOffset = 0;
+        uint32_t externalAttributes = 0;
+        uint64_t recordEnd = 0;
+    };
+
+    class ZipDirectory {
+    private:
+        std::vector<ZipDirectoryEntry> m_entries;
+        uint64_t m_centralDirectoryOffset = 0;
+        uint64_t m_centralDirectorySize = 0;
+        bool m_zip64 = false;
+        std::wstring m_lastError;
+
+        bool SetError(const std::wstring& error);
+        bool ReadEndOfCentralDirectory(RandomAccessSource& source, uint64_t& entryCount);
+        bool ParseCentralDirectory(const std::vector<uint8_t>& data, uint64_t entryCount);
+        void ComputeRecordExtents();
+
+    public:
+        bool Read(RandomAccessSource& source);
+        bool ReadDataOffset(RandomAccessSource& source, const ZipDirectoryEntry& entry, uint64_t& dataOffset);
+        // Entries read whole, such as the manifest and the block map; larger claims are refused before
+        // anything is allocated.
+        static constexpr uint64_t MAX_ENTRY_DATA_SIZE = 256ull * 1024 * 1024;
+
+        bool ReadEntryData(RandomAccessSource& source, const ZipDirectoryEntry& entry, std::string& data,
+            uint64_t maxSize = MAX_ENTRY_DATA_SIZE);
+        const ZipDirectoryEntry* Find(const std::string& name) const;
+
+        const std::vector<ZipDirectoryEntry>& Entries() const { return m_entries; }
+        uint64_t CentralDirectoryOffset() const { return m_centralDirectoryOffset; }
+        uint64_t CentralDirectorySize() const { return m_centralDirectorySize; }
+        bool IsZip64() const { return m_zip64; }
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+}
@@ -0,0 +1,625 @@
+#include "ZipStream.h"
+#include "AppxPackageImpl.h"
+#include "Crc32.h"
+#include <algorithm>
+#include <cstring>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+namespace MakeAppxCore {
+
+    namespace {
+        constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+        constexpr uint32_t DATA_DESCRIPTOR_SIGNATURE = 0x08074b50;
+        constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+        constexpr uint32_t EOCD_SIGNATURE = 0x06054b50;
+        constexpr uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+        constexpr uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+        constexpr uint16_t ZIP64_EXTRA_FIELD = 1;
+        constexpr uint16_t FLAG_ENCRYPTED = 0x0001;
+        constexpr uint16_t FLAG_DATA_DESCRIPTOR = 0x0008;
+        constexpr uint16_t FLAG_UTF8 = 0x0800;
+        constexpr uint16_t VERSION_DEFAULT = 20;
+        constexpr uint16_t VERSION_ZIP64 = 45;
+        constexpr uint32_t UINT32_SATURATED = 0xFFFFFFFF;
+        // Deflate can grow incompressible input slightly, so entries close to 4 GB get zip64 headers up front.
+        constexpr uint64_t ZIP64_SIZE_THRESHOLD = 0xFFFF0000ull;
+        constexpr size_t STREAM_BUFFER_SIZE = 256 * 1024;
+        constexpr size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+
+        uint16_t ReadU16(const uint8_t* p) {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        uint32_t ReadU32(const uint8_t* p) {
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        uint64_t ReadU64(const uint8_t* p) {
+            return static_cast<uint64_t>(ReadU32(p)) | (static_cast<uint64_t>(ReadU32(p + 4)) << 32);
+        }
+
+        void PutU16(std::vector<uint8_t>& out, uint16_t value) {
+            out.push_back(static_cast<uint8_t>(value));
+            out.push_back(static_cast<uint8_t>(value >> 8));
+        }
+
+        void PutU32(std::vector<uint8_t>& out, uint32_t value) {
+            for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+
+        void PutU64(std::vector<uint8_t>& out, uint64_t value) {
+            for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+
+        uint32_t Saturate(uint64_t value) {
+            return value >= UINT32_SATURATED ? UINT32_SATURATED : static_cast<uint32_t>(value);
+        }
+
+        bool IsAscii(const std::string& name) {
+            return std::all_of(name.begin(), name.end(), [](char c) {
+                return static_cast<unsigned char>(c) < 0x80;
+            });
+        }
+
+        bool NeedsZip64Header(uint64_t size) {
+            return size > ZIP64_SIZE_THRESHOLD;
+        }
+
+        uint32_t LocalHeaderSizeFor(const std::string& name, bool zip64) {
+            return static_cast<uint32_t>(30 + name.size() + (zip64 ? 20 : 0));
+        }
+
+        void ToDosDateTime(time_t time, uint16_t& dosTime, uint16_t& dosDate) {
+            struct tm local = {};
+#ifdef _WIN32
+            localtime_s(&local, &time);
+#else
+            localtime_r(&time, &local);
+#endif
+            if (local.tm_year < 80) {
+                dosTime = 0;
+                dosDate = (1 << 5) | 1;
+                return;
+            }
+            dosTime = static_cast<uint16_t>((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+            dosDate = static_cast<uint16_t>(((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+        }
+    }
+
+    FILE* OpenStandardInput() {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        return stdin;
+    }
+
+    FILE* OpenStandardOutput() {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        setvbuf(stdout, nullptr, _IOFBF, OUTPUT_BUFFER_SIZE);
+        return stdout;
+    }
+
+    bool ZipStreamWriter::SetError(const std::wstring& error) {
+        if (m_lastError.empty()) m_lastError = error;
+        return false;
+    }
+
+    bool ZipStreamWriter::WriteRaw(const void* data, size_t size) {
+        bool written = size == 0 || (m_sink ? m_sink(static_cast<const uint8_t*>(data), size) :
+            fwrite(data, 1, size, m_file) == size);
+        if (!written) {
+            return SetError(L"Failed to write package stream");
+        }
+        m_offset += size;
+        return true;
+    }
+
+    uint32_t ZipStreamWriter::LocalHeaderSize(const std::string& name, uint64_t size) {
+        return LocalHeaderSizeFor(name, NeedsZip64Header(size));
+    }
+
+    void ZipStreamWriter::Resume(uint64_t offset, std::vector<ZipDirectoryEntry> entries) {
+        m_offset = offset;
+        m_entries = std::move(entries);
+    }
+
+    bool ZipStreamWriter::BeginEntry(const std::string& name, uint16_t method, time_t modified, uint64_t size) {
+        uint16_t dosTime = 0, dosDate = 0;
+        ToDosDateTime(modified, dosTime, dosDate);
+        return BeginEntry(name, method, dosTime, dosDate, size);
+    }
+
+    bool ZipStreamWriter::BeginEntry(const std::string& name, uint16_t method, uint16_t dosTime, uint16_t dosDate,
+        uint64_t size) {
+
+        if (m_inEntry) {
+            return SetError(L"Previous stream entry was not finished");
+        }
+        if (name.size() > 0xFFFF) {
+            return SetError(L"Entry name is too long");
+        }
+
+        m_current = ZipDirectoryEntry();
+        m_current.name = name;
+        m_current.method = method;
+        m_current.flags = FLAG_DATA_DESCRIPTOR | (IsAscii(name) ? 0 : FLAG_UTF8);
+        m_current.localHeaderOffset = m_offset;
+        m_current.modifiedTime = dosTime;
+        m_current.modifiedDate = dosDate;
+        if (method == ZIP_METHOD_STORE) {
+            m_current.compressedSize = size;
+            m_current.uncompressedSize = size;
+        }
+
+        m_zip64Entry = NeedsZip64Header(size);
+        m_current.versionNeeded = m_zip64Entry ? VERSION_ZIP64 : VERSION_DEFAULT;
+
+        std::vector<uint8_t> header;
+        header.reserve(LocalHeaderSize(name, size));
+        PutU32(header, LOCAL_HEADER_SIGNATURE);
+        PutU16(header, m_current.versionNeeded);
+        PutU16(header, m_current.flags);
+        PutU16(header, method);
+        PutU16(header, m_current.modifiedTime);
+        PutU16(header, m_current.modifiedDate);
+        PutU32(header, 0);
+        PutU32(header, m_zip64Entry ? UINT32_SATURATED : static_cast<uint32_t>(m_current.compressedSize));
+        PutU32(header, m_zip64Entry ? UINT32_SATURATED : static_cast<uint32_t>(m_current.uncompressedSize));
+        PutU16(header, static_cast<uint16_t>(name.size()));
+        PutU16(header, m_zip64Entry ? 20 : 0);
+        header.insert(header.end(), name.begin(), name.end());
+        if (m_zip64Entry) {
+            PutU16(header, ZIP64_EXTRA_FIELD);
+            PutU16(header, 16);
+            PutU64(header, m_current.uncompressedSize);
+            PutU64(header, m_current.compressedSize);
+        }
+
+        m_written = 0;
+        m_inEntry = true;
+        return WriteRaw(header.data(), header.size());
+    }
+
+    bool ZipStreamWriter::Write(const void* data, size_t size) {
+        if (!m_inEntry) {
+            return SetError(L"No stream entry is open");
+        }
+        m_written += size;
+        return WriteRaw(data, size);
+    }
+
+    bool ZipStreamWriter::EndEntry(uint32_t crc32, uint64_t uncompressedSize) {
+        if (!m_inEntry) {
+            return SetError(L"No stream entry is open");
+        }
+        m_inEntry = false;
+
+        if (m_current.method == ZIP_METHOD_STORE &&
+            (m_written != m_current.compressedSize || uncompressedSize != m_written)) {
+            return SetError(L"File changed size while streaming: " + Utf8ToWideSafe(m_current.name));
+        }
+        if (!m_zip64Entry && (m_written >= UINT32_SATURATED || uncompressedSize >= UINT32_SATURATED)) {
+            return SetError(L"Entry grew past 4 GB while streaming: " + Utf8ToWideSafe(m_current.name));
+        }
+
+        m_current.crc32 = crc32;
+        m_current.compressedSize = m_written;
+        m_current.uncompressedSize = uncompressedSize;
+
+        std::vector<uint8_t> descriptor;
+        PutU32(descriptor, DATA_DESCRIPTOR_SIGNATURE);
+        PutU32(descriptor, crc32);
+        if (m_zip64Entry) {
+            PutU64(descriptor, m_current.compressedSize);
+            PutU64(descriptor, m_current.uncompressedSize);
+        }
+        else {
+            PutU32(descriptor, static_cast<uint32_t>(m_current.compressedSize));
+            PutU32(descriptor, static_cast<uint32_t>(m_current.uncompressedSize));
+        }
+
+        if (!WriteRaw(descriptor.data(), descriptor.size())) return false;
+        m_current.recordEnd = m_offset;
+        m_entries.push_back(std::move(m_current));
+        return true;
+    }
+
+    bool ZipStreamWriter::Finish() {
+        if (m_inEntry) {
+            return SetError(L"Previous stream entry was not finished");
+        }
+
+        uint64_t directoryOffset = m_offset;
+        std::vector<uint8_t> record;
+        for (const auto& entry : m_entries) {
+            std::vector<uint8_t> extra;
+            if (entry.uncompressedSize >= UINT32_SATURATED) PutU64(extra, entry.uncompressedSize);
+            if (entry.compressedSize >= UINT32_SATURATED) PutU64(extra, entry.compressedSize);
+            if (entry.localHeaderOffset >= UINT32_SATURATED) PutU64(extra, entry.localHeaderOffset);
+            bool zip64 = !extra.empty();
+
+            record.clear();
+            PutU32(record, CENTRAL_HEADER_SIGNATURE);
+            PutU16(record, VERSION_ZIP64);
+            PutU16(record, zip64 ? VERSION_ZIP64 : entry.versionNeeded);
+            PutU16(record, entry.flags);
+            PutU16(record, entry.method);
+            PutU16(record, entry.modifiedTime);
+            PutU16(record, entry.modifiedDate);
+            PutU32(record, entry.crc32);
+            PutU32(record, Saturate(entry.compressedSize));
+            PutU32(record, Saturate(entry.uncompressedSize));
+            PutU16(record, static_cast<uint16_t>(entry.name.size()));
+            PutU16(record, static_cast<uint16_t>(zip64 ? extra.size() + 4 : 0));
+            PutU16(record, 0);
+            PutU16(record, 0);
+            PutU16(record, 0);
+            PutU32(record, 0);
+            PutU32(record, Saturate(entry.localHeaderOffset));
+            record.insert(record.end(), entry.name.begin(), entry.name.end());
+            if (zip64) {
+                PutU16(record, ZIP64_EXTRA_FIELD);
+                PutU16(record, static_cast<uint16_t>(extra.size()));
+                record.insert(record.end(), extra.begin(), extra.end());
+            }
+            if (!WriteRaw(record.data(), record.size())) return false;
+        }
+
+        uint64_t directorySize = m_offset - directoryOffset;
+        uint64_t count = m_entries.size();
+        record.clear();
+
+        if (count >= 0xFFFF || directoryOffset >= UINT32_SATURATED || directorySize >= UINT32_SATURATED) {
+            uint64_t zip64EndOffset = m_offset;
+            PutU32(record, ZIP64_END_SIGNATURE);
+            PutU64(record, 44);
+            PutU16(record, VERSION_ZIP64);
+            PutU16(record, VERSION_ZIP64);
+            PutU32(record, 0);
+            PutU32(record, 0);
+            PutU64(record, count);
+            PutU64(record, count);
+            PutU64(record, directorySize);
+            PutU64(record, directoryOffset);
+
+            PutU32(record, ZIP64_LOCATOR_SIGNATURE);
+            PutU32(record, 0);
+            PutU64(record, zip64EndOffset);
+            PutU32(record, 1);
+        }
+
+        PutU32(record, EOCD_SIGNATURE);
+        PutU16(record, 0);
+        PutU16(record, 0);
+        PutU16(record, static_cast<uint16_t>(std::min<uint64_t>(count, 0xFFFF)));
+        PutU16(record, static_cast<uint16_t>(std::min<uint64_t>(count, 0xFFFF)));
+        PutU32(record, Saturate(directorySize));
+        PutU32(record, Saturate(directoryOffset));
+        PutU16(record, 0);
+
+        if (!WriteRaw(record.data(), record.size())) return false;
+        if (m_file && fflush(m_file) != 0) {
+            return SetError(L"Failed to flush package stream");
+        }
+        return true;
+    }
+
+    bool VerifyStreamedEntry(RandomAccessSource& source, const ZipDirectoryEntry& entry, bool checkData) {
+        bool zip64 = entry.versionNeeded == VERSION_ZIP64;
+        uint64_t dataOffset = entry.localHeaderOffset + LocalHeaderSizeFor(entry.name, zip64);
+        size_t descriptorSize = zip64 ? 24 : 16;
+        if (entry.recordEnd != dataOffset + entry.compressedSize + descriptorSize || entry.recordEnd > source.Size()) {
+            return false;
+        }
+
+        std::vector<uint8_t> header(static_cast<size_t>(dataOffset - entry.localHeaderOffset));
+        if (!source.ReadAt(entry.localHeaderOffset, header.data(), header.size()) ||
+            ReadU32(header.data()) != LOCAL_HEADER_SIGNATURE || ReadU16(header.data() + 8) != entry.method ||
+            ReadU16(header.data() + 26) != entry.name.size() ||
+            memcmp(header.data() + 30, entry.name.data(), entry.name.size()) != 0) {
+            return false;
+        }
+
+        uint8_t descriptor[24];
+        if (!source.ReadAt(entry.recordEnd - descriptorSize, descriptor, descriptorSize) ||
+            ReadU32(descriptor) != DATA_DESCRIPTOR_SIGNATURE || ReadU32(descriptor + 4) != entry.crc32 ||
+            (zip64 ? ReadU64(descriptor + 8) : ReadU32(descriptor + 8)) != entry.compressedSize ||
+            (zip64 ? ReadU64(descriptor + 16) : ReadU32(descriptor + 12)) != entry.uncompressedSize) {
+            return false;
+        }
+        if (!checkData) return true;
+
+        bool deflated = entry.method == ZIP_METHOD_DEFLATE;
+        z_stream stream = {};
+        if (deflated && inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            return false;
+        }
+
+        std::vector<uint8_t> input(STREAM_BUFFER_SIZE);
+        std::vector<uint8_t> output(deflated ? STREAM_BUFFER_SIZE : 0);
+        uint64_t offset = dataOffset;
+        uint64_t remaining = entry.compressedSize;
+        uint64_t produced = 0;
+        uint32_t crc = 0;
+        int status = Z_OK;
+        bool valid = true;
+
+        while (valid && remaining > 0) {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, input.size()));
+            if (!source.ReadAt(offset, input.data(), chunk)) {
+                valid = false;
+                break;
+            }
+            offset += chunk;
+            remaining -= chunk;
+
+            if (!deflated) {
+                crc = Crc32(crc, input.data(), chunk);
+                produced += chunk;
+                continue;
+            }
+
+            stream.next_in = input.data();
+            stream.avail_in = static_cast<uInt>(chunk);
+            do {
+                stream.next_out = output.data();
+                stream.avail_out = static_cast<uInt>(output.size());
+                status = inflate(&stream, Z_NO_FLUSH);
+                if (status == Z_BUF_ERROR) break;
+                if (status != Z_OK && status != Z_STREAM_END) {
+                    valid = false;
+                    break;
+                }
+                size_t inflated = output.size() - stream.avail_out;
+                crc = Crc32(crc, output.data(), inflated);
+                produced += inflated;
+            } while (status != Z_STREAM_END && (stream.avail_in > 0 || stream.avail_out == 0));
+        }
+
+        if (deflated) {
+            inflateEnd(&stream);
+            valid = valid && status == Z_STREAM_END;
+        }
+        return valid && crc == entry.crc32 && produced == entry.uncompressedSize;
+    }
+
+    ZipStreamReader::ZipStreamReader(FILE* file) : m_file(file), m_buffer(STREAM_BUFFER_SIZE) {
+    }
+
+    ZipStreamReader::~ZipStreamReader() {
+        if (m_inflateReady) inflateEnd(&m_inflate);
+    }
+
+    bool ZipStreamReader::SetError(const std::wstring& error) {
+        if (m_lastError.empty()) m_lastError = error;
+        return false;
+    }
+
+    bool ZipStreamReader::Fill(size_t needed) {
+        if (m_end - m_position >= needed) return true;
+
+        if (m_position > 0) {
+            std::memmove(m_buffer.data(), m_buffer.data() + m_position, m_end - m_position);
+            m_end -= m_position;
+            m_position = 0;
+        }
+        if (needed > m_buffer.size()) m_buffer.resize(needed);
+
+        while (m_end < needed && !m_eof) {
+            size_t bytesRead = fread(m_buffer.data() + m_end, 1, m_buffer.size() - m_end, m_file);
+            if (bytesRead == 0) {
+                if (ferror(m_file)) SetError(L"Failed to read package stream");
+                m_eof = true;
+            }
+            m_end += bytesRead;
+        }
+        return m_end - m_position >= needed;
+    }
+
+    bool ZipStreamReader::ReadExact(void* data, size_t size) {
+        if (!Fill(size)) {
+            return SetError(L"Package stream ended unexpectedly");
+        }
+        std::memcpy(data, m_buffer.data() + m_position, size);
+        m_position += size;
+        return true;
+    }
+
+    bool ZipStreamReader::NextEntry(ZipStreamEntry& entry) {
+        if (m_inEntry && !SkipEntry()) return false;
+        if (HasError()) return false;
+
+        if (!Fill(4)) {
+            if (m_end > m_position) SetError(L"Package stream ended unexpectedly");
+            return false;
+        }
+
+        uint32_t signature = ReadU32(m_buffer.data() + m_position);
+        if (signature == CENTRAL_HEADER_SIGNATURE || signature == EOCD_SIGNATURE || signature == ZIP64_END_SIGNATURE) {
+            return false;
+        }
+        if (signature != LOCAL_HEADER_SIGNATURE) {
+            return SetError(L"Invalid package stream - expected a local file header");
+        }
+
+        uint8_t header[30];
+        if (!ReadExact(header, sizeof(header))) return false;
+
+        m_entry = ZipStreamEntry();
+        m_entry.flags = ReadU16(header + 6);
+        m_entry.method = ReadU16(header + 8);
+        m_entry.modifiedTime = ReadU16(header + 10);
+        m_entry.modifiedDate = ReadU16(header + 12);
+        m_entry.crc32 = ReadU32(header + 14);
+        m_entry.compressedSize = ReadU32(header + 18);
+        m_entry.uncompressedSize = ReadU32(header + 22);
+        uint16_t nameLength = ReadU16(header + 26);
+        uint16_t extraLength = ReadU16(header + 28);
+
+        m_entry.name.resize(nameLength);
+        std::vector<uint8_t> extra(extraLength);
+        if ((nameLength > 0 && !ReadExact(&m_entry.name[0], nameLength)) ||
+            (extraLength > 0 && !ReadExact(extra.data(), extraLength))) {
+            return false;
+        }
+
+        m_zip64Entry = false;
+        for (size_t pos = 0; pos + 4 <= extra.size();) {
+            uint16_t id = ReadU16(extra.data() + pos);
+            uint16_t size = ReadU16(extra.data() + pos + 2);
+            const uint8_t* field = extra.data() + pos + 4;
+            const uint8_t* fieldEnd = field + std::min<size_t>(size, extra.size() - pos - 4);
+            if (id == ZIP64_EXTRA_FIELD) {
+                m_zip64Entry = true;
+                if (m_entry.uncompressedSize == UINT32_SATURATED && field + 8 <= fieldEnd) {
+                    m_entry.uncompressedSize = ReadU64(field);
+                    field += 8;
+                }
+                if (m_entry.compressedSize == UINT32_SATURATED && field + 8 <= fieldEnd) {
+                    m_entry.compressedSize = ReadU64(field);
+                }
+            }
+            pos += 4 + size;
+        }
+
+        if (m_entry.flags & FLAG_ENCRYPTED) {
+            return SetError(L"Encrypted entries cannot be streamed: " + Utf8ToWideSafe(m_entry.name));
+        }
+        if (m_entry.method != ZIP_METHOD_STORE && m_entry.method != ZIP_METHOD_DEFLATE) {
+            return SetError(L"Unsupported compression method in entry: " + Utf8ToWideSafe(m_entry.name));
+        }
+
+        if (m_entry.method == ZIP_METHOD_DEFLATE) {
+            int result = m_inflateReady ? inflateReset(&m_inflate) : inflateInit2(&m_inflate, -MAX_WBITS);
+            if (result != Z_OK) {
+                return SetError(L"Failed to initialize inflate");
+            }
+            m_inflateReady = true;
+        }
+
+        m_remaining = m_entry.compressedSize;
+        m_consumed = 0;
+        m_produced = 0;
+        m_crc = 0;
+        m_dataEnded = false;
+        m_inEntry = true;
+        entry = m_entry;
+        return true;
+    }
+
+    size_t ZipStreamReader::ReadData(uint8_t* data, size_t size) {
+        if (m_entry.method == ZIP_METHOD_STORE) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(size, m_remaining));
+            if (want == 0) {
+                m_dataEnded = true;
+                return 0;
+            }
+
+            size_t produced;
+            if (m_position == m_end && want >= m_buffer.size()) {
+                produced = fread(data, 1, want, m_file);
+            }
+            else {
+                Fill(1);
+                produced = std::min(want, m_end - m_position);
+                std::memcpy(data, m_buffer.data() + m_position, produced);
+                m_position += produced;
+            }
+            if (produced == 0) {
+                SetError(L"Package stream ended inside entry: " + Utf8ToWideSafe(m_entry.name));
+                return 0;
+            }
+            m_remaining -= produced;
+            m_consumed += produced;
+            return produced;
+        }
+
+        while (true) {
+            if (m_position == m_end && !Fill(1)) {
+                SetError(L"Package stream ended inside entry: " + Utf8ToWideSafe(m_entry.name));
+                return 0;
+            }
+
+            m_inflate.next_in = m_buffer.data() + m_position;
+            m_inflate.avail_in = static_cast<uInt>(m_end - m_position);
+            m_inflate.next_out = data;
+            m_inflate.avail_out = static_cast<uInt>(std::min<size_t>(size, UINT32_MAX));
+
+            int result = inflate(&m_inflate, Z_NO_FLUSH);
+            size_t consumed = (m_end - m_position) - m_inflate.avail_in;
+            size_t produced = static_cast<size_t>(m_inflate.next_out - data);
+            m_position += consumed;
+            m_consumed += consumed;
+
+            if (result == Z_STREAM_END) {
+                m_dataEnded = true;
+                return produced;
+            }
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                SetError(L"Corrupt compressed data in entry: " + Utf8ToWideSafe(m_entry.name));
+                return 0;
+            }
+            if (produced > 0) return produced;
+        }
+    }
+
+    bool ZipStreamReader::FinishEntry() {
+        m_inEntry = false;
+
+        if (m_entry.flags & FLAG_DATA_DESCRIPTOR) {
+            if (!Fill(4)) {
+                return SetError(L"Package stream ended before data descriptor of: " + Utf8ToWideSafe(m_entry.name));
+            }
+            if (ReadU32(m_buffer.data() + m_position) == DATA_DESCRIPTOR_SIGNATURE) {
+                m_position += 4;
+            }
+
+            uint8_t descriptor[20];
+            size_t descriptorSize = m_zip64Entry ? 20 : 12;
+            if (!ReadExact(descriptor, descriptorSize)) return false;
+
+            m_entry.crc32 = ReadU32(descriptor);
+            m_entry.compressedSize = m_zip64Entry ? ReadU64(descriptor + 4) : ReadU32(descriptor + 4);
+            m_entry.uncompressedSize = m_zip64Entry ? ReadU64(descriptor + 12) : ReadU32(descriptor + 8);
+        }
+
+        if (m_crc != m_entry.crc32) {
+            return SetError(L"CRC mismatch in entry: " + Utf8ToWideSafe(m_entry.name));
+        }
+        if (m_produced != m_entry.uncompressedSize || m_consumed != m_entry.compressedSize) {
+            return SetError(L"Size mismatch in entry: " + Utf8ToWideSafe(m_entry.name));
+        }
+        return true;
+    }
+
+    size_t ZipStreamReader::Read(void* data, size_t size) {
+        if (!m_inEntry || HasError() || size == 0) return 0;
+
+        size_t produced = 0;
+        while (produced == 0 && !m_dataEnded && !HasError()) {
+            produced = ReadData(static_cast<uint8_t*>(data), size);
+        }
+
+        if (produced > 0) {
+            m_crc = Crc32(m_crc, data, produced);
+            m_produced += produced;
+        }
+        else if (m_dataEnded && !HasError()) {
+            FinishEntry();
+        }
+        return produced;
+    }
+
+    bool ZipStreamReader::SkipEntry() {
+        std::vector<uint8_t> scratch(64 * 1024);
+        while (Read(scratch.data(), scratch.size()) > 0) {
+        }
+        return !HasError();
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "ZipDirectory.h"
+#include <zlib.h>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <functional>
+#include <cstdint>
+#include <ctime>
+
+namespace MakeAppxCore {
+
+    constexpr uint16_t ZIP_METHOD_STORE = 0;
+    constexpr uint16_t ZIP_METHOD_DEFLATE = 8;
+
+    FILE* OpenStandardInput();
+    FILE* OpenStandardOutput();
+
+    using StreamSink = std::function<bool(const uint8_t* data, size_t size)>;
+
+    // Writes a zip archive front to back without ever seeking, so the output can be a pipe.
+    // Deflated entries carry their CRC and sizes in a data descriptor after the data;
+    // stored entries must declare their size up front because readers cannot find their end otherwise.
+    class ZipStreamWriter {
+    private:
+        FILE* m_file = nullptr;
+        StreamSink m_sink;
+        uint64_t m_offset = 0;
+        std::vector<ZipDirectoryEntry> m_entries;
+        ZipDirectoryEntry m_current;
+        uint64_t m_written = 0;
+        bool m_inEntry = false;
+        bool m_zip64Entry = false;
+        std::wstring m_lastError;
+
+        bool SetError(const std::wstring& error);
+        bool WriteRaw(const void* data, size_t size);
+
+    public:
+        explicit ZipStreamWriter(FILE* file) : m_file(file) {}
+        explicit ZipStreamWriter(StreamSink sink) : m_sink(std::move(sink)) {}
+
+        static uint32_t LocalHeaderSize(const std::string& name, uint64_t size);
+
+        // Continues an archive whose first entries are already written, ending at offset.
+        void Resume(uint64_t offset, std::vector<ZipDirectoryEntry> entries);
+
+        bool BeginEntry(const std::string& name, uint16_t method, time_t modified, uint64_t size);
+        // For entries copied from another archive, which keep their DOS timestamp as it is.
+        bool BeginEntry(const std::string& name, uint16_t method, uint16_t dosTime, uint16_t dosDate, uint64_t size);
+        bool Write(const void* data, size_t size);
+        bool EndEntry(uint32_t crc32, uint64_t uncompressedSize);
+        bool Finish();
+
+        uint64_t Offset() const { return m_offset; }
+        const ZipDirectoryEntry& LastEntry() const { return m_entries.back(); }
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+
+    // Checks that an entry written by ZipStreamWriter is intact in the archive: its local header and data
+    // descriptor always, and with checkData also the CRC of its contents.
+    bool VerifyStreamedEntry(RandomAccessSource& source, const ZipDirectoryEntry& entry, bool checkData);
+
+    struct ZipStreamEntry {
+        std::string name;
+        uint16_t flags = 0;
+        uint16_t method = 0;
+        uint16_t modifiedTime = 0;
+        uint16_t modifiedDate = 0;
+        uint32_t crc32 = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+    };
+
+    // Reads a zip archive front to back from its local headers, stopping at the central directory.
+    class ZipStreamReader {
+    private:
+        FILE* m_file;
+        std::vector<uint8_t> m_buffer;
+        size_t m_position = 0;
+        size_t m_end = 0;
+        bool m_eof = false;
+
+        ZipStreamEntry m_entry;
+        bool m_inEntry = false;
+        bool m_dataEnded = false;
+        bool m_zip64Entry = false;
+        uint64_t m_remaining = 0;
+        uint64_t m_consumed = 0;
+        uint64_t m_produced = 0;
+        uint32_t m_crc = 0;
+        z_stream m_inflate = {};
+        bool m_inflateReady = false;
+        std::wstring m_lastError;
+
+        bool SetError(const std::wstring& error);
+        bool Fill(size_t needed);
+        bool ReadExact(void* data, size_t size);
+        size_t ReadData(uint8_t* data, size_t size);
+        bool FinishEntry();
+        bool SkipEntry();
+
+    public:
+        explicit ZipStreamReader(FILE* file);
+        ~ZipStreamReader();
+
+        ZipStreamReader(const ZipStreamReader&) = delete;
+        ZipStreamReader& operator=(const ZipStreamReader&) = delete;
+
+        bool NextEntry(ZipStreamEntry& entry);
+        size_t Read(void* data, size_t size);
+
+        bool HasError() const { return !m_lastError.empty(); }
+        std::wstring GetLastError() const { return m_lastError; }
+    };
+}
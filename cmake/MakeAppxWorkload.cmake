@@ -0,0 +1,149 @@
+# Runs MakeAppxPP over a synthetic package corpus and reports the time of each step.
+# Used as the training run of profile-guided builds (pgo-train) and as a benchmark.
+#
+#   cmake -DMAKEAPPX=<path to MakeAppxPP> -DWORK_DIR=<scratch dir> [-DITERATIONS=<n>]
+#         [-DPROFILE_DIR=<dir> [-DLLVM_PROFDATA=<llvm-profdata>]] -P MakeAppxWorkload.cmake
+#
+# PROFILE_DIR is cleared of old counters before the run. When LLVM_PROFDATA is set,
+# the raw profiles written there are merged into PROFILE_DIR/makeappx.profdata afterwards.
+
+cmake_minimum_required(VERSION 3.16)
+
+if(NOT MAKEAPPX OR NOT WORK_DIR)
+    message(FATAL_ERROR "MAKEAPPX and WORK_DIR must be set")
+endif()
+if(NOT ITERATIONS)
+    set(ITERATIONS 1)
+endif()
+
+set(corpus "${WORK_DIR}/corpus")
+set(manifest "<?xml version=\"1.0\" encoding=\"utf-8\"?>
+<Package xmlns=\"http://schemas.microsoft.com/appx/manifest/foundation/windows10\">
+  <Identity Name=\"MakeAppx.Workload\" Publisher=\"CN=MakeAppx\" Version=\"1.0.0.0\" />
+  <Properties>
+    <DisplayName>MakeAppx Workload</DisplayName>
+    <PublisherDisplayName>MakeAppx</PublisherDisplayName>
+    <Logo>Assets\\Logo.png</Logo>
+  </Properties>
+</Package>
+")
+
+# The corpus mixes the shapes real packages have: many small compressible files,
+# a few medium ones and one large entry that deflate cannot shrink much.
+if(NOT EXISTS "${corpus}/AppxManifest.xml")
+    message(STATUS "Generating workload corpus in ${corpus}")
+    file(REMOVE_RECURSE "${corpus}")
+    file(WRITE "${corpus}/AppxManifest.xml" "${manifest}")
+
+    set(line "<TextBlock x:Uid=\"Label\" Text=\"The quick brown fox jumps over the lazy dog\" Margin=\"0,4,0,4\" />\n")
+    foreach(i RANGE 1 400)
+        math(EXPR dir "${i} % 8")
+        math(EXPR repeat "20 + (${i} * 37) % 400")
+        string(REPEAT "${line}" ${repeat} text)
+        file(WRITE "${corpus}/Views/Group${dir}/Page${i}.xaml" "<!-- page ${i} -->\n${text}")
+    endforeach()
+
+    foreach(i RANGE 1 24)
+        string(RANDOM LENGTH 98304 chunk)
+        string(REPEAT "${chunk}" 3 data)
+        file(WRITE "${corpus}/Assets/Images/Image${i}.bin" "${data}")
+    endforeach()
+    file(WRITE "${corpus}/Assets/Logo.png" "${chunk}")
+    file(WRITE "${corpus}/Resources/Übersetzung/de-DE.resw" "${text}")
+
+    string(RANDOM LENGTH 1048576 chunk)
+    string(REPEAT "${chunk}" 24 data)
+    file(WRITE "${corpus}/Data/content.pak" "${data}")
+    string(RANDOM LENGTH 32 key)
+    file(WRITE "${WORK_DIR}/workload.key" "${key}")
+endif()
+
+# Counters from an earlier training run would be merged into this one.
+if(PROFILE_DIR)
+    file(GLOB_RECURSE stale "${PROFILE_DIR}/*.gcda" "${PROFILE_DIR}/*.profraw")
+    if(stale)
+        file(REMOVE ${stale})
+    endif()
+endif()
+
+function(current_micros out)
+    if(CMAKE_VERSION VERSION_LESS 3.23)
+        string(TIMESTAMP now "%s" UTC)
+        math(EXPR now "${now} * 1000000")
+    else()
+        string(TIMESTAMP now "%s%f" UTC)
+    endif()
+    set(${out} ${now} PARENT_SCOPE)
+endfunction()
+
+set(steps)
+set(package "${WORK_DIR}/workload.msix")
+
+# run_step(<name> [INPUT <file>] [OUTPUT <file>] ARGS <arguments...>)
+function(run_step name)
+    cmake_parse_arguments(STEP "" "INPUT;OUTPUT" "ARGS" ${ARGN})
+    set(redirect OUTPUT_FILE "${WORK_DIR}/${name}.log")
+    if(STEP_OUTPUT)
+        set(redirect OUTPUT_FILE "${STEP_OUTPUT}")
+    endif()
+    if(STEP_INPUT)
+        list(APPEND redirect INPUT_FILE "${STEP_INPUT}")
+    endif()
+
+    current_micros(start)
+    execute_process(COMMAND "${MAKEAPPX}" ${STEP_ARGS}
+        ${redirect}
+        ERROR_FILE "${WORK_DIR}/${name}.err"
+        RESULT_VARIABLE result)
+    current_micros(end)
+    if(NOT result EQUAL 0)
+        file(READ "${WORK_DIR}/${name}.err" details)
+        message(FATAL_ERROR "Workload step '${name}' failed (${result}): ${details}")
+    endif()
+
+    math(EXPR elapsed "(${end} - ${start}) / 1000")
+    if(DEFINED ${name}_total)
+        math(EXPR elapsed "${elapsed} + ${${name}_total}")
+    endif()
+    set(${name}_total ${elapsed} PARENT_SCOPE)
+    if(NOT name IN_LIST steps)
+        set(steps ${steps} ${name} PARENT_SCOPE)
+    endif()
+endfunction()
+
+foreach(iteration RANGE 1 ${ITERATIONS})
+    file(REMOVE_RECURSE "${WORK_DIR}/unpacked" "${WORK_DIR}/streamed")
+    run_step(pack ARGS pack -d "${corpus}" -p "${package}")
+    run_step(pack-fast ARGS pack -d "${corpus}" -p "${WORK_DIR}/workload-fast.msix" -c fast -q)
+    run_step(pack-stdout OUTPUT "${WORK_DIR}/workload-stream.msix" ARGS pack -d "${corpus}" -p -)
+    run_step(verify ARGS verify -p "${package}")
+    run_step(list ARGS list -p "${package}")
+    run_step(unpack ARGS unpack -p "${package}" -d "${WORK_DIR}/unpacked" -o)
+    run_step(unpack-stdin INPUT "${WORK_DIR}/workload-stream.msix"
+        ARGS unpack -p - -d "${WORK_DIR}/streamed" -o -q)
+    run_step(encrypt ARGS encrypt -p "${package}" -ep "${WORK_DIR}/workload.enc" -kf "${WORK_DIR}/workload.key")
+    run_step(decrypt ARGS decrypt -ep "${WORK_DIR}/workload.enc" -p "${WORK_DIR}/workload-decrypted.msix"
+        -kf "${WORK_DIR}/workload.key")
+endforeach()
+
+set(report "Workload timings over ${ITERATIONS} iteration(s), milliseconds per iteration:")
+set(overall 0)
+foreach(step IN LISTS steps)
+    math(EXPR average "${${step}_total} / ${ITERATIONS}")
+    math(EXPR overall "${overall} + ${average}")
+    string(APPEND report "\n  ${step}\t${average}")
+endforeach()
+string(APPEND report "\n  total\t${overall}")
+message(STATUS "${report}")
+
+if(PROFILE_DIR AND LLVM_PROFDATA)
+    file(GLOB raw "${PROFILE_DIR}/*.profraw")
+    if(NOT raw)
+        message(FATAL_ERROR "No raw profiles were written to ${PROFILE_DIR}")
+    endif()
+    execute_process(COMMAND "${LLVM_PROFDATA}" merge -output "${PROFILE_DIR}/makeappx.profdata" ${raw}
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "llvm-profdata merge failed (${result})")
+    endif()
+endif()
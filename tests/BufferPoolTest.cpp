@@ -0,0 +1,109 @@
+#include "BufferPool.h"
+#include "EntryCache.h"
+#include "TestSupport.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace MakeAppxCore;
+
+int main() {
+    // Unlimited: everything is granted and accounted for.
+    {
+        BufferPool pool;
+        BufferPool::Lease a = pool.Acquire(1000);
+        BufferPool::Lease b = pool.Reserve(5000);
+        CHECK(a.Data() != nullptr && a.Size() == 1000);
+        CHECK(reinterpret_cast<uintptr_t>(a.Data()) % BufferPool::ALIGNMENT == 0);
+        CHECK(b.Data() == nullptr && b.Size() == 5000);
+        CHECK(pool.InUse() == 6000);
+        b.Release();
+        CHECK(pool.InUse() == 1000);
+        CHECK(pool.Peak() == 6000);
+    }
+
+    // A thread holding a lease that asks for its next buffer past the limit is granted at once, not
+    // left waiting for itself. This is what a compressing worker does: deflate state, then buffers.
+    {
+        BufferPool pool;
+        pool.SetLimit(256 * 1024);
+        std::atomic<bool> done{ false };
+        std::thread worker([&]() {
+            BufferPool::Lease state = pool.Reserve(DEFLATE_STATE_MEMORY);
+            BufferPool::Lease in = pool.Acquire(64 * 1024);
+            BufferPool::Lease out = pool.Acquire(64 * 1024 + 64);
+            done = true;
+        });
+        for (int i = 0; i < 5000 && !done; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(done);
+        if (!done) {
+            // Unblocks the worker so the test reports instead of hanging.
+            pool.SetLimit(0);
+        }
+        worker.join();
+        CHECK(pool.Peak() > pool.Limit());
+    }
+
+    // A thread holding nothing waits until the memory it needs is released.
+    {
+        BufferPool pool;
+        pool.SetLimit(100 * 1024);
+        BufferPool::Lease held = pool.Reserve(80 * 1024);
+        std::atomic<bool> granted{ false };
+        std::thread waiter([&]() {
+            BufferPool::Lease lease = pool.Reserve(40 * 1024);
+            granted = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(!granted);
+        held.Release();
+        waiter.join();
+        CHECK(granted);
+        CHECK(pool.InUse() == 0);
+    }
+
+    // Several workers each holding one buffer and asking for a second, with room for only a few.
+    {
+        BufferPool pool;
+        pool.SetLimit(512 * 1024);
+        std::vector<std::thread> workers;
+        std::atomic<int> finished{ 0 };
+        for (int t = 0; t < 8; ++t) {
+            workers.emplace_back([&]() {
+                for (int i = 0; i < 200; ++i) {
+                    BufferPool::Lease first = pool.Acquire(128 * 1024);
+                    BufferPool::Lease second = pool.Acquire(128 * 1024);
+                    first.Data()[0] = second.Data()[0] = 1;
+                }
+                ++finished;
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        CHECK(finished == 8);
+        CHECK(pool.Peak() <= 512 * 1024 + 8 * 128 * 1024);
+    }
+
+    // A request larger than the whole budget is granted once nothing else is held.
+    {
+        BufferPool pool;
+        pool.SetLimit(64 * 1024);
+        BufferPool::Lease big = pool.Acquire(1 << 20);
+        CHECK(big.Size() == 1 << 20);
+    }
+
+    // Worker and buffer sizing follow the limit.
+    {
+        BufferPool pool;
+        CHECK(pool.WorkerCount(1 << 20, 8) == 8);
+        CHECK(pool.BufferSize(1 << 20, 64 * 1024) == 1 << 20);
+        pool.SetLimit(4 << 20);
+        CHECK(pool.WorkerCount(1 << 20, 8) == 4);
+        CHECK(pool.WorkerCount(8 << 20, 8) == 1);
+        CHECK(pool.BufferSize(1 << 20, 64 * 1024, 8) == 512 * 1024);
+    }
+
+    return MakeAppxTests::TestResult();
+}
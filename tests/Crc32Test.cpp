@@ -0,0 +1,44 @@
+#include "Crc32.h"
+#include "TestSupport.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace MakeAppxCore;
+
+int main() {
+    CHECK(Crc32(0, nullptr, 0) == 0);
+    CHECK(Crc32(0, "123456789", 9) == 0xCBF43926u);
+
+    std::vector<uint8_t> data(70000);
+    uint32_t state = 12345;
+    for (auto& byte : data) {
+        state = state * 1103515245u + 12345u;
+        byte = static_cast<uint8_t>(state >> 16);
+    }
+
+    // Every length around the vector widths, from every alignment the folding loop can start at.
+    for (size_t offset = 0; offset < 16; ++offset) {
+        for (size_t size = 0; size < 300; ++size) {
+            uint32_t expected = static_cast<uint32_t>(crc32(0, data.data() + offset, static_cast<uInt>(size)));
+            CHECK(Crc32(0, data.data() + offset, size) == expected);
+        }
+    }
+
+    uint32_t whole = static_cast<uint32_t>(crc32(0, data.data(), static_cast<uInt>(data.size())));
+    CHECK(Crc32(0, data.data(), data.size()) == whole);
+
+    // Chaining over uneven pieces gives the CRC of the whole buffer.
+    uint32_t chained = 0;
+    size_t position = 0;
+    for (size_t piece = 1; position < data.size(); piece = piece * 3 + 1) {
+        size_t size = std::min(piece, data.size() - position);
+        chained = Crc32(chained, data.data() + position, size);
+        position += size;
+    }
+    CHECK(chained == whole);
+
+    CHECK(Crc32Implementation() != nullptr && std::strlen(Crc32Implementation()) > 0);
+    return MakeAppxTests::TestResult();
+}
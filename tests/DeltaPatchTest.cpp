@@ -0,0 +1,166 @@
+#include "DeltaPatch.h"
+#include "TestSupport.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace MakeAppxCore;
+namespace fs = std::filesystem;
+
+namespace {
+    std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed) {
+        std::vector<uint8_t> data(size);
+        for (auto& byte : data) {
+            seed = seed * 1664525u + 1013904223u;
+            byte = static_cast<uint8_t>(seed >> 24);
+        }
+        return data;
+    }
+
+    std::vector<uint8_t> Text(size_t lines, const std::string& word) {
+        std::string text;
+        for (size_t i = 0; i < lines; ++i) {
+            text += word + " " + std::to_string(i) + "\n";
+        }
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    bool WritePackage(const fs::path& path, const std::vector<std::pair<std::wstring, std::vector<uint8_t>>>& entries) {
+        auto builder = CreatePackageBuilder();
+        for (const auto& entry : entries) {
+            if (!builder->AddEntry(entry.first, entry.second.data(), entry.second.size())) return false;
+        }
+        std::vector<uint8_t> package;
+        if (!builder->Write(package)) return false;
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(package.data()), static_cast<std::streamsize>(package.size()));
+        return out.good();
+    }
+
+    std::vector<uint8_t> ReadFile(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const fs::path& path, const std::vector<uint8_t>& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    uint64_t GetU64(const std::vector<uint8_t>& data, size_t offset) {
+        uint64_t value = 0;
+        memcpy(&value, data.data() + offset, sizeof(value));
+        return value;
+    }
+
+    void PutU64(std::vector<uint8_t>& data, size_t offset, uint64_t value) {
+        memcpy(data.data() + offset, &value, sizeof(value));
+    }
+
+    // Layout offsets of the patch format: the header's newSize, and the trailer's op list offset and count.
+    constexpr size_t HEADER_NEW_SIZE = 24;
+    constexpr size_t TRAILER_SIZE = 24;
+    constexpr size_t OP_SIZE = 49;
+
+    // Applying a damaged patch fails cleanly and leaves no output behind.
+    bool RejectsPatch(const fs::path& oldPath, const std::vector<uint8_t>& patch, const fs::path& directory) {
+        fs::path patchPath = directory / "damaged.patch";
+        fs::path outputPath = directory / "damaged.appx";
+        WriteFile(patchPath, patch);
+
+        std::wstring error;
+        bool applied = ApplyDeltaPatch(oldPath.wstring(), patchPath.wstring(), outputPath.wstring(), nullptr, error);
+        return !applied && !error.empty() && !fs::exists(outputPath) && !fs::exists(directory / "damaged.appx.apply.tmp");
+    }
+}
+
+int main() {
+    MakeAppxTests::TempDirectory temp("makeappx-delta");
+    fs::path oldPath = temp / "old.appx";
+    fs::path newPath = temp / "new.appx";
+    fs::path patchPath = temp / "update.patch";
+    fs::path outputPath = temp / "rebuilt.appx";
+
+    std::vector<uint8_t> shared = RandomBytes(300000, 7);
+    CHECK(WritePackage(oldPath, {
+        { L"AppxManifest.xml", Text(20, "<manifest>") },
+        { L"assets/big.bin", shared },
+        { L"code/app.js", Text(4000, "console.log") },
+        { L"removed.txt", Text(10, "gone") },
+    }));
+    CHECK(WritePackage(newPath, {
+        { L"AppxManifest.xml", Text(21, "<manifest>") },
+        { L"assets/big.bin", shared },
+        { L"code/app.js", Text(4000, "console.warn") },
+        { L"added.bin", RandomBytes(70000, 11) },
+    }));
+
+    std::wstring error;
+    DeltaStats stats;
+    CHECK(CreateDeltaPatch(oldPath.wstring(), newPath.wstring(), patchPath.wstring(), stats, nullptr, error));
+    CHECK(error.empty());
+    CHECK(stats.copiedBytes >= shared.size() / 2);
+    CHECK(stats.literalBytes > 0);
+    CHECK(fs::file_size(patchPath) < fs::file_size(newPath));
+
+    CHECK(ApplyDeltaPatch(oldPath.wstring(), patchPath.wstring(), outputPath.wstring(), nullptr, error));
+    CHECK(ReadFile(outputPath) == ReadFile(newPath));
+    CHECK(!fs::exists(temp / "update.patch.tmp"));
+
+    // Damaged and hostile patches.
+    std::vector<uint8_t> patch = ReadFile(patchPath);
+    size_t trailer = patch.size() - TRAILER_SIZE;
+    uint64_t opListOffset = GetU64(patch, trailer);
+    uint64_t opCount = GetU64(patch, trailer + 8);
+    CHECK(opListOffset + opCount * OP_SIZE == trailer);
+
+    std::vector<uint8_t> damaged = patch;
+    PutU64(damaged, trailer + 8, uint64_t(1) << 60);
+    CHECK(RejectsPatch(oldPath, damaged, temp.Path()));
+
+    damaged = patch;
+    PutU64(damaged, trailer + 8, opCount + 1);
+    CHECK(RejectsPatch(oldPath, damaged, temp.Path()));
+
+    damaged = patch;
+    PutU64(damaged, trailer, patch.size());
+    CHECK(RejectsPatch(oldPath, damaged, temp.Path()));
+
+    damaged = patch;
+    PutU64(damaged, HEADER_NEW_SIZE, uint64_t(1) << 50);
+    CHECK(RejectsPatch(oldPath, damaged, temp.Path()));
+
+    bool foundCopy = false;
+    for (uint64_t i = 0; i < opCount; ++i) {
+        size_t op = static_cast<size_t>(opListOffset + i * OP_SIZE);
+        if (patch[op] != 0) continue;
+        foundCopy = true;
+
+        damaged = patch;
+        PutU64(damaged, op + 9, fs::file_size(oldPath) - 1);
+        CHECK(RejectsPatch(oldPath, damaged, temp.Path()));
+
+        damaged = patch;
+        PutU64(damaged, op + 1, ~uint64_t(0));
+        CHECK(RejectsPatch(oldPath, damaged, temp.Path()));
+        break;
+    }
+    CHECK(foundCopy);
+
+    damaged.assign(patch.begin(), patch.begin() + patch.size() / 2);
+    CHECK(RejectsPatch(oldPath, damaged, temp.Path()));
+    damaged.assign(patch.begin(), patch.begin() + 10);
+    CHECK(RejectsPatch(oldPath, damaged, temp.Path()));
+
+    // The patch only applies to the package it was made from.
+    fs::path otherPath = temp / "other.appx";
+    CHECK(WritePackage(otherPath, { { L"AppxManifest.xml", Text(5, "<other>") } }));
+    error.clear();
+    CHECK(!ApplyDeltaPatch(otherPath.wstring(), patchPath.wstring(), (temp / "wrong.appx").wstring(), nullptr, error));
+    CHECK(!error.empty());
+    CHECK(!fs::exists(temp / "wrong.appx"));
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,158 @@
+#include "Crc32.h"
+#include "EntryCache.h"
+#include "TestSupport.h"
+#include <zlib.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+using namespace MakeAppxCore;
+namespace fs = std::filesystem;
+
+namespace {
+    std::string Content(size_t lines, const std::string& word) {
+        std::string text;
+        for (size_t i = 0; i < lines; ++i) {
+            text += word + " " + std::to_string(i) + "\n";
+        }
+        return text;
+    }
+
+    void WriteFile(const fs::path& path, const std::string& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::string ReadFile(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    PackageFile MakeFile(const fs::path& path) {
+        PackageFile file = {};
+        file.localPath = path;
+        file.packagePath = path.filename().string();
+        file.size = fs::file_size(path);
+        return file;
+    }
+
+    std::string Inflate(const std::string& data, size_t size) {
+        z_stream stream = {};
+        inflateInit2(&stream, -MAX_WBITS);
+        std::string out(size, '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream.avail_out = static_cast<uInt>(out.size());
+        int result = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        return result == Z_STREAM_END ? out : std::string();
+    }
+
+    fs::path FindBlob(const fs::path& root, const std::string& extension) {
+        for (const auto& item : fs::recursive_directory_iterator(root / "blobs")) {
+            if (item.path().extension() == extension) return item.path();
+        }
+        return fs::path();
+    }
+}
+
+int main() {
+    MakeAppxTests::TempDirectory temp("makeappx-cache");
+    fs::path source = temp / "app.js";
+    std::string content = Content(20000, "console.log");
+    WriteFile(source, content);
+
+    CompressedEntryCache cache(temp / "cache");
+    std::wstring error;
+    CHECK(cache.Open(error));
+
+    // Miss, store, then hit with the same data, CRC and blocks.
+    PackageFile file = MakeFile(source);
+    CompressedEntry entry;
+    CHECK(!cache.Lookup(file, 6, entry));
+
+    CompressedEntry stored;
+    CHECK(cache.Store(file, 6, stored, error));
+    CHECK(stored.uncompressedSize == content.size());
+    CHECK(stored.crc32 == Crc32(0, content.data(), content.size()));
+    CHECK(stored.blocks.size() == (content.size() + BLOCK_MAP_BLOCK_SIZE - 1) / BLOCK_MAP_BLOCK_SIZE);
+    CHECK(cache.GetMisses() == 1);
+
+    CHECK(cache.Lookup(file, 6, entry));
+    CHECK(cache.GetHits() == 1);
+    CHECK(entry.contentHash == stored.contentHash);
+    CHECK(entry.crc32 == stored.crc32 && entry.compressedSize == stored.compressedSize);
+    CHECK(entry.blocks.size() == stored.blocks.size());
+    CHECK(Inflate(ReadFile(entry.dataPath).substr(static_cast<size_t>(entry.dataOffset)), content.size()) == content);
+
+    // The quick key covers the level, the modification time and the size.
+    CHECK(!cache.Lookup(file, 9, entry));
+
+    fs::last_write_time(source, fs::last_write_time(source) + std::chrono::seconds(10));
+    CHECK(!cache.Lookup(file, 6, entry));
+
+    // Same content under a new key reuses the stored blob.
+    CHECK(cache.Store(file, 6, stored, error));
+    CHECK(cache.Lookup(file, 6, entry));
+
+    WriteFile(source, content + "tail\n");
+    fs::last_write_time(source, fs::last_write_time(source) - std::chrono::seconds(3600));
+    PackageFile grown = MakeFile(source);
+    CHECK(!cache.Lookup(grown, 6, entry));
+    grown.size = file.size;
+    CHECK(!cache.Lookup(grown, 6, entry));
+
+    // A truncated blob or metadata file is never served.
+    WriteFile(source, content);
+    file = MakeFile(source);
+    CHECK(cache.Store(file, 6, stored, error));
+    CHECK(cache.Lookup(file, 6, entry));
+
+    fs::path blob = FindBlob(temp / "cache", ".deflate");
+    fs::path meta = FindBlob(temp / "cache", ".meta");
+    CHECK(!blob.empty() && !meta.empty());
+
+    std::string blobData = ReadFile(blob);
+    WriteFile(blob, blobData.substr(0, blobData.size() / 2));
+    CHECK(!cache.Lookup(file, 6, entry));
+    WriteFile(blob, blobData);
+    CHECK(cache.Lookup(file, 6, entry));
+
+    std::string metaData = ReadFile(meta);
+    WriteFile(meta, metaData.substr(0, metaData.size() - 10));
+    CHECK(!cache.Lookup(file, 6, entry));
+    WriteFile(meta, metaData.substr(0, 6));
+    CHECK(!cache.Lookup(file, 6, entry));
+    WriteFile(meta, metaData);
+    CHECK(cache.Lookup(file, 6, entry));
+
+    // Stored entries pass the data through and leave every block's compressed size unset, so the block
+    // map omits Size for them.
+    std::istringstream input(content);
+    std::string passed;
+    CompressedEntry plain;
+    CHECK(EncodeEntry(input, 0, true, [&passed](const uint8_t* data, size_t size) {
+        passed.append(reinterpret_cast<const char*>(data), size);
+        return true;
+    }, plain, error));
+    CHECK(passed == content);
+    CHECK(plain.compressedSize == content.size() && plain.crc32 == stored.crc32);
+    CHECK(plain.blocks.size() == stored.blocks.size());
+    for (const auto& block : plain.blocks) {
+        CHECK(block.compressedSize == 0);
+    }
+    BlockMapEntry mapped;
+    mapped.name = "app.js";
+    mapped.size = plain.uncompressedSize;
+    mapped.blocks = plain.blocks;
+    CHECK(GenerateBlockMapXml({ mapped }).find("Size=\"65536\"") == std::string::npos);
+
+    // A missing source file is a clean miss.
+    PackageFile missing = file;
+    missing.localPath = temp / "missing.js";
+    CHECK(!cache.Lookup(missing, 6, entry));
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,41 @@
+#include "ExtractionPlan.h"
+#include "TestSupport.h"
+#include <string>
+#include <vector>
+
+using namespace MakeAppxCore;
+
+int main() {
+    std::vector<std::string> segments;
+    bool isDirectory = false;
+
+    CHECK(SplitEntryPath("Assets/./Logo.png", segments, isDirectory));
+    CHECK((segments == std::vector<std::string>{ "Assets", "Logo.png" }) && !isDirectory);
+    CHECK(SplitEntryPath("/Assets\\Sub/", segments, isDirectory));
+    CHECK((segments == std::vector<std::string>{ "Assets", "Sub" }) && isDirectory);
+
+    const char* hostile[] = { "../evil.txt", "a/../../evil.txt", "a\\..\\evil.txt", "..", "/", "./" };
+    for (const char* name : hostile) {
+        CHECK(!SplitEntryPath(name, segments, isDirectory));
+    }
+#ifdef _WIN32
+    CHECK(!SplitEntryPath("C:/Windows/evil.dll", segments, isDirectory));
+    CHECK(!SplitEntryPath("a/C:evil.txt", segments, isDirectory));
+#endif
+
+    // Rejected entries are reported, not planned.
+    MakeAppxTests::TempDirectory temp("makeappx-plan");
+    ExtractionPlan plan(temp / "out");
+    CHECK(plan.Add(0, "AppxManifest.xml", 10));
+    CHECK(!plan.Add(1, "../evil.txt", 10));
+    CHECK(!plan.GetLastError().empty());
+    CHECK(plan.Add(2, "Assets/Logo.png", 10));
+    CHECK(plan.Files().size() == 2);
+    for (const auto& file : plan.Files()) {
+        CHECK(file.entry != 1);
+        CHECK(file.path.parent_path().string().find((temp / "out").string()) == 0);
+    }
+    CHECK(plan.Prepare(OverwriteMode::Yes));
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,74 @@
+#include "JsonUtil.h"
+#include "TestSupport.h"
+#include <string>
+
+using namespace MakeAppxCore;
+
+namespace {
+    bool Parses(const std::string& text, JsonObject& object) {
+        std::string error;
+        object.clear();
+        return ParseJsonObject(text, object, error) && error.empty();
+    }
+
+    bool Rejects(const std::string& text) {
+        JsonObject object;
+        std::string error;
+        return !ParseJsonObject(text, object, error) && !error.empty();
+    }
+}
+
+int main() {
+    JsonObject request;
+
+    // Request lines as the packaging server receives them.
+    CHECK(Parses("{\"id\":\"1\",\"op\":\"pack\",\"input\":\"/src/app\",\"output\":\"/out/app.msix\","
+        "\"compression\":\"fast\",\"cache\":null,\"workers\":4}", request));
+    CHECK(request.size() == 7);
+    CHECK(request["op"] == "pack");
+    CHECK(request["input"] == "/src/app");
+    CHECK(request["cache"].empty());
+    CHECK(request["workers"] == "4");
+
+    CHECK(Parses(" { \"op\" : \"ping\" } ", request) && request["op"] == "ping");
+    CHECK(Parses("{}", request) && request.empty());
+
+    // Escapes, including a path with backslashes and a surrogate pair.
+    CHECK(Parses("{\"input\":\"C:\\\\Apps\\\\caf\\u00e9\\t\\\"x\\\"\"}", request));
+    CHECK(request["input"] == "C:\\Apps\\caf\xC3\xA9\t\"x\"");
+    CHECK(Parses("{\"name\":\"\\ud83d\\ude00\\u20ac\"}", request));
+    CHECK(request["name"] == "\xF0\x9F\x98\x80\xE2\x82\xAC");
+
+    // Surrogates that do not form a pair never reach a path.
+    CHECK(Rejects("{\"input\":\"\\uD800\\u0041\"}"));
+    CHECK(Rejects("{\"input\":\"\\uD800\"}"));
+    CHECK(Rejects("{\"input\":\"\\uD800x\"}"));
+    CHECK(Rejects("{\"input\":\"\\uDC00\"}"));
+    CHECK(Rejects("{\"input\":\"\\uD800\\uD800\"}"));
+    CHECK(Rejects("{\"input\":\"\\u12\"}"));
+
+    // Malformed objects.
+    CHECK(Rejects(""));
+    CHECK(Rejects("[\"op\"]"));
+    CHECK(Rejects("{\"op\":\"pack\""));
+    CHECK(Rejects("{\"op\" \"pack\"}"));
+    CHECK(Rejects("{op:\"pack\"}"));
+    CHECK(Rejects("{\"op\":\"pack\"} trailing"));
+    CHECK(Rejects("{\"op\":\"pa\\qck\"}"));
+
+    // Responses written by JsonWriter parse back to the same values.
+    JsonWriter writer;
+    writer.BeginObject()
+        .Key("id").String("7")
+        .Key("event").String("progress")
+        .Key("currentFile").String("dir/\"quoted\"\n\x01.txt")
+        .Key("processedBytes").Number(uint64_t(1) << 40)
+        .Key("success").Bool(true)
+        .EndObject();
+    CHECK(Parses(writer.Str(), request));
+    CHECK(request["currentFile"] == "dir/\"quoted\"\n\x01.txt");
+    CHECK(request["processedBytes"] == "1099511627776");
+    CHECK(request["success"] == "true");
+
+    return MakeAppxTests::TestResult();
+}
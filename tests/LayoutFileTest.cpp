@@ -0,0 +1,76 @@
+#include "LayoutFile.h"
+#include "TestSupport.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace MakeAppxCore;
+namespace fs = std::filesystem;
+
+namespace {
+    void WriteFile(const fs::path& path, const std::string& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+}
+
+int main() {
+    MakeAppxTests::TempDirectory temp("makeappx-layout");
+    fs::create_directories(temp / "src" / "Assets");
+    WriteFile(temp / "src" / "AppxManifest.xml", "<Package/>");
+    WriteFile(temp / "src" / "Assets" / "Logo.png", std::string(1234, 'L'));
+
+    std::string src = (temp / "src").string();
+    std::vector<PackageFile> files;
+    std::wstring error;
+
+    // BOM, comments, blank lines, CRLF and lines without a full pair of quoted paths.
+    WriteFile(temp / "layout.txt",
+        "\xEF\xBB\xBF# layout\r\n"
+        "\r\n"
+        "  \"" + src + "/AppxManifest.xml\" \"AppxManifest.xml\"\r\n"
+        "\t# \"" + src + "/missing\" \"commented\"\n"
+        "\"" + src + "/Assets/Logo.png\"\t\"Assets\\Logo.png\"\n"
+        "\"" + src + "/AppxManifest.xml\" incomplete\n"
+        "\"" + src + "/AppxManifest.xml\" \"Copy.xml\"");
+    CHECK(ReadLayoutFile((temp / "layout.txt").wstring(), files, error));
+    CHECK(files.size() == 3);
+    if (files.size() == 3) {
+        CHECK(files[0].packagePath == "AppxManifest.xml" && files[0].size == 10);
+        CHECK(files[1].packagePath == "Assets\\Logo.png" && files[1].size == 1234);
+        CHECK(files[1].localPath == temp / "src" / "Assets" / "Logo.png");
+        CHECK(files[2].packagePath == "Copy.xml");
+    }
+
+    // More files than one stat batch.
+    std::string many;
+    for (int i = 0; i < 300; ++i) {
+        WriteFile(temp / "src" / ("f" + std::to_string(i)), std::string(static_cast<size_t>(i), 'x'));
+        many += "\"" + src + "/f" + std::to_string(i) + "\" \"f" + std::to_string(i) + "\"\n";
+    }
+    WriteFile(temp / "many.txt", many);
+    CHECK(ReadLayoutFile((temp / "many.txt").wstring(), files, error));
+    CHECK(files.size() == 300);
+    for (size_t i = 0; i < files.size(); ++i) {
+        CHECK(files[i].size == i);
+    }
+
+    // Every unusable source is listed with its line, and nothing is returned.
+    WriteFile(temp / "bad.txt",
+        "\"" + src + "/AppxManifest.xml\" \"AppxManifest.xml\"\n"
+        "\"" + src + "/missing.dll\" \"missing.dll\"\n"
+        "\"" + src + "/Assets\" \"Assets\"\n");
+    CHECK(!ReadLayoutFile((temp / "bad.txt").wstring(), files, error));
+    CHECK(files.empty());
+    CHECK(error.find(L"2 of 3 layout sources") == 0);
+    CHECK(error.find(L"line 2:") != std::wstring::npos && error.find(L"(not found)") != std::wstring::npos);
+    CHECK(error.find(L"line 3:") != std::wstring::npos && error.find(L"(not a regular file)") != std::wstring::npos);
+
+    WriteFile(temp / "empty.txt", "# nothing\n\n");
+    CHECK(!ReadLayoutFile((temp / "empty.txt").wstring(), files, error));
+    CHECK(error.find(L"no file mappings") != std::wstring::npos);
+    CHECK(!ReadLayoutFile((temp / "missing.txt").wstring(), files, error));
+    CHECK(error.find(L"Cannot open layout file") == 0);
+
+    return MakeAppxTests::TestResult();
+}
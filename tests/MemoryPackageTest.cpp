@@ -0,0 +1,162 @@
+#include "AppxPackage.h"
+#include "BlockMap.h"
+#include "TestSupport.h"
+#include "ZipDirectory.h"
+#include "ZipStream.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace MakeAppxCore;
+namespace fs = std::filesystem;
+
+namespace {
+    const char MANIFEST[] = "<Package/>";
+
+    std::string Pattern(size_t size) {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>('a' + (i * 7 + i / 1000) % 26);
+        }
+        return data;
+    }
+
+    // Hands out the data in uneven slices, the way a caller streaming from elsewhere would.
+    EntryReader SliceReader(const std::string& data, size_t slice) {
+        auto offset = std::make_shared<size_t>(0);
+        return [&data, slice, offset](uint8_t* buffer, size_t size, size_t& produced) {
+            produced = std::min({ size, slice, data.size() - *offset });
+            memcpy(buffer, data.data() + *offset, produced);
+            *offset += produced;
+            return true;
+        };
+    }
+
+    std::string ReadStream(std::istream& stream) {
+        std::string data;
+        char buffer[8192];
+        while (stream.read(buffer, sizeof(buffer)) || stream.gcount() > 0) {
+            data.append(buffer, static_cast<size_t>(stream.gcount()));
+        }
+        return data;
+    }
+}
+
+int main() {
+    std::string large = Pattern(300000);
+    std::string streamed = Pattern(150001);
+    std::string contentTypes = "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\"/>";
+
+    for (CompressionLevel compression : { CompressionLevel::None, CompressionLevel::Normal }) {
+        auto builder = CreatePackageBuilder(compression);
+        CHECK(builder->AddEntry(L"AppxManifest.xml", MANIFEST, strlen(MANIFEST)));
+        CHECK(builder->AddEntry(L"Assets\\Large.bin", std::vector<uint8_t>(large.begin(), large.end())));
+        CHECK(builder->AddEntry(L"./data/streamed.txt", streamed.size(), SliceReader(streamed, 4097)));
+        CHECK(builder->AddEntry(L"[Content_Types].xml", contentTypes.data(), contentTypes.size()));
+
+        std::vector<uint8_t> package;
+        CHECK(builder->Write(package));
+
+        // The reader sees every entry in order, followed by the generated block map.
+        auto reader = CreatePackageReader();
+        CHECK(reader->Open(package.data(), package.size()));
+        const PackageInfo& info = reader->Info();
+        CHECK(info.hasBlockMap && !info.hasSignature && info.fileSize == package.size());
+        CHECK(info.entries.size() == 5);
+        CHECK(info.uncompressedSize >= large.size() + streamed.size());
+
+        std::string data;
+        CHECK(reader->ReadEntry(L"appxmanifest.XML", data) && data == MANIFEST);
+        CHECK(reader->ReadEntry(L"assets/large.bin", data) && data == large);
+
+        auto first = reader->OpenEntry(L"data/streamed.txt");
+        auto second = reader->OpenEntry(L"Assets/Large.bin");
+        CHECK(first && second);
+        if (first && second) {
+            char head[100];
+            first->read(head, sizeof(head));
+            CHECK(ReadStream(*second) == large);
+            CHECK(std::string(head, sizeof(head)) + ReadStream(*first) == streamed);
+            CHECK(!first->bad());
+        }
+
+        // The block map lists payload only, each with the exact local header size.
+        std::vector<BlockMapEntry> blockMap;
+        CHECK(reader->ReadEntry(L"AppxBlockMap.xml", data) && ParseBlockMapXml(data, blockMap));
+        CHECK(blockMap.size() == 3);
+        MemorySource source(package.data(), package.size());
+        ZipDirectory directory;
+        CHECK(directory.Read(source));
+        for (const auto& entry : blockMap) {
+            const ZipDirectoryEntry* zipEntry = directory.Find(entry.name);
+            uint64_t dataOffset = 0;
+            CHECK(zipEntry && directory.ReadDataOffset(source, *zipEntry, dataOffset));
+            CHECK(zipEntry && dataOffset - zipEntry->localHeaderOffset == entry.lfhSize);
+            CHECK(zipEntry && (compression == CompressionLevel::None) == (zipEntry->method == ZIP_METHOD_STORE));
+        }
+
+        // The same bytes verify as a package on disk.
+        MakeAppxTests::TempDirectory temp("makeappx-memory");
+        {
+            std::ofstream out(temp / "app.appx", std::ios::binary);
+            out.write(reinterpret_cast<const char*>(package.data()), static_cast<std::streamsize>(package.size()));
+        }
+        VerifyResult result;
+        CHECK(CreateAppxPackage()->Verify((temp / "app.appx").wstring(), result));
+        CHECK(result.blockMapChecked && result.failures.empty());
+
+        // A corrupted byte fails the entry's stream rather than returning wrong data.
+        std::vector<uint8_t> corrupt = package;
+        const ZipDirectoryEntry* target = directory.Find("Assets/Large.bin");
+        uint64_t targetOffset = 0;
+        CHECK(target && directory.ReadDataOffset(source, *target, targetOffset));
+        corrupt[static_cast<size_t>(targetOffset + target->compressedSize / 2)] ^= 0x55;
+        auto corruptReader = CreatePackageReader();
+        CHECK(corruptReader->Open(corrupt.data(), corrupt.size()));
+        auto broken = corruptReader->OpenEntry(L"Assets/Large.bin");
+        CHECK(broken);
+        if (broken) {
+            ReadStream(*broken);
+            CHECK(broken->bad());
+        }
+    }
+
+    // Names and content the builder refuses.
+    auto builder = CreatePackageBuilder();
+    CHECK(builder->AddEntry(L"Assets/Logo.png", MANIFEST, 1));
+    CHECK(!builder->AddEntry(L"assets\\LOGO.PNG", MANIFEST, 1));
+    CHECK(builder->GetLastError().find(L"Duplicate entry") == 0);
+    CHECK(!builder->AddEntry(L"AppxBlockMap.xml", MANIFEST, 1));
+    CHECK(!builder->AddEntry(L"../evil.txt", MANIFEST, 1));
+    CHECK(!builder->AddEntry(L"Assets/", MANIFEST, 1));
+    CHECK(!builder->AddEntry(L"empty.txt", 0, EntryReader()));
+
+    std::vector<uint8_t> package;
+    CHECK(!builder->Write(package));
+    CHECK(builder->GetLastError() == L"AppxManifest.xml not found");
+
+    CHECK(builder->AddEntry(L"AppxManifest.xml", MANIFEST, strlen(MANIFEST)));
+    CHECK(builder->AddEntry(L"short.bin", streamed.size() + 1, SliceReader(streamed, 65536)));
+    CHECK(!builder->Write(package));
+    CHECK(builder->GetLastError().find(L"instead of") != std::wstring::npos);
+
+    auto failing = CreatePackageBuilder();
+    CHECK(failing->AddEntry(L"AppxManifest.xml", MANIFEST, strlen(MANIFEST)));
+    CHECK(failing->AddEntry(L"fail.bin", 10, [](uint8_t*, size_t, size_t& produced) {
+        produced = 0;
+        return false;
+    }));
+    CHECK(!failing->Write(package));
+
+    // Readers reject garbage and report missing entries.
+    auto reader = CreatePackageReader();
+    std::string garbage(1000, 'x');
+    CHECK(!reader->Open(garbage.data(), garbage.size()));
+    std::string data;
+    CHECK(!reader->ReadEntry(L"AppxManifest.xml", data));
+    CHECK(reader->GetLastError() == L"No package is open");
+
+    return MakeAppxTests::TestResult();
+}
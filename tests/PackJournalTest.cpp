@@ -0,0 +1,95 @@
+#include "PackJournal.h"
+#include "TestSupport.h"
+
+using namespace MakeAppxCore;
+
+namespace {
+    JournalEntry MakeEntry(const std::string& name, uint64_t size, uint64_t offset) {
+        JournalEntry entry;
+        entry.directory.name = name;
+        entry.directory.method = 8;
+        entry.directory.crc32 = 0x12345678u ^ static_cast<uint32_t>(size);
+        entry.directory.uncompressedSize = size;
+        entry.directory.compressedSize = size / 2;
+        entry.directory.localHeaderOffset = offset;
+        entry.directory.recordEnd = offset + 30 + name.size() + size / 2 + 16;
+        entry.sourceModified = 1600000000 + static_cast<time_t>(size);
+        entry.blocks.resize((size + BLOCK_MAP_BLOCK_SIZE - 1) / BLOCK_MAP_BLOCK_SIZE);
+        for (size_t i = 0; i < entry.blocks.size(); ++i) {
+            entry.blocks[i].hash.fill(static_cast<uint8_t>(i + size));
+            entry.blocks[i].compressedSize = static_cast<uint32_t>(1000 + i);
+        }
+        return entry;
+    }
+
+    bool SameEntry(const JournalEntry& a, const JournalEntry& b) {
+        if (a.directory.name != b.directory.name || a.directory.crc32 != b.directory.crc32 ||
+            a.directory.uncompressedSize != b.directory.uncompressedSize ||
+            a.directory.compressedSize != b.directory.compressedSize ||
+            a.directory.localHeaderOffset != b.directory.localHeaderOffset ||
+            a.directory.recordEnd != b.directory.recordEnd || a.sourceModified != b.sourceModified ||
+            a.blocks.size() != b.blocks.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.blocks.size(); ++i) {
+            if (a.blocks[i].hash != b.blocks[i].hash || a.blocks[i].compressedSize != b.blocks[i].compressedSize) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    MakeAppxTests::TempDirectory temp("makeappx-journal");
+    fs::path package = temp / "out.appx";
+
+    std::vector<JournalEntry> written = {
+        MakeEntry("a.txt", 0, 0),
+        MakeEntry("dir/b.bin", 200000, 100),
+        MakeEntry("c.dat", 65536, 120000),
+    };
+
+    {
+        PackJournal journal(package);
+        CHECK(journal.Path() == temp / "out.appx.journal");
+        CHECK(journal.Start(6, { written[0] }));
+        CHECK(journal.Append(written[1]));
+        CHECK(journal.Append(written[2]));
+    }
+
+    // Round trip.
+    std::vector<JournalEntry> loaded;
+    PackJournal reader(package);
+    CHECK(reader.Load(6, loaded));
+    CHECK(loaded.size() == written.size());
+    for (size_t i = 0; i < loaded.size() && i < written.size(); ++i) {
+        CHECK(SameEntry(loaded[i], written[i]));
+    }
+
+    // A journal of another compression level is not used.
+    CHECK(!reader.Load(9, loaded));
+    CHECK(loaded.empty());
+
+    // A record torn by a crash ends the log; the records before it survive.
+    fs::resize_file(reader.Path(), fs::file_size(reader.Path()) - 5);
+    CHECK(reader.Load(6, loaded));
+    CHECK(loaded.size() == 2);
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        CHECK(SameEntry(loaded[i], written[i]));
+    }
+
+    // Start replaces what was there.
+    {
+        PackJournal journal(package);
+        CHECK(journal.Start(6, { written[2] }));
+    }
+    CHECK(reader.Load(6, loaded));
+    CHECK(loaded.size() == 1 && SameEntry(loaded[0], written[2]));
+
+    reader.Remove();
+    CHECK(!fs::exists(reader.Path()));
+    CHECK(!reader.Load(6, loaded));
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,141 @@
+#include "BlockMap.h"
+#include "EntryCache.h"
+#include "PackageDiff.h"
+#include "TestSupport.h"
+#include "ZipStream.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace MakeAppxCore;
+namespace fs = std::filesystem;
+
+namespace {
+    enum class BlockMapMode {
+        None,
+        Valid,
+        TamperFirst,
+        Invalid
+    };
+
+    // Stored entries plus, unless mode is None, a block map listing them.
+    bool WritePackage(const fs::path& path, const std::vector<std::pair<std::string, std::string>>& files,
+        BlockMapMode mode) {
+
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        ZipStreamWriter writer(StreamSink([&output](const uint8_t* data, size_t size) {
+            output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            return output.good();
+        }));
+        auto sink = [&writer](const uint8_t* data, size_t size) {
+            return writer.Write(data, size);
+        };
+        auto add = [&](const std::string& name, const std::string& data, std::vector<BlockMapBlock>* blocks) {
+            std::istringstream input(data);
+            CompressedEntry entry;
+            std::wstring error;
+            if (!writer.BeginEntry(name, ZIP_METHOD_STORE, 1600000000, data.size()) ||
+                !EncodeEntry(input, 0, true, sink, entry, error) ||
+                !writer.EndEntry(entry.crc32, entry.uncompressedSize)) {
+                return false;
+            }
+            if (blocks) *blocks = entry.blocks;
+            return true;
+        };
+
+        std::vector<BlockMapEntry> blockMap(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            blockMap[i].name = files[i].first;
+            blockMap[i].size = files[i].second.size();
+            if (!add(files[i].first, files[i].second, &blockMap[i].blocks)) return false;
+        }
+        if (mode == BlockMapMode::TamperFirst && !blockMap.empty() && !blockMap[0].blocks.empty()) {
+            blockMap[0].blocks[0].hash[0] ^= 0xFF;
+        }
+
+        if (mode == BlockMapMode::Invalid) {
+            if (!add(BLOCK_MAP_ENTRY_NAME, "<BlockMap><File", nullptr)) return false;
+        }
+        else if (mode != BlockMapMode::None) {
+            if (!add(BLOCK_MAP_ENTRY_NAME, GenerateBlockMapXml(blockMap), nullptr)) return false;
+        }
+        return writer.Finish();
+    }
+
+    const PackageDiffEntry* FindChange(const PackageDiff& diff, const std::wstring& name) {
+        for (const auto& entry : diff.entries) {
+            if (entry.name == name) return &entry;
+        }
+        return nullptr;
+    }
+}
+
+int main() {
+    MakeAppxTests::TempDirectory temp("makeappx-diff");
+    fs::path oldPath = temp / "old.appx";
+    fs::path newPath = temp / "new.appx";
+
+    CHECK(WritePackage(oldPath, {
+        { "AppxManifest.xml", "<Package/>" },
+        { "Assets/Logo.png", std::string(70000, 'L') },
+        { "removed.txt", "gone" },
+        { "changed.txt", "before" },
+    }, BlockMapMode::Valid));
+    CHECK(WritePackage(newPath, {
+        { "AppxManifest.xml", "<Package/>" },
+        { "assets\\LOGO.png", std::string(70000, 'L') },
+        { "changed.txt", "after!" },
+        { "added.txt", "new" },
+    }, BlockMapMode::Valid));
+
+    // Names match case-insensitively across separators; the result is sorted by name.
+    PackageDiff diff;
+    std::wstring error;
+    CHECK(DiffPackages(oldPath.wstring(), newPath.wstring(), false, diff, error));
+    CHECK(!diff.blockMapsCompared);
+    CHECK(diff.entries.size() == 4 && diff.unchanged == 2);
+    CHECK(diff.entries.size() == 4 && diff.entries[0].name == L"AppxBlockMap.xml" && diff.entries[3].name == L"removed.txt");
+
+    const PackageDiffEntry* added = FindChange(diff, L"added.txt");
+    CHECK(added && added->change == DiffChange::Added && added->newSize == 3 && added->oldSize == 0);
+    const PackageDiffEntry* removed = FindChange(diff, L"removed.txt");
+    CHECK(removed && removed->change == DiffChange::Removed && removed->oldSize == 4);
+    const PackageDiffEntry* changed = FindChange(diff, L"changed.txt");
+    CHECK(changed && changed->change == DiffChange::Modified && changed->oldSize == changed->newSize);
+    CHECK(changed && changed->oldCrc32 != changed->newCrc32 && !changed->blockMapDiffers);
+
+    // Strict mode finds the renamed logo's blocks unchanged too.
+    CHECK(DiffPackages(oldPath.wstring(), newPath.wstring(), true, diff, error));
+    CHECK(diff.blockMapsCompared);
+    CHECK(diff.entries.size() == 4 && diff.unchanged == 2 && !FindChange(diff, L"assets\\LOGO.png"));
+
+    // Same CRC and size but different block hashes only shows up in strict mode.
+    std::vector<std::pair<std::string, std::string>> files = {
+        { "AppxManifest.xml", "<Package/>" },
+        { "data.bin", std::string(200000, 'd') },
+    };
+    CHECK(WritePackage(oldPath, files, BlockMapMode::Valid));
+    CHECK(WritePackage(newPath, files, BlockMapMode::TamperFirst));
+    CHECK(DiffPackages(oldPath.wstring(), newPath.wstring(), false, diff, error));
+    CHECK(diff.entries.size() == 1 && diff.entries[0].name == L"AppxBlockMap.xml");
+    CHECK(DiffPackages(oldPath.wstring(), newPath.wstring(), true, diff, error));
+    const PackageDiffEntry* manifest = FindChange(diff, L"AppxManifest.xml");
+    CHECK(manifest && manifest->change == DiffChange::Modified && manifest->blockMapDiffers);
+    CHECK(manifest && manifest->oldCrc32 == manifest->newCrc32);
+    CHECK(!FindChange(diff, L"data.bin") && diff.unchanged == 1);
+
+    // Block maps are only compared when both packages have one; a broken one is an error.
+    CHECK(WritePackage(newPath, files, BlockMapMode::None));
+    CHECK(DiffPackages(oldPath.wstring(), newPath.wstring(), true, diff, error));
+    CHECK(!diff.blockMapsCompared);
+    CHECK(WritePackage(newPath, files, BlockMapMode::Invalid));
+    CHECK(!DiffPackages(oldPath.wstring(), newPath.wstring(), true, diff, error));
+    CHECK(error.find(L"Invalid block map") == 0);
+    CHECK(DiffPackages(oldPath.wstring(), newPath.wstring(), false, diff, error));
+
+    CHECK(!DiffPackages((temp / "missing.appx").wstring(), newPath.wstring(), false, diff, error));
+    CHECK(error.find(L"Cannot open package") == 0);
+
+    return MakeAppxTests::TestResult();
+}
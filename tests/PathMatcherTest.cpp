@@ -0,0 +1,62 @@
+#include "PathMatcher.h"
+#include "TestSupport.h"
+
+using namespace MakeAppxCore;
+
+int main() {
+    CHECK(MatchSegmentGlob("*.txt", "readme.txt"));
+    CHECK(MatchSegmentGlob("a?c", "abc"));
+    CHECK(MatchSegmentGlob("*", ""));
+    CHECK(MatchSegmentGlob("a*b*c", "aXXbYYc"));
+    CHECK(!MatchSegmentGlob("*.txt", "readme.txt.bak"));
+    CHECK(!MatchSegmentGlob("a?c", "ac"));
+
+    PathMatcher empty;
+    CHECK(empty.Empty());
+    CHECK(!empty.Match("anything"));
+
+    PathMatcher matcher;
+    matcher.AddPattern("*.pdb");
+    matcher.AddPattern("/build/");
+    matcher.AddPattern("docs/**/draft-?.md");
+    matcher.AddPattern("Temp/");
+    CHECK(matcher.PatternCount() == 4);
+
+    // A pattern without a slash matches at any depth.
+    CHECK(matcher.Match("app.pdb"));
+    CHECK(matcher.Match("bin/x64/App.PDB"));
+    CHECK(!matcher.Match("app.pdb.txt"));
+
+    // A leading slash anchors to the root; a matched directory takes its whole subtree with it.
+    CHECK(matcher.Match("build"));
+    CHECK(matcher.Match("build/obj/main.o"));
+    CHECK(!matcher.Match("src/build/main.o"));
+
+    // ** spans any number of directories, including none.
+    CHECK(matcher.Match("docs/draft-1.md"));
+    CHECK(matcher.Match("docs/a/b/c/draft-2.md"));
+    CHECK(!matcher.Match("docs/a/draft-10.md"));
+    CHECK(!matcher.Match("other/docs/draft-1.md"));
+
+    // A trailing slash alone does not anchor.
+    CHECK(matcher.Match("src/temp/cache.bin"));
+
+    // Matching is case-insensitive and takes either separator.
+    CHECK(matcher.Match("DOCS\\x\\Draft-3.MD"));
+    CHECK(!matcher.Match("src/main.cpp"));
+
+    // Siblings and unrelated paths in any order, so state kept from the previous path is not trusted blindly.
+    CHECK(matcher.Match("build/a"));
+    CHECK(!matcher.Match("buildings/a"));
+    CHECK(matcher.Match("build/b"));
+    CHECK(!matcher.Match("src/a"));
+    CHECK(matcher.Match("src/a/b.pdb"));
+    CHECK(!matcher.Match("src/a/b.cpp"));
+
+    PathMatcher anchored;
+    anchored.AddPattern("Assets", true);
+    CHECK(anchored.Match("assets/logo.png"));
+    CHECK(!anchored.Match("src/assets/logo.png"));
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,168 @@
+#include "AsyncOperation.h"
+#include "TaskScheduler.h"
+#include "TestSupport.h"
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MakeAppxCore;
+namespace fs = std::filesystem;
+
+namespace {
+    // Enough poorly compressible text that compression is still running when the test pauses it.
+    void WriteTree(const fs::path& root) {
+        fs::create_directories(root / "data");
+        std::ofstream(root / "AppxManifest.xml") << "<Package/>";
+        uint32_t state = 1;
+        for (int file = 0; file < 96; ++file) {
+            std::string text(1 << 20, ' ');
+            for (auto& c : text) {
+                state = state * 1664525u + 1013904223u;
+                c = static_cast<char>('a' + (state >> 24) % 26);
+            }
+            std::ofstream(root / "data" / ("file" + std::to_string(file) + ".txt"), std::ios::binary) << text;
+        }
+    }
+}
+
+int main() {
+    TaskScheduler scheduler(4, 4);
+    CHECK(scheduler.ThreadCount(TaskClass::Cpu) == 4);
+    CHECK(scheduler.ThreadCount(TaskClass::Io) == 4);
+    CHECK(scheduler.CurrentWorker(TaskClass::Cpu) == 4);
+
+    // Every task runs exactly once, on a worker of its own class.
+    for (TaskClass taskClass : { TaskClass::Cpu, TaskClass::Io }) {
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<bool> offWorker{ false };
+        TaskGroup group(taskClass, 0, scheduler);
+        for (uint64_t i = 1; i <= 10000; ++i) {
+            group.Run([&, i, taskClass]() {
+                if (scheduler.CurrentWorker(taskClass) >= scheduler.ThreadCount(taskClass)) offWorker = true;
+                sum += i;
+            }, i % 3 == 0 ? TaskScheduler::LARGE_TASK : 0);
+        }
+        group.Wait();
+        CHECK(sum == 10000ull * 10001ull / 2);
+        CHECK(!offWorker);
+    }
+
+    // Tasks that wait for tasks of their own class; more than there are workers, so waiting workers
+    // have to run the inner tasks themselves.
+    {
+        std::atomic<size_t> inner{ 0 };
+        TaskGroup outer(TaskClass::Cpu, 0, scheduler);
+        for (int i = 0; i < 16; ++i) {
+            outer.Run([&]() {
+                TaskGroup nested(TaskClass::Cpu, 0, scheduler);
+                for (int j = 0; j < 50; ++j) {
+                    nested.Run([&]() { ++inner; });
+                }
+                nested.Wait();
+            });
+        }
+        outer.Wait();
+        CHECK(inner == 16 * 50);
+    }
+
+    // A limited group never runs more than its limit at once.
+    {
+        std::atomic<size_t> running{ 0 }, peak{ 0 }, done{ 0 };
+        TaskGroup group(TaskClass::Io, 2, scheduler);
+        CHECK(group.Concurrency() == 2);
+        for (int i = 0; i < 200; ++i) {
+            group.Run([&]() {
+                size_t now = ++running;
+                size_t seen = peak;
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                --running;
+                ++done;
+            });
+        }
+        group.Wait();
+        CHECK(done == 200);
+        CHECK(peak <= 2);
+    }
+
+    // Held tasks start heaviest first, equal weights in the order they were added.
+    {
+        std::mutex mutex;
+        std::vector<int> order;
+        std::atomic<bool> release{ false };
+        TaskGroup group(TaskClass::Cpu, 1, scheduler);
+        group.Run([&]() {
+            while (!release) std::this_thread::yield();
+        });
+        const uint64_t weights[] = { 10, 500, 10, 7000, 1 };
+        for (int i = 0; i < 5; ++i) {
+            group.Run([&, i]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(i);
+            }, weights[i]);
+        }
+        CHECK(!group.WaitFor(std::chrono::milliseconds(20)));
+        release = true;
+        CHECK(group.WaitFor(std::chrono::seconds(60)));
+        CHECK((order == std::vector<int>{ 3, 1, 0, 2, 4 }));
+    }
+
+    // An empty group is done at once.
+    {
+        TaskGroup group(TaskClass::Io, 0, scheduler);
+        CHECK(group.WaitFor(std::chrono::milliseconds(0)));
+    }
+
+    // A paused operation waits on its own thread and leaves the shared workers to everyone else.
+    {
+        MakeAppxTests::TempDirectory temp("makeappx-pause");
+        WriteTree(temp / "input");
+        PackOptions options;
+        options.compression = CompressionLevel::Maximum;
+        options.cacheDirectory = (temp / "cache").wstring();
+        OperationPtr pack = PackAsync((temp / "input").wstring(), (temp / "app.appx").wstring(), options);
+
+        while (pack->Progress().processedFiles == 0 && !pack->WaitFor(std::chrono::milliseconds(1))) {
+        }
+        pack->Pause();
+        bool paused = !pack->WaitFor(std::chrono::milliseconds(500));
+        if (paused) {
+            uint64_t processed = pack->Progress().processedBytes;
+
+            std::atomic<size_t> count{ 0 };
+            TaskGroup group;
+            for (int i = 0; i < 100; ++i) {
+                group.Run([&]() { ++count; });
+            }
+            CHECK(group.WaitFor(std::chrono::seconds(10)));
+            CHECK(count == 100);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            CHECK(pack->Progress().processedBytes == processed);
+            CHECK(pack->Status() == OperationStatus::Running);
+        }
+        else {
+            std::fprintf(stderr, "pack finished before it could be paused\n");
+        }
+        pack->Resume();
+        CHECK(pack->Wait());
+        CHECK(fs::exists(temp / "app.appx"));
+    }
+
+    // The shared scheduler, as the engines use it.
+    {
+        std::atomic<size_t> count{ 0 };
+        TaskGroup group;
+        for (int i = 0; i < 1000; ++i) {
+            group.Run([&]() { ++count; });
+        }
+        group.Wait();
+        CHECK(count == 1000);
+    }
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+
+// Every test is a small executable: CHECK records a failure and carries on, main returns TestResult().
+namespace MakeAppxTests {
+
+    namespace fs = std::filesystem;
+
+    inline int& FailureCount() {
+        static int count = 0;
+        return count;
+    }
+
+    inline int TestResult() {
+        if (FailureCount() != 0) {
+            std::fprintf(stderr, "%d check(s) failed\n", FailureCount());
+            return 1;
+        }
+        return 0;
+    }
+
+    // A fresh directory under the system temp directory, removed with everything in it.
+    class TempDirectory {
+    private:
+        fs::path m_path;
+
+    public:
+        explicit TempDirectory(const std::string& name) {
+            std::random_device random;
+            m_path = fs::temp_directory_path() / (name + "-" + std::to_string(random()));
+            fs::create_directories(m_path);
+        }
+
+        ~TempDirectory() {
+            std::error_code ec;
+            fs::remove_all(m_path, ec);
+        }
+
+        TempDirectory(const TempDirectory&) = delete;
+        TempDirectory& operator=(const TempDirectory&) = delete;
+
+        const fs::path& Path() const { return m_path; }
+        fs::path operator/(const std::string& name) const { return m_path / name; }
+    };
+}
+
+#define CHECK(condition)                                                                      \
+    do {                                                                                      \
+        if (!(condition)) {                                                                   \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++MakeAppxTests::FailureCount();                                                  \
+        }                                                                                     \
+    } while (0)
@@ -0,0 +1,151 @@
+#include "AppxPackage.h"
+#include "BlockMap.h"
+#include "ContentTypes.h"
+#include "EntryCache.h"
+#include "TestSupport.h"
+#include "ZipDirectory.h"
+#include "ZipStream.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace MakeAppxCore;
+namespace fs = std::filesystem;
+
+namespace {
+    const char* CONTENT_TYPES_XML =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+        "<Default Extension=\"xml\" ContentType=\"application/vnd.ms-appx.manifest+xml\"/>"
+        "<Default Extension=\"PNG\" ContentType=\"image/png\"/>"
+        "<Override PartName=\"/AppxBlockMap.xml\" ContentType=\"application/vnd.ms-appx.blockmap+xml\"/>"
+        "</Types>";
+
+    void WriteFile(const fs::path& path, const std::string& data) {
+        fs::create_directories(path.parent_path());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    // A package laid out the way MakeAppx writes one: payload, block map, then [Content_Types].xml, which
+    // the block map does not list.
+    bool WritePackage(const fs::path& path, const std::vector<std::pair<std::string, std::string>>& files) {
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        ZipStreamWriter writer(StreamSink([&output](const uint8_t* data, size_t size) {
+            output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            return output.good();
+        }));
+        auto sink = [&writer](const uint8_t* data, size_t size) {
+            return writer.Write(data, size);
+        };
+        auto add = [&](const std::string& name, const std::string& data, BlockMapEntry* blockMapEntry) {
+            std::istringstream input(data);
+            CompressedEntry entry;
+            std::wstring error;
+            if (!writer.BeginEntry(name, ZIP_METHOD_STORE, 1600000000, data.size()) ||
+                !EncodeEntry(input, 0, true, sink, entry, error) ||
+                !writer.EndEntry(entry.crc32, entry.uncompressedSize)) {
+                return false;
+            }
+            if (blockMapEntry) {
+                blockMapEntry->name = name;
+                blockMapEntry->size = entry.uncompressedSize;
+                blockMapEntry->lfhSize = ZipStreamWriter::LocalHeaderSize(name, data.size());
+                blockMapEntry->blocks = entry.blocks;
+            }
+            return true;
+        };
+
+        std::vector<BlockMapEntry> blockMap(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (!add(files[i].first, files[i].second, &blockMap[i])) return false;
+        }
+        return add(BLOCK_MAP_ENTRY_NAME, GenerateBlockMapXml(blockMap), nullptr) &&
+            add(CONTENT_TYPES_ENTRY_NAME, CONTENT_TYPES_XML, nullptr) && writer.Finish();
+    }
+
+    std::string ReadEntry(const fs::path& package, const std::string& name) {
+        FileSource source(package);
+        ZipDirectory directory;
+        std::string data;
+        if (!source.IsOpen() || !directory.Read(source)) return data;
+        const ZipDirectoryEntry* entry = directory.Find(name);
+        if (entry) directory.ReadEntryData(source, *entry, data);
+        return data;
+    }
+
+    bool Verifies(IAppxPackage& package, const fs::path& path) {
+        VerifyResult result;
+        return package.Verify(path.wstring(), result) && result.blockMapChecked && result.failures.empty();
+    }
+}
+
+int main() {
+    // Part names, extensions and the XML round trip.
+    ContentTypes types;
+    CHECK(!types.Parse("<Package/>"));
+    CHECK(types.Parse(CONTENT_TYPES_XML));
+    CHECK(types.Covers("AppxManifest.xml") && types.Covers("Assets/Logo.png") && types.Covers("AppxBlockMap.xml"));
+    CHECK(!types.Covers("app.js") && !types.Covers("LICENSE") && !types.Covers("dir.v2/README"));
+    CHECK(!types.Add("Assets\\Wide.png"));
+    CHECK(types.Add("scripts/app.JS") && types.Covers("other.js"));
+    CHECK(types.Add("docs/read me"));
+    CHECK(types.Covers("docs/read me") && !types.Covers("docs/readme"));
+    ContentTypes reparsed;
+    CHECK(reparsed.Parse(types.ToXml()));
+    CHECK(reparsed.ToXml() == types.ToXml());
+    CHECK(types.ToXml().find("<Default Extension=\"js\" ContentType=\"application/javascript\"/>") != std::string::npos);
+    CHECK(types.ToXml().find("PartName=\"/docs/read%20me\"") != std::string::npos);
+    CHECK(ContentTypeForExtension("bin") == "application/octet-stream");
+
+    MakeAppxTests::TempDirectory temp("makeappx-update");
+    fs::path packagePath = temp / "app.appx";
+    CHECK(WritePackage(packagePath, {
+        { "AppxManifest.xml", "<Package/>" },
+        { "Assets/Logo.png", std::string(70000, 'L') },
+        { "Assets/Wide.png", std::string(1000, 'W') },
+    }));
+
+    auto package = CreateAppxPackage();
+    CHECK(Verifies(*package, packagePath));
+
+    // A changed file with a known extension keeps the block map and leaves the content types alone.
+    WriteFile(temp / "changes1" / "Assets" / "Logo.png", std::string(140000, 'N'));
+    PackOptions options;
+    options.cacheDirectory = (temp / "cache").wstring();
+    CHECK(package->Update(packagePath.wstring(), (temp / "changes1").wstring(), options));
+    CHECK(Verifies(*package, packagePath));
+    CHECK(ReadEntry(packagePath, CONTENT_TYPES_ENTRY_NAME) == CONTENT_TYPES_XML);
+    CHECK(ReadEntry(packagePath, "Assets/Logo.png") == std::string(140000, 'N'));
+
+    // New extensions and extensionless files get content types; the block map still lists only payload.
+    WriteFile(temp / "changes2" / "data" / "config.json", "{}");
+    WriteFile(temp / "changes2" / "LICENSE", "MIT");
+    WriteFile(temp / "changes2" / "[Content_Types].xml", "<Types/>");
+    options.compression = CompressionLevel::None;
+    CHECK(package->Update(packagePath.wstring(), (temp / "changes2").wstring(), options));
+    CHECK(Verifies(*package, packagePath));
+
+    ContentTypes updated;
+    CHECK(updated.Parse(ReadEntry(packagePath, CONTENT_TYPES_ENTRY_NAME)));
+    CHECK(updated.Covers("data/config.json") && updated.Covers("LICENSE") && updated.Covers("Assets/Logo.png"));
+
+    std::vector<BlockMapEntry> blockMap;
+    CHECK(ParseBlockMapXml(ReadEntry(packagePath, BLOCK_MAP_ENTRY_NAME), blockMap));
+    CHECK(blockMap.size() == 5);
+
+    // Every LfhSize matches the local header the writer laid out.
+    FileSource source(packagePath);
+    ZipDirectory directory;
+    CHECK(source.IsOpen() && directory.Read(source));
+    for (const auto& entry : blockMap) {
+        CHECK(!IsFootprintFile(entry.name));
+        const ZipDirectoryEntry* zipEntry = directory.Find(entry.name);
+        uint64_t dataOffset = 0;
+        CHECK(zipEntry && directory.ReadDataOffset(source, *zipEntry, dataOffset));
+        CHECK(zipEntry && dataOffset - zipEntry->localHeaderOffset == entry.lfhSize);
+    }
+
+    return MakeAppxTests::TestResult();
+}
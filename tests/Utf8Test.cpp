@@ -0,0 +1,81 @@
+#include "TestSupport.h"
+#include "Utf8.h"
+#include <string>
+
+using namespace MakeAppxCore;
+
+namespace {
+    // Code points up to and past the 16-byte blocks of the vector path, starting at every offset of a block.
+    std::wstring MixedText(size_t asciiRun, wchar_t other) {
+        std::wstring text(asciiRun, L'a');
+        for (size_t i = 0; i < text.size(); ++i) {
+            text[i] = static_cast<wchar_t>(L'!' + i % 90);
+        }
+        text += other;
+        text += std::wstring(asciiRun, L'z');
+        return text;
+    }
+
+    bool RoundTrip(const std::wstring& text) {
+        std::string utf8;
+        std::wstring back;
+        return TranscodeWideToUtf8(text.data(), text.size(), utf8) &&
+            TranscodeUtf8ToWide(utf8.data(), utf8.size(), back) && back == text;
+    }
+}
+
+int main() {
+    std::wstring wide;
+    std::string narrow;
+
+    CHECK(TranscodeUtf8ToWide("", 0, wide) && wide.empty());
+    CHECK(TranscodeWideToUtf8(L"", 0, narrow) && narrow.empty());
+
+    std::string ascii = "AppxManifest.xml and some more ASCII past sixteen bytes";
+    CHECK(TranscodeUtf8ToWide(ascii.data(), ascii.size(), wide));
+    CHECK(wide == L"AppxManifest.xml and some more ASCII past sixteen bytes");
+
+    // Two, three and four byte sequences.
+    std::string multi = "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80";
+    CHECK(TranscodeUtf8ToWide(multi.data(), multi.size(), wide));
+    CHECK(TranscodeWideToUtf8(wide.data(), wide.size(), narrow));
+    CHECK(narrow == multi);
+#ifdef _WIN32
+    CHECK(wide.size() == 9);
+#else
+    CHECK(wide.size() == 8);
+    CHECK(wide[7] == static_cast<wchar_t>(0x1F600));
+#endif
+
+    for (size_t run = 0; run < 40; ++run) {
+        CHECK(RoundTrip(MixedText(run, L'\x00E9')));
+        CHECK(RoundTrip(MixedText(run, L'\x20AC')));
+        CHECK(RoundTrip(MixedText(run, L'\x007F')));
+    }
+
+    // Malformed input is replaced and reported, at the start, in and after an ASCII block.
+    const char* invalid[] = {
+        "\xFF",
+        "abc\xC3",
+        "0123456789abcdef\x80tail",
+        "0123456789abcdefXYZ\xE2\x82",
+        "\xC0\xAF",
+        "\xED\xA0\x80",
+        "\xF4\x90\x80\x80",
+    };
+    for (const char* text : invalid) {
+        std::string input(text);
+        CHECK(!TranscodeUtf8ToWide(input.data(), input.size(), wide));
+        CHECK(wide.find(L'\xFFFD') != std::wstring::npos);
+    }
+
+    std::string tail = "0123456789abcdef\x80tail";
+    TranscodeUtf8ToWide(tail.data(), tail.size(), wide);
+    CHECK(wide == std::wstring(L"0123456789abcdef") + L'\xFFFD' + L"tail");
+
+    // Embedded NULs are characters like any other.
+    std::string nul("a\0b", 3);
+    CHECK(TranscodeUtf8ToWide(nul.data(), nul.size(), wide) && wide.size() == 3 && wide[1] == L'\0');
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,129 @@
+#include "AppxPackage.h"
+#include "TestSupport.h"
+#include "VolumeSet.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace MakeAppxCore;
+
+namespace {
+    std::string Pattern(size_t size) {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>((i * 131 + i / 4096) & 0xFF);
+        }
+        return data;
+    }
+
+    void WriteFile(const fs::path& path, const std::string& data) {
+        fs::create_directories(path.parent_path());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::string ReadFile(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Writes data in uneven pieces so buffer, volume and write boundaries all fall in different places.
+    bool WriteSplit(const fs::path& packagePath, uint64_t volumeSize, const std::string& data, size_t& volumeCount) {
+        VolumeWriter writer(packagePath, volumeSize);
+        size_t offset = 0;
+        for (size_t piece = 1; offset < data.size(); piece = piece * 3 + 1) {
+            size_t size = std::min(piece % 700001, data.size() - offset);
+            if (!writer.Write(reinterpret_cast<const uint8_t*>(data.data() + offset), size)) return false;
+            offset += size;
+        }
+        bool closed = writer.Close();
+        volumeCount = writer.VolumeCount();
+        return closed;
+    }
+}
+
+int main() {
+    MakeAppxTests::TempDirectory temp("makeappx-volumes");
+    fs::path package = temp / "app.appx";
+
+    CHECK(VolumePath(package, 1) == temp / "app.appx.001");
+    CHECK(VolumePath(package, 1000) == temp / "app.appx.1000");
+
+    // Stale volumes from an earlier, longer split are removed on Close.
+    WriteFile(VolumePath(package, 5), "stale");
+    WriteFile(VolumePath(package, 6), "stale");
+
+    std::string data = Pattern(3500000);
+    size_t volumeCount = 0;
+    CHECK(WriteSplit(package, 1000000, data, volumeCount));
+    CHECK(volumeCount == 4);
+    CHECK(fs::file_size(VolumePath(package, 1)) == 1000000 && fs::file_size(VolumePath(package, 4)) == 500000);
+    CHECK(!fs::exists(VolumePath(package, 5)) && !fs::exists(VolumePath(package, 6)));
+    CHECK(!fs::exists(package));
+
+    // Either the package path or its first volume finds every volume in order.
+    std::vector<fs::path> volumes;
+    CHECK(FindVolumes(package, volumes) && volumes.size() == 4 && volumes[3] == VolumePath(package, 4));
+    CHECK(FindVolumes(VolumePath(package, 1), volumes) && volumes.size() == 4);
+    CHECK(!FindVolumes(temp / "other.appx", volumes) && volumes.empty());
+    WriteFile(temp / "single.appx", "zip");
+    CHECK(!FindVolumes(temp / "single.appx", volumes));
+
+    // The source reads across volume boundaries as one archive.
+    VolumeSource source;
+    CHECK(FindVolumes(package, volumes) && source.Open(volumes));
+    CHECK(source.Size() == data.size() && source.VolumeCount() == 4);
+    CHECK(source.VolumeOf(0) == 0 && source.VolumeOf(999999) == 0 && source.VolumeOf(1000000) == 1);
+    CHECK(source.VolumeOf(data.size() - 1) == 3);
+
+    std::string read(2500000, '\0');
+    CHECK(source.ReadAt(999990, &read[0], read.size()) && read == data.substr(999990, read.size()));
+    CHECK(source.ReadAt(data.size() - 10, &read[0], 10) && read.compare(0, 10, data, data.size() - 10, 10) == 0);
+    CHECK(source.ReadAt(data.size(), &read[0], 0));
+    CHECK(!source.ReadAt(data.size() - 10, &read[0], 11));
+    CHECK(!source.ReadAt(data.size() + 1, &read[0], 0));
+
+    VolumeSource empty;
+    CHECK(!empty.Open({}));
+    CHECK(!empty.Open({ temp / "missing.001" }) && !empty.GetLastError().empty());
+
+    // Data that fills the last volume exactly does not leave an empty volume behind.
+    CHECK(WriteSplit(temp / "exact.appx", 700000, data.substr(0, 2100000), volumeCount));
+    CHECK(volumeCount == 3 && !fs::exists(VolumePath(temp / "exact.appx", 4)));
+
+    // Volumes are removed unless Close succeeds, and a volume that cannot be created fails the write.
+    {
+        VolumeWriter writer(temp / "abandoned.appx", 100000);
+        CHECK(writer.Write(reinterpret_cast<const uint8_t*>(data.data()), 3000000));
+    }
+    CHECK(!fs::exists(VolumePath(temp / "abandoned.appx", 1)));
+    {
+        VolumeWriter writer(temp / "missing" / "app.appx", 100000);
+        writer.Write(reinterpret_cast<const uint8_t*>(data.data()), 100);
+        CHECK(!writer.Close());
+        CHECK(writer.GetLastError().find(L"Cannot create volume") == 0);
+    }
+
+    // A split pack unpacks from its volumes to the same files.
+    for (int i = 0; i < 8; ++i) {
+        WriteFile(temp / "in" / "Assets" / ("f" + std::to_string(i) + ".bin"), Pattern(100000 + i * 7919));
+    }
+    WriteFile(temp / "in" / "AppxManifest.xml", "<Package/>");
+    auto appx = CreateAppxPackage();
+    PackOptions options;
+    options.compression = CompressionLevel::None;
+    options.volumeSize = 300000;
+    CHECK(appx->Pack((temp / "in").wstring(), (temp / "split.appx").wstring(), options));
+    CHECK(FindVolumes(temp / "split.appx", volumes) && volumes.size() > 1);
+
+    UnpackOptions unpack;
+    unpack.overwrite = OverwriteMode::Yes;
+    CHECK(appx->Unpack((temp / "split.appx").wstring(), (temp / "out").wstring(), unpack));
+    for (int i = 0; i < 8; ++i) {
+        std::string name = "f" + std::to_string(i) + ".bin";
+        CHECK(ReadFile(temp / "out" / "Assets" / name) == ReadFile(temp / "in" / "Assets" / name));
+    }
+
+    return MakeAppxTests::TestResult();
+}
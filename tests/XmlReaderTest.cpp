@@ -0,0 +1,113 @@
+#include "AppxPackage.h"
+#include "TestSupport.h"
+#include "XmlReader.h"
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+using namespace MakeAppxCore;
+namespace fs = std::filesystem;
+
+namespace {
+    // Every node as one line: "<name" or "</name" with its depth, or the quoted text.
+    std::string Tokens(const std::string& xml, std::wstring* error = nullptr) {
+        std::istringstream stream(xml);
+        XmlReader reader(stream);
+        std::string tokens;
+        while (reader.Read()) {
+            switch (reader.NodeType()) {
+            case XmlNodeType::StartElement:
+                tokens += "<" + reader.LocalName() + (reader.IsEmptyElement() ? "/" : "") + std::to_string(reader.Depth());
+                if (!reader.GetAttribute("a").empty()) tokens += " a=" + reader.GetAttribute("a");
+                break;
+            case XmlNodeType::EndElement:
+                tokens += "</" + reader.LocalName() + std::to_string(reader.Depth());
+                break;
+            case XmlNodeType::Text:
+                tokens += "'" + reader.Text() + "'";
+                break;
+            default:
+                break;
+            }
+            tokens += "\n";
+        }
+        if (error) *error = reader.GetLastError();
+        return reader.HasError() ? std::string() : tokens;
+    }
+
+    void WriteFile(const fs::path& path, const std::string& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::string ReadFile(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+}
+
+int main() {
+    // Declarations, comments and whitespace are skipped; empty elements close at their own depth.
+    CHECK(Tokens("\xEF\xBB\xBF<?xml version=\"1.0\"?>\n<!DOCTYPE x>\n<!-- c -->\n<s:Root xmlns:s=\"u\">\n"
+        "  <Item a='1'/>\n  <Item a=\"&lt;2&gt;\">t&amp;x</Item>\n</s:Root>\n") ==
+        "<Root1\n<Item/2 a=1\n</Item1\n<Item2 a=<2>\n't&x'\n</Item1\n</Root0\n");
+
+    // Character references and CDATA decode to UTF-8 text.
+    CHECK(Tokens("<a>&#x20AC;&#233;&quot;&apos;</a>") == "<a1\n'\xE2\x82\xAC\xC3\xA9\"''\n</a0\n");
+    CHECK(Tokens("<a><![CDATA[<not> &amp; markup]]></a>") == "<a1\n'<not> &amp; markup'\n</a0\n");
+    CHECK(Tokens("<a>&nbsp;</a>") == "<a1\n'&nbsp;'\n</a0\n");
+
+    // Text longer than the 64 KB read buffer.
+    std::string longText(70000, 'x');
+    CHECK(Tokens("<a>" + longText + "</a>") == "<a1\n'" + longText + "'\n</a0\n");
+
+    // Malformed input reports the line it failed on.
+    std::wstring error;
+    CHECK(Tokens("<a>\n<b>\n</a>", &error).empty());
+    CHECK(error.find(L"Mismatched end tag") != std::wstring::npos && error.find(L"line 3") != std::wstring::npos);
+    CHECK(Tokens("<a>", &error).empty() && !error.empty());
+    CHECK(Tokens("<a b=c/>", &error).empty() && !error.empty());
+    CHECK(Tokens("<a>&averyverylongname;</a>", &error).empty() && !error.empty());
+    CHECK(Tokens("<a>&#x110000;</a>", &error).empty() && !error.empty());
+    CHECK(Tokens("<a><!-- x ->", &error).empty() && !error.empty());
+
+    CHECK(XmlEscape("a<b>&\"'") == "a&lt;b&gt;&amp;&quot;&apos;");
+
+    // ConvertCGM keeps Automatic, then Required, then Optional groups, whatever the source order.
+    MakeAppxTests::TempDirectory temp("makeappx-cgm");
+    auto builder = CreateAppxBuilder();
+    WriteFile(temp / "source.cgm",
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<ContentGroupMap xmlns=\"http://schemas.microsoft.com/appx/2016/sourcecgm\">\n"
+        "  <Optional Name=\"Levels &amp; Maps\"><Files><File Name=\"levels\\1.dat\"/></Files></Optional>\n"
+        "  <Required><Files><File Name=\"AppxManifest.xml\"/><File Name=\"a&lt;b.txt\"/></Files></Required>\n"
+        "  <Automatic><Files><File Name=\"*.png\"/></Files></Automatic>\n"
+        "</ContentGroupMap>\n");
+    CHECK(builder->ConvertCGM((temp / "source.cgm").wstring(), (temp / "out.cgm").wstring()));
+    std::string converted = ReadFile(temp / "out.cgm");
+    size_t automatic = converted.find("<Automatic>");
+    size_t required = converted.find("<Required>");
+    size_t optional = converted.find("<Optional Name=\"Levels &amp; Maps\">");
+    CHECK(automatic != std::string::npos && automatic < required && required < optional && optional != std::string::npos);
+    CHECK(converted.find("<File Name=\"a&lt;b.txt\" />") != std::string::npos);
+    CHECK(converted.find("<File Name=\"levels\\1.dat\" />") != std::string::npos);
+    CHECK(!Tokens(converted).empty());
+    CHECK(!fs::exists(temp / "out.cgm.required.tmp") && !fs::exists(temp / "out.cgm.optional.tmp"));
+
+    // Invalid maps fail and leave no output behind.
+    const char* invalid[] = {
+        "<Other/>",
+        "<ContentGroupMap></ContentGroupMap>",
+        "<ContentGroupMap><Required><Files></Required></ContentGroupMap>",
+    };
+    for (const char* source : invalid) {
+        WriteFile(temp / "bad.cgm", source);
+        CHECK(!builder->ConvertCGM((temp / "bad.cgm").wstring(), (temp / "bad-out.cgm").wstring()));
+        CHECK(builder->GetLastError().find(L"Invalid source CGM") == 0);
+        CHECK(!fs::exists(temp / "bad-out.cgm"));
+    }
+    CHECK(!builder->ConvertCGM((temp / "missing.cgm").wstring(), (temp / "bad-out.cgm").wstring()));
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,105 @@
+#include "Crc32.h"
+#include "TestSupport.h"
+#include "ZipDirectory.h"
+#include "ZipStream.h"
+#include <zlib.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace MakeAppxCore;
+
+namespace {
+    std::string Deflate(const std::string& data) {
+        z_stream stream = {};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        std::string out(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream.avail_out = static_cast<uInt>(out.size());
+        deflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        return out;
+    }
+
+    void PutU32(std::vector<uint8_t>& data, size_t offset, uint32_t value) {
+        memcpy(data.data() + offset, &value, sizeof(value));
+    }
+
+    // Offset of the central directory record of the only entry, found by its signature.
+    size_t CentralHeader(const std::vector<uint8_t>& archive) {
+        for (size_t i = archive.size() - 4; i > 0; --i) {
+            if (archive[i] == 'P' && archive[i + 1] == 'K' && archive[i + 2] == 1 && archive[i + 3] == 2) return i;
+        }
+        return 0;
+    }
+
+    bool ReadsEntry(const std::vector<uint8_t>& archive, std::string& data) {
+        MemorySource source(archive.data(), archive.size());
+        ZipDirectory directory;
+        if (!directory.Read(source) || directory.Entries().size() != 1) return false;
+        return directory.ReadEntryData(source, directory.Entries()[0], data);
+    }
+}
+
+int main() {
+    std::string manifest;
+    for (int i = 0; i < 2000; ++i) {
+        manifest += "<Resource Language=\"x-" + std::to_string(i) + "\" />\n";
+    }
+    std::string payload = Deflate(manifest);
+
+    std::vector<uint8_t> archive;
+    ZipStreamWriter writer([&archive](const uint8_t* data, size_t size) {
+        archive.insert(archive.end(), data, data + size);
+        return true;
+    });
+    uint32_t crc = Crc32(0, manifest.data(), manifest.size());
+    CHECK(writer.BeginEntry("AppxManifest.xml", ZIP_METHOD_DEFLATE, 1600000000, manifest.size()));
+    CHECK(writer.Write(payload.data(), payload.size()));
+    CHECK(writer.EndEntry(crc, manifest.size()));
+    CHECK(writer.Finish());
+
+    std::string data;
+    CHECK(ReadsEntry(archive, data) && data == manifest);
+
+    size_t central = CentralHeader(archive);
+    CHECK(central != 0);
+    constexpr size_t COMPRESSED_SIZE = 20;
+    constexpr size_t UNCOMPRESSED_SIZE = 24;
+
+    // Claimed sizes are checked against the package and the deflate ratio before anything is allocated.
+    std::vector<uint8_t> damaged = archive;
+    PutU32(damaged, central + UNCOMPRESSED_SIZE, 0xFFFFFFF0u);
+    CHECK(!ReadsEntry(damaged, data));
+
+    damaged = archive;
+    PutU32(damaged, central + COMPRESSED_SIZE, static_cast<uint32_t>(archive.size()));
+    CHECK(!ReadsEntry(damaged, data));
+
+    damaged = archive;
+    PutU32(damaged, central + UNCOMPRESSED_SIZE, static_cast<uint32_t>(manifest.size() + 1));
+    CHECK(!ReadsEntry(damaged, data));
+
+    damaged = archive;
+    PutU32(damaged, central + UNCOMPRESSED_SIZE, static_cast<uint32_t>(manifest.size() - 1));
+    CHECK(!ReadsEntry(damaged, data));
+
+    // A smaller limit refuses the entry outright.
+    MemorySource source(archive.data(), archive.size());
+    ZipDirectory directory;
+    CHECK(directory.Read(source));
+    CHECK(!directory.ReadEntryData(source, directory.Entries()[0], data, manifest.size() - 1));
+    CHECK(!directory.GetLastError().empty());
+
+    // A central directory that claims to run past the end of the file.
+    damaged = archive;
+    size_t end = archive.size() - 22;
+    PutU32(damaged, end + 12, 0xFFFFFF00u);
+    MemorySource damagedSource(damaged.data(), damaged.size());
+    CHECK(!directory.Read(damagedSource));
+
+    return MakeAppxTests::TestResult();
+}
@@ -0,0 +1,161 @@
+#include "Crc32.h"
+#include "TestSupport.h"
+#include "ZipDirectory.h"
+#include "ZipStream.h"
+#include <zlib.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace MakeAppxCore;
+
+namespace {
+    struct TestEntry {
+        std::string name;
+        uint16_t method;
+        std::string data;
+    };
+
+    std::string Deflate(const std::string& data) {
+        z_stream stream = {};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        std::string out(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream.avail_out = static_cast<uInt>(out.size());
+        deflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        return out;
+    }
+
+    std::vector<TestEntry> MakeEntries() {
+        std::string text;
+        for (int i = 0; i < 5000; ++i) {
+            text += "line " + std::to_string(i) + " of some compressible text\n";
+        }
+        std::string binary(100000, '\0');
+        uint32_t state = 1;
+        for (auto& c : binary) {
+            state = state * 1664525u + 1013904223u;
+            c = static_cast<char>(state >> 24);
+        }
+
+        return {
+            { "empty.txt", ZIP_METHOD_STORE, "" },
+            { "stored.bin", ZIP_METHOD_STORE, binary },
+            { "dir/deflated.txt", ZIP_METHOD_DEFLATE, text },
+            { "dir/\xC3\xA9t\xC3\xA9.txt", ZIP_METHOD_DEFLATE, "unicode name" },
+            { "empty-deflated", ZIP_METHOD_DEFLATE, "" },
+        };
+    }
+
+    bool WriteArchive(ZipStreamWriter& writer, const std::vector<TestEntry>& entries) {
+        for (const auto& entry : entries) {
+            std::string payload = entry.method == ZIP_METHOD_DEFLATE ? Deflate(entry.data) : entry.data;
+            uint32_t crc = Crc32(0, entry.data.data(), entry.data.size());
+            if (!writer.BeginEntry(entry.name, entry.method, 1600000000, entry.data.size()) ||
+                !writer.Write(payload.data(), payload.size()) ||
+                !writer.EndEntry(crc, entry.data.size())) {
+                return false;
+            }
+            CHECK(writer.LastEntry().name == entry.name);
+            CHECK(writer.LastEntry().crc32 == crc);
+        }
+        return writer.Finish();
+    }
+}
+
+int main() {
+    std::vector<TestEntry> entries = MakeEntries();
+
+    std::vector<uint8_t> archive;
+    ZipStreamWriter writer([&archive](const uint8_t* data, size_t size) {
+        archive.insert(archive.end(), data, data + size);
+        return true;
+    });
+    CHECK(WriteArchive(writer, entries));
+    CHECK(writer.Offset() == archive.size());
+
+    // Random access through the central directory.
+    MemorySource source(archive.data(), archive.size());
+    ZipDirectory directory;
+    CHECK(directory.Read(source));
+    CHECK(directory.Entries().size() == entries.size());
+    for (const auto& expected : entries) {
+        const ZipDirectoryEntry* entry = directory.Find(expected.name);
+        CHECK(entry != nullptr);
+        if (!entry) continue;
+
+        CHECK(entry->method == expected.method);
+        CHECK(entry->uncompressedSize == expected.data.size());
+        CHECK(VerifyStreamedEntry(source, *entry, true));
+
+        uint64_t dataOffset = 0;
+        CHECK(directory.ReadDataOffset(source, *entry, dataOffset));
+        CHECK(dataOffset == entry->localHeaderOffset + ZipStreamWriter::LocalHeaderSize(entry->name, expected.data.size()));
+
+        std::string data;
+        CHECK(directory.ReadEntryData(source, *entry, data));
+        CHECK(data == expected.data);
+    }
+
+    // Front to back through the local headers, as from a pipe.
+    FILE* file = std::tmpfile();
+    CHECK(file != nullptr);
+    if (file) {
+        std::fwrite(archive.data(), 1, archive.size(), file);
+        std::rewind(file);
+
+        ZipStreamReader reader(file);
+        ZipStreamEntry entry;
+        size_t index = 0;
+        while (reader.NextEntry(entry)) {
+            CHECK(index < entries.size());
+            if (index >= entries.size()) break;
+            CHECK(entry.name == entries[index].name);
+
+            std::string data;
+            char buffer[4096];
+            size_t read;
+            while ((read = reader.Read(buffer, sizeof(buffer))) > 0) {
+                data.append(buffer, read);
+            }
+            CHECK(data == entries[index].data);
+            ++index;
+        }
+        CHECK(!reader.HasError());
+        CHECK(index == entries.size());
+        std::fclose(file);
+    }
+
+    // A flipped byte in an entry's data fails its CRC check.
+    const ZipDirectoryEntry* stored = directory.Find("stored.bin");
+    if (stored) {
+        std::vector<uint8_t> damaged = archive;
+        damaged[stored->localHeaderOffset + ZipStreamWriter::LocalHeaderSize(stored->name, stored->uncompressedSize) + 10] ^= 0xFF;
+        MemorySource damagedSource(damaged.data(), damaged.size());
+        CHECK(!VerifyStreamedEntry(damagedSource, *stored, true));
+    }
+
+    // LocalHeaderSize is what block maps record as LfhSize; it has to match the header written, zip64
+    // extra field included.
+    for (uint64_t size : { uint64_t(0), uint64_t(70000), uint64_t(5) << 30 }) {
+        std::vector<uint8_t> header;
+        ZipStreamWriter probe([&header](const uint8_t* data, size_t length) {
+            header.insert(header.end(), data, data + length);
+            return true;
+        });
+        CHECK(probe.BeginEntry("Assets/large.bin", ZIP_METHOD_STORE, 1600000000, size));
+        CHECK(header.size() == ZipStreamWriter::LocalHeaderSize("Assets/large.bin", size));
+    }
+    CHECK(ZipStreamWriter::LocalHeaderSize("a", uint64_t(5) << 30) > ZipStreamWriter::LocalHeaderSize("a", 0));
+
+    // A sink that fails stops the writer.
+    ZipStreamWriter failing([](const uint8_t*, size_t) { return false; });
+    CHECK(!WriteArchive(failing, entries));
+    CHECK(!failing.GetLastError().empty());
+
+    return MakeAppxTests::TestResult();
+}